@@ -0,0 +1,97 @@
+#include "BVH.h"
+#include "Bench.h"
+#include "CullScene.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//	BVH build and query against the flat SIMD cull (BVH_CULL_MIN), over the
+//	srand(100) scatter from 1k to 10M trees, and refit against rebuild when
+//	1% or all of the instances move. Queries average a stretch of the camera
+//	path, the far plane stays at 100 so bigger forests show less of themselves.
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	const size_t counts[] = { 1024, 4096, 16384, 65536, 100000, 1000000, 10000000 };
+	size_t countCount = quick ? 3 : 7;
+	size_t frames = quick ? 4 : 30;
+	const FLOAT3 treeMin(-0.5f, -0.5f, -0.5f), treeMax(0.5f, 0.5f, 0.5f);
+
+	printf("%-9s %9s %9s %9s %9s %9s %9s %9s %9s\n", "trees", "visible", "build ms",
+		"flat ms", "bvh ms", "coher ms", "refit1 ms", "refit ms", "faster");
+	for (size_t c = 0; c < countCount; ++c){
+		size_t n = counts[c];
+		int reps = (quick || n >= 1000000) ? 1 : 3;
+		InstanceSoA inst;
+		MakeForest(inst, n);
+		float extent = SceneExtent(n);
+
+		std::vector<AABB> boxes(n);
+		for (size_t i = 0; i < n; ++i)
+			boxes[i] = AABB(FLOAT3(inst.x[i] + treeMin.x, inst.y[i] + treeMin.y, inst.z[i] + treeMin.z),
+				FLOAT3(inst.x[i] + treeMax.x, inst.y[i] + treeMax.y, inst.z[i] + treeMax.z));
+
+		BVH bvh;
+		double build = BestMs(reps, [&]{ bvh.Build(&boxes[0], n); });
+
+		std::vector<Frustum> frustums(frames);
+		std::vector<CullPlanes> planes(frames);
+		for (size_t f = 0; f < frames; ++f){
+			FLOAT3 eye;
+			float yaw;
+			CameraPath(f, extent, eye, yaw);
+			MakeFrustum(eye, yaw, frustums[f]);
+			BuildCullPlanes(frustums[f].planes, treeMin, treeMax, planes[f]);
+		}
+
+		std::vector<unsigned int> flatOut(n);
+		size_t visible = 0;
+		double flat = BestMs(reps, [&]{
+			visible = 0;
+			for (size_t f = 0; f < frames; ++f)
+				visible += CullInstances(planes[f], inst, 0, n, &flatOut[0]);
+		}) / frames;
+
+		std::vector<unsigned int> out;
+		out.reserve(n);
+		double tree = BestMs(reps, [&]{
+			for (size_t f = 0; f < frames; ++f){
+				out.clear();
+				bvh.CullFrustum(frustums[f].planes, out);
+			}
+		}) / frames;
+
+		BVHCullCache cache;
+		double coherent = BestMs(reps, [&]{
+			for (size_t f = 0; f < frames; ++f){
+				out.clear();
+				bvh.CullFrustumCoherent(frustums[f].planes, out, cache);
+			}
+		}) / frames;
+
+		//	Every 100th instance nudged, then every one of them
+		double refitSome = BestMs(reps, [&]{
+			for (size_t i = 0; i < n; i += 100){
+				AABB box = boxes[i];
+				box.min.x += 0.25f;
+				box.max.x += 0.25f;
+				bvh.SetBounds((unsigned int)i, box);
+			}
+			bvh.Refit();
+		});
+		double refitAll = BestMs(reps, [&]{
+			for (size_t i = 0; i < n; ++i){
+				AABB box = boxes[i];
+				box.min.z -= 0.25f;
+				box.max.z -= 0.25f;
+				bvh.SetBounds((unsigned int)i, box);
+			}
+			bvh.Refit();
+		});
+
+		printf("%-9zu %9zu %9.2f %9.3f %9.3f %9.3f %9.3f %9.3f %9s\n", n, visible / frames, build,
+			flat, tree, coherent, refitSome, refitAll, (tree < flat) ? "bvh" : "flat");
+	}
+	return 0;
+}
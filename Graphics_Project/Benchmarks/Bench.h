@@ -0,0 +1,40 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <chrono>
+#include <cstring>
+
+#ifdef _MSC_VER
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+//	Timing for the Linux benchmarks. --quick shrinks every benchmark to a
+//	smoke run, which is how ctest runs them.
+static bool QuickRun(int argc, char** argv){
+	for (int i = 1; i < argc; ++i)
+		if (strcmp(argv[i], "--quick") == 0)
+			return true;
+	return false;
+}
+
+static double NowMs(){
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//	Fastest of reps runs of fn, in ms
+template <typename Fn>
+static double BestMs(int reps, const Fn& fn){
+	double best = 1e30;
+	for (int r = 0; r < reps; ++r){
+		double start = NowMs();
+		fn();
+		double ms = NowMs() - start;
+		if (ms < best)
+			best = ms;
+	}
+	return best;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "BlockCompress.h"
+#include "JobSystem.h"
+#include "MathSIMD.h"
+#include "Bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+//	The block encoders on the bundled source textures. First the PSNR of
+//	every format on each texture's top level, decoded back and compared over
+//	the channels the format keeps. Then MPix/s per format on a 2048 x 2048
+//	surface tiled from all four, scalar, SSE2 and SSE2 over the job system.
+//	The three paths have to write the same bytes or the run fails.
+
+struct Format{
+	const char* name;
+	DXGI_FORMAT format;
+	size_t blockBytes;
+	int channels;
+};
+
+static const Format formats[] = {
+	{ "BC1", DXGI_FORMAT_BC1_UNORM, 8, 3 },
+	{ "BC3", DXGI_FORMAT_BC3_UNORM, 16, 4 },
+	{ "BC4", DXGI_FORMAT_BC4_UNORM, 8, 1 },
+	{ "BC5", DXGI_FORMAT_BC5_UNORM, 16, 2 },
+	{ "BC7", DXGI_FORMAT_BC7_UNORM, 16, 4 }
+};
+#define FORMAT_COUNT	(sizeof(formats) / sizeof(formats[0]))
+
+struct Texture{
+	const char* name;
+	std::vector<uint8_t> rgba;
+	size_t width, height;
+};
+
+static bool LoadRGBA(const char* path, Texture& texture){
+	DDSFile file;
+	if (!file.Open(path))
+		return false;
+	const DDSSubresource& top = file.GetSubresource(0, 0);
+	bool bgra = file.GetInfo().format == DXGI_FORMAT_B8G8R8A8_UNORM || file.GetInfo().format == DXGI_FORMAT_B8G8R8X8_UNORM;
+	texture.name = path;
+	texture.width = top.width;
+	texture.height = top.height;
+	texture.rgba.resize(top.width * top.height * 4);
+	for (size_t y = 0; y < top.height; ++y){
+		for (size_t x = 0; x < top.width; ++x){
+			const uint8_t* s = top.data + y * top.rowPitch + x * 4;
+			uint8_t* d = &texture.rgba[(y * top.width + x) * 4];
+			d[0] = bgra ? s[2] : s[0];
+			d[1] = s[1];
+			d[2] = bgra ? s[0] : s[2];
+			d[3] = s[3];
+		}
+	}
+	return true;
+}
+
+static void Decode(const Format& f, const uint8_t* block, uint8_t* rgba){
+	switch (f.format){
+	case DXGI_FORMAT_BC1_UNORM:	DecodeBC1Block(block, rgba); break;
+	case DXGI_FORMAT_BC3_UNORM:	DecodeBC3Block(block, rgba); break;
+	case DXGI_FORMAT_BC4_UNORM:	DecodeBC4Block(block, 0, rgba); break;
+	case DXGI_FORMAT_BC5_UNORM:	DecodeBC5Block(block, rgba); break;
+	default:					DecodeBC7Block(block, rgba); break;
+	}
+}
+
+static double PSNR(const Format& f, const Texture& texture, const std::vector<uint8_t>& blocks){
+	double error = 0.0;
+	size_t blocksWide = texture.width / 4;
+	for (size_t by = 0; by < texture.height / 4; ++by){
+		for (size_t bx = 0; bx < blocksWide; ++bx){
+			uint8_t back[64];
+			Decode(f, &blocks[(by * blocksWide + bx) * f.blockBytes], back);
+			for (int i = 0; i < 16; ++i){
+				const uint8_t* s = &texture.rgba[((by * 4 + i / 4) * texture.width + bx * 4 + i % 4) * 4];
+				for (int c = 0; c < f.channels; ++c){
+					double d = (double)s[c] - back[4 * i + c];
+					error += d * d;
+				}
+			}
+		}
+	}
+	double mse = error / ((double)texture.width * texture.height * f.channels);
+	return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	size_t size = quick ? 256 : 2048;
+	int reps = quick ? 1 : 3;
+
+	const char* paths[] = { "../Assets/_bark.dds", "../Assets/_barrel.dds", "../Assets/_grass.dds", "../Assets/_ground.dds" };
+	const size_t textureCount = sizeof(paths) / sizeof(paths[0]);
+	Texture textures[textureCount];
+	for (size_t t = 0; t < textureCount; ++t){
+		if (!LoadRGBA(paths[t], textures[t])){
+			printf("Can't read %s\n", paths[t]);
+			return 1;
+		}
+	}
+
+	SIMDLevel detected = DetectSIMDLevel();
+	JobSystem jobs;
+	jobs.Initialize();
+
+	printf("PSNR in dB, top level\n%-22s", "texture");
+	for (size_t f = 0; f < FORMAT_COUNT; ++f)
+		printf(" %7s", formats[f].name);
+	printf("\n");
+	for (size_t t = 0; t < textureCount; ++t){
+		const Texture& texture = textures[t];
+		printf("%-22s", texture.name);
+		for (size_t f = 0; f < FORMAT_COUNT; ++f){
+			std::vector<uint8_t> blocks((texture.width / 4) * (texture.height / 4) * formats[f].blockBytes);
+			CompressSurface(&texture.rgba[0], texture.width, texture.height, texture.width * 4, formats[f].format, &blocks[0], &jobs);
+			printf(" %7.1f", PSNR(formats[f], texture, blocks));
+		}
+		printf("\n");
+	}
+
+	//	Quadrants of the surface take one texture each, wrapped
+	std::vector<uint8_t> surface(size * size * 4);
+	for (size_t y = 0; y < size; ++y){
+		for (size_t x = 0; x < size; ++x){
+			const Texture& texture = textures[(y * 2 / size) * 2 + x * 2 / size];
+			memcpy(&surface[(y * size + x) * 4], &texture.rgba[((y % texture.height) * texture.width + x % texture.width) * 4], 4);
+		}
+	}
+
+	double mpix = (double)size * size / 1e6;
+	printf("\n%zu x %zu, MPix/s, %u threads\n%-6s %9s %9s %9s %9s\n", size, size, jobs.GetNumThreads(), "format", "scalar", "SSE2", "jobs", "vs scalar");
+	for (size_t f = 0; f < FORMAT_COUNT; ++f){
+		const Format& format = formats[f];
+		std::vector<uint8_t> scalar(((size / 4) * (size / 4)) * format.blockBytes), simd(scalar.size()), threaded(scalar.size());
+
+		SetSIMDLevel(SIMD_SCALAR);
+		double scalarMs = BestMs(reps, [&]{ CompressSurface(&surface[0], size, size, size * 4, format.format, &scalar[0]); });
+		SetSIMDLevel(detected >= SIMD_SSE2 ? SIMD_SSE2 : detected);
+		double simdMs = BestMs(reps, [&]{ CompressSurface(&surface[0], size, size, size * 4, format.format, &simd[0]); });
+		double threadedMs = BestMs(reps, [&]{ CompressSurface(&surface[0], size, size, size * 4, format.format, &threaded[0], &jobs); });
+		SetSIMDLevel(detected);
+
+		if (simd != scalar || threaded != scalar){
+			printf("%s: SSE2 or threaded blocks differ from scalar\n", format.name);
+			return 1;
+		}
+		printf("%-6s %9.1f %9.1f %9.1f %8.1fx\n", format.name, mpix / scalarMs * 1e3, mpix / simdMs * 1e3,
+			mpix / threadedMs * 1e3, scalarMs / threadedMs);
+	}
+
+	jobs.Shutdown();
+	return 0;
+}
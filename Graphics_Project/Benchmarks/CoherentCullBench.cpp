@@ -0,0 +1,80 @@
+#include "BVH.h"
+#include "FrustumCull.h"
+#include "MathSIMD.h"
+#include "Bench.h"
+#include "CullScene.h"
+
+#include <cstdio>
+#include <vector>
+
+//	The coherent BVH cull against the one that tests every plane, frame by
+//	frame along the camera path (CullScene.h) from a cold cache, with the
+//	plane tests it skipped. The flat SIMD cull at each level for scale.
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	const size_t counts[] = { 400, 4096, 65536, 1048576 };
+	size_t countCount = quick ? 2 : 4;
+	size_t frames = quick ? 30 : 600;
+	const FLOAT3 treeMin(-0.5f, -0.5f, -0.5f), treeMax(0.5f, 0.5f, 0.5f);
+	const char* levelNames[] = { "scalar", "SSE2", "AVX" };
+	SIMDLevel detected = DetectSIMDLevel();
+
+	printf("%-8s %-16s %12s %12s %12s\n", "trees", "cull", "us / frame", "tests skip", "cache hits");
+	for (size_t c = 0; c < countCount; ++c){
+		size_t n = counts[c];
+		InstanceSoA inst;
+		MakeForest(inst, n);
+		float extent = SceneExtent(n);
+
+		std::vector<Frustum> frustums(frames);
+		std::vector<CullPlanes> planes(frames);
+		for (size_t f = 0; f < frames; ++f){
+			FLOAT3 eye;
+			float yaw;
+			CameraPath(f, extent, eye, yaw);
+			MakeFrustum(eye, yaw, frustums[f]);
+			BuildCullPlanes(frustums[f].planes, treeMin, treeMax, planes[f]);
+		}
+
+		std::vector<unsigned int> out(n);
+		for (int level = SIMD_SCALAR; level <= detected; ++level){
+			SetSIMDLevel((SIMDLevel)level);
+			double ms = BestMs(3, [&]{
+				for (size_t f = 0; f < frames; ++f)
+					CullInstances(planes[f], inst, 0, n, &out[0]);
+			});
+			printf("%-8zu flat %-11s %12.2f\n", n, levelNames[level], ms * 1000.0 / frames);
+		}
+		SetSIMDLevel(detected);
+
+		std::vector<AABB> boxes(n);
+		for (size_t i = 0; i < n; ++i)
+			boxes[i] = AABB(FLOAT3(inst.x[i] + treeMin.x, inst.y[i] + treeMin.y, inst.z[i] + treeMin.z),
+				FLOAT3(inst.x[i] + treeMax.x, inst.y[i] + treeMax.y, inst.z[i] + treeMax.z));
+		BVH bvh;
+		bvh.Build(&boxes[0], n);
+
+		std::vector<unsigned int> visible;
+		visible.reserve(n);
+		double ms = BestMs(3, [&]{
+			for (size_t f = 0; f < frames; ++f){
+				visible.clear();
+				bvh.CullFrustum(frustums[f].planes, visible);
+			}
+		});
+		printf("%-8zu %-16s %12.2f\n", n, "bvh", ms * 1000.0 / frames);
+
+		BVHCullCache cache;
+		CullStats stats;
+		ms = BestMs(1, [&]{
+			for (size_t f = 0; f < frames; ++f){
+				visible.clear();
+				bvh.CullFrustumCoherent(frustums[f].planes, visible, cache, &stats);
+			}
+		});
+		printf("%-8zu %-16s %12.2f %11.0f%% %11.0f%%\n", n, "bvh coherent", ms * 1000.0 / frames,
+			100.0 * stats.TestsSkipped() / (stats.objects * 6), 100.0 * stats.cacheHits / stats.objects);
+	}
+	return 0;
+}
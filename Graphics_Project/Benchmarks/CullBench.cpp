@@ -0,0 +1,119 @@
+#include "FrustumCull.h"
+#include "JobSystem.h"
+#include "Bench.h"
+#include "CullScene.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+//	Where CullInstancesParallel starts paying for itself (PARALLEL_CULL_MIN).
+//	Serial and parallel cull of 1k to 4M trees over the camera path for 2 to 8
+//	threads, the fixed cost of a ParallelFor with nothing to do, and how long a
+//	sleeping worker takes to pick up its first chunk. The caller runs chunks
+//	itself meanwhile, so a worker only helps once the work left outlasts its
+//	wake up. Break even on T cores is roughly where
+//	count * nsPerTree * (1 - 1/T) covers two dispatches plus that wake up.
+//	With fewer hardware threads than T the parallel columns only show overhead.
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	const size_t counts[] = { 1024, 4096, 16384, 65536, 262144, 1048576, 4194304 };
+	const unsigned int threadCounts[] = { 2, 4, 8 };
+	size_t countCount = quick ? 3 : 7;
+	size_t frames = quick ? 4 : 60;
+	int reps = quick ? 1 : 3;
+
+	printf("hardware threads: %u\n\n", std::thread::hardware_concurrency());
+
+	JobSystem jobs[3];
+	for (int t = 0; t < 3; ++t)
+		jobs[t].Initialize(threadCounts[t]);
+
+	//	Fixed cost: two ParallelFor calls per cull, with chunks doing nothing
+	double dispatchUs[3];
+	for (int t = 0; t < 3; ++t){
+		const int calls = quick ? 100 : 2000;
+		double ms = BestMs(reps, [&]{
+			for (int c = 0; c < calls; ++c)
+				jobs[t].ParallelFor(threadCounts[t] * 2, 1, [](size_t, size_t, size_t, unsigned int){});
+		});
+		dispatchUs[t] = ms * 1000.0 / calls;
+	}
+	printf("ParallelFor with empty chunks: %.1f us (2 threads) %.1f us (4) %.1f us (8)\n",
+		dispatchUs[0], dispatchUs[1], dispatchUs[2]);
+
+	//	Worker wake up: chunks long enough that the caller can't take them all
+	//	before a worker shows up, median time to the first chunk off thread 0
+	double wakeUs[3];
+	for (int t = 0; t < 3; ++t){
+		const int calls = quick ? 5 : 50;
+		std::vector<double> wakes;
+		for (int c = 0; c < calls; ++c){
+			double start = NowMs();
+			std::atomic<double> first(0.0);
+			jobs[t].ParallelFor(threadCounts[t] * 4, 1, [&](size_t, size_t, size_t, unsigned int thread){
+				double now = NowMs();
+				double none = 0.0;
+				if (thread != 0)
+					first.compare_exchange_strong(none, now);
+				while (NowMs() - now < 0.2) {}
+			});
+			if (first.load() > 0.0)
+				wakes.push_back((first.load() - start) * 1000.0);
+		}
+		std::sort(wakes.begin(), wakes.end());
+		wakeUs[t] = wakes.empty() ? 0.0 : wakes[wakes.size() / 2];
+	}
+	printf("worker wake up (median):       %.1f us (2 threads) %.1f us (4) %.1f us (8)\n\n",
+		wakeUs[0], wakeUs[1], wakeUs[2]);
+
+	printf("%-9s %11s %11s %11s %11s %11s\n", "trees", "serial ms", "ns/tree", "2 thr ms", "4 thr ms", "8 thr ms");
+	double nsPerTree = 0.0;
+	for (size_t c = 0; c < countCount; ++c){
+		size_t n = counts[c];
+		InstanceSoA inst;
+		MakeForest(inst, n);
+		float extent = SceneExtent(n);
+
+		std::vector<CullPlanes> planes(frames);
+		for (size_t f = 0; f < frames; ++f){
+			FLOAT3 eye;
+			float yaw;
+			CameraPath(f * 10, extent, eye, yaw);
+			Frustum frustum;
+			MakeFrustum(eye, yaw, frustum);
+			BuildCullPlanes(frustum.planes, FLOAT3(-0.5f, -0.5f, -0.5f), FLOAT3(0.5f, 0.5f, 0.5f), planes[f]);
+		}
+
+		std::vector<unsigned int> out(n), outParallel(n);
+		size_t visible = 0;
+		double serial = BestMs(reps, [&]{
+			for (size_t f = 0; f < frames; ++f)
+				visible += CullInstances(planes[f], inst, 0, n, &out[0]);
+		}) / frames;
+
+		double parallel[3];
+		for (int t = 0; t < 3; ++t){
+			CullScratch scratch;
+			parallel[t] = BestMs(reps, [&]{
+				for (size_t f = 0; f < frames; ++f)
+					CullInstancesParallel(jobs[t], planes[f], inst, scratch, &outParallel[0]);
+			}) / frames;
+		}
+
+		nsPerTree = serial * 1e6 / n;
+		printf("%-9zu %11.3f %11.2f %11.3f %11.3f %11.3f\n", n, serial, nsPerTree, parallel[0], parallel[1], parallel[2]);
+		if (visible == 0)
+			printf("  (nothing visible)\n");
+	}
+
+	printf("\nbreak even on T real cores, from the largest run's ns/tree:\n");
+	for (int t = 0; t < 3; ++t){
+		double saved = nsPerTree * (1.0 - 1.0 / threadCounts[t]);
+		printf("  %u cores: %.0f trees\n", threadCounts[t], (2.0 * dispatchUs[t] + wakeUs[t]) * 1000.0 / saved);
+	}
+	return 0;
+}
@@ -0,0 +1,73 @@
+#ifndef _CULLSCENE_H_
+#define _CULLSCENE_H_
+
+#include "FrustumCull.h"
+
+#include <cmath>
+#include <cstdlib>
+
+//	The game's forest and camera without D3D, for the culling benchmarks.
+//	Trees scatter like InitScene does (srand(100), 1/10 unit grid), over an
+//	area grown with the count so the density stays what NUMTREES gives.
+
+#define SCENE_TREES			400			//	NUMTREES
+#define SCENE_FOV_DEGREES	72.0f		//	CreateProjectionMatrix(100.0f, 0.1f, 72, aspect)
+#define SCENE_NEAR			0.1f
+#define SCENE_FAR			100.0f
+#define SCENE_ASPECT		(1024.0f / 768.0f)
+
+static float SceneExtent(size_t count){
+	return 100.0f * sqrtf((float)count / SCENE_TREES);
+}
+
+static void MakeForest(InstanceSoA& inst, size_t count){
+	float scale = SceneExtent(count) / 100.0f;
+	srand(100);
+	inst.Clear();
+	inst.Reserve(count);
+	for (size_t i = 0; i < count; ++i){
+		float x = ((float)(rand() % 2000) / 10) * scale - 100 * scale;
+		float z = ((float)(rand() % 2000) / 10) * scale - 100 * scale;
+		inst.Add(FLOAT3(x, 0.0f, z));
+	}
+}
+
+//	Planes in the layout Frustum uses, normals facing in, for an eye at
+//	eye looking along yaw (radians, 0 = +z) with the game's projection
+static void MakeFrustum(FLOAT3 eye, float yaw, Frustum& out){
+	float fx = sinf(yaw), fz = cosf(yaw);			//	forward
+	float rx = fz, rz = -fx;						//	right
+	float th = tanf(SCENE_FOV_DEGREES * 0.5f * 3.14159265f / 180.0f);
+	float tw = th * SCENE_ASPECT;
+
+	FLOAT3 n[6] = {
+		FLOAT3(rx + tw * fx, 0.0f, rz + tw * fz),	//	left
+		FLOAT3(-rx + tw * fx, 0.0f, -rz + tw * fz),	//	right
+		FLOAT3(th * fx, -1.0f, th * fz),			//	top
+		FLOAT3(th * fx, 1.0f, th * fz),				//	bottom
+		FLOAT3(fx, 0.0f, fz),						//	near
+		FLOAT3(-fx, 0.0f, -fz)						//	far
+	};
+	for (int p = 0; p < 6; ++p){
+		float len = sqrtf(n[p].x * n[p].x + n[p].y * n[p].y + n[p].z * n[p].z);
+		out.planes[p] = FLOAT4(n[p].x / len, n[p].y / len, n[p].z / len, 0.0f);
+		out.planes[p].w = -(out.planes[p].x * eye.x + out.planes[p].y * eye.y + out.planes[p].z * eye.z);
+	}
+	out.planes[4].w -= SCENE_NEAR;
+	out.planes[5].w += SCENE_FAR;
+}
+
+//	A fixed walk through the forest at 60 Hz: a slow loop around the middle
+//	at walking pace, looking about as a player does, with a faster turn now
+//	and then. Same frames every run so coherent and flat culls compare.
+static void CameraPath(size_t frame, float extent, FLOAT3& eye, float& yaw){
+	float t = frame / 60.0f;
+	float radius = 0.5f * extent;
+	float angle = t * 4.0f / radius;				//	4 units a second along the loop
+	eye = FLOAT3(radius * sinf(angle), 2.0f, radius * cosf(angle));
+	yaw = angle + 1.5707963f + 0.6f * sinf(t * 0.7f);
+	if (fmodf(t, 5.0f) > 4.5f)						//	half a second turn every 5
+		yaw += (fmodf(t, 5.0f) - 4.5f) * 6.2831853f;
+}
+
+#endif
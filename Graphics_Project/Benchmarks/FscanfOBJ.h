@@ -0,0 +1,106 @@
+#ifndef _FSCANFOBJ_H_
+#define _FSCANFOBJ_H_
+
+#include "Defines.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+//	The fscanf loader main.cpp had before ObjLoader, less the device
+//	parameter it never used, and closing its file and bounding its reads so
+//	it builds clean with -Wall. Triangles written v/vt/vn only, one Vert per
+//	face corner and indices 0..n-1. What ParseOBJ is measured and checked
+//	against.
+
+static bool FscanfLoadOBJ(const char* path, Model* m){
+
+	std::vector<unsigned int> posIndicies, uvIndicies, normIndicies;
+	std::vector<FLOAT3> tmp_Pos;
+	std::vector<FLOAT2> tmp_Uvs;
+	std::vector<FLOAT3> tmp_Norms;
+
+	FILE* file = fopen(path, "r");
+	if (file == NULL){
+		printf("Impossible to open!\n");
+		return false;
+	}
+
+	while (true){
+		char lineHeader[128];
+
+		int res = fscanf(file, "%127s", lineHeader);
+		if (res == EOF)
+			break;
+
+		//	pos
+		if (strcmp(lineHeader, "v") == 0){
+			FLOAT3 f3;
+			if (fscanf(file, "%f %f %f\n", &f3.x, &f3.y, &f3.z) != 3)
+				break;
+			tmp_Pos.push_back(f3);
+		}
+		//	uvs
+		else if (strcmp(lineHeader, "vt") == 0){
+			FLOAT2 uv;
+			if (fscanf(file, "%f %f\n", &uv.u, &uv.v) != 2)
+				break;
+			tmp_Uvs.push_back(uv);
+		}
+		//	normals
+		else if (strcmp(lineHeader, "vn") == 0){
+			FLOAT3 normal;
+			if (fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z) != 3)
+				break;
+			tmp_Norms.push_back(normal);
+		}
+		else if (strcmp(lineHeader, "f") == 0){
+			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
+			int matches = fscanf(file, "%u/%u/%u %u/%u/%u %u/%u/%u\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
+			if (matches != 9){
+				printf("Cannot be read properly!");
+				fclose(file);
+				return false;
+			}
+			posIndicies.push_back(vertexIndex[0]);
+			posIndicies.push_back(vertexIndex[1]);
+			posIndicies.push_back(vertexIndex[2]);
+			uvIndicies.push_back(uvIndex[0]);
+			uvIndicies.push_back(uvIndex[1]);
+			uvIndicies.push_back(uvIndex[2]);
+			normIndicies.push_back(normalIndex[0]);
+			normIndicies.push_back(normalIndex[1]);
+			normIndicies.push_back(normalIndex[2]);
+		}
+	}
+	fclose(file);
+
+	for (unsigned int i = 0; i < posIndicies.size(); ++i){
+		Vert temp;
+		temp.Pos = tmp_Pos[posIndicies[i] - 1];
+		temp.Uvs = tmp_Uvs[uvIndicies[i] - 1];
+		temp.Norms = tmp_Norms[normIndicies[i] - 1];
+		temp.tangent = FLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+
+		m->interleaved.push_back(temp);
+		m->out_Indicies.push_back(i);
+	}
+
+	return true;
+}
+
+//	Corner i of b, through its index buffer, has corner i of a's position, uv
+//	and normal bit for bit
+static bool SameCorners(const Model& a, const Model& b){
+	if (a.out_Indicies.size() != b.out_Indicies.size())
+		return false;
+	for (size_t i = 0; i < a.out_Indicies.size(); ++i){
+		const Vert& x = a.interleaved[a.out_Indicies[i]];
+		const Vert& y = b.interleaved[b.out_Indicies[i]];
+		if (memcmp(&x.Pos, &y.Pos, sizeof(x.Pos)) != 0 || memcmp(&x.Uvs, &y.Uvs, sizeof(x.Uvs)) != 0 || memcmp(&x.Norms, &y.Norms, sizeof(x.Norms)) != 0)
+			return false;
+	}
+	return true;
+}
+
+#endif
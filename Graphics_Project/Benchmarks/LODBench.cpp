@@ -0,0 +1,174 @@
+#include "MeshSimplify.h"
+#include "MeshOptimize.h"
+#include "ObjLoader.h"
+#include "CullScene.h"
+#include "MeshScene.h"
+#include "Bench.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+//	BuildLODChain on Tree.obj and two synthetic meshes: triangles per level,
+//	the error the quadrics estimate against the measured one (furthest
+//	original vertex from the level's surface) and the build time. Then the
+//	forest along CameraPath with the game's SelectLOD settings, triangles
+//	drawn per frame against drawing every tree in full.
+
+#define LOD_PIXEL_ERROR		1.0f		//	TREE_LOD_PIXEL_ERROR
+
+//	Rolling height field with an open border, 2 units across
+static Model Terrain(int size){
+	Model m;
+	for (int z = 0; z <= size; ++z){
+		for (int x = 0; x <= size; ++x){
+			float fx = (float)x / size, fz = (float)z / size;
+			float y = 0.1f * sinf(fx * 9.0f) * cosf(fz * 7.0f) + 0.03f * sinf(fx * 31.0f + fz * 17.0f);
+			m.interleaved.push_back(Vert(fx * 2.0f - 1.0f, y, fz * 2.0f - 1.0f, fx, fz, 0, 1, 0, 0, 0, 0));
+		}
+	}
+	for (int z = 0; z < size; ++z){
+		for (int x = 0; x < size; ++x){
+			unsigned int a = z * (size + 1) + x, b = a + size + 1;
+			unsigned int tris[6] = { a, b, a + 1, a + 1, b, b + 1 };
+			m.out_Indicies.insert(m.out_Indicies.end(), tris, tris + 6);
+		}
+	}
+	return m;
+}
+
+static float PointTriangle(const FLOAT3& p, const FLOAT3& a, const FLOAT3& b, const FLOAT3& c){
+	//	Closest point by region, Ericson's Real-Time Collision Detection 5.1.5
+	FLOAT3 ab(b.x - a.x, b.y - a.y, b.z - a.z), ac(c.x - a.x, c.y - a.y, c.z - a.z), ap(p.x - a.x, p.y - a.y, p.z - a.z);
+	float d1 = ab.x * ap.x + ab.y * ap.y + ab.z * ap.z, d2 = ac.x * ap.x + ac.y * ap.y + ac.z * ap.z;
+	FLOAT3 q;
+	if (d1 <= 0 && d2 <= 0)
+		q = a;
+	else{
+		FLOAT3 bp(p.x - b.x, p.y - b.y, p.z - b.z);
+		float d3 = ab.x * bp.x + ab.y * bp.y + ab.z * bp.z, d4 = ac.x * bp.x + ac.y * bp.y + ac.z * bp.z;
+		FLOAT3 cp(p.x - c.x, p.y - c.y, p.z - c.z);
+		float d5 = ab.x * cp.x + ab.y * cp.y + ab.z * cp.z, d6 = ac.x * cp.x + ac.y * cp.y + ac.z * cp.z;
+		float vc = d1 * d4 - d3 * d2, vb = d5 * d2 - d1 * d6, va = d3 * d6 - d5 * d4;
+		if (d3 >= 0 && d4 <= d3)
+			q = b;
+		else if (d6 >= 0 && d5 <= d6)
+			q = c;
+		else if (vc <= 0 && d1 >= 0 && d3 <= 0){
+			float v = d1 / (d1 - d3);
+			q = FLOAT3(a.x + ab.x * v, a.y + ab.y * v, a.z + ab.z * v);
+		}
+		else if (vb <= 0 && d2 >= 0 && d6 <= 0){
+			float w = d2 / (d2 - d6);
+			q = FLOAT3(a.x + ac.x * w, a.y + ac.y * w, a.z + ac.z * w);
+		}
+		else if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0){
+			float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			q = FLOAT3(b.x + (c.x - b.x) * w, b.y + (c.y - b.y) * w, b.z + (c.z - b.z) * w);
+		}
+		else{
+			float denom = 1.0f / (va + vb + vc);
+			float v = vb * denom, w = vc * denom;
+			q = FLOAT3(a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w);
+		}
+	}
+	FLOAT3 d(p.x - q.x, p.y - q.y, p.z - q.z);
+	return sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+}
+
+//	Furthest used original vertex from the level, brute force
+static float MeasuredError(const Model& m, const unsigned int* level, size_t indexCount){
+	std::vector<bool> used(m.interleaved.size(), false);
+	for (size_t i = 0; i < m.out_Indicies.size(); ++i)
+		used[m.out_Indicies[i]] = true;
+
+	float worst = 0.0f;
+	for (size_t v = 0; v < m.interleaved.size(); ++v){
+		if (!used[v])
+			continue;
+		float best = FLT_MAX;
+		for (size_t t = 0; t + 2 < indexCount && best > worst; t += 3)
+			best = std::min(best, PointTriangle(m.interleaved[v].Pos, m.interleaved[level[t]].Pos,
+				m.interleaved[level[t + 1]].Pos, m.interleaved[level[t + 2]].Pos));
+		worst = std::max(worst, best);
+	}
+	return worst;
+}
+
+static unsigned int Chain(const char* name, const Model& m, std::vector<unsigned int>& lodIndices, MeshLOD* lods){
+	unsigned int count = 0;
+	double ms = BestMs(3, [&]{
+		lodIndices.clear();
+		count = BuildLODChain(m.interleaved.data(), m.interleaved.size(), m.out_Indicies.data(), m.out_Indicies.size(), lodIndices, lods);
+	});
+
+	for (unsigned int l = 0; l < count; ++l){
+		float measured = MeasuredError(m, lodIndices.data() + lods[l].firstIndex, lods[l].indexCount);
+		printf("%-10s %4u %9u %12.4f %12.4f", l ? "" : name, l, lods[l].indexCount / 3, lods[l].error, measured);
+		if (l == 0)
+			printf("   build %.1f ms", ms);
+		printf("\n");
+	}
+	return count;
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+
+	printf("%-10s %4s %9s %12s %12s\n", "mesh", "lod", "tris", "estimated", "measured");
+	std::vector<unsigned int> lodIndices;
+	MeshLOD lods[MESH_MAX_LODS];
+
+	Model sphere = Sphere(quick ? 30 : 60, quick ? 60 : 120);
+	Chain("sphere", sphere, lodIndices, lods);
+	Model terrain = Terrain(quick ? 50 : 100);
+	Chain("terrain", terrain, lodIndices, lods);
+
+	Model tree;
+	if (!LoadOBJFile("Tree.obj", &tree)){
+		printf("Tree.obj missing\n");
+		return 1;
+	}
+	OptimizeModel(&tree);
+	unsigned int treeLods = Chain("Tree.obj", tree, lodIndices, lods);
+
+	//	CreateProjectionMatrix's [1][1] is 1 / tan(fov / 2)
+	float pixelsPerUnit = 0.5f * 768.0f / tanf(SCENE_FOV_DEGREES * 0.5f * 3.14159265f / 180.0f);
+	size_t frames = quick ? 60 : 3600;
+	size_t trees[] = { SCENE_TREES, 10000, 100000 };
+
+	printf("\n%8s %12s %12s %8s  instances per level\n", "trees", "full tris", "LOD tris", "saved");
+	for (int s = 0; s < (quick ? 1 : 3); ++s){
+		InstanceSoA inst;
+		MakeForest(inst, trees[s]);
+		CullPlanes planes;
+		std::vector<unsigned int> visible(inst.Size());
+
+		size_t full = 0, drawn = 0, perLevel[MESH_MAX_LODS] = {};
+		for (size_t f = 0; f < frames; ++f){
+			FLOAT3 eye;
+			float yaw;
+			CameraPath(f, SceneExtent(trees[s]), eye, yaw);
+			Frustum frustum;
+			MakeFrustum(eye, yaw, frustum);
+			BuildCullPlanes(frustum.planes, FLOAT3(-0.5f, -0.5f, -0.5f), FLOAT3(0.5f, 0.5f, 0.5f), planes);
+			size_t count = CullInstances(planes, inst, 0, inst.Size(), visible.data());
+
+			for (size_t i = 0; i < count; ++i){
+				FLOAT3 p = inst.Get(visible[i]);
+				float dx = p.x - eye.x, dy = p.y - eye.y, dz = p.z - eye.z;
+				unsigned int lod = SelectLOD(lods, treeLods, sqrtf(dx * dx + dy * dy + dz * dz), pixelsPerUnit, LOD_PIXEL_ERROR);
+				drawn += lods[lod].indexCount / 3;
+				full += lods[0].indexCount / 3;
+				++perLevel[lod];
+			}
+		}
+		printf("%8zu %12.0f %12.0f %7.1f%% ", trees[s], (double)full / frames, (double)drawn / frames, full ? 100.0 * (full - drawn) / full : 0.0);
+		for (unsigned int l = 0; l < treeLods; ++l)
+			printf(" %8.1f", (double)perLevel[l] / frames);
+		printf("\n");
+	}
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include "MathSIMD.h"
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//	Matrices and vertices per second for each SIMD level, 10k to 1M at a time.
+//	The by-value loop is what MathFunc's Mult_4x4 costs the caller.
+
+static BENCH_NOINLINE MATRIX4X4 ByValueMul(MATRIX4X4 A, MATRIX4X4 B){
+	MATRIX4X4 out;
+	MulBatch(&A, &B, &out, 1);
+	return out;
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	const size_t counts[] = { 10000, 100000, 1000000 };
+	size_t countCount = quick ? 1 : 3;
+	int reps = quick ? 1 : 5;
+	const char* levelNames[] = { "scalar", "SSE2", "AVX" };
+	SIMDLevel detected = DetectSIMDLevel();
+
+	printf("%-10s %-8s %12s %12s %12s %12s\n", "count", "level", "pairs M/s", "one M/s", "aligned M/s", "verts M/s");
+	for (size_t c = 0; c < countCount; ++c){
+		size_t n = counts[c];
+		std::vector<MATRIX4X4> a(n), b(n), out(n);
+		std::vector<SIMDMatrix> sa(n), sout(n);
+		std::vector<FLOAT4> v(n), vout(n);
+		for (size_t i = 0; i < n; ++i){
+			float* fa = &a[i].a;
+			float* fb = &b[i].a;
+			for (int k = 0; k < 16; ++k){
+				fa[k] = (float)rand() / RAND_MAX;
+				fb[k] = (float)rand() / RAND_MAX;
+			}
+			sa[i] = SIMDMatrix(a[i]);
+			v[i] = FLOAT4(fa[0], fa[1], fa[2], 1.0f);
+		}
+		SIMDMatrix sone(b[0]);
+
+		for (int level = SIMD_SCALAR; level <= detected; ++level){
+			SetSIMDLevel((SIMDLevel)level);
+			double pairs = BestMs(reps, [&]{ MulBatch(&a[0], &b[0], &out[0], n); });
+			double one = BestMs(reps, [&]{ MulBatch(&a[0], b[0], &out[0], n); });
+			double aligned = BestMs(reps, [&]{ MulBatch(&sa[0], sone, &sout[0], n); });
+			double verts = BestMs(reps, [&]{ TransformBatch(&v[0], b[0], &vout[0], n); });
+			printf("%-10zu %-8s %12.1f %12.1f %12.1f %12.1f\n", n, levelNames[level],
+				n / pairs / 1e3, n / one / 1e3, n / aligned / 1e3, n / verts / 1e3);
+		}
+
+		SetSIMDLevel(detected);
+		double byValue = BestMs(reps, [&]{
+			for (size_t i = 0; i < n; ++i)
+				out[i] = ByValueMul(a[i], b[i]);
+		});
+		printf("%-10zu %-8s %12.1f   (one call per matrix, by value)\n", n, "single", n / byValue / 1e3);
+	}
+	return 0;
+}
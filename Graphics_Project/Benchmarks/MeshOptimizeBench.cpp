@@ -0,0 +1,107 @@
+#include "MeshOptimize.h"
+#include "ObjLoader.h"
+#include "MeshScene.h"
+#include "Bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//	ACMR and overdraw of the bundled models and two synthetic ones after each
+//	pass, OptimizeModel with and without MESH_OPTIMIZE_OVERDRAW, and the time
+//	OptimizeModel takes on a model split into many sub-meshes against
+//	reordering each sub-mesh in the model's numbering as it used to.
+
+//	Three nested UV spheres, inner first, triangles shuffled in the input
+static Model NestedSpheres(int rings, int segments){
+	Model m;
+	for (int shell = 0; shell < 3; ++shell){
+		Model sphere = Sphere(rings, segments, 1.0f + shell * 0.5f);
+		unsigned int base = (unsigned int)m.interleaved.size();
+		m.interleaved.insert(m.interleaved.end(), sphere.interleaved.begin(), sphere.interleaved.end());
+		for (size_t i = 0; i < sphere.out_Indicies.size(); ++i)
+			m.out_Indicies.push_back(base + sphere.out_Indicies[i]);
+	}
+
+	srand(5);
+	size_t triCount = m.out_Indicies.size() / 3;
+	for (size_t t = triCount - 1; t > 0; --t){
+		size_t o = rand() % (t + 1);
+		std::swap_ranges(&m.out_Indicies[t * 3], &m.out_Indicies[t * 3] + 3, &m.out_Indicies[o * 3]);
+	}
+	return m;
+}
+
+//	A grid of cells, each cell its own sub-mesh
+static Model CellGrid(int size, int cell){
+	Model m;
+	for (int z = 0; z <= size; ++z)
+		for (int x = 0; x <= size; ++x)
+			m.interleaved.push_back(Vert((float)x, 0.0f, (float)z, 0, 0, 0, 1, 0, 0, 0, 0));
+	for (int cz = 0; cz < size; cz += cell){
+		for (int cx = 0; cx < size; cx += cell){
+			SubMesh sub = { (unsigned int)m.out_Indicies.size(), 0, 0, 0 };
+			for (int z = cz; z < cz + cell; ++z){
+				for (int x = cx; x < cx + cell; ++x){
+					unsigned int a = z * (size + 1) + x, b = a + size + 1;
+					unsigned int tris[6] = { a, b, a + 1, a + 1, b, b + 1 };
+					m.out_Indicies.insert(m.out_Indicies.end(), tris, tris + 6);
+				}
+			}
+			sub.indexCount = (unsigned int)m.out_Indicies.size() - sub.firstIndex;
+			m.subMeshes.push_back(sub);
+		}
+	}
+	return m;
+}
+
+static void Report(const char* name, const char* pass, const Model& m){
+	VertexCacheStats cache = AnalyzeVertexCache(m.out_Indicies.data(), m.out_Indicies.size(), m.interleaved.size());
+	OverdrawStats over = AnalyzeOverdraw(m.out_Indicies.data(), m.out_Indicies.size(), m.interleaved.data(), m.interleaved.size());
+	printf("%-14s %-16s %8.3f %10.3f\n", name, pass, cache.acmr, over.overdraw);
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+
+	printf("%-14s %-16s %8s %10s\n", "model", "pass", "ACMR", "overdraw");
+	const char* names[] = { "Tree.obj", "Cube.obj", "spheres" };
+	for (int i = 0; i < 3; ++i){
+		Model input;
+		if (i < 2){
+			if (!LoadOBJFile(names[i], &input)){
+				printf("%-14s missing\n", names[i]);
+				continue;
+			}
+		}
+		else
+			input = NestedSpheres(quick ? 16 : 64, quick ? 32 : 128);
+
+		Model cache = input, both = input;
+		OptimizeModel(&cache);
+		OptimizeModel(&both, MESH_OPTIMIZE_OVERDRAW);
+		Report(names[i], "input", input);
+		Report(names[i], "vertex cache", cache);
+		Report(names[i], "+ overdraw", both);
+	}
+
+	int size = quick ? 128 : 1024;
+	Model grid = CellGrid(size, 16);
+	printf("\n%zu vertices in %zu sub-meshes:\n", grid.interleaved.size(), grid.subMeshes.size());
+
+	Model copy = grid;
+	double local = BestMs(1, [&]{ OptimizeModel(&copy); });
+	Model byLocal = copy;
+	copy = grid;
+	double whole = BestMs(1, [&]{
+		for (size_t s = 0; s < copy.subMeshes.size(); ++s)
+			OptimizeVertexCache(copy.out_Indicies.data() + copy.subMeshes[s].firstIndex, copy.subMeshes[s].indexCount, copy.interleaved.size());
+		OptimizeVertexFetch(&copy);
+	});
+	printf("  OptimizeModel, sub-mesh numbering     %10.1f ms\n", local);
+	printf("  per sub-mesh in the model's numbering %10.1f ms\n", whole);
+	printf("  same index buffer: %s\n", (byLocal.out_Indicies == copy.out_Indicies) ? "yes" : "no");
+	return 0;
+}
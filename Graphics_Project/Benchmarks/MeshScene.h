@@ -0,0 +1,37 @@
+#ifndef _MESHSCENE_H_
+#define _MESHSCENE_H_
+
+#include "Defines.h"
+
+#include <cmath>
+
+//	Synthetic meshes the mesh processing tests and benchmarks share, the way
+//	CullScene.h is shared by the culling ones.
+
+//	UV sphere around the origin, a seam column of duplicated vertices and
+//	rings + 1 rows of them so the poles are degenerate fans. Normals point
+//	out, uv runs 0..1 around and pole to pole, tangents are left 0.
+static Model Sphere(int rings, int segments, float radius = 1.0f){
+	Model m;
+	m.interleaved.reserve((size_t)(rings + 1) * (segments + 1));
+	m.out_Indicies.reserve((size_t)rings * segments * 6);
+	for (int r = 0; r <= rings; ++r){
+		float phi = 3.14159265f * r / rings;
+		for (int s = 0; s <= segments; ++s){
+			float theta = 6.2831853f * s / segments;
+			FLOAT3 n(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+			m.interleaved.push_back(Vert(n.x * radius, n.y * radius, n.z * radius, (float)s / segments, (float)r / rings, n.x, n.y, n.z, 0, 0, 0));
+		}
+	}
+	//	Clockwise seen from outside, D3D's front faces
+	for (int r = 0; r < rings; ++r){
+		for (int s = 0; s < segments; ++s){
+			unsigned int a = r * (segments + 1) + s, b = a + segments + 1;
+			unsigned int tris[6] = { a, a + 1, b, a + 1, b + 1, b };
+			m.out_Indicies.insert(m.out_Indicies.end(), tris, tris + 6);
+		}
+	}
+	return m;
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include "Meshlet.h"
+#include "MeshOptimize.h"
+#include "ObjLoader.h"
+#include "CullScene.h"
+#include "MeshScene.h"
+#include "Bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+//	Triangles MeshletSet::Cull rejects per frame and what the cull costs.
+//	Link and the barrel orbit the camera once over 360 frames, as a model
+//	standing in the scene is walked around. Trees are culled per visible
+//	instance along CameraPath, which is what per meshlet culling would buy
+//	the forest. Every rejected triangle is checked to be back facing or
+//	outside a plane, a wrong one fails the run. Link.obj isn't in the repo,
+//	a 20k triangle sphere stands in for it when it's missing.
+
+struct MeshletModel{
+	Model model;
+	MeshletSet meshlets;
+	std::vector<unsigned int> indices;		//	meshlet order
+	float radius;
+};
+
+static bool Prepare(MeshletModel& out){
+	if (out.model.interleaved.empty())
+		return false;
+	OptimizeModel(&out.model);
+	out.meshlets.Build(out.model.interleaved.data(), out.model.interleaved.size(),
+		out.model.out_Indicies.data(), out.model.out_Indicies.size(), out.indices);
+
+	out.radius = 0.0f;
+	for (size_t i = 0; i < out.model.interleaved.size(); ++i){
+		const FLOAT3& p = out.model.interleaved[i].Pos;
+		out.radius = fmaxf(out.radius, sqrtf(p.x * p.x + p.y * p.y + p.z * p.z));
+	}
+	return true;
+}
+
+static MATRIX4X4 Translation(FLOAT3 pos){
+	return MATRIX4X4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, pos.x, pos.y, pos.z, 1);
+}
+
+//	Triangles of the rejected meshlets that could have been seen
+static size_t WronglyRejected(const MeshletModel& mm, const std::vector<unsigned int>& visible,
+	const FLOAT4* planes, const FLOAT3& eye){
+	size_t wrong = 0, next = 0;
+	const Meshlet* meshlets = mm.meshlets.GetMeshlets();
+	for (size_t i = 0; i < mm.meshlets.GetCount(); ++i){
+		if (next < visible.size() && visible[next] == i){
+			++next;
+			continue;
+		}
+		for (unsigned int t = 0; t < meshlets[i].triangleCount; ++t){
+			const unsigned int* tri = &mm.indices[meshlets[i].firstIndex + t * 3];
+			FLOAT3 a = mm.model.interleaved[tri[0]].Pos, b = mm.model.interleaved[tri[1]].Pos, c = mm.model.interleaved[tri[2]].Pos;
+
+			bool outside = false;
+			for (int p = 0; p < 6 && !outside; ++p){
+				const FLOAT4& pl = planes[p];
+				outside = pl.x * a.x + pl.y * a.y + pl.z * a.z + pl.w < 0.0f
+					&& pl.x * b.x + pl.y * b.y + pl.z * b.z + pl.w < 0.0f
+					&& pl.x * c.x + pl.y * c.y + pl.z * c.z + pl.w < 0.0f;
+			}
+
+			FLOAT3 e1(b.x - a.x, b.y - a.y, b.z - a.z), e2(c.x - a.x, c.y - a.y, c.z - a.z);
+			FLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+			float facing = (a.x - eye.x) * n.x + (a.y - eye.y) * n.y + (a.z - eye.z) * n.z;
+			float scale = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z) * 1e-4f;
+			if (!outside && facing < -scale)
+				++wrong;
+		}
+	}
+	return wrong;
+}
+
+//	Camera circling the model at 3 radii, a little above it, looking at it
+static size_t Orbit(const char* name, const MeshletModel& mm, size_t frames){
+	std::vector<unsigned int> visible;
+	visible.reserve(mm.meshlets.GetCount());
+	size_t triangles = mm.indices.size() / 3;
+	size_t rejected = 0, draws = 0, wrong = 0;
+	double cullMs = 0.0;
+
+	for (size_t f = 0; f < frames; ++f){
+		float angle = 6.2831853f * f / frames;
+		float dist = 3.0f * mm.radius;
+		FLOAT3 eye(dist * sinf(angle), 0.3f * mm.radius, dist * cosf(angle));
+		Frustum frustum;
+		MakeFrustum(eye, angle + 3.14159265f, frustum);
+
+		visible.clear();
+		double start = NowMs();
+		rejected += mm.meshlets.Cull(frustum.planes, eye, visible);
+		cullMs += NowMs() - start;
+
+		for (size_t i = 0; i < visible.size(); ++i)
+			if (i == 0 || visible[i] != visible[i - 1] + 1)
+				++draws;
+		wrong += WronglyRejected(mm, visible, frustum.planes, eye);
+	}
+
+	printf("%-10s %8zu %9zu %12.1f %8.1f%% %8.1f %9.2f\n", name, triangles, mm.meshlets.GetCount(),
+		(double)rejected / frames, 100.0 * rejected / ((double)triangles * frames), (double)draws / frames, 1000.0 * cullMs / frames);
+	if (wrong)
+		printf("  %zu visible triangles rejected\n", wrong);
+	return wrong;
+}
+
+//	Every tree in the frustum culled as its own instance, trees are only
+//	moved so the local eye and planes are a translation away
+static size_t Forest(const MeshletModel& mm, size_t frames){
+	InstanceSoA inst;
+	MakeForest(inst, SCENE_TREES);
+	std::vector<unsigned int> visible;
+	visible.reserve(mm.meshlets.GetCount());
+
+	size_t triangles = mm.indices.size() / 3;
+	size_t drawn = 0, rejected = 0, wrong = 0;
+	double cullMs = 0.0;
+
+	for (size_t f = 0; f < frames; ++f){
+		FLOAT3 eye;
+		float yaw;
+		CameraPath(f, SceneExtent(SCENE_TREES), eye, yaw);
+		Frustum frustum;
+		MakeFrustum(eye, yaw, frustum);
+
+		for (size_t t = 0; t < inst.Size(); ++t){
+			FLOAT3 pos = inst.Get(t);
+			FLOAT4 local[6];
+			FrustumToLocal(frustum.planes, Translation(pos), local);
+			FLOAT3 localEye(eye.x - pos.x, eye.y - pos.y, eye.z - pos.z);
+
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; ++p)
+				inside = local[p].w >= -mm.radius;
+			if (!inside)
+				continue;
+
+			visible.clear();
+			double start = NowMs();
+			rejected += mm.meshlets.Cull(local, localEye, visible);
+			cullMs += NowMs() - start;
+			drawn += triangles;
+			if (f % 30 == 0)
+				wrong += WronglyRejected(mm, visible, local, localEye);
+		}
+	}
+
+	printf("%-10s %8zu %9zu %12.1f %8.1f%% %8s %9.2f   (trees in view, per frame)\n", "forest", (size_t)(drawn / frames), mm.meshlets.GetCount(),
+		(double)rejected / frames, drawn ? 100.0 * rejected / drawn : 0.0, "-", 1000.0 * cullMs / frames);
+	if (wrong)
+		printf("  %zu visible triangles rejected\n", wrong);
+	return wrong;
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	size_t frames = quick ? 36 : 360;
+	size_t wrong = 0;
+
+	printf("%-10s %8s %9s %12s %9s %8s %9s\n", "model", "tris", "meshlets", "rejected", "", "draws", "us/frame");
+
+	MeshletModel link;
+	if (!LoadOBJFile("Link.obj", &link.model)){
+		printf("Link.obj missing, 20k triangle sphere instead\n");
+		link.model = Sphere(100, 100);
+	}
+	if (Prepare(link))
+		wrong += Orbit("Link", link, frames);
+
+	MeshletModel barrel;
+	if (LoadOBJFile("Barrel.obj", &barrel.model) && Prepare(barrel))
+		wrong += Orbit("Barrel", barrel, frames);
+
+	MeshletModel tree;
+	if (LoadOBJFile("Tree.obj", &tree.model) && Prepare(tree)){
+		wrong += Orbit("Tree", tree, frames);
+		wrong += Forest(tree, quick ? 60 : 600);
+	}
+	else
+		printf("Tree.obj missing\n");
+
+	return wrong ? 1 : 0;
+}
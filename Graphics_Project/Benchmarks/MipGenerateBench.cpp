@@ -0,0 +1,84 @@
+#include "MipGenerate.h"
+#include "JobSystem.h"
+#include "MathSIMD.h"
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+//	Mip generation at 2048 x 2048, box and Kaiser, scalar, SSE2 and SSE2
+//	over the job system. DownsampleLevel alone takes the float top to the
+//	next level, GenerateMipChain is the whole import step on an sRGB file
+//	tiled from _grass (decode, every level, encode). The scalar and SSE2
+//	chains have to come out byte for byte the same or the run fails.
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	size_t size = quick ? 256 : 2048;
+	int reps = quick ? 1 : 3;
+
+	DDSFile grass;
+	if (!grass.Open("../Assets/_grass.dds")){
+		printf("Can't read ../Assets/_grass.dds\n");
+		return 1;
+	}
+	const DDSSubresource& top = grass.GetSubresource(0, 0);
+
+	DDSInfo info;
+	memset(&info, 0, sizeof(info));
+	info.width = info.height = size;
+	info.depth = 1;
+	info.mipCount = 1;
+	info.arraySize = 1;
+	info.format = DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+	info.dimension = DDS_DIMENSION_TEXTURE2D;
+	std::vector<uint8_t> bytes;
+	WriteDDSHeader(info, bytes);
+	std::vector<float> level(size * size * 4), next((size / 2) * (size / 2) * 4);
+	for (size_t y = 0; y < size; ++y){
+		for (size_t x = 0; x < size; ++x){
+			const uint8_t* t = top.data + (y % top.height) * top.rowPitch + (x % top.width) * 4;
+			bytes.insert(bytes.end(), t, t + 4);
+			for (int c = 0; c < 4; ++c)
+				level[(y * size + x) * 4 + c] = t[c] / 255.0f;
+		}
+	}
+	DDSFile src;
+	if (!src.Parse(&bytes[0], bytes.size()))
+		return 1;
+
+	SIMDLevel detected = DetectSIMDLevel();
+	SIMDLevel sse2 = detected >= SIMD_SSE2 ? SIMD_SSE2 : detected;
+	JobSystem jobs;
+	jobs.Initialize();
+
+	const MipFilter filters[] = { MIP_FILTER_BOX, MIP_FILTER_KAISER };
+	const char* names[] = { "box", "kaiser" };
+	printf("%zu x %zu, %u threads, ms\n%-8s %-10s %9s %9s %9s\n", size, size, jobs.GetNumThreads(), "filter", "", "scalar", "SSE2", "jobs");
+	for (int f = 0; f < 2; ++f){
+		SetSIMDLevel(SIMD_SCALAR);
+		double levelScalar = BestMs(reps, [&]{ DownsampleLevel(&level[0], size, size, &next[0], filters[f], MIP_SRGB | MIP_WRAP); });
+		SetSIMDLevel(sse2);
+		double levelSIMD = BestMs(reps, [&]{ DownsampleLevel(&level[0], size, size, &next[0], filters[f], MIP_SRGB | MIP_WRAP); });
+		double levelJobs = BestMs(reps, [&]{ DownsampleLevel(&level[0], size, size, &next[0], filters[f], MIP_SRGB | MIP_WRAP, &jobs); });
+
+		std::vector<uint8_t> scalar, simd, threaded;
+		SetSIMDLevel(SIMD_SCALAR);
+		double chainScalar = BestMs(reps, [&]{ GenerateMipChain(src, scalar, filters[f], MIP_WRAP); });
+		SetSIMDLevel(sse2);
+		double chainSIMD = BestMs(reps, [&]{ GenerateMipChain(src, simd, filters[f], MIP_WRAP); });
+		double chainJobs = BestMs(reps, [&]{ GenerateMipChain(src, threaded, filters[f], MIP_WRAP, &jobs); });
+		SetSIMDLevel(detected);
+
+		if (simd != scalar || threaded != scalar){
+			printf("%s: SSE2 or threaded chain differs from scalar\n", names[f]);
+			return 1;
+		}
+		printf("%-8s %-10s %9.2f %9.2f %9.2f\n", names[f], "one level", levelScalar, levelSIMD, levelJobs);
+		printf("%-8s %-10s %9.2f %9.2f %9.2f\n", names[f], "chain", chainScalar, chainSIMD, chainJobs);
+	}
+
+	jobs.Shutdown();
+	return 0;
+}
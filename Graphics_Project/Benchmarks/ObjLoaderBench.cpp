@@ -0,0 +1,67 @@
+#include "ObjLoader.h"
+#include "JobSystem.h"
+#include "Bench.h"
+#include "FscanfOBJ.h"
+#include "ObjScene.h"
+
+#include <cstdio>
+#include <string>
+
+//	LoadOBJFile against the fscanf loader it replaced, on Tree.obj and on a
+//	generated grid (ObjScene.h) of about 210 MB. Both have to read the same
+//	corners. The target was 10x over the old loader.
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	int reps = quick ? 1 : 3;
+
+	std::string gridPath = std::string(P_tmpdir) + "/ObjLoaderBench.obj";
+	size_t gridBytes = WriteGridOBJ(gridPath.c_str(), quick ? 100 : 1000);
+	if (!gridBytes){
+		printf("Can't write %s\n", gridPath.c_str());
+		return 1;
+	}
+
+	JobSystem jobs;
+	jobs.Initialize();
+
+	const char* names[] = { "Tree.obj", "grid" };
+	const char* paths[] = { "Tree.obj", gridPath.c_str() };
+	printf("%-10s %9s %9s %10s %10s %10s %8s %8s\n", "file", "MB", "corners", "fscanf ms", "mapped ms", "jobs ms", "speedup", "w/ jobs");
+	for (int p = 0; p < 2; ++p){
+		Model old, loaded, threaded;
+		double oldMs = BestMs(reps, [&]{
+			old = Model();
+			FscanfLoadOBJ(paths[p], &old);
+		});
+		double loadMs = BestMs(reps, [&]{
+			loaded = Model();
+			LoadOBJFile(paths[p], &loaded);
+		});
+		double jobsMs = BestMs(reps, [&]{
+			threaded = Model();
+			LoadOBJFile(paths[p], &threaded, &jobs);
+		});
+
+		if (old.out_Indicies.empty() || !SameCorners(old, loaded) || !SameCorners(old, threaded)){
+			printf("%s: LoadOBJFile corners differ from the fscanf loader\n", names[p]);
+			remove(gridPath.c_str());
+			return 1;
+		}
+
+		FILE* f = fopen(paths[p], "rb");
+		long size = 0;
+		if (f){
+			fseek(f, 0, SEEK_END);
+			size = ftell(f);
+			fclose(f);
+		}
+		printf("%-10s %9.1f %9zu %10.1f %10.1f %10.1f %7.1fx %7.1fx\n", names[p], size / 1048576.0, old.out_Indicies.size(),
+			oldMs, loadMs, jobsMs, oldMs / loadMs, oldMs / jobsMs);
+	}
+	printf("%u job threads\n", jobs.GetNumThreads());
+
+	jobs.Shutdown();
+	remove(gridPath.c_str());
+	return 0;
+}
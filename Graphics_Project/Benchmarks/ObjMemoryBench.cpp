@@ -0,0 +1,171 @@
+#include "ObjLoader.h"
+#include "Bench.h"
+#include "ObjScene.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//	Peak resident memory of LoadOBJFile against StreamOBJ on generated grid
+//	files of 256 MB, 1 GB and 2 GB. Each load runs in its own child process,
+//	and its peak RSS is the child's ru_maxrss from wait4. That counts the
+//	mapped text the loader touched as well as what it allocated. LoadOBJFile
+//	runs under an address space limit of 80% of MemAvailable. When it hits
+//	the limit the row shows how far it got instead of letting the OOM killer
+//	in. StreamOBJ hands its blocks to a sink that only checks and counts them,
+//	the way an offline converter would write them out.
+//	--quick runs one 20 MB file so ctest can smoke run it.
+
+#define STREAM_BUDGET		(640u << 20)
+
+//	Counts what StreamOBJ hands over, every index has to point at a vertex
+//	that already arrived
+class CountingSink : public ObjSink {
+
+public:
+	size_t vertices, indices;
+	bool inRange;
+
+	CountingSink() : vertices(0), indices(0), inRange(true){}
+
+	bool Vertices(const Vert*, size_t count) override {
+		vertices += count;
+		return true;
+	}
+	bool Indices(const unsigned int* list, size_t count) override {
+		for (size_t i = 0; i < count; ++i)
+			inRange = inRange && list[i] < vertices;
+		indices += count;
+		return true;
+	}
+	bool Finish(const std::vector<SubMesh>&, const std::vector<std::string>&, const std::vector<std::string>&, const std::string&) override {
+		return true;
+	}
+};
+
+struct LoadResult{
+	bool ok;
+	double ms;
+	size_t indices;
+	unsigned int tableResets;
+	size_t peakMB;
+};
+
+//	MemAvailable from /proc/meminfo in bytes, 0 if it can't be read
+static size_t AvailableBytes(){
+	FILE* f = fopen("/proc/meminfo", "r");
+	if (!f)
+		return 0;
+	char line[256];
+	size_t kb = 0;
+	while (fgets(line, sizeof(line), f))
+		if (sscanf(line, "MemAvailable: %zu kB", &kb) == 1)
+			break;
+	fclose(f);
+	return kb * 1024;
+}
+
+//	Runs load(result) in a child. limit caps the child's address space, 0 for none.
+template <typename Fn>
+static LoadResult RunInChild(size_t limit, const Fn& load){
+	LoadResult result = { false, 0.0, 0, 0, 0 };
+	int pipeFds[2];
+	if (pipe(pipeFds) != 0)
+		return result;
+
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0){
+		close(pipeFds[0]);
+		if (limit){
+			rlimit rl;
+			rl.rlim_cur = rl.rlim_max = limit;
+			setrlimit(RLIMIT_AS, &rl);
+		}
+		LoadResult child = { false, 0.0, 0, 0, 0 };
+		try {
+			double start = NowMs();
+			child.ok = load(child);
+			child.ms = NowMs() - start;
+		}
+		catch (...){
+			child.ok = false;
+		}
+		if (write(pipeFds[1], &child, sizeof(child)) != (ssize_t)sizeof(child))
+			_exit(2);
+		_exit(0);
+	}
+
+	close(pipeFds[1]);
+	if (pid > 0){
+		LoadResult child;
+		bool reported = read(pipeFds[0], &child, sizeof(child)) == (ssize_t)sizeof(child);
+		int status = 0;
+		rusage usage;
+		memset(&usage, 0, sizeof(usage));
+		wait4(pid, &status, 0, &usage);
+		if (reported)
+			result = child;
+		result.peakMB = (size_t)usage.ru_maxrss / 1024;
+	}
+	close(pipeFds[0]);
+	return result;
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	const size_t targetMB[] = { 256, 1024, 2048 };
+	size_t fileCount = quick ? 1 : 3;
+	size_t limit = AvailableBytes() / 10 * 8;
+
+	std::string path = std::string(P_tmpdir) + "/ObjMemoryBench.obj";
+	printf("LoadOBJFile address space limit %zu MB, StreamOBJ budget %u MB\n", limit >> 20, STREAM_BUDGET >> 20);
+	printf("%-9s %10s %12s %10s %12s %10s %8s\n", "file MB", "corners", "load peak MB", "load ms", "stream peak", "stream ms", "resets");
+	for (size_t f = 0; f < fileCount; ++f){
+		size_t bytes = quick ? (20u << 20) : (targetMB[f] << 20);
+		int size = (int)sqrt((double)bytes / OBJ_GRID_BYTES_PER_QUAD);
+		size_t written = WriteGridOBJ(path.c_str(), size);
+		if (!written){
+			printf("Can't write %s\n", path.c_str());
+			remove(path.c_str());
+			return 1;
+		}
+
+		LoadResult load = RunInChild(limit, [&](LoadResult& r){
+			Model model;
+			if (!LoadOBJFile(path.c_str(), &model))
+				return false;
+			r.indices = model.out_Indicies.size();
+			return true;
+		});
+
+		LoadResult stream = RunInChild(0, [&](LoadResult& r){
+			CountingSink sink;
+			ObjStreamStats stats;
+			bool ok = StreamOBJ(path.c_str(), &sink, STREAM_BUDGET, &stats) && sink.inRange;
+			r.indices = sink.indices;
+			r.tableResets = stats.tableResets;
+			return ok;
+		});
+		remove(path.c_str());
+
+		size_t corners = (size_t)size * size * 6;
+		if (!stream.ok || stream.indices != corners || (load.ok && load.indices != corners)){
+			printf("%zu MB: StreamOBJ %s with %zu corners, LoadOBJFile %zu, expected %zu\n", written >> 20,
+				stream.ok ? "finished" : "failed", stream.indices, load.indices, corners);
+			return 1;
+		}
+
+		char loadPeak[32], loadMs[32];
+		snprintf(loadPeak, sizeof(loadPeak), load.ok ? "%zu" : "> %zu", load.peakMB);
+		snprintf(loadMs, sizeof(loadMs), load.ok ? "%.0f" : "failed", load.ms);
+		printf("%-9zu %10zu %12s %10s %12zu %10.0f %8u\n", written >> 20, corners, loadPeak, loadMs,
+			stream.peakMB, stream.ms, stream.tableResets);
+	}
+	return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef _OBJSCENE_H_
+#define _OBJSCENE_H_
+
+#include <cstdio>
+
+//	Generated OBJ files for the loader benchmarks, written the way Blender
+//	exports them: six decimals, every corner its own v/vt/vn, triangles.
+//	A size x size grid comes to about 212 bytes per quad.
+
+#define OBJ_GRID_BYTES_PER_QUAD		212
+
+//	size x size quads as two triangles each, returns the bytes written or 0
+static size_t WriteGridOBJ(const char* path, int size){
+	FILE* f = fopen(path, "wb");
+	if (!f)
+		return 0;
+	size_t bytes = 0;
+	for (int z = 0; z <= size; ++z){
+		for (int x = 0; x <= size; ++x){
+			float h = (float)((x * 7 + z * 13) % 29) * 0.0137f;
+			bytes += fprintf(f, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", x * 0.25f - 50.0f, h, z * 0.25f - 50.0f,
+				(float)x / size, (float)z / size, h * 0.1f, 0.994987f, -h * 0.1f);
+		}
+	}
+	int row = size + 1;
+	for (int z = 0; z < size; ++z){
+		for (int x = 0; x < size; ++x){
+			int v = z * row + x + 1;
+			bytes += fprintf(f, "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n", v, v, v, v + row + 1, v + row + 1, v + row + 1, v + 1, v + 1, v + 1,
+				v, v, v, v + row, v + row, v + row, v + row + 1, v + row + 1, v + row + 1);
+		}
+	}
+	if (fclose(f) != 0)
+		return 0;
+	return bytes;
+}
+
+#endif
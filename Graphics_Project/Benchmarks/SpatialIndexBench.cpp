@@ -0,0 +1,157 @@
+#include "LooseOctree.h"
+#include "HashGrid.h"
+#include "Bench.h"
+#include "CullScene.h"
+
+#include <cstdio>
+#include <vector>
+
+//	Frustum queries on LooseOctree and HashGrid against the flat cull
+//	cullAABB does without a BVH (CullInstances), as the forest gets denser.
+//	The world stays the game's 200 x 200 and the srand(100) scatter is
+//	squeezed into it, from NUMTREES up to 10000 times as many. Queries
+//	average a stretch of the camera path. A second table does the same for a
+//	light sized sphere around the eye, where the flat path has to scan too.
+
+#define LIGHT_RADIUS	10.0f
+
+struct SphereRow{
+	size_t n, found;
+	double flat, octree, grid;
+};
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	const size_t counts[] = { 400, 4000, 40000, 400000, 4000000 };
+	size_t countCount = quick ? 2 : 5;
+	size_t frames = quick ? 4 : 30;
+	const float extent = SceneExtent(SCENE_TREES);
+	const FLOAT3 treeMin(-0.5f, -0.5f, -0.5f), treeMax(0.5f, 0.5f, 0.5f);
+
+	std::vector<Frustum> frustums(frames);
+	std::vector<CullPlanes> planes(frames);
+	for (size_t f = 0; f < frames; ++f){
+		FLOAT3 eye;
+		float yaw;
+		CameraPath(f, extent, eye, yaw);
+		MakeFrustum(eye, yaw, frustums[f]);
+		BuildCullPlanes(frustums[f].planes, treeMin, treeMax, planes[f]);
+	}
+
+	std::vector<SphereRow> sphereRows;
+	printf("%-9s %9s %9s %9s %9s %9s %9s %9s %9s\n", "trees", "per 100m2", "visible",
+		"flat ms", "oct bld", "oct ms", "grid bld", "grid ms", "fastest");
+	for (size_t c = 0; c < countCount; ++c){
+		size_t n = counts[c];
+		int reps = (quick || n >= 1000000) ? 1 : 3;
+
+		InstanceSoA inst;
+		MakeForest(inst, n);
+		float squeeze = extent / SceneExtent(n);
+		for (size_t i = 0; i < n; ++i){
+			inst.x[i] *= squeeze;
+			inst.z[i] *= squeeze;
+		}
+
+		std::vector<unsigned int> flatOut(n);
+		size_t visible = 0;
+		double flat = BestMs(reps, [&]{
+			visible = 0;
+			for (size_t f = 0; f < frames; ++f)
+				visible += CullInstances(planes[f], inst, 0, n, &flatOut[0]);
+		}) / frames;
+
+		LooseOctree octree;
+		HashGrid grid;
+		double octreeBuild = BestMs(reps, [&]{
+			octree.Clear();
+			for (size_t i = 0; i < n; ++i)
+				octree.Insert((unsigned int)i, AABB(FLOAT3(inst.x[i] + treeMin.x, inst.y[i] + treeMin.y, inst.z[i] + treeMin.z),
+					FLOAT3(inst.x[i] + treeMax.x, inst.y[i] + treeMax.y, inst.z[i] + treeMax.z)));
+		});
+		double gridBuild = BestMs(reps, [&]{
+			grid.Clear();
+			for (size_t i = 0; i < n; ++i)
+				grid.Insert((unsigned int)i, AABB(FLOAT3(inst.x[i] + treeMin.x, inst.y[i] + treeMin.y, inst.z[i] + treeMin.z),
+					FLOAT3(inst.x[i] + treeMax.x, inst.y[i] + treeMax.y, inst.z[i] + treeMax.z)));
+		});
+
+		std::vector<unsigned int> out;
+		out.reserve(n);
+		size_t octreeVisible = 0, gridVisible = 0;
+		double octreeMs = BestMs(reps, [&]{
+			octreeVisible = 0;
+			for (size_t f = 0; f < frames; ++f){
+				out.clear();
+				octree.QueryFrustum(frustums[f].planes, out);
+				octreeVisible += out.size();
+			}
+		}) / frames;
+		double gridMs = BestMs(reps, [&]{
+			gridVisible = 0;
+			for (size_t f = 0; f < frames; ++f){
+				out.clear();
+				grid.QueryFrustum(frustums[f].planes, out);
+				gridVisible += out.size();
+			}
+		}) / frames;
+
+		//	The octree runs the same box test, the grid may only drop corner cases
+		if (octreeVisible != visible || gridVisible > visible){
+			printf("%zu trees: octree found %zu, grid %zu, flat %zu\n", n, octreeVisible, gridVisible, visible);
+			return 1;
+		}
+
+		const char* fastest = (octreeMs < flat && octreeMs < gridMs) ? "octree" : (gridMs < flat ? "grid" : "flat");
+		printf("%-9zu %9.1f %9zu %9.3f %9.2f %9.3f %9.2f %9.3f %9s\n", n, n * 100.0f / (extent * extent * 4.0f),
+			visible / frames, flat, octreeBuild, octreeMs, gridBuild, gridMs, fastest);
+
+		//	Sphere around each frame's eye, the flat version tests every box
+		SphereRow row;
+		row.n = n;
+		std::vector<FLOAT3> eyes(frames);
+		for (size_t f = 0; f < frames; ++f){
+			float yaw;
+			CameraPath(f, extent, eyes[f], yaw);
+		}
+		size_t flatFound = 0, octreeFound = 0, gridFound = 0;
+		row.flat = BestMs(reps, [&]{
+			flatFound = 0;
+			for (size_t f = 0; f < frames; ++f)
+				for (size_t i = 0; i < n; ++i)
+					if (SphereOverlapsAABB(eyes[f], LIGHT_RADIUS, AABB(FLOAT3(inst.x[i] + treeMin.x, inst.y[i] + treeMin.y, inst.z[i] + treeMin.z),
+						FLOAT3(inst.x[i] + treeMax.x, inst.y[i] + treeMax.y, inst.z[i] + treeMax.z))))
+						++flatFound;
+		}) / frames;
+		row.octree = BestMs(reps, [&]{
+			octreeFound = 0;
+			for (size_t f = 0; f < frames; ++f){
+				out.clear();
+				octree.QuerySphere(eyes[f], LIGHT_RADIUS, out);
+				octreeFound += out.size();
+			}
+		}) / frames;
+		row.grid = BestMs(reps, [&]{
+			gridFound = 0;
+			for (size_t f = 0; f < frames; ++f){
+				out.clear();
+				grid.QuerySphere(eyes[f], LIGHT_RADIUS, out);
+				gridFound += out.size();
+			}
+		}) / frames;
+		if (octreeFound != flatFound || gridFound != flatFound){
+			printf("%zu trees: sphere found %zu octree, %zu grid, %zu flat\n", n, octreeFound, gridFound, flatFound);
+			return 1;
+		}
+		row.found = flatFound / frames;
+		sphereRows.push_back(row);
+	}
+
+	printf("\n%-9s %9s %9s %9s %9s %9s\n", "trees", "in sphere", "flat ms", "oct ms", "grid ms", "fastest");
+	for (size_t r = 0; r < sphereRows.size(); ++r){
+		const SphereRow& row = sphereRows[r];
+		const char* fastest = (row.octree < row.flat && row.octree < row.grid) ? "octree" : (row.grid < row.flat ? "grid" : "flat");
+		printf("%-9zu %9zu %9.3f %9.3f %9.3f %9s\n", row.n, row.found, row.flat, row.octree, row.grid, fastest);
+	}
+	return 0;
+}
@@ -0,0 +1,50 @@
+#include "TangentSpace.h"
+#include "JobSystem.h"
+#include "MeshScene.h"
+#include "Bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+//	GenerateTangents on a 2M triangle UV sphere, serially and across the job
+//	system. Each run starts from a fresh copy, the copy isn't timed.
+
+static double Time(const Model& source, JobSystem* jobs, int reps){
+	double best = 1e30;
+	for (int r = 0; r < reps; ++r){
+		Model m = source;
+		double start = NowMs();
+		GenerateTangents(&m, jobs);
+		double ms = NowMs() - start;
+		if (ms < best)
+			best = ms;
+	}
+	return best;
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	int size = quick ? 200 : 1024;
+	int reps = quick ? 1 : 5;
+
+	Model sphere = Sphere(size, size);
+	size_t tris = sphere.out_Indicies.size() / 3;
+	printf("%zu triangles, %zu vertices, %u hardware threads\n", tris, sphere.interleaved.size(), std::thread::hardware_concurrency());
+
+	double serial = Time(sphere, nullptr, reps);
+	printf("%-10s %10.1f ms %8.2f Mtri/s\n", "serial", serial, tris / serial / 1000.0);
+
+	unsigned int counts[] = { 1, 2, 4, 8 };
+	for (unsigned int c : counts){
+		JobSystem jobs;
+		jobs.Initialize(c);
+		double ms = Time(sphere, &jobs, reps);
+		jobs.Shutdown();
+		char label[16];
+		snprintf(label, sizeof(label), "%u thread%s", c, c == 1 ? "" : "s");
+		printf("%-10s %10.1f ms %8.2f Mtri/s %6.2fx\n", label, ms, tris / ms / 1000.0, serial / ms);
+	}
+	return 0;
+}
@@ -0,0 +1,185 @@
+#include "TextureStreamer.h"
+#include "Bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+//	TextureStreamer scheduling on the headless backend, against files
+//	written to P_tmpdir first (RGBA8, full chains, bytes unique per texture
+//	and mip). Three runs:
+//	  sync: every file opened and uploaded whole, what the render thread
+//	    blocked for before streaming
+//	  stream: everything requested with random priorities, Update every
+//	    frame until idle. How long Request blocks, the worst Update, when
+//	    each texture is whole and how often a higher priority one got
+//	    there no later than a lower one
+//	  budget: 60% of the total as the residency budget, half the textures
+//	    touched every frame. The touched ones must end whole, the peak must
+//	    stay within budget
+//	Uploaded bytes are compared with the files, a mismatch fails the run.
+
+#define FRAME_MS		2				//	render thread sleep between Updates
+
+static std::string TexturePath(int t){
+	return std::string(P_tmpdir) + "/TextureStreamBench" + std::to_string(t) + ".dds";
+}
+
+static size_t WriteTextures(int count, size_t size){
+	size_t total = 0;
+	for (int t = 0; t < count; ++t){
+		DDSInfo info;
+		memset(&info, 0, sizeof(info));
+		info.width = info.height = size;
+		info.depth = 1;
+		info.arraySize = 1;
+		info.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		info.dimension = DDS_DIMENSION_TEXTURE2D;
+		for (size_t s = size; s; s >>= 1)
+			++info.mipCount;
+
+		std::vector<uint8_t> bytes;
+		WriteDDSHeader(info, bytes);
+		size_t header = bytes.size();
+		for (size_t mip = 0; mip < info.mipCount; ++mip){
+			size_t side = std::max<size_t>(1, size >> mip);
+			bytes.resize(bytes.size() + side * side * 4, (uint8_t)(mip * 16 + t));
+		}
+		total += bytes.size() - header;
+		SaveDDSFile(TexturePath(t).c_str(), bytes);
+	}
+	return total;
+}
+
+//	Subresources of id that differ from the file, only for whole textures
+static size_t Mismatches(const HeadlessTextureBackend& backend, TextureId id, int t){
+	if (backend.GetResidentMip(id) != 0)
+		return 0;
+	DDSFile file;
+	if (!file.Open(TexturePath(t).c_str()))
+		return 1;
+	size_t bad = 0;
+	for (size_t s = 0; s < file.GetSubresourceCount(); ++s){
+		const DDSSubresource& sub = file.GetSubresources()[s];
+		if (memcmp(backend.GetData(id, s), sub.data, sub.size) != 0)
+			++bad;
+	}
+	return bad;
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	int count = quick ? 8 : 48;
+	size_t size = quick ? 256 : 1024;
+	size_t total = WriteTextures(count, size);
+	printf("%d textures of %zux%zu RGBA8, %.1f MB with mips, %u I/O threads\n", count, size, size, total / 1048576.0, TEXTURE_IO_THREADS);
+
+	size_t bad = 0;
+	{
+		double start = NowMs();
+		HeadlessTextureBackend backend;
+		std::vector<std::unique_ptr<DDSFile>> files;
+		for (int t = 0; t < count; ++t){
+			files.push_back(std::unique_ptr<DDSFile>(new DDSFile));
+			files.back()->Open(TexturePath(t).c_str());
+			backend.Create((TextureId)t, *files.back(), 0, 0);
+		}
+		printf("\nsync:   render thread blocked %.1f ms\n", NowMs() - start);
+	}
+
+	std::mt19937 rng(3);
+	std::vector<float> priority(count);
+	for (int t = 0; t < count; ++t)
+		priority[t] = (float)(rng() % 1000 + 1);
+
+	{
+		HeadlessTextureBackend backend;
+		TextureStreamer streamer;
+		streamer.Initialize(&backend);
+		streamer.SetBudget(total * 2);
+
+		double start = NowMs();
+		std::vector<TextureId> ids;
+		for (int t = 0; t < count; ++t)
+			ids.push_back(streamer.Request(TexturePath(t).c_str(), priority[t]));
+		double blocked = NowMs() - start;
+
+		std::vector<double> whole(count, -1.0);
+		double worstUpdate = 0.0;
+		int frames = 0;
+		for (bool idle = false; !idle; ++frames){
+			idle = streamer.IsIdle();
+			double before = NowMs();
+			streamer.Update();
+			worstUpdate = std::max(worstUpdate, NowMs() - before);
+			for (int t = 0; t < count; ++t)
+				if (whole[t] < 0.0 && backend.GetResidentMip(ids[t]) == 0)
+					whole[t] = NowMs() - start;
+			if (!idle)
+				std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_MS));
+		}
+
+		size_t pairs = 0, inOrder = 0, resident = 0;
+		for (int a = 0; a < count; ++a){
+			resident += whole[a] >= 0.0;
+			for (int b = 0; b < count; ++b){
+				if (priority[a] > priority[b] && whole[a] >= 0.0 && whole[b] >= 0.0){
+					++pairs;
+					inOrder += whole[a] <= whole[b];
+				}
+			}
+			bad += Mismatches(backend, ids[a], a);
+		}
+		TextureStreamStats stats = streamer.GetStats();
+		printf("stream: Request blocked %.1f ms, all whole after %.1f ms over %d frames, worst Update %.2f ms\n",
+			blocked, *std::max_element(whole.begin(), whole.end()), frames, worstUpdate);
+		printf("        %zu/%d whole, priority order kept for %.1f%% of pairs, %.1f MB read\n",
+			resident, count, pairs ? 100.0 * inOrder / pairs : 100.0, stats.bytesRead / 1048576.0);
+		if (resident != (size_t)count)
+			++bad;
+	}
+
+	{
+		HeadlessTextureBackend backend;
+		TextureStreamer streamer;
+		streamer.Initialize(&backend);
+		size_t budget = total * 6 / 10;
+		streamer.SetBudget(budget);
+
+		std::vector<TextureId> ids;
+		for (int t = 0; t < count; ++t)
+			ids.push_back(streamer.Request(TexturePath(t).c_str(), priority[t]));
+
+		//	The first half is drawn every frame, the rest never
+		int frames = 0;
+		for (bool idle = false; !idle && frames < 10000; ++frames){
+			for (int t = 0; t < count / 2; ++t)
+				streamer.Touch(ids[t]);
+			idle = streamer.IsIdle();
+			streamer.Update();
+			std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_MS));
+		}
+
+		size_t touchedWhole = 0;
+		for (int t = 0; t < count; ++t){
+			touchedWhole += t < count / 2 && backend.GetResidentMip(ids[t]) == 0;
+			bad += Mismatches(backend, ids[t], t);
+		}
+		TextureResidencyStats stats = streamer.GetResidencyStats();
+		printf("budget: %.1f of %.1f MB, peak %.1f MB, %zu/%d drawn textures whole after %d frames, %zu evictions, %zu refusals\n",
+			budget / 1048576.0, total / 1048576.0, stats.peakBytes / 1048576.0, touchedWhole, count / 2, frames, stats.evictions, stats.refusals);
+		if (stats.peakBytes > budget || touchedWhole != (size_t)count / 2)
+			++bad;
+	}
+
+	for (int t = 0; t < count; ++t)
+		remove(TexturePath(t).c_str());
+
+	if (bad)
+		printf("%zu failures\n", bad);
+	return bad ? 1 : 0;
+}
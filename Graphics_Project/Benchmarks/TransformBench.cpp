@@ -0,0 +1,89 @@
+#include "Transform.h"
+#include "MathFunc.h"
+#include "Bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//	World matrices for 100k objects the way Update() used to build them
+//	(Identity -> Rotate -> Translate -> Scale through MathFunc, three 4x4
+//	multiplies and the trig per object) against Transform: from the angle
+//	(quaternion + ToMatrix, the trig included), from a stored quaternion, and
+//	ToMatrixBatch. Half the objects spin about x and half about y like the cubes.
+
+struct Object{
+	float angle;
+	bool aboutX;
+	FLOAT3 pos;
+	float scale;
+};
+
+static BENCH_NOINLINE void ChainWorlds(const std::vector<Object>& objects, MATRIX4X4* out){
+	for (size_t i = 0; i < objects.size(); ++i){
+		const Object& o = objects[i];
+		MATRIX4X4 m = Identity();
+		m = o.aboutX ? RotateX(m, o.angle) : RotateZ(m, o.angle);
+		m = Translate(m, o.pos.x, o.pos.y, o.pos.z);
+		out[i] = Scale_4x4(m, o.scale, o.scale, o.scale);
+	}
+}
+
+static BENCH_NOINLINE void TransformWorlds(const std::vector<Object>& objects, MATRIX4X4* out){
+	for (size_t i = 0; i < objects.size(); ++i){
+		const Object& o = objects[i];
+		FLOAT4 q = o.aboutX ? QuatRotationX(o.angle) : QuatRotationY(o.angle);
+		out[i] = Transform(o.pos, q, FLOAT3(o.scale, o.scale, o.scale)).ToMatrix();
+	}
+}
+
+static BENCH_NOINLINE void StoredWorlds(const std::vector<Transform>& transforms, MATRIX4X4* out){
+	for (size_t i = 0; i < transforms.size(); ++i)
+		out[i] = transforms[i].ToMatrix();
+}
+
+int main(int argc, char** argv){
+	bool quick = QuickRun(argc, argv);
+	size_t n = quick ? 10000 : 100000;
+	int reps = quick ? 1 : 10;
+
+	srand(2);
+	std::vector<Object> objects(n);
+	std::vector<Transform> transforms(n);
+	for (size_t i = 0; i < n; ++i){
+		Object& o = objects[i];
+		o.angle = (float)rand() / RAND_MAX * 6.2831853f;
+		o.aboutX = (i & 1) != 0;
+		o.pos = FLOAT3((float)(rand() % 2000) / 10 - 100, 1.0f, (float)(rand() % 2000) / 10 - 100);
+		o.scale = 0.5f + (float)rand() / RAND_MAX;
+		transforms[i] = Transform(o.pos, o.aboutX ? QuatRotationX(o.angle) : QuatRotationY(o.angle), FLOAT3(o.scale, o.scale, o.scale));
+	}
+
+	std::vector<MATRIX4X4> chain(n), fused(n), stored(n), batch(n);
+	double chainMs = BestMs(reps, [&]{ ChainWorlds(objects, &chain[0]); });
+	double fusedMs = BestMs(reps, [&]{ TransformWorlds(objects, &fused[0]); });
+	double storedMs = BestMs(reps, [&]{ StoredWorlds(transforms, &stored[0]); });
+	double batchMs = BestMs(reps, [&]{ ToMatrixBatch(&transforms[0], &batch[0], n); });
+
+	//	Same worlds either way, to float rounding
+	float worst = 0.0f;
+	for (size_t i = 0; i < n; ++i){
+		const float* a = &chain[i].a;
+		const float* b = &fused[i].a;
+		for (int k = 0; k < 16; ++k)
+			worst = fmaxf(worst, fabsf(a[k] - b[k]));
+	}
+	if (worst > 1e-4f){
+		printf("Transform differs from the chain by %g\n", worst);
+		return 1;
+	}
+
+	printf("%zu objects, largest difference from the chain %.2g\n", n, worst);
+	printf("%-22s %9s %9s %9s\n", "path", "ms", "M/s", "vs chain");
+	printf("%-22s %9.3f %9.1f %9.2fx\n", "MathFunc chain", chainMs, n / chainMs / 1e3, 1.0);
+	printf("%-22s %9.3f %9.1f %9.2fx\n", "Transform from angle", fusedMs, n / fusedMs / 1e3, chainMs / fusedMs);
+	printf("%-22s %9.3f %9.1f %9.2fx\n", "Transform::ToMatrix", storedMs, n / storedMs / 1e3, chainMs / storedMs);
+	printf("%-22s %9.3f %9.1f %9.2fx\n", "ToMatrixBatch", batchMs, n / batchMs / 1e3, chainMs / batchMs);
+	return 0;
+}
@@ -0,0 +1,128 @@
+#include "BVH.h"
+#include "Check.h"
+#include "CullScene.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+//	BVH culls against testing every box, before and after instances move
+
+static const FLOAT3 treeMin(-0.5f, -0.5f, -0.5f), treeMax(0.5f, 0.5f, 0.5f);
+
+static AABB TreeBox(float x, float y, float z){
+	return AABB(FLOAT3(x + treeMin.x, y + treeMin.y, z + treeMin.z), FLOAT3(x + treeMax.x, y + treeMax.y, z + treeMax.z));
+}
+
+static std::vector<unsigned int> BruteForce(const FLOAT4* planes, const std::vector<AABB>& boxes){
+	std::vector<unsigned int> out;
+	for (size_t i = 0; i < boxes.size(); ++i){
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; ++p)
+			visible = ClassifyAABB(planes[p], boxes[i]) >= 0;
+		if (visible)
+			out.push_back((unsigned int)i);
+	}
+	return out;
+}
+
+static std::vector<unsigned int> Sorted(std::vector<unsigned int> v){
+	std::sort(v.begin(), v.end());
+	return v;
+}
+
+int main(){
+	const size_t count = 20000;
+	InstanceSoA inst;
+	MakeForest(inst, count);
+	float extent = SceneExtent(count);
+
+	std::vector<AABB> boxes(count);
+	for (size_t i = 0; i < count; ++i)
+		boxes[i] = TreeBox(inst.x[i], inst.y[i], inst.z[i]);
+
+	BVH bvh;
+	bvh.Build(&boxes[0], count);
+	CHECK(bvh.GetPrimCount() == count);
+	CHECK(bvh.GetNodeCount() > 1 && bvh.GetNodeCount() < count * 2);
+
+	//	Static forest: hierarchy, coherent hierarchy, flat SIMD and brute force agree
+	BVHCullCache cache;
+	size_t totalVisible = 0;
+	for (size_t f = 0; f < 120; ++f){
+		FLOAT3 eye;
+		float yaw;
+		CameraPath(f * 5, extent, eye, yaw);
+		Frustum frustum;
+		MakeFrustum(eye, yaw, frustum);
+
+		std::vector<unsigned int> expected = BruteForce(frustum.planes, boxes);
+		std::vector<unsigned int> tree, coherent;
+		bvh.CullFrustum(frustum.planes, tree);
+		CullStats stats;
+		bvh.CullFrustumCoherent(frustum.planes, coherent, cache, &stats);
+		CHECK(Sorted(tree) == expected);
+		CHECK(Sorted(coherent) == expected);
+		CHECK(stats.planeTests <= stats.objects * 6);
+
+		CullPlanes planes;
+		BuildCullPlanes(frustum.planes, treeMin, treeMax, planes);
+		std::vector<unsigned int> flat(count);
+		flat.resize(CullInstances(planes, inst, 0, count, &flat[0]));
+		CHECK(flat == expected);
+		totalVisible += expected.size();
+	}
+	CHECK(totalVisible > 0);
+
+	//	Instances move, a few far and the rest a little: refit keeps the culls
+	//	exact, and the cache stays usable as the node count doesn't change
+	srand(7);
+	for (int step = 0; step < 10; ++step){
+		for (size_t i = 0; i < count; ++i){
+			if (rand() % 10 != 0)
+				continue;
+			float range = (rand() % 50 == 0) ? extent : 2.0f;
+			float x = boxes[i].min.x - treeMin.x + range * ((float)rand() / RAND_MAX - 0.5f);
+			float z = boxes[i].min.z - treeMin.z + range * ((float)rand() / RAND_MAX - 0.5f);
+			boxes[i] = TreeBox(x, (float)(rand() % 3), z);
+			bvh.SetBounds((unsigned int)i, boxes[i]);
+		}
+		bvh.Refit();
+
+		FLOAT3 eye;
+		float yaw;
+		CameraPath(step * 60, extent, eye, yaw);
+		Frustum frustum;
+		MakeFrustum(eye, yaw, frustum);
+
+		std::vector<unsigned int> expected = BruteForce(frustum.planes, boxes);
+		std::vector<unsigned int> tree, coherent;
+		bvh.CullFrustum(frustum.planes, tree);
+		bvh.CullFrustumCoherent(frustum.planes, coherent, cache);
+		CHECK(Sorted(tree) == expected);
+		CHECK(Sorted(coherent) == expected);
+	}
+
+	//	Empty and single box trees
+	BVH empty;
+	empty.Build(nullptr, 0);
+	std::vector<unsigned int> none;
+	Frustum frustum;
+	MakeFrustum(FLOAT3(0.0f, 2.0f, 0.0f), 0.0f, frustum);
+	empty.CullFrustum(frustum.planes, none);
+	empty.Refit();
+	CHECK(none.empty());
+
+	AABB one = TreeBox(0.0f, 0.0f, 10.0f);
+	BVH single;
+	single.Build(&one, 1);
+	single.CullFrustum(frustum.planes, none);
+	CHECK(none.size() == 1);
+	single.SetBounds(0, TreeBox(0.0f, 0.0f, -10.0f));
+	single.Refit();
+	none.clear();
+	single.CullFrustum(frustum.planes, none);
+	CHECK(none.empty());
+
+	return CheckResult();
+}
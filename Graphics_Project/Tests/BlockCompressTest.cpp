@@ -0,0 +1,288 @@
+#include "BlockCompress.h"
+#include "JobSystem.h"
+#include "MathSIMD.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+//	Block encoders through their decoders: solid blocks come back exact (BC1
+//	and BC3 colour as close as 5:6:5 allows), two colour and ramp blocks stay
+//	inside per format bounds, the bundled textures keep their PSNR, and the
+//	scalar, SSE2, AVX and threaded surfaces are byte for byte the same.
+
+struct Format{
+	const char* name;
+	DXGI_FORMAT format;
+	size_t blockBytes;
+	int channels;					//	checked over the first this many of rgba
+	double minPSNR;					//	on the bundled textures, top level
+};
+
+static const Format formats[] = {
+	{ "BC1", DXGI_FORMAT_BC1_UNORM, 8, 3, 30.5 },
+	{ "BC3", DXGI_FORMAT_BC3_UNORM, 16, 4, 31.5 },
+	{ "BC4", DXGI_FORMAT_BC4_UNORM, 8, 1, 37.5 },
+	{ "BC5", DXGI_FORMAT_BC5_UNORM, 16, 2, 37.5 },
+	{ "BC7", DXGI_FORMAT_BC7_UNORM, 16, 4, 39.5 }
+};
+#define FORMAT_COUNT	(sizeof(formats) / sizeof(formats[0]))
+
+static void Encode(const Format& f, const uint8_t* rgba, uint8_t* block){
+	switch (f.format){
+	case DXGI_FORMAT_BC1_UNORM:	EncodeBC1Block(rgba, block); break;
+	case DXGI_FORMAT_BC3_UNORM:	EncodeBC3Block(rgba, block); break;
+	case DXGI_FORMAT_BC4_UNORM:	EncodeBC4Block(rgba, 0, block); break;
+	case DXGI_FORMAT_BC5_UNORM:	EncodeBC5Block(rgba, block); break;
+	default:					EncodeBC7Block(rgba, block); break;
+	}
+}
+
+static void Decode(const Format& f, const uint8_t* block, uint8_t* rgba){
+	memset(rgba, 0, 64);
+	switch (f.format){
+	case DXGI_FORMAT_BC1_UNORM:	DecodeBC1Block(block, rgba); break;
+	case DXGI_FORMAT_BC3_UNORM:	DecodeBC3Block(block, rgba); break;
+	case DXGI_FORMAT_BC4_UNORM:	DecodeBC4Block(block, 0, rgba); break;
+	case DXGI_FORMAT_BC5_UNORM:	DecodeBC5Block(block, rgba); break;
+	default:					DecodeBC7Block(block, rgba); break;
+	}
+}
+
+//	Largest channel error of the block through encode and decode
+static int RoundTripError(const Format& f, const uint8_t* rgba){
+	uint8_t block[16], back[64];
+	Encode(f, rgba, block);
+	Decode(f, block, back);
+	int worst = 0;
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < f.channels; ++c)
+			worst = std::max(worst, std::abs(back[4 * i + c] - rgba[4 * i + c]));
+	return worst;
+}
+
+//	Closest a BC1 solid colour channel can get: entry 2 of a four colour
+//	palette over every pair of 5 or 6 bit endpoints, a == b covers the
+//	endpoints themselves
+static int BestSolidError(int v, int bits){
+	int best = 256;
+	for (int a = 0; a < (1 << bits); ++a){
+		for (int b = 0; b < (1 << bits); ++b){
+			int ea = bits == 5 ? (a << 3) | (a >> 2) : (a << 2) | (a >> 4);
+			int eb = bits == 5 ? (b << 3) | (b >> 2) : (b << 2) | (b >> 4);
+			best = std::min(best, std::abs((2 * ea + eb + 1) / 3 - v));
+		}
+	}
+	return best;
+}
+
+static void FillSolid(uint8_t* rgba, const uint8_t* color){
+	for (int i = 0; i < 16; ++i)
+		memcpy(rgba + 4 * i, color, 4);
+}
+
+static void TestSolid(){
+	int bestError[2][256];
+	for (int v = 0; v < 256; ++v){
+		bestError[0][v] = BestSolidError(v, 5);
+		bestError[1][v] = BestSolidError(v, 6);
+	}
+
+	srand(24);
+	for (int t = 0; t < 256 + 4000; ++t){
+		//	Every grey level first, then random colours
+		uint8_t color[4];
+		for (int c = 0; c < 4; ++c)
+			color[c] = t < 256 ? (uint8_t)t : (uint8_t)(rand() & 255);
+		if (t < 256)
+			color[3] = 255;
+
+		uint8_t rgba[64], block[16], back[64];
+		FillSolid(rgba, color);
+		for (size_t f = 0; f < FORMAT_COUNT; ++f){
+			const Format& format = formats[f];
+			Encode(format, rgba, block);
+			Decode(format, block, back);
+
+			bool uniform = true;
+			for (int i = 1; i < 16; ++i)
+				uniform = uniform && memcmp(back + 4 * i, back, 4) == 0;
+			CHECK(uniform);
+
+			if (format.format == DXGI_FORMAT_BC1_UNORM || format.format == DXGI_FORMAT_BC3_UNORM){
+				//	Four colour mode, so BC1 stays opaque
+				uint16_t c0 = (uint16_t)(block[format.blockBytes - 8] | (block[format.blockBytes - 7] << 8));
+				uint16_t c1 = (uint16_t)(block[format.blockBytes - 6] | (block[format.blockBytes - 5] << 8));
+				CHECK(c0 >= c1);
+				CHECK(std::abs(back[0] - color[0]) == bestError[0][color[0]]);
+				CHECK(std::abs(back[1] - color[1]) == bestError[1][color[1]]);
+				CHECK(std::abs(back[2] - color[2]) == bestError[0][color[2]]);
+				CHECK(back[3] == (format.format == DXGI_FORMAT_BC1_UNORM ? 255 : color[3]));
+			}
+			else
+				CHECK(memcmp(back, color, format.channels) == 0);
+		}
+
+		//	BC4 on each channel
+		for (unsigned int c = 0; c < 4; ++c){
+			uint8_t one[64];
+			memset(one, 0, 64);
+			EncodeBC4Block(rgba, c, block);
+			DecodeBC4Block(block, c, one);
+			CHECK(one[c] == color[c] && one[60 + c] == color[c]);
+		}
+	}
+}
+
+//	Texels picked from two colours, and a 16 step ramp between them
+static void TestBounds(){
+	srand(7);
+	for (size_t f = 0; f < FORMAT_COUNT; ++f){
+		const Format& format = formats[f];
+		int worstTwo = 0;
+		bool rampInside = true;
+		for (int t = 0; t < 5000; ++t){
+			uint8_t a[4], b[4];
+			for (int c = 0; c < 4; ++c){
+				a[c] = (uint8_t)(rand() & 255);
+				b[c] = (uint8_t)(rand() & 255);
+			}
+			if (format.format == DXGI_FORMAT_BC1_UNORM)
+				a[3] = b[3] = 255;
+
+			uint8_t two[64], ramp[64];
+			int range = 0;
+			for (int c = 0; c < format.channels; ++c)
+				range = std::max(range, std::abs(a[c] - b[c]));
+			for (int i = 0; i < 16; ++i){
+				memcpy(two + 4 * i, (rand() & 1) ? a : b, 4);
+				for (int c = 0; c < 4; ++c)
+					ramp[4 * i + c] = (uint8_t)((a[c] * (15 - i) + b[c] * i + 7) / 15);
+			}
+			worstTwo = std::max(worstTwo, RoundTripError(format, two));
+
+			//	Half a palette step plus endpoint rounding
+			int steps = format.format == DXGI_FORMAT_BC7_UNORM ? 15 : (format.channels <= 2 ? 7 : 3);
+			int slack = format.format == DXGI_FORMAT_BC7_UNORM ? 3 : (format.channels <= 2 ? 2 : 5);
+			rampInside = rampInside && RoundTripError(format, ramp) <= range / (2 * steps) + slack;
+		}
+
+		//	BC4 / BC5 store the two values as endpoints, BC7 to its 7 bits and
+		//	p bit, BC1 / BC3 colour to 5:6:5
+		int twoBound = format.channels <= 2 ? 0 : (format.format == DXGI_FORMAT_BC7_UNORM ? 1 : 4);
+		printf("%s two colour worst %d\n", format.name, worstTwo);
+		CHECK(worstTwo <= twoBound);
+		CHECK(rampInside);
+	}
+}
+
+//	Top level of a bundled source texture as RGBA8
+static bool LoadRGBA(const char* path, std::vector<uint8_t>& rgba, size_t& width, size_t& height){
+	DDSFile file;
+	if (!file.Open(path))
+		return false;
+	const DDSSubresource& top = file.GetSubresource(0, 0);
+	bool bgra = file.GetInfo().format == DXGI_FORMAT_B8G8R8A8_UNORM || file.GetInfo().format == DXGI_FORMAT_B8G8R8X8_UNORM;
+	width = top.width;
+	height = top.height;
+	rgba.resize(width * height * 4);
+	for (size_t y = 0; y < height; ++y){
+		for (size_t x = 0; x < width; ++x){
+			const uint8_t* s = top.data + y * top.rowPitch + x * 4;
+			uint8_t* d = &rgba[(y * width + x) * 4];
+			d[0] = bgra ? s[2] : s[0];
+			d[1] = s[1];
+			d[2] = bgra ? s[0] : s[2];
+			d[3] = s[3];
+		}
+	}
+	return true;
+}
+
+static double SurfacePSNR(const Format& f, const std::vector<uint8_t>& rgba, size_t width, size_t height, const std::vector<uint8_t>& blocks){
+	double error = 0.0;
+	size_t blocksWide = (width + 3) / 4;
+	for (size_t by = 0; by < height / 4; ++by){
+		for (size_t bx = 0; bx < width / 4; ++bx){
+			uint8_t back[64];
+			Decode(f, &blocks[(by * blocksWide + bx) * f.blockBytes], back);
+			for (int i = 0; i < 16; ++i){
+				const uint8_t* s = &rgba[((by * 4 + i / 4) * width + bx * 4 + i % 4) * 4];
+				for (int c = 0; c < f.channels; ++c){
+					double d = (double)s[c] - back[4 * i + c];
+					error += d * d;
+				}
+			}
+		}
+	}
+	double mse = error / ((double)width * height * f.channels);
+	return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+static std::vector<uint8_t> Compress(const Format& f, const std::vector<uint8_t>& rgba, size_t width, size_t height, JobSystem* jobs){
+	std::vector<uint8_t> blocks(((width + 3) / 4) * ((height + 3) / 4) * f.blockBytes);
+	CHECK(CompressSurface(&rgba[0], width, height, width * 4, f.format, &blocks[0], jobs));
+	return blocks;
+}
+
+int main(){
+	TestSolid();
+	TestBounds();
+
+	JobSystem jobs;
+	CHECK(jobs.Initialize(4));
+	SIMDLevel detected = DetectSIMDLevel();
+
+	//	Bundled textures, plus noise at a size that isn't a multiple of 4
+	const char* textures[] = { "../Assets/_bark.dds", "../Assets/_barrel.dds", "../Assets/_grass.dds", "../Assets/_ground.dds", nullptr };
+	for (int t = 0; t < 5; ++t){
+		std::vector<uint8_t> rgba;
+		size_t width, height;
+		if (textures[t]){
+			bool loaded = LoadRGBA(textures[t], rgba, width, height);
+			CHECK(loaded);
+			if (!loaded)
+				continue;
+			//	A quarter of each is plenty to compare paths and PSNR
+			width /= 2;
+			height /= 2;
+			std::vector<uint8_t> part(width * height * 4);
+			for (size_t y = 0; y < height; ++y)
+				memcpy(&part[y * width * 4], &rgba[y * width * 8], width * 4);
+			rgba.swap(part);
+		}
+		else {
+			width = 37;
+			height = 21;
+			srand(9);
+			rgba.resize(width * height * 4);
+			for (size_t i = 0; i < rgba.size(); ++i)
+				rgba[i] = (uint8_t)(rand() & 255);
+		}
+
+		for (size_t f = 0; f < FORMAT_COUNT; ++f){
+			const Format& format = formats[f];
+			SetSIMDLevel(SIMD_SCALAR);
+			std::vector<uint8_t> scalar = Compress(format, rgba, width, height, nullptr);
+			for (int level = SIMD_SSE2; level <= detected; ++level){
+				SetSIMDLevel((SIMDLevel)level);
+				CHECK(Compress(format, rgba, width, height, nullptr) == scalar);
+			}
+			SetSIMDLevel(detected);
+			CHECK(Compress(format, rgba, width, height, &jobs) == scalar);
+
+			if (textures[t]){
+				double psnr = SurfacePSNR(format, rgba, width, height, scalar);
+				printf("%-22s %s %.1f dB\n", textures[t], format.name, psnr);
+				CHECK(psnr >= format.minPSNR);
+			}
+		}
+	}
+
+	jobs.Shutdown();
+	return CheckResult();
+}
@@ -0,0 +1,20 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <cstdio>
+
+//	Assertions for the Linux test targets. A failed check prints where it was
+//	and carries on, main returns CheckResult() so ctest sees the failure.
+static int checkFailures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++checkFailures; } } while (0)
+
+static int CheckResult(){
+	if (checkFailures)
+		printf("%d check(s) failed\n", checkFailures);
+	else
+		printf("all checks passed\n");
+	return checkFailures ? 1 : 0;
+}
+
+#endif
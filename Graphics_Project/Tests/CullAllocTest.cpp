@@ -0,0 +1,142 @@
+#include "BVH.h"
+#include "FrustumCull.h"
+#include "JobSystem.h"
+#include "OcclusionCull.h"
+#include "Check.h"
+#include "CullScene.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+//	Counts every heap allocation in the process, then runs the per frame cull
+//	path as cullAABB does it (flat, parallel and BVH, then occlusion) and checks
+//	that once warmed up a frame allocates nothing.
+
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size){
+	allocations.fetch_add(1);
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+void* operator new[](size_t size){ return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept{
+	allocations.fetch_add(1);
+	return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept{ return operator new(size, tag); }
+void operator delete(void* p) noexcept{ free(p); }
+void operator delete[](void* p) noexcept{ operator delete(p); }
+void operator delete(void* p, size_t) noexcept{ operator delete(p); }
+void operator delete[](void* p, size_t) noexcept{ operator delete(p); }
+
+//	Row vector view * projection the way MathFunc builds them
+static MATRIX4X4 ViewProj(FLOAT3 eye, float yaw){
+	float fx = sinf(yaw), fz = cosf(yaw);
+	float ys = 1.0f / tanf(SCENE_FOV_DEGREES * 0.5f * 3.14159265f / 180.0f);
+	float xs = ys / SCENE_ASPECT;
+	float q = SCENE_FAR / (SCENE_FAR - SCENE_NEAR);
+
+	//	View: right (fz, 0, -fx), up (0, 1, 0), forward (fx, 0, fz)
+	MATRIX4X4 m;
+	m.a = fz * xs;	m.b = 0.0f;	m.c = fx * q;	m.d = fx;
+	m.e = 0.0f;		m.f = ys;	m.g = 0.0f;		m.h = 0.0f;
+	m.i = -fx * xs;	m.j = 0.0f;	m.k = fz * q;	m.l = fz;
+	float tx = -(eye.x * fz - eye.z * fx), ty = -eye.y, tz = -(eye.x * fx + eye.z * fz);
+	m.m = tx * xs;	m.n = ty * ys;	m.o = tz * q - SCENE_NEAR * q;	m.p = tz;
+	return m;
+}
+
+struct Scene{
+	InstanceSoA inst;
+	std::vector<unsigned int> visible;
+	CullScratch scratch;
+	BVH bvh;
+	BVHCullCache cache;
+	CullStats stats;
+	OcclusionBuffer occlusion;
+	float extent;
+};
+
+static const FLOAT3 treeMin(-0.5f, -0.5f, -0.5f), treeMax(0.5f, 0.5f, 0.5f);
+
+static size_t Frame(Scene& s, JobSystem& jobs, size_t frame, int path){
+	FLOAT3 eye;
+	float yaw;
+	CameraPath(frame, s.extent, eye, yaw);
+	Frustum frustum;
+	MakeFrustum(eye, yaw, frustum);
+	MATRIX4X4 viewProj = ViewProj(eye, yaw);
+
+	//	A box in front of the camera as the occluder
+	s.occlusion.Clear();
+	s.occlusion.RasterizeBox(AABB(FLOAT3(eye.x + 4.0f * sinf(yaw) - 1.0f, 0.0f, eye.z + 4.0f * cosf(yaw) - 1.0f),
+		FLOAT3(eye.x + 4.0f * sinf(yaw) + 1.0f, 4.0f, eye.z + 4.0f * cosf(yaw) + 1.0f)), viewProj);
+	s.occlusion.BuildHiZ();
+
+	size_t count = 0;
+	s.stats.Reset();
+	if (path == 2){
+		s.visible.clear();
+		s.bvh.CullFrustumCoherent(frustum.planes, s.visible, s.cache, &s.stats);
+		count = s.visible.size();
+	}
+	else{
+		CullPlanes planes;
+		BuildCullPlanes(frustum.planes, treeMin, treeMax, planes);
+		s.visible.resize(s.inst.Size());
+		if (path == 1)
+			count = CullInstancesParallel(jobs, planes, s.inst, s.scratch, &s.visible[0], 1024);
+		else
+			count = CullInstances(planes, s.inst, 0, s.inst.Size(), &s.visible[0]);
+	}
+
+	if (count > 0)
+		count = s.occlusion.FilterInstances(&s.visible[0], count, s.inst, treeMin, treeMax, viewProj, &s.visible[0]);
+	return count;
+}
+
+int main(){
+	JobSystem jobs;
+	jobs.Initialize(4);
+
+	Scene scene;
+	const size_t count = 20000;
+	MakeForest(scene.inst, count);
+	scene.extent = SceneExtent(count);
+	scene.visible.reserve(count);
+	scene.occlusion.Initialize(256, 192);
+
+	std::vector<AABB> boxes(count);
+	for (size_t i = 0; i < count; ++i)
+		boxes[i] = AABB(FLOAT3(scene.inst.x[i] + treeMin.x, scene.inst.y[i] + treeMin.y, scene.inst.z[i] + treeMin.z),
+			FLOAT3(scene.inst.x[i] + treeMax.x, scene.inst.y[i] + treeMax.y, scene.inst.z[i] + treeMax.z));
+	scene.bvh.Build(&boxes[0], count);
+
+	const char* names[] = { "flat", "parallel", "bvh" };
+	for (int path = 0; path < 3; ++path){
+		//	First frame sizes the scratch and caches
+		size_t drawn = Frame(scene, jobs, 0, path);
+
+		size_t before = allocations.load();
+		for (size_t f = 1; f <= 200; ++f)
+			drawn += Frame(scene, jobs, f, path);
+		size_t perPath = allocations.load() - before;
+
+		printf("%-8s %zu allocations over 200 frames, %zu trees drawn\n", names[path], perPath, drawn);
+		CHECK(perPath == 0);
+		CHECK(drawn > 0);
+	}
+
+	//	The counter does see allocations
+	size_t before = allocations.load();
+	std::vector<int> probe(10);
+	CHECK(allocations.load() - before == 1);
+
+	return CheckResult();
+}
@@ -0,0 +1,258 @@
+#include "DDSFile.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+//	DDSFile on hand built headers with known layouts, the bundled textures,
+//	a WriteDDSHeader round trip and a mutation fuzz. The fuzz flips bits,
+//	overwrites words with small and huge numbers and truncates, mostly in
+//	the headers, starting from every other case here. Whatever comes out,
+//	a parse that succeeds must only point inside the bytes it was given.
+//	DDSFileTest <iterations> runs a longer fuzz than ctest does.
+
+#define FUZZ_ITERATIONS		50000
+#define FUZZ_SEED			7
+
+static const char* statusNames[] = { "ok", "open failed", "invalid", "unsupported", "truncated" };
+
+static std::vector<uint8_t> MakeDDS(uint32_t width, uint32_t height, uint32_t depth, uint32_t mips, uint32_t fourCC,
+	bool dx10, uint32_t format, uint32_t dimension, uint32_t misc, uint32_t arraySize, size_t payload){
+	size_t headerBytes = sizeof(uint32_t) + sizeof(DDS_HEADER) + (dx10 ? sizeof(DDS_HEADER_DXT10) : 0);
+	std::vector<uint8_t> bytes(headerBytes + payload, 0xAB);
+
+	uint32_t magic = DDS_MAGIC;
+	memcpy(&bytes[0], &magic, sizeof(magic));
+
+	DDS_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE | (depth > 1 ? DDS_HEADER_FLAGS_VOLUME : 0);
+	header.width = width;
+	header.height = height;
+	header.depth = depth;
+	header.mipMapCount = mips;
+	header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header.ddspf.flags = DDS_FOURCC;
+	header.ddspf.fourCC = dx10 ? MAKEFOURCC('D', 'X', '1', '0') : fourCC;
+	memcpy(&bytes[sizeof(uint32_t)], &header, sizeof(header));
+
+	if (dx10){
+		DDS_HEADER_DXT10 ext = { format, dimension, misc, arraySize, 0 };
+		memcpy(&bytes[sizeof(uint32_t) + sizeof(DDS_HEADER)], &ext, sizeof(ext));
+	}
+	return bytes;
+}
+
+static std::vector<uint8_t> ReadFile(const char* path){
+	std::vector<uint8_t> data;
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return data;
+	fseek(f, 0, SEEK_END);
+	data.resize((size_t)ftell(f));
+	fseek(f, 0, SEEK_SET);
+	if (!data.empty() && fread(&data[0], 1, data.size(), f) != data.size())
+		data.clear();
+	fclose(f);
+	return data;
+}
+
+//	Every subresource inside [data, data + size), back to back after the
+//	headers and sized as GetSurfaceInfo says
+static bool Consistent(const DDSFile& dds, const uint8_t* data, size_t size){
+	const DDSInfo& info = dds.GetInfo();
+	if (dds.GetSubresourceCount() != info.arraySize * info.mipCount)
+		return false;
+
+	const uint8_t* expected = nullptr;
+	for (size_t i = 0; i < dds.GetSubresourceCount(); ++i){
+		const DDSSubresource& s = dds.GetSubresources()[i];
+		if (s.data < data || s.size > size || s.data > data + size - s.size)
+			return false;
+		if (expected && s.data != expected)
+			return false;
+		expected = s.data + s.size;
+
+		size_t numBytes, rowBytes, numRows;
+		GetSurfaceInfo(s.width, s.height, info.format, &numBytes, &rowBytes, &numRows);
+		if (s.rowPitch != rowBytes || s.slicePitch != numBytes || s.size != numBytes * s.depth)
+			return false;
+	}
+	return true;
+}
+
+struct ParseCase{
+	const char* name;
+	std::vector<uint8_t> bytes;
+	DDSStatus status;
+	size_t subresources;
+};
+
+int main(int argc, char** argv){
+	const uint32_t dxt1 = MAKEFOURCC('D', 'X', 'T', '1'), dxt5 = MAKEFOURCC('D', 'X', 'T', '5');
+	const size_t dxt1Chain = 32768 + 8192 + 2048 + 512 + 128 + 32 + 8 + 8 + 8;
+	const size_t bc7Cube = 4096 + 1024 + 256 + 64 + 16 + 16 + 16;
+
+	std::vector<uint8_t> cut = MakeDDS(4, 4, 1, 1, dxt1, false, 0, 0, 0, 0, 8);
+	cut.resize(100);
+
+	std::vector<ParseCase> cases = {
+		{ "BC1 256 full chain", MakeDDS(256, 256, 1, 9, dxt1, false, 0, 0, 0, 0, dxt1Chain), DDS_OK, 9 },
+		{ "BC1 a byte short", MakeDDS(256, 256, 1, 9, dxt1, false, 0, 0, 0, 0, dxt1Chain - 1), DDS_TRUNCATED, 0 },
+		{ "BC7 cube array of 2", MakeDDS(64, 64, 1, 7, 0, true, DXGI_FORMAT_BC7_UNORM, DDS_DIMENSION_TEXTURE2D, DDS_MISC_TEXTURECUBE, 2, 12 * bc7Cube), DDS_OK, 12 * 7 },
+		{ "RGBA volume", MakeDDS(32, 16, 8, 3, 0, true, DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE3D, 0, 1, 32 * 16 * 8 * 4 + 16 * 8 * 4 * 4 + 8 * 4 * 2 * 4), DDS_OK, 3 },
+		{ "1D array of 3", MakeDDS(100, 1, 1, 1, 0, true, DXGI_FORMAT_R32_FLOAT, DDS_DIMENSION_TEXTURE1D, 0, 3, 3 * 400), DDS_OK, 3 },
+		{ "mips past 1x1", MakeDDS(4, 4, 1, 4, dxt5, false, 0, 0, 0, 0, 100), DDS_INVALID, 0 },
+		{ "zero width", MakeDDS(0, 4, 1, 1, dxt5, false, 0, 0, 0, 0, 100), DDS_INVALID, 0 },
+		{ "zero array size", MakeDDS(4, 4, 1, 1, 0, true, DXGI_FORMAT_R8_UNORM, DDS_DIMENSION_TEXTURE2D, 0, 0, 100), DDS_INVALID, 0 },
+		{ "unknown format", MakeDDS(4, 4, 1, 1, 0, true, 200, DDS_DIMENSION_TEXTURE2D, 0, 1, 100), DDS_UNSUPPORTED, 0 },
+		{ "unknown fourCC", MakeDDS(4, 4, 1, 1, MAKEFOURCC('A', 'B', 'C', 'D'), false, 0, 0, 0, 0, 100), DDS_UNSUPPORTED, 0 },
+		{ "past the size limit", MakeDDS(16385, 4, 1, 1, 0, true, DXGI_FORMAT_R8_UNORM, DDS_DIMENSION_TEXTURE2D, 0, 1, 1 << 20), DDS_UNSUPPORTED, 0 },
+		{ "cube count overflows", MakeDDS(4, 4, 1, 1, 0, true, DXGI_FORMAT_R8_UNORM, DDS_DIMENSION_TEXTURE2D, DDS_MISC_TEXTURECUBE, 0x40000000, 100), DDS_UNSUPPORTED, 0 },
+		{ "largest legal, no data", MakeDDS(16384, 16384, 1, 15, 0, true, DXGI_FORMAT_R32G32B32A32_FLOAT, DDS_DIMENSION_TEXTURE2D, 0, 2048, 100), DDS_TRUNCATED, 0 },
+		{ "3D without the flag", MakeDDS(4, 4, 1, 1, 0, true, DXGI_FORMAT_R8_UNORM, DDS_DIMENSION_TEXTURE3D, 0, 1, 100), DDS_INVALID, 0 },
+		{ "header cut short", cut, DDS_INVALID, 0 },
+	};
+
+	for (size_t i = 0; i < cases.size(); ++i){
+		const ParseCase& c = cases[i];
+		DDSFile dds;
+		bool ok = dds.Parse(c.bytes.data(), c.bytes.size());
+		bool right = dds.GetStatus() == c.status && ok == (c.status == DDS_OK) && dds.GetSubresourceCount() == c.subresources;
+		if (!right)
+			printf("%s: %s with %zu subresources\n", c.name, statusNames[dds.GetStatus()], dds.GetSubresourceCount());
+		CHECK(right);
+		CHECK(!ok || Consistent(dds, c.bytes.data(), c.bytes.size()));
+	}
+
+	//	The mip sizes of a BC block chain bottom out at one block
+	DDSFile chain;
+	CHECK(chain.Parse(cases[0].bytes.data(), cases[0].bytes.size()));
+	CHECK(chain.GetSubresource(0, 0).size == 32768 && chain.GetSubresource(0, 8).size == 8 && chain.GetSubresource(0, 8).width == 1);
+
+	//	WriteDDSHeader output parses back to the same description
+	DDSInfo info;
+	memset(&info, 0, sizeof(info));
+	info.width = 48;
+	info.height = 20;
+	info.depth = 1;
+	info.mipCount = 6;
+	info.arraySize = 2;
+	info.format = DXGI_FORMAT_BC5_UNORM;
+	info.dimension = DDS_DIMENSION_TEXTURE2D;
+	std::vector<uint8_t> written;
+	WriteDDSHeader(info, written);
+	size_t headerBytes = written.size();
+	for (size_t item = 0; item < info.arraySize; ++item){
+		for (size_t mip = 0; mip < info.mipCount; ++mip){
+			size_t numBytes;
+			GetSurfaceInfo(std::max<size_t>(1, info.width >> mip), std::max<size_t>(1, info.height >> mip), info.format, &numBytes, nullptr, nullptr);
+			written.resize(written.size() + numBytes, (uint8_t)(item * 16 + mip));
+		}
+	}
+	DDSFile reread;
+	CHECK(reread.Parse(written.data(), written.size()));
+	const DDSInfo& back = reread.GetInfo();
+	CHECK(back.width == 48 && back.height == 20 && back.mipCount == 6 && back.arraySize == 2 && back.format == DXGI_FORMAT_BC5_UNORM);
+	CHECK(Consistent(reread, written.data(), written.size()));
+	CHECK(reread.GetSubresource(0, 0).data == written.data() + headerBytes);
+	CHECK(reread.GetSubresource(1, 5).data[0] == 16 + 5);
+
+	//	The bundled textures, mapped from disk
+	const char* textures[] = { "_bark.dds", "_barrel.dds", "_barrelN.dds", "_grass.dds", "_ground.dds", "_wood.dds" };
+	std::vector<std::vector<uint8_t>> seeds;
+	for (int t = 0; t < 6; ++t){
+		DDSFile dds;
+		bool ok = dds.Open(textures[t]);
+		CHECK(ok);
+		if (!ok)
+			continue;
+		const DDSInfo& i = dds.GetInfo();
+		printf("%-14s %zux%zu, %zu mips, format %d\n", textures[t], i.width, i.height, i.mipCount, (int)i.format);
+
+		std::vector<uint8_t> bytes = ReadFile(textures[t]);
+		DDSFile copy;
+		CHECK(copy.Parse(bytes.data(), bytes.size()) && Consistent(copy, bytes.data(), bytes.size()));
+
+		//	Same layout whether mapped or parsed from memory
+		const DDSSubresource& last = copy.GetSubresources()[copy.GetSubresourceCount() - 1];
+		size_t end = last.data + last.size - bytes.data();
+		CHECK(copy.GetSubresourceCount() == dds.GetSubresourceCount());
+		CHECK(memcmp(dds.GetSubresource(0, 0).data, copy.GetSubresource(0, 0).data, end - (copy.GetSubresource(0, 0).data - bytes.data())) == 0);
+		seeds.push_back(bytes);
+	}
+	DDSFile missing;
+	CHECK(!missing.Open("no such file.dds") && missing.GetStatus() == DDS_OPEN_FAILED);
+
+	//	Fuzz
+	for (size_t i = 0; i < cases.size(); ++i)
+		seeds.push_back(cases[i].bytes);
+	seeds.push_back(written);
+
+	long iterations = argc > 1 ? atol(argv[1]) : FUZZ_ITERATIONS;
+	std::mt19937 rng(FUZZ_SEED);
+	size_t counts[5] = {};
+	size_t broken = 0;
+	for (long it = 0; it < iterations; ++it){
+		std::vector<uint8_t> bytes = seeds[rng() % seeds.size()];
+		int mutations = 1 + rng() % 8;
+		for (int m = 0; m < mutations && !bytes.empty(); ++m){
+			//	Mostly inside the 148 header bytes, now and then anywhere
+			size_t reach = (rng() % 2) ? bytes.size() : std::min<size_t>(bytes.size(), 148);
+			size_t at = rng() % reach;
+			switch (rng() % 4){
+			case 0:
+				bytes[at] = (uint8_t)rng();
+				break;
+			case 1:
+				if (at + 4 <= bytes.size()){
+					uint32_t word = (rng() % 4) ? rng() % 70000 : (uint32_t)rng();
+					memcpy(&bytes[at], &word, sizeof(word));
+				}
+				break;
+			case 2:
+				bytes.resize(rng() % (bytes.size() + 1));
+				break;
+			default:
+				bytes[at] ^= (uint8_t)(1 << (rng() % 8));
+				break;
+			}
+		}
+
+		//	Exactly sized, so a read past the end is a read past the allocation
+		uint8_t* exact = (uint8_t*)malloc(bytes.size() ? bytes.size() : 1);
+		if (!bytes.empty())
+			memcpy(exact, bytes.data(), bytes.size());
+
+		DDSFile dds;
+		bool ok = dds.Parse(exact, bytes.size());
+		++counts[dds.GetStatus()];
+		if (ok && !Consistent(dds, exact, bytes.size()))
+			++broken;
+
+		//	Touch both ends of every subresource
+		if (ok){
+			unsigned int sum = 0;
+			for (size_t s = 0; s < dds.GetSubresourceCount(); ++s){
+				const DDSSubresource& sub = dds.GetSubresources()[s];
+				if (sub.size)
+					sum += sub.data[0] + sub.data[sub.size - 1];
+			}
+			volatile unsigned int sink = sum;
+			(void)sink;
+		}
+		free(exact);
+	}
+	printf("fuzz %ld: %zu ok, %zu invalid, %zu unsupported, %zu truncated\n", iterations,
+		counts[DDS_OK], counts[DDS_INVALID], counts[DDS_UNSUPPORTED], counts[DDS_TRUNCATED]);
+	CHECK(broken == 0);
+	CHECK(counts[DDS_OK] > 0 && counts[DDS_INVALID] > 0 && counts[DDS_UNSUPPORTED] > 0 && counts[DDS_TRUNCATED] > 0);
+
+	return CheckResult();
+}
@@ -0,0 +1,180 @@
+#include "FrustumCull.h"
+#include "JobSystem.h"
+#include "MathSIMD.h"
+#include "Check.h"
+#include "CullScene.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+//	CullInstances and CullInstancesParallel against the per plane loop
+//	cullAABB ran before the SoA path, at every SIMD level. The visible lists
+//	have to be the same indices in the same order. Besides the forest there
+//	are trees whose corner sits exactly on a plane, or an ulp or two off it,
+//	where only the same arithmetic order gives the same answer.
+
+//	The tree model's box, lopsided so every plane picks a different corner
+static const FLOAT3 treeAABB[2] = { FLOAT3(-1.25f, -0.5f, -0.75f), FLOAT3(1.5f, 6.0f, 0.75f) };
+
+//	The old cullAABB loop, XMVector3Dot(planeNormal, axisVert) spelled out:
+//	the products summed x + y, then + z, then the plane constant added
+static std::vector<unsigned int> ReferenceCull(const FLOAT4* frustumPlanes, const InstanceSoA& inst){
+	std::vector<unsigned int> visible;
+	for (size_t i = 0; i < inst.Size(); ++i){
+		bool cull = false;
+		for (int planeID = 0; planeID < 6; ++planeID){
+			FLOAT3 axisVert;
+			float planeConstant = frustumPlanes[planeID].w;
+
+			if (frustumPlanes[planeID].x < 0.0f)
+				axisVert.x = treeAABB[0].x + inst.x[i];
+			else
+				axisVert.x = treeAABB[1].x + inst.x[i];
+
+			if (frustumPlanes[planeID].y < 0.0f)
+				axisVert.y = treeAABB[0].y + inst.y[i];
+			else
+				axisVert.y = treeAABB[1].y + inst.y[i];
+
+			if (frustumPlanes[planeID].z < 0.0f)
+				axisVert.z = treeAABB[0].z + inst.z[i];
+			else
+				axisVert.z = treeAABB[1].z + inst.z[i];
+
+			float xy = frustumPlanes[planeID].x * axisVert.x + frustumPlanes[planeID].y * axisVert.y;
+			float dot = xy + frustumPlanes[planeID].z * axisVert.z;
+			if (dot + planeConstant < 0.0f){
+				cull = true;
+				break;
+			}
+		}
+		if (!cull)
+			visible.push_back((unsigned int)i);
+	}
+	return visible;
+}
+
+static float Random(float lo, float hi){
+	return lo + (hi - lo) * ((float)rand() / RAND_MAX);
+}
+
+//	Trees with the chosen corner of a plane exactly on it, solved for x, and
+//	the same nudged up to two ulps in and out. With all three normal
+//	components non zero about one in twenty of these flips if the products
+//	are summed in another order.
+static void AddOnPlanes(const FLOAT4* planes, InstanceSoA& inst){
+	for (int p = 0; p < 6; ++p){
+		const FLOAT4& n = planes[p];
+		if (n.x == 0.0f)
+			continue;
+		float cx = n.x < 0.0f ? treeAABB[0].x : treeAABB[1].x;
+		float cy = n.y < 0.0f ? treeAABB[0].y : treeAABB[1].y;
+		float cz = n.z < 0.0f ? treeAABB[0].z : treeAABB[1].z;
+		for (int k = 0; k < 64; ++k){
+			float y = Random(-2.0f, 3.0f), z = Random(-50.0f, 50.0f);
+			float x = -(n.w + n.y * (cy + y) + n.z * (cz + z)) / n.x - cx;
+			inst.Add(FLOAT3(x, y, z));
+			float in = x, out = x;
+			for (int u = 0; u < 2; ++u){
+				in = nextafterf(in, 1e30f);
+				out = nextafterf(out, -1e30f);
+				inst.Add(FLOAT3(in, y, z));
+				inst.Add(FLOAT3(out, y, z));
+			}
+		}
+	}
+}
+
+//	Six planes at any angle, as a rolled and pitched camera gives
+static void RandomPlanes(FLOAT4* planes){
+	for (int p = 0; p < 6; ++p){
+		FLOAT3 n(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+		float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+		planes[p] = FLOAT4(n.x / len, n.y / len, n.z / len, Random(-20.0f, 20.0f));
+	}
+}
+
+static void CheckPaths(const FLOAT4* planes, const InstanceSoA& inst, JobSystem& jobs){
+	std::vector<unsigned int> expected = ReferenceCull(planes, inst);
+	CullPlanes cull;
+	BuildCullPlanes(planes, treeAABB[0], treeAABB[1], cull);
+
+	size_t n = inst.Size();
+	std::vector<unsigned int> out(n);
+	SIMDLevel detected = DetectSIMDLevel();
+	for (int level = SIMD_SCALAR; level <= detected; ++level){
+		SetSIMDLevel((SIMDLevel)level);
+
+		size_t count = CullInstances(cull, inst, 0, n, &out[0]);
+		CHECK(std::vector<unsigned int>(out.begin(), out.begin() + count) == expected);
+
+		//	A range that starts and ends off the 4 / 8 lane boundaries
+		std::vector<unsigned int> inside;
+		for (size_t i = 0; i < expected.size(); ++i)
+			if (expected[i] >= 3 && expected[i] < n - 5)
+				inside.push_back(expected[i]);
+		count = CullInstances(cull, inst, 3, n - 5, &out[0]);
+		CHECK(std::vector<unsigned int>(out.begin(), out.begin() + count) == inside);
+
+		CullScratch scratch;
+		count = CullInstancesParallel(jobs, cull, inst, scratch, &out[0], 37);
+		CHECK(std::vector<unsigned int>(out.begin(), out.begin() + count) == expected);
+	}
+	SetSIMDLevel(detected);
+
+	size_t visible = 0;
+	for (size_t i = 0; i < n; ++i)
+		visible += IsInstanceVisible(cull, inst.Get(i)) ? 1 : 0;
+	CHECK(visible == expected.size());
+}
+
+int main(){
+	JobSystem jobs;
+	CHECK(jobs.Initialize(4));
+
+	//	A box of axis aligned planes, with trees on every face
+	const FLOAT4 box[6] = { FLOAT4(1.0f, 0.0f, 0.0f, 10.0f), FLOAT4(-1.0f, 0.0f, 0.0f, 10.0f), FLOAT4(0.0f, -1.0f, 0.0f, 5.0f),
+		FLOAT4(0.0f, 1.0f, 0.0f, 2.0f), FLOAT4(0.0f, 0.0f, 1.0f, -1.0f), FLOAT4(0.0f, 0.0f, -1.0f, 50.0f) };
+	InstanceSoA inst;
+	srand(3);
+	AddOnPlanes(box, inst);
+	for (float z = -2.0f; z <= 52.0f; z += 0.25f){
+		inst.Add(FLOAT3(-11.5f, 0.0f, z));			//	max x on x = -10
+		inst.Add(FLOAT3(11.25f, 0.0f, z));			//	min x on x = 10
+		inst.Add(FLOAT3(0.0f, -8.0f, z));			//	max y on y = -2
+		inst.Add(FLOAT3(0.0f, 5.5f, z));			//	min y on y = 5
+	}
+	CHECK(ReferenceCull(box, inst).size() > 0);
+	CheckPaths(box, inst, jobs);
+
+	//	The forest down the camera path, with trees on each frame's planes
+	float extent = SceneExtent(SCENE_TREES * 10);
+	for (size_t frame = 0; frame < 600; frame += 20){
+		FLOAT3 eye;
+		float yaw;
+		CameraPath(frame, extent, eye, yaw);
+		Frustum frustum;
+		MakeFrustum(eye, yaw, frustum);
+
+		MakeForest(inst, SCENE_TREES * 10);
+		srand((unsigned int)frame);
+		AddOnPlanes(frustum.planes, inst);
+		CheckPaths(frustum.planes, inst, jobs);
+	}
+
+	//	Planes at any angle, trees on each and scattered around them
+	srand(33);
+	for (int round = 0; round < 30; ++round){
+		FLOAT4 planes[6];
+		RandomPlanes(planes);
+		inst.Clear();
+		AddOnPlanes(planes, inst);
+		for (int i = 0; i < 200; ++i)
+			inst.Add(FLOAT3(Random(-30.0f, 30.0f), Random(-30.0f, 30.0f), Random(-30.0f, 30.0f)));
+		CheckPaths(planes, inst, jobs);
+	}
+
+	jobs.Shutdown();
+	return CheckResult();
+}
@@ -0,0 +1,59 @@
+#include "JobSystem.h"
+#include "Check.h"
+
+#include <atomic>
+#include <vector>
+
+//	Every index of a ParallelFor runs exactly once, for any thread count and
+//	for more chunks than the job rings hold at once
+
+static void CheckCoverage(JobSystem& jobs, size_t count, size_t chunkSize){
+	std::vector<std::atomic<int>> hits(count);
+	for (size_t i = 0; i < count; ++i)
+		hits[i].store(0);
+	std::atomic<size_t> chunks(0);
+	std::atomic<bool> badThread(false);
+	unsigned int numThreads = jobs.GetNumThreads();
+
+	jobs.ParallelFor(count, chunkSize, [&](size_t chunk, size_t begin, size_t end, unsigned int thread){
+		if (thread >= numThreads || begin != chunk * chunkSize)
+			badThread.store(true);
+		for (size_t i = begin; i < end; ++i)
+			hits[i].fetch_add(1);
+		chunks.fetch_add(1);
+	});
+
+	bool once = true;
+	for (size_t i = 0; i < count; ++i)
+		once = once && hits[i].load() == 1;
+	CHECK(once);
+	CHECK(!badThread.load());
+	CHECK(chunks.load() == (count + chunkSize - 1) / chunkSize);
+}
+
+int main(){
+	const unsigned int threadCounts[] = { 1, 2, 3, 8 };
+	for (unsigned int t = 0; t < 4; ++t){
+		JobSystem jobs;
+		jobs.Initialize(threadCounts[t]);
+		CHECK(jobs.GetNumThreads() == threadCounts[t]);
+
+		CheckCoverage(jobs, 1, 16);
+		CheckCoverage(jobs, 1000, 7);
+		CheckCoverage(jobs, 100000, 1024);
+
+		//	Several rounds through the rings, ending on a partial one
+		CheckCoverage(jobs, threadCounts[t] * JOB_QUEUE_CAPACITY * 3 + 5, 1);
+
+		//	Back to back calls reuse the rings
+		for (int i = 0; i < 100; ++i)
+			CheckCoverage(jobs, 64, 4);
+	}
+
+	//	Not initialized: runs inline on the caller
+	JobSystem idle;
+	CHECK(idle.GetNumThreads() == 1);
+	CheckCoverage(idle, 500, 32);
+
+	return CheckResult();
+}
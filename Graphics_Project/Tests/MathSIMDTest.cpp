@@ -0,0 +1,160 @@
+#include "MathSIMD.h"
+#include "Check.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static_assert(alignof(SIMDMatrix) == 16 && sizeof(SIMDMatrix) == sizeof(MATRIX4X4), "SIMDMatrix layout");
+static_assert(alignof(SIMDVector) == 16 && sizeof(SIMDVector) == sizeof(FLOAT4), "SIMDVector layout");
+
+//	Mult_4x4 / Mult_Vertex4x4 as MathFunc.cpp has them (MathFunc needs DirectXMath)
+static MATRIX4X4 RefMul(const MATRIX4X4& A, const MATRIX4X4& B){
+	MATRIX4X4 ans;
+	ans.a = (A.a * B.a) + (A.b * B.e) + (A.c * B.i) + (A.d * B.m);
+	ans.b = (A.a * B.b) + (A.b * B.f) + (A.c * B.j) + (A.d * B.n);
+	ans.c = (A.a * B.c) + (A.b * B.g) + (A.c * B.k) + (A.d * B.o);
+	ans.d = (A.a * B.d) + (A.b * B.h) + (A.c * B.l) + (A.d * B.p);
+	ans.e = (A.e * B.a) + (A.f * B.e) + (A.g * B.i) + (A.h * B.m);
+	ans.f = (A.e * B.b) + (A.f * B.f) + (A.g * B.j) + (A.h * B.n);
+	ans.g = (A.e * B.c) + (A.f * B.g) + (A.g * B.k) + (A.h * B.o);
+	ans.h = (A.e * B.d) + (A.f * B.h) + (A.g * B.l) + (A.h * B.p);
+	ans.i = (A.i * B.a) + (A.j * B.e) + (A.k * B.i) + (A.l * B.m);
+	ans.j = (A.i * B.b) + (A.j * B.f) + (A.k * B.j) + (A.l * B.n);
+	ans.k = (A.i * B.c) + (A.j * B.g) + (A.k * B.k) + (A.l * B.o);
+	ans.l = (A.i * B.d) + (A.j * B.h) + (A.k * B.l) + (A.l * B.p);
+	ans.m = (A.m * B.a) + (A.n * B.e) + (A.o * B.i) + (A.p * B.m);
+	ans.n = (A.m * B.b) + (A.n * B.f) + (A.o * B.j) + (A.p * B.n);
+	ans.o = (A.m * B.c) + (A.n * B.g) + (A.o * B.k) + (A.p * B.o);
+	ans.p = (A.m * B.d) + (A.n * B.h) + (A.o * B.l) + (A.p * B.p);
+	return ans;
+}
+
+static FLOAT4 RefTransform(const FLOAT4& ver, const MATRIX4X4& mat4){
+	FLOAT4 answer;
+	answer.x = (ver.x * mat4.a) + (ver.y * mat4.e) + (ver.z * mat4.i) + (ver.w * mat4.m);
+	answer.y = (ver.x * mat4.b) + (ver.y * mat4.f) + (ver.z * mat4.j) + (ver.w * mat4.n);
+	answer.z = (ver.x * mat4.c) + (ver.y * mat4.g) + (ver.z * mat4.k) + (ver.w * mat4.o);
+	answer.w = (ver.x * mat4.d) + (ver.y * mat4.h) + (ver.z * mat4.l) + (ver.w * mat4.p);
+	return answer;
+}
+
+static float Random(){
+	return (float)rand() / RAND_MAX * 200.0f - 100.0f;
+}
+
+static MATRIX4X4 RandomMatrix(){
+	MATRIX4X4 m;
+	float* f = &m.a;
+	for (int i = 0; i < 16; ++i)
+		f[i] = Random();
+	return m;
+}
+
+static bool Same(const void* a, const void* b, size_t bytes){
+	return memcmp(a, b, bytes) == 0;
+}
+
+static void TestLevel(SIMDLevel level){
+	SetSIMDLevel(level);
+	printf("level %d (asked for %d)\n", (int)GetSIMDLevel(), (int)level);
+
+	//	Odd counts take the AVX tails
+	const size_t n = 1001;
+	std::vector<MATRIX4X4> a(n), b(n), out(n), ref(n);
+	std::vector<FLOAT4> v(n), vout(n);
+	std::vector<FLOAT3> p(n), pout(n);
+	for (size_t i = 0; i < n; ++i){
+		a[i] = RandomMatrix();
+		b[i] = RandomMatrix();
+		v[i] = FLOAT4(Random(), Random(), Random(), Random());
+		p[i] = FLOAT3(Random(), Random(), Random());
+	}
+	MATRIX4X4 one = RandomMatrix();
+
+	MulBatch(&a[0], &b[0], &out[0], n);
+	for (size_t i = 0; i < n; ++i)
+		ref[i] = RefMul(a[i], b[i]);
+	CHECK(Same(&out[0], &ref[0], n * sizeof(MATRIX4X4)));
+
+	MulBatch(&a[0], one, &out[0], n);
+	for (size_t i = 0; i < n; ++i)
+		ref[i] = RefMul(a[i], one);
+	CHECK(Same(&out[0], &ref[0], n * sizeof(MATRIX4X4)));
+
+	TransformBatch(&v[0], one, &vout[0], n);
+	bool same = true;
+	for (size_t i = 0; i < n; ++i){
+		FLOAT4 r = RefTransform(v[i], one);
+		same &= Same(&r, &vout[i], sizeof(FLOAT4));
+	}
+	CHECK(same);
+
+	TransformPointBatch(&p[0], one, &pout[0], n);
+	same = true;
+	for (size_t i = 0; i < n; ++i){
+		FLOAT4 r = RefTransform(FLOAT4(p[i].x, p[i].y, p[i].z, 1.0f), one);
+		same &= Same(&r, &pout[i], sizeof(FLOAT3));
+	}
+	CHECK(same);
+
+	//	In place, out on top of a, then on top of b
+	std::vector<MATRIX4X4> alias = a;
+	MulBatch(&alias[0], &b[0], &alias[0], n);
+	for (size_t i = 0; i < n; ++i)
+		ref[i] = RefMul(a[i], b[i]);
+	CHECK(Same(&alias[0], &ref[0], n * sizeof(MATRIX4X4)));
+	alias = b;
+	MulBatch(&a[0], &alias[0], &alias[0], n);
+	CHECK(Same(&alias[0], &ref[0], n * sizeof(MATRIX4X4)));
+	alias = a;
+	MulBatch(&alias[0], alias[7], &alias[0], n);
+	for (size_t i = 0; i < n; ++i)
+		ref[i] = RefMul(a[i], a[7]);
+	CHECK(Same(&alias[0], &ref[0], n * sizeof(MATRIX4X4)));
+
+	//	The aligned types give the same bits
+	std::vector<SIMDMatrix> sa(n), sb(n), sout(n);
+	std::vector<SIMDVector> sv(n), svout(n);
+	for (size_t i = 0; i < n; ++i){
+		sa[i] = SIMDMatrix(a[i]);
+		sb[i] = SIMDMatrix(b[i]);
+		sv[i] = SIMDVector(v[i]);
+		CHECK(((size_t)&sa[i] & 15) == 0);
+	}
+	SIMDMatrix sone(one);
+
+	MulBatch(&sa[0], &sb[0], &sout[0], n);
+	MulBatch(&a[0], &b[0], &out[0], n);
+	CHECK(Same(&sout[0], &out[0], n * sizeof(MATRIX4X4)));
+
+	MulBatch(&sa[0], sone, &sout[0], n);
+	MulBatch(&a[0], one, &out[0], n);
+	CHECK(Same(&sout[0], &out[0], n * sizeof(MATRIX4X4)));
+
+	TransformBatch(&sv[0], sone, &svout[0], n);
+	TransformBatch(&v[0], one, &vout[0], n);
+	CHECK(Same(&svout[0], &vout[0], n * sizeof(FLOAT4)));
+
+	SIMDMatrix single;
+	Mul(sa[3], sb[3], single);
+	MATRIX4X4 r = RefMul(a[3], b[3]);
+	MATRIX4X4 back = single.ToMatrix();
+	CHECK(Same(&back, &r, sizeof(MATRIX4X4)));
+	Mul(single, sb[4], single);
+	r = RefMul(r, b[4]);
+	CHECK(Same(&single, &r, sizeof(MATRIX4X4)));
+
+	//	Nothing to do is fine
+	MulBatch(&a[0], &b[0], &out[0], 0);
+	TransformBatch(&sv[0], sone, &svout[0], 0);
+}
+
+int main(){
+	srand(1);
+	SIMDLevel detected = DetectSIMDLevel();
+	for (int level = SIMD_SCALAR; level <= detected; ++level)
+		TestLevel((SIMDLevel)level);
+	SetSIMDLevel(detected);
+	return CheckResult();
+}
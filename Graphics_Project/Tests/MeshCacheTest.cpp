@@ -0,0 +1,104 @@
+#include "MeshCache.h"
+#include "ObjLoader.h"
+#include "Check.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//	A cache written from Tree.obj opens and matches the model. Damaged copies
+//	(an index past the vertices, a bad sub-mesh, truncation, another source)
+//	are refused.
+
+static std::vector<char> ReadAll(const std::string& path){
+	std::vector<char> data;
+	FILE* f = fopen(path.c_str(), "rb");
+	if (!f)
+		return data;
+	fseek(f, 0, SEEK_END);
+	data.resize((size_t)ftell(f));
+	fseek(f, 0, SEEK_SET);
+	if (!data.empty() && fread(&data[0], 1, data.size(), f) != data.size())
+		data.clear();
+	fclose(f);
+	return data;
+}
+
+static void WriteAll(const std::string& path, const std::vector<char>& data, size_t size){
+	FILE* f = fopen(path.c_str(), "wb");
+	if (!f)
+		return;
+	fwrite(data.data(), 1, size, f);
+	fclose(f);
+}
+
+int main(){
+	Model model;
+	CHECK(LoadOBJFile("Tree.obj", &model));
+	CHECK(!model.out_Indicies.empty());
+
+	std::string path = std::string(P_tmpdir) + "/MeshCacheTest.mesh";
+	const unsigned long long hash = 0x1234, size = 5678;
+	CHECK(MeshCache::Write(path.c_str(), model, hash, size, 0));
+
+	{
+		MeshCache cache;
+		CHECK(cache.Open(path.c_str(), hash, size, 0));
+		const MeshView& view = cache.GetView();
+		CHECK(view.vertexCount == model.interleaved.size());
+		CHECK(view.indexCount == model.out_Indicies.size());
+		CHECK(memcmp(view.indices, model.out_Indicies.data(), view.indexCount * sizeof(unsigned int)) == 0);
+		CHECK(memcmp(view.verts, model.interleaved.data(), view.vertexCount * sizeof(Vert)) == 0);
+
+		CHECK(!cache.Open(path.c_str(), hash + 1, size, 0));
+		CHECK(!cache.Open(path.c_str(), hash, size, MESH_CACHE_TANGENTS));
+	}
+
+	std::vector<char> good = ReadAll(path);
+	MeshCacheHeader header;
+	memcpy(&header, good.data(), sizeof(header));
+
+	//	Last index one past the vertices, then far past them
+	unsigned int bad[] = { (unsigned int)header.vertexCount, 0xFFFFFFFFu };
+	for (int b = 0; b < 2; ++b){
+		std::vector<char> data = good;
+		memcpy(&data[header.indexOffset + (header.indexCount - 1) * sizeof(unsigned int)], &bad[b], sizeof(unsigned int));
+		WriteAll(path, data, data.size());
+		MeshCache cache;
+		CHECK(!cache.Open(path.c_str(), hash, size, 0));
+		CHECK(cache.GetView().indices == nullptr);
+	}
+
+	//	The highest index still in range is fine
+	{
+		std::vector<char> data = good;
+		unsigned int last = (unsigned int)header.vertexCount - 1;
+		memcpy(&data[header.indexOffset], &last, sizeof(unsigned int));
+		WriteAll(path, data, data.size());
+		MeshCache cache;
+		CHECK(cache.Open(path.c_str(), hash, size, 0));
+	}
+
+	//	A sub-mesh running past the index list
+	{
+		std::vector<char> data = good;
+		SubMesh sub;
+		memcpy(&sub, &data[header.subMeshOffset], sizeof(sub));
+		sub.indexCount = (unsigned int)header.indexCount + 3;
+		memcpy(&data[header.subMeshOffset], &sub, sizeof(sub));
+		WriteAll(path, data, data.size());
+		MeshCache cache;
+		CHECK(!cache.Open(path.c_str(), hash, size, 0));
+	}
+
+	//	Truncated anywhere
+	for (size_t cut = 0; cut < good.size(); cut += 97){
+		WriteAll(path, good, cut);
+		MeshCache cache;
+		CHECK(!cache.Open(path.c_str(), hash, size, 0));
+	}
+
+	remove(path.c_str());
+	return CheckResult();
+}
@@ -0,0 +1,158 @@
+#include "MeshOptimize.h"
+#include "ObjLoader.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//	The reorder passes on the CPU: OptimizeVertexCache, OptimizeOverdraw and
+//	OptimizeVertexFetch keep every triangle with its winding, fetch keeps
+//	every corner's attributes and drops only unused vertices, sub-meshes keep
+//	their own triangles, and the cache pass never makes Tree.obj's ACMR worse.
+
+//	Triangle as the bytes of its three corners, rotated so the smallest comes
+//	first. Rotation keeps the winding, a flipped triangle comes out different.
+static std::string TriangleKey(const Vert* verts, const unsigned int* tri){
+	int first = 0;
+	for (int c = 1; c < 3; ++c)
+		if (memcmp(&verts[tri[c]], &verts[tri[first]], sizeof(Vert)) < 0)
+			first = c;
+	std::string key;
+	for (int c = 0; c < 3; ++c)
+		key.append((const char*)&verts[tri[(first + c) % 3]], sizeof(Vert));
+	return key;
+}
+
+//	Sorted triangle keys of indices [first, first + count)
+static std::vector<std::string> Triangles(const Model& m, size_t first, size_t count){
+	std::vector<std::string> keys;
+	for (size_t i = first; i + 3 <= first + count; i += 3)
+		keys.push_back(TriangleKey(m.interleaved.data(), &m.out_Indicies[i]));
+	std::sort(keys.begin(), keys.end());
+	return keys;
+}
+
+static std::vector<std::string> Triangles(const Model& m){
+	return Triangles(m, 0, m.out_Indicies.size());
+}
+
+static float ACMR(const Model& m){
+	return AnalyzeVertexCache(m.out_Indicies.data(), m.out_Indicies.size(), m.interleaved.size()).acmr;
+}
+
+//	Indices number vertices in order of first use, every vertex used
+static bool InFetchOrder(const Model& m){
+	unsigned int next = 0;
+	for (size_t i = 0; i < m.out_Indicies.size(); ++i){
+		if (m.out_Indicies[i] > next)
+			return false;
+		if (m.out_Indicies[i] == next)
+			++next;
+	}
+	return next == m.interleaved.size();
+}
+
+static void CheckPasses(const char* name, const Model& loaded){
+	//	Each pass on its own, then the three in a row
+	Model m = loaded;
+	std::vector<std::string> before = Triangles(m);
+	float acmrBefore = ACMR(m);
+
+	OptimizeVertexCache(m.out_Indicies.data(), m.out_Indicies.size(), m.interleaved.size());
+	CHECK(Triangles(m) == before);
+	float acmrCache = ACMR(m);
+
+	OptimizeOverdraw(m.out_Indicies.data(), m.out_Indicies.size(), m.interleaved.data(), m.interleaved.size());
+	CHECK(Triangles(m) == before);
+	float acmrOverdraw = ACMR(m);
+
+	//	A vertex nothing uses goes, the rest keep their attributes per corner
+	Vert unused = m.interleaved[0];
+	unused.Pos.x += 1000.0f;
+	m.interleaved.push_back(unused);
+	std::vector<unsigned int> oldIndices = m.out_Indicies;
+	std::vector<Vert> oldVerts = m.interleaved;
+	size_t kept = OptimizeVertexFetch(&m);
+	CHECK(kept == m.interleaved.size() && kept == loaded.interleaved.size());
+	CHECK(InFetchOrder(m));
+	CHECK(Triangles(m) == before);
+	bool corners = m.out_Indicies.size() == oldIndices.size();
+	for (size_t i = 0; corners && i < oldIndices.size(); ++i)
+		corners = memcmp(&m.interleaved[m.out_Indicies[i]], &oldVerts[oldIndices[i]], sizeof(Vert)) == 0;
+	CHECK(corners);
+	CHECK(ACMR(m) == acmrOverdraw);
+
+	printf("%-10s ACMR %.3f, cache %.3f, overdraw sort %.3f\n", name, acmrBefore, acmrCache, acmrOverdraw);
+	CHECK(acmrCache <= acmrBefore);
+}
+
+int main(){
+	Model tree, cube;
+	CHECK(LoadOBJFile("Tree.obj", &tree));
+	CHECK(LoadOBJFile("Cube.obj", &cube));
+	CHECK(!tree.out_Indicies.empty() && !cube.out_Indicies.empty());
+
+	CheckPasses("Tree.obj", tree);
+	CheckPasses("Cube.obj", cube);
+
+	//	Tree.obj with its triangles shuffled, the cache pass has real work
+	Model shuffled = tree;
+	srand(13);
+	size_t triCount = shuffled.out_Indicies.size() / 3;
+	for (size_t t = triCount - 1; t > 0; --t){
+		size_t o = rand() % (t + 1);
+		std::swap_ranges(&shuffled.out_Indicies[t * 3], &shuffled.out_Indicies[t * 3] + 3, &shuffled.out_Indicies[o * 3]);
+	}
+	CheckPasses("shuffled", shuffled);
+
+	//	OptimizeModel on Tree.obj as loaded never gets a worse ACMR, with or
+	//	without the overdraw sort
+	const unsigned int flagSets[] = { 0, MESH_OPTIMIZE_OVERDRAW };
+	for (int f = 0; f < 2; ++f){
+		Model m = tree;
+		OptimizeModel(&m, flagSets[f]);
+		CHECK(Triangles(m) == Triangles(tree) && InFetchOrder(m));
+		printf("OptimizeModel(Tree.obj, %u) ACMR %.3f\n", flagSets[f], ACMR(m));
+		CHECK(ACMR(m) <= ACMR(tree));
+	}
+
+	//	Shuffled Tree.obj split into three sub-meshes: each keeps its own
+	//	triangles and range, and the whole does better than the shuffle
+	Model split = shuffled;
+	unsigned int third = (unsigned int)(triCount / 3) * 3;
+	split.subMeshes.clear();
+	for (unsigned int s = 0; s < 3; ++s){
+		SubMesh sub = { s * third, s < 2 ? third : (unsigned int)split.out_Indicies.size() - 2 * third, s, 0 };
+		split.subMeshes.push_back(sub);
+	}
+	for (int f = 0; f < 2; ++f){
+		Model m = split;
+		OptimizeModel(&m, flagSets[f]);
+		CHECK(m.subMeshes.size() == 3 && InFetchOrder(m));
+		for (size_t s = 0; s < 3; ++s){
+			const SubMesh& a = split.subMeshes[s];
+			const SubMesh& b = m.subMeshes[s];
+			CHECK(a.firstIndex == b.firstIndex && a.indexCount == b.indexCount);
+			CHECK(Triangles(m, b.firstIndex, b.indexCount) == Triangles(split, a.firstIndex, a.indexCount));
+		}
+		CHECK(ACMR(m) <= ACMR(split));
+	}
+
+	//	Nothing to do for an empty or single triangle model
+	Model empty;
+	OptimizeModel(&empty);
+	CHECK(empty.interleaved.empty() && empty.out_Indicies.empty());
+	Model one;
+	one.interleaved.assign(tree.interleaved.begin(), tree.interleaved.begin() + 4);
+	unsigned int tri[3] = { 3, 1, 2 };
+	one.out_Indicies.assign(tri, tri + 3);
+	OptimizeModel(&one);
+	CHECK(one.interleaved.size() == 3 && one.out_Indicies.size() == 3);
+	CHECK(memcmp(&one.interleaved[one.out_Indicies[0]], &tree.interleaved[3], sizeof(Vert)) == 0);
+
+	return CheckResult();
+}
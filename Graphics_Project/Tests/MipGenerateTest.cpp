@@ -0,0 +1,193 @@
+#include "MipGenerate.h"
+#include "JobSystem.h"
+#include "MathSIMD.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+//	Mip chains: a one texel checker averages in linear light, constant
+//	colours stay exact at odd sizes under both filters, the SSE2 and threaded
+//	paths write the same floats and bytes as the scalar one, and the
+//	_barrelN chain keeps its normals unit length.
+
+//	A width x height single mip RGBA8 file, texel(x, y, rgba) fills it
+template <typename Fn>
+static void MakeFile(size_t width, size_t height, DXGI_FORMAT format, std::vector<uint8_t>& bytes, const Fn& texel){
+	DDSInfo info;
+	memset(&info, 0, sizeof(info));
+	info.width = width;
+	info.height = height;
+	info.depth = 1;
+	info.mipCount = 1;
+	info.arraySize = 1;
+	info.format = format;
+	info.dimension = DDS_DIMENSION_TEXTURE2D;
+	bytes.clear();
+	WriteDDSHeader(info, bytes);
+	for (size_t y = 0; y < height; ++y){
+		for (size_t x = 0; x < width; ++x){
+			uint8_t rgba[4];
+			texel(x, y, rgba);
+			bytes.insert(bytes.end(), rgba, rgba + 4);
+		}
+	}
+}
+
+//	Every texel of every level below the top equal to rgba
+static bool LevelsAre(const DDSFile& chain, const uint8_t* rgba){
+	for (size_t mip = 1; mip < chain.GetInfo().mipCount; ++mip){
+		const DDSSubresource& s = chain.GetSubresource(0, mip);
+		for (size_t y = 0; y < s.height; ++y)
+			for (size_t x = 0; x < s.width; ++x)
+				if (memcmp(s.data + y * s.rowPitch + x * 4, rgba, 4) != 0)
+					return false;
+	}
+	return true;
+}
+
+static void TestChecker(){
+	std::vector<uint8_t> bytes, out;
+	MakeFile(16, 16, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, bytes, [](size_t x, size_t y, uint8_t* rgba){
+		uint8_t v = ((x + y) & 1) ? 255 : 0;
+		rgba[0] = rgba[1] = rgba[2] = rgba[3] = v;
+	});
+	DDSFile src;
+	CHECK(src.Parse(&bytes[0], bytes.size()));
+
+	//	Half linear light is sRGB 188, alpha is linear and lands on 128
+	const unsigned int flags[] = { 0, MIP_WRAP };
+	for (int f = 0; f < 2; ++f){
+		CHECK(GenerateMipChain(src, out, MIP_FILTER_BOX, flags[f]));
+		DDSFile chain;
+		CHECK(chain.Parse(&out[0], out.size()));
+		CHECK(chain.GetInfo().mipCount == 5);
+		CHECK(memcmp(chain.GetSubresource(0, 0).data, &bytes[bytes.size() - 16 * 16 * 4], 16 * 16 * 4) == 0);
+		const uint8_t expected[4] = { 188, 188, 188, 128 };
+		CHECK(LevelsAre(chain, expected));
+	}
+
+	//	Without MIP_SRGB the same file averages to 128 (127.5 rounded)
+	MakeFile(16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, bytes, [](size_t x, size_t y, uint8_t* rgba){
+		uint8_t v = ((x + y) & 1) ? 255 : 0;
+		rgba[0] = rgba[1] = rgba[2] = rgba[3] = v;
+	});
+	CHECK(src.Parse(&bytes[0], bytes.size()));
+	CHECK(GenerateMipChain(src, out, MIP_FILTER_BOX, 0));
+	DDSFile chain;
+	CHECK(chain.Parse(&out[0], out.size()));
+	const uint8_t linear[4] = { 128, 128, 128, 128 };
+	CHECK(LevelsAre(chain, linear));
+}
+
+static void TestConstant(){
+	const MipFilter filters[] = { MIP_FILTER_BOX, MIP_FILTER_KAISER };
+	const uint8_t colors[][4] = { { 0, 0, 0, 0 }, { 255, 255, 255, 255 }, { 37, 128, 201, 90 }, { 1, 254, 77, 255 } };
+	std::vector<uint8_t> bytes, out;
+	bool exact = true;
+	for (size_t width = 1; width <= 100; width += 3){
+		for (size_t height = 1; height <= 64; height += 7){
+			const uint8_t* color = colors[(width + height) % 4];
+			DXGI_FORMAT format = (width & 1) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+			MakeFile(width, height, format, bytes, [&](size_t, size_t, uint8_t* rgba){ memcpy(rgba, color, 4); });
+			DDSFile src;
+			CHECK(src.Parse(&bytes[0], bytes.size()));
+			for (int f = 0; f < 2; ++f){
+				for (unsigned int flags = 0; flags <= MIP_WRAP; flags += MIP_WRAP){
+					DDSFile chain;
+					exact = exact && GenerateMipChain(src, out, filters[f], flags) && chain.Parse(&out[0], out.size())
+						&& chain.GetInfo().mipCount == FullMipCount(width, height) && LevelsAre(chain, color);
+				}
+			}
+		}
+	}
+	CHECK(exact);
+	CHECK(FullMipCount(1, 1) == 1 && FullMipCount(512, 512) == 10 && FullMipCount(37, 5) == 6 && FullMipCount(1, 100) == 7);
+}
+
+//	DownsampleLevel and whole chains at every SIMD level and over jobs
+static void TestPaths(JobSystem& jobs){
+	SIMDLevel detected = DetectSIMDLevel();
+	srand(25);
+	const size_t sizes[][2] = { { 64, 64 }, { 37, 21 }, { 1, 9 }, { 130, 3 } };
+	const MipFilter filters[] = { MIP_FILTER_BOX, MIP_FILTER_KAISER };
+	const unsigned int flagSets[] = { 0, MIP_WRAP, MIP_NORMAL_MAP | MIP_WRAP };
+	for (size_t s = 0; s < 4; ++s){
+		size_t width = sizes[s][0], height = sizes[s][1];
+		std::vector<float> src(width * height * 4);
+		for (size_t i = 0; i < src.size(); ++i)
+			src[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+		size_t count = std::max<size_t>(width / 2, 1) * std::max<size_t>(height / 2, 1) * 4;
+
+		for (int f = 0; f < 2; ++f){
+			for (int k = 0; k < 3; ++k){
+				std::vector<float> scalar(count), other(count);
+				SetSIMDLevel(SIMD_SCALAR);
+				DownsampleLevel(&src[0], width, height, &scalar[0], filters[f], flagSets[k]);
+				for (int level = SIMD_SSE2; level <= detected; ++level){
+					SetSIMDLevel((SIMDLevel)level);
+					DownsampleLevel(&src[0], width, height, &other[0], filters[f], flagSets[k]);
+					CHECK(memcmp(&other[0], &scalar[0], count * sizeof(float)) == 0);
+					DownsampleLevel(&src[0], width, height, &other[0], filters[f], flagSets[k], &jobs);
+					CHECK(memcmp(&other[0], &scalar[0], count * sizeof(float)) == 0);
+				}
+			}
+		}
+	}
+
+	DDSFile barrel;
+	CHECK(barrel.Open("../Assets/_barrel.dds"));
+	for (int f = 0; f < 2; ++f){
+		std::vector<uint8_t> scalar, other;
+		SetSIMDLevel(SIMD_SCALAR);
+		CHECK(GenerateMipChain(barrel, scalar, filters[f], MIP_SRGB | MIP_WRAP));
+		SetSIMDLevel(detected);
+		CHECK(GenerateMipChain(barrel, other, filters[f], MIP_SRGB | MIP_WRAP, &jobs));
+		CHECK(other == scalar);
+	}
+}
+
+//	Every level of the _barrelN chain decodes to unit normals, to within
+//	half an 8 bit step on each of the three channels (sqrt(3) / 255)
+static void TestNormals(JobSystem& jobs){
+	DDSFile src;
+	CHECK(src.Open("../Assets/_barrelN.dds"));
+	std::vector<uint8_t> out;
+	CHECK(GenerateMipChain(src, out, MIP_FILTER_KAISER, MIP_NORMAL_MAP | MIP_WRAP, &jobs));
+	DDSFile chain;
+	CHECK(chain.Parse(&out[0], out.size()));
+	CHECK(chain.GetInfo().mipCount == 10);
+
+	double worst = 0.0;
+	for (size_t mip = 1; mip < chain.GetInfo().mipCount; ++mip){
+		const DDSSubresource& s = chain.GetSubresource(0, mip);
+		for (size_t y = 0; y < s.height; ++y){
+			for (size_t x = 0; x < s.width; ++x){
+				const uint8_t* t = s.data + y * s.rowPitch + x * 4;
+				double n[3];
+				for (int c = 0; c < 3; ++c)
+					n[c] = t[c] / 255.0 * 2.0 - 1.0;
+				worst = fmax(worst, fabs(sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) - 1.0));
+			}
+		}
+	}
+	printf("_barrelN worst normal length error %.4f\n", worst);
+	CHECK(worst <= 0.0068);
+}
+
+int main(){
+	JobSystem jobs;
+	CHECK(jobs.Initialize(4));
+
+	TestChecker();
+	TestConstant();
+	TestPaths(jobs);
+	TestNormals(jobs);
+
+	jobs.Shutdown();
+	return CheckResult();
+}
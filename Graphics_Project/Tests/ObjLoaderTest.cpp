@@ -0,0 +1,257 @@
+#include "ObjLoader.h"
+#include "JobSystem.h"
+#include "Check.h"
+#include "FscanfOBJ.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//	ParseOBJ gives the same model whatever the job system splits it into,
+//	and the same corners the fscanf loader it replaced read from the bundled
+//	models, in fewer vertices
+
+static bool SameModel(const Model& a, const Model& b){
+	if (a.interleaved.size() != b.interleaved.size() || a.out_Indicies != b.out_Indicies)
+		return false;
+	if (a.subMeshes.size() != b.subMeshes.size() || a.materials != b.materials || a.groups != b.groups || a.materialLib != b.materialLib)
+		return false;
+	for (size_t i = 0; i < a.subMeshes.size(); ++i){
+		const SubMesh& x = a.subMeshes[i];
+		const SubMesh& y = b.subMeshes[i];
+		if (x.firstIndex != y.firstIndex || x.indexCount != y.indexCount || x.material != y.material || x.group != y.group)
+			return false;
+	}
+	return a.interleaved.empty() || memcmp(&a.interleaved[0], &b.interleaved[0], a.interleaved.size() * sizeof(Vert)) == 0;
+}
+
+//	A grid big enough to split, with relative indices, quads, missing normals
+//	and group / material changes all through it
+static std::string MakeGrid(int size){
+	std::string text = "mtllib grid.mtl\n";
+	char line[128];
+	for (int z = 0; z <= size; ++z){
+		for (int x = 0; x <= size; ++x){
+			snprintf(line, sizeof(line), "v %d.5 %g %d.25\nvt %g %g\nvn 0 1 0\n", x, (x * z % 7) * 0.1, z, x / (float)size, z / (float)size);
+			text += line;
+		}
+	}
+	int row = size + 1;
+	for (int z = 0; z < size; ++z){
+		snprintf(line, sizeof(line), "g row%d\nusemtl mat%d\n", z % 5, z % 3);
+		text += line;
+		for (int x = 0; x < size; ++x){
+			int v = z * row + x + 1;
+			if (x % 3 == 0)
+				snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", v, v, v, v + 1, v + 1, v + 1, v + row + 1, v + row + 1, v + row + 1, v + row, v + row, v + row);
+			else if (x % 3 == 1)
+				snprintf(line, sizeof(line), "f %d/%d %d/%d %d/%d\n", v, v, v + 1, v + 1, v + row + 1, v + row + 1);
+			else{
+				int last = (size + 1) * (size + 1);
+				int r = v - last - 1;
+				snprintf(line, sizeof(line), "f %d//%d %d//%d %d//%d\n", r, r, r + row + 1, r + row + 1, r + row, r + row);
+			}
+			text += line;
+		}
+	}
+	text += "f 1 2 3";		//	no newline at the end
+	return text;
+}
+
+static std::vector<char> ReadFile(const char* path){
+	std::vector<char> data;
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return data;
+	fseek(f, 0, SEEK_END);
+	data.resize((size_t)ftell(f));
+	fseek(f, 0, SEEK_SET);
+	if (!data.empty() && fread(&data[0], 1, data.size(), f) != data.size())
+		data.clear();
+	fclose(f);
+	return data;
+}
+
+//	ParseOBJ and StreamOBJ on a small text, ParseOBJ's model in m. Both have
+//	to agree on whether it loads.
+static bool LoadText(const std::string& text, Model* m){
+	bool parsed = ParseOBJ(text.data(), text.size(), m);
+
+	std::string path = std::string(P_tmpdir) + "/ObjLoaderTestSmall.obj";
+	FILE* f = fopen(path.c_str(), "wb");
+	bool written = f && fwrite(text.data(), 1, text.size(), f) == text.size();
+	if (f)
+		fclose(f);
+	Model streamed;
+	ModelSink sink(&streamed);
+	bool stream = written && StreamOBJ(path.c_str(), &sink, OBJ_STREAM_MIN_BUDGET);
+	remove(path.c_str());
+
+	CHECK(written && stream == parsed);
+	CHECK(!parsed || streamed.out_Indicies.size() == m->out_Indicies.size());
+	return parsed;
+}
+
+//	Faces beyond MakeGrid's quads and triangles: n-gons fan from their first
+//	corner, faces that can't be read or point outside what came before fail
+//	the whole load and leave the model empty, and a usemtl with no faces
+//	after it makes no sub-mesh
+static void TestFaces(){
+	const std::string square = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 1 1\n";
+	const std::string ring = "v 1 0 0\nv 0.5 0.8 0\nv -0.5 0.8 0\nv -1 0 0\nv -0.5 -0.8 0\nv 0.5 -0.8 0\nv 1 -0.1 0\n";
+
+	//	Five, six and seven corners, then all three in one file
+	const char* ngons[] = { "f 1 2 3 4 5\n", "f 1 2 3 4 5 6\n", "f -7 -6 -5 -4 -3 -2 -1\n" };
+	const size_t triangles[] = { 3, 4, 5 };
+	for (int n = 0; n < 3; ++n){
+		Model m;
+		CHECK(LoadText(ring + ngons[n], &m));
+		CHECK(m.out_Indicies.size() == triangles[n] * 3 && m.interleaved.size() == triangles[n] + 2);
+		bool fan = m.out_Indicies.size() == triangles[n] * 3;
+		for (size_t t = 0; fan && t < triangles[n]; ++t){
+			const unsigned int* tri = &m.out_Indicies[t * 3];
+			fan = m.interleaved[tri[0]].Pos.x == 1.0f && m.interleaved[tri[0]].Pos.y == 0.0f
+				&& tri[1] == t + 1 && tri[2] == t + 2;
+		}
+		CHECK(fan);
+	}
+	Model all;
+	CHECK(LoadText(ring + ngons[0] + ngons[1] + ngons[2], &all));
+	CHECK(all.out_Indicies.size() == (3 + 4 + 5) * 3 && all.subMeshes.size() == 1);
+
+	//	Each of these fails the load, whichever line it's on
+	const char* bad[] = {
+		"f 1/ 2/ 3/\n",			//	slash with no uv after it
+		"f 1/1/ 2/2/ 3/3/\n",		//	nor a normal
+		"f 1 2\n",					//	two corners
+		"f 1\n",
+		"f\n",
+		"f 0 1 2\n",				//	OBJ counts from 1
+		"f 1/0 2/1 3/2\n",
+		"f -0 1 2\n",
+		"f -5 1 2\n",				//	four positions back when there are four
+		"f -6 1 2\n",
+		"f 1/-4 2/1 3/2\n",		//	four uvs back when there are three
+		"f 1 2 5\n",				//	past the end
+		"f 1//1 2//1 3//1\n",		//	normal that isn't there
+		"f 1 2 x\n",
+	};
+	for (size_t b = 0; b < sizeof(bad) / sizeof(bad[0]); ++b){
+		Model m;
+		bool loaded = LoadText(square + "f 1 2 3\n" + bad[b] + "f 1 3 4\n", &m);
+		if (loaded)
+			printf("loaded: %s", bad[b]);
+		CHECK(!loaded);
+		CHECK(m.interleaved.empty() && m.out_Indicies.empty() && m.subMeshes.empty());
+	}
+
+	//	The last usemtl and g have no faces after them: the faces before keep
+	//	their material and no empty range is added. A file that only names a
+	//	material has nothing to draw.
+	Model trailing;
+	CHECK(LoadText(square + "usemtl a\nf 1/1 2/2 3/3\nf 1 3 4\nusemtl b\ng rest\n", &trailing));
+	CHECK(trailing.out_Indicies.size() == 6 && trailing.subMeshes.size() == 1);
+	if (trailing.subMeshes.size() == 1){
+		const SubMesh& sub = trailing.subMeshes[0];
+		CHECK(sub.firstIndex == 0 && sub.indexCount == 6 && trailing.materials[sub.material] == "a");
+	}
+	Model named;
+	CHECK(LoadText(square + "usemtl a\n", &named));
+	CHECK(named.out_Indicies.empty() && named.subMeshes.empty());
+}
+
+int main(){
+	std::string grid = MakeGrid(700);
+	CHECK(grid.size() > 8 * (1 << 20));
+
+	std::vector<char> tree = ReadFile("Tree.obj");
+	CHECK(!tree.empty());
+
+	const char* names[] = { "grid", "Tree.obj" };
+	const char* texts[] = { grid.data(), tree.empty() ? "" : &tree[0] };
+	size_t sizes[] = { grid.size(), tree.size() };
+
+	for (int t = 0; t < 2; ++t){
+		Model serial;
+		CHECK(ParseOBJ(texts[t], sizes[t], &serial));
+		CHECK(!serial.out_Indicies.empty());
+
+		const unsigned int threadCounts[] = { 1, 2, 3, 8 };
+		for (int j = 0; j < 4; ++j){
+			JobSystem jobs;
+			jobs.Initialize(threadCounts[j]);
+			Model split;
+			CHECK(ParseOBJ(texts[t], sizes[t], &split, &jobs));
+			CHECK(SameModel(serial, split));
+		}
+		printf("%s: %zu vertices, %zu indices, %zu sub-meshes\n", names[t], serial.interleaved.size(), serial.out_Indicies.size(), serial.subMeshes.size());
+	}
+
+	//	Every corner of the bundled models as the old loader expanded it
+	const char* bundled[] = { "Tree.obj", "Cube.obj" };
+	for (int b = 0; b < 2; ++b){
+		Model old, loaded;
+		CHECK(FscanfLoadOBJ(bundled[b], &old));
+		CHECK(LoadOBJFile(bundled[b], &loaded));
+		CHECK(!old.out_Indicies.empty() && SameCorners(old, loaded));
+	}
+
+	//	What dedup saves: a Vert and a 32 bit index per corner before, one
+	//	Vert per distinct corner and 16 bit indices where they fit now. The
+	//	expanded corners stay the old loader's.
+	printf("%-10s %8s %8s %9s %9s\n", "model", "corners", "verts", "bytes was", "bytes now");
+	for (int b = 0; b < 2; ++b){
+		Model old, loaded;
+		CHECK(FscanfLoadOBJ(bundled[b], &old));
+		CHECK(LoadOBJFile(bundled[b], &loaded));
+		size_t corners = loaded.out_Indicies.size(), verts = loaded.interleaved.size();
+		size_t was = corners * (sizeof(Vert) + 4);
+		size_t now = verts * sizeof(Vert) + corners * (verts <= 65536 ? 2 : 4);
+		printf("%-10s %8zu %8zu %9zu %9zu\n", bundled[b], corners, verts, was, now);
+		CHECK(corners == old.interleaved.size() && verts < corners && now < was);
+		CHECK(SameCorners(old, loaded));
+	}
+
+	TestFaces();
+
+	//	A bad index in a later chunk still fails the whole parse
+	std::string bad = grid + "\nf 1 2 99999999\n";
+	JobSystem jobs;
+	jobs.Initialize(4);
+	Model model;
+	CHECK(!ParseOBJ(bad.data(), bad.size(), &model, &jobs));
+	CHECK(model.interleaved.empty() && model.out_Indicies.empty());
+
+	//	StreamOBJ stays inside its budget and draws the same triangles, even
+	//	when the vertex table has to start over. Normals aren't compared, the
+	//	faces without vn get theirs differently.
+	std::string path = std::string(P_tmpdir) + "/ObjLoaderTest.obj";
+	FILE* f = fopen(path.c_str(), "wb");
+	CHECK(f && fwrite(grid.data(), 1, grid.size(), f) == grid.size());
+	if (f)
+		fclose(f);
+
+	Model parsed;
+	CHECK(ParseOBJ(grid.data(), grid.size(), &parsed));
+	const size_t budgets[] = { 36 << 20, 40 << 20, 48 << 20, 100 << 20 };
+	for (int b = 0; b < 4; ++b){
+		Model streamed;
+		ModelSink sink(&streamed);
+		ObjStreamStats stats;
+		CHECK(StreamOBJ(path.c_str(), &sink, budgets[b], &stats));
+		printf("stream budget %zu MB: peak %.1f MB, %u table resets\n", budgets[b] >> 20, stats.peakBytes / 1048576.0, stats.tableResets);
+		CHECK(stats.peakBytes <= budgets[b]);
+
+		bool same = streamed.out_Indicies.size() == parsed.out_Indicies.size();
+		for (size_t i = 0; same && i < parsed.out_Indicies.size(); ++i){
+			const Vert& a = parsed.interleaved[parsed.out_Indicies[i]];
+			const Vert& c = streamed.interleaved[streamed.out_Indicies[i]];
+			same = memcmp(&a.Pos, &c.Pos, sizeof(a.Pos)) == 0 && memcmp(&a.Uvs, &c.Uvs, sizeof(a.Uvs)) == 0;
+		}
+		CHECK(same);
+	}
+	remove(path.c_str());
+
+	return CheckResult();
+}
@@ -0,0 +1,122 @@
+#include "VertexFormat.h"
+#include "Check.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//	The input layouts main.cpp builds from the element tables against the
+//	inputs the vertex shaders declare: every input has an element with its
+//	semantic and enough components, and the elements sit inside the vertex
+//	without overlapping. What CreateInputLayout checks on the device.
+
+struct ShaderInput{
+	std::string type, semantic;
+	unsigned int components;
+};
+
+//	"float2 inNorm : COLOR" for each parameter of main(...)
+static std::vector<ShaderInput> ReadInputs(const char* path){
+	std::vector<ShaderInput> inputs;
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return inputs;
+	std::string text;
+	char buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		text.append(buffer, n);
+	fclose(f);
+
+	size_t open = text.find(" main(");
+	size_t close = text.find(')', open);
+	if (open == std::string::npos || close == std::string::npos)
+		return inputs;
+
+	std::string params = text.substr(open + 6, close - open - 6);
+	size_t start = 0;
+	while (start < params.size()){
+		size_t end = params.find(',', start);
+		if (end == std::string::npos)
+			end = params.size();
+		std::string param = params.substr(start, end - start);
+		start = end + 1;
+
+		char type[64], name[64], semantic[64];
+		if (sscanf(param.c_str(), " %63s %63s : %63s", type, name, semantic) != 3)
+			continue;
+
+		ShaderInput input;
+		input.type = type;
+		input.semantic = semantic;
+		char last = input.type.empty() ? 0 : input.type[input.type.size() - 1];
+		input.components = (last >= '1' && last <= '4') ? (unsigned int)(last - '0') : 1;
+		inputs.push_back(input);
+	}
+	return inputs;
+}
+
+static unsigned int FormatBytes(unsigned int format){
+	static const unsigned int bytes[] = { 8, 12, 8, 4, 4, 16 };
+	return bytes[format];
+}
+
+static void CheckLayout(const char* shader, const MeshVertexElement* elements, unsigned int count, size_t stride){
+	std::vector<ShaderInput> inputs = ReadInputs(shader);
+	CHECK(!inputs.empty());
+
+	for (size_t i = 0; i < inputs.size(); ++i){
+		const ShaderInput& in = inputs[i];
+		bool found = false;
+		for (unsigned int e = 0; e < count; ++e){
+			if (in.semantic != MeshAttributeSemantic(elements[e].attribute))
+				continue;
+			found = true;
+
+			//	Missing components read as 0, 0, 0, 1: only a position may lean on the w
+			unsigned int given = MeshFormatComponents(elements[e].format);
+			bool enough = in.components <= given || (in.semantic == "POSITION" && given == 3 && in.components == 4);
+			if (!enough)
+				printf("%s: %s wants %u components, the layout gives %u\n", shader, in.semantic.c_str(), in.components, given);
+			CHECK(enough);
+			CHECK(in.type.compare(0, 5, "float") == 0);
+		}
+		if (!found)
+			printf("%s: no element for %s\n", shader, in.semantic.c_str());
+		CHECK(found);
+	}
+
+	for (unsigned int e = 0; e < count; ++e){
+		CHECK(elements[e].offset + FormatBytes(elements[e].format) <= stride);
+		for (unsigned int o = 0; o < e; ++o){
+			bool apart = elements[e].offset >= elements[o].offset + FormatBytes(elements[o].format)
+				|| elements[o].offset >= elements[e].offset + FormatBytes(elements[e].format);
+			CHECK(apart);
+		}
+	}
+	printf("%s: %zu inputs match\n", shader, inputs.size());
+}
+
+int main(){
+	MeshVertexElement vert[MESH_MAX_ELEMENTS], packed[MESH_MAX_ELEMENTS];
+	unsigned int vertCount = DescribeVert(vert);
+	unsigned int packedCount = DescribePackedVert(packed);
+	CHECK(vertCount == 4 && packedCount == 4);
+
+	//	Element counts as main.cpp passes them to BuildInputLayout
+	CheckLayout("VS.hlsl", vert, 3, sizeof(Vert));
+	CheckLayout("VS_Norm.hlsl", vert, vertCount, sizeof(Vert));
+	CheckLayout("VS_Quantized.hlsl", packed, 3, sizeof(PackedVert));
+
+	//	A mismatch is caught: quantized normals fed to a shader wanting a float3
+	MeshVertexElement wrong[MESH_MAX_ELEMENTS];
+	DescribePackedVert(wrong);
+	int before = checkFailures;
+	printf("expected failure:\n  ");
+	CheckLayout("VS.hlsl", wrong, 3, sizeof(PackedVert));
+	CHECK(checkFailures > before);
+	checkFailures = before;
+
+	return CheckResult();
+}
@@ -0,0 +1,212 @@
+#include "LooseOctree.h"
+#include "HashGrid.h"
+#include "Check.h"
+#include "CullScene.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+//	LooseOctree and HashGrid against scanning every live box, through
+//	inserts, removes and moves. The scene starts as the game's forest with
+//	every 20th tree grown to span many grid cells, the random boxes that
+//	come in later also land outside the octree's root cell.
+
+#define OBJECTS		3000
+
+struct Scene{
+	std::vector<AABB> boxes;
+	std::vector<bool> live;
+};
+
+static float Random(float lo, float hi){
+	return lo + (hi - lo) * ((float)rand() / RAND_MAX);
+}
+
+static AABB RandomBox(){
+	float x = Random(-150.0f, 150.0f), y = Random(-4.0f, 6.0f), z = Random(-150.0f, 150.0f);
+	float h = (rand() % 20 == 0) ? Random(4.0f, 30.0f) : Random(0.2f, 1.0f);
+	return AABB(FLOAT3(x - h, y - h, z - h), FLOAT3(x + h, y + h, z + h));
+}
+
+static std::vector<unsigned int> Sorted(std::vector<unsigned int> v){
+	std::sort(v.begin(), v.end());
+	return v;
+}
+
+static bool Unique(const std::vector<unsigned int>& sorted){
+	return std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+}
+
+static std::vector<unsigned int> BruteFrustum(const Scene& scene, const FLOAT4* planes){
+	std::vector<unsigned int> out;
+	for (size_t i = 0; i < scene.boxes.size(); ++i){
+		bool visible = scene.live[i];
+		for (int p = 0; p < 6 && visible; ++p)
+			visible = ClassifyAABB(planes[p], scene.boxes[i]) >= 0;
+		if (visible)
+			out.push_back((unsigned int)i);
+	}
+	return out;
+}
+
+static std::vector<unsigned int> BruteSphere(const Scene& scene, const FLOAT3& center, float radius){
+	std::vector<unsigned int> out;
+	for (size_t i = 0; i < scene.boxes.size(); ++i)
+		if (scene.live[i] && SphereOverlapsAABB(center, radius, scene.boxes[i]))
+			out.push_back((unsigned int)i);
+	return out;
+}
+
+static std::vector<unsigned int> BruteRay(const Scene& scene, const FLOAT3& origin, const FLOAT3& dir, float maxT){
+	FLOAT3 invDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+	std::vector<unsigned int> out;
+	for (size_t i = 0; i < scene.boxes.size(); ++i)
+		if (scene.live[i] && RayHitsAABB(origin, invDir, maxT, scene.boxes[i]))
+			out.push_back((unsigned int)i);
+	return out;
+}
+
+//	Box center strictly inside every plane, so the box really is in view
+static bool CenterInside(const FLOAT4* planes, const AABB& box){
+	FLOAT3 c((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f);
+	for (int p = 0; p < 6; ++p)
+		if (planes[p].x * c.x + planes[p].y * c.y + planes[p].z * c.z + planes[p].w <= 0.0f)
+			return false;
+	return true;
+}
+
+static void CheckQueries(const Scene& scene, const SpatialIndex& octree, const SpatialIndex& grid, int round){
+	size_t live = std::count(scene.live.begin(), scene.live.end(), true);
+	CHECK(octree.Size() == live);
+	CHECK(grid.Size() == live);
+	for (size_t i = 0; i < scene.boxes.size(); ++i){
+		CHECK(octree.Contains((unsigned int)i) == scene.live[i]);
+		CHECK(grid.Contains((unsigned int)i) == scene.live[i]);
+	}
+
+	for (int q = 0; q < 20; ++q){
+		//	Frustum: the octree matches exactly, the grid may drop boxes that
+		//	only pass across a frustum corner but never one that's really in view
+		FLOAT3 eye;
+		float yaw;
+		CameraPath((size_t)(round * 97 + q * 31), 200.0f, eye, yaw);
+		Frustum frustum;
+		MakeFrustum(eye, yaw, frustum);
+
+		std::vector<unsigned int> expected = BruteFrustum(scene, frustum.planes);
+		std::vector<unsigned int> tree, cells;
+		octree.QueryFrustum(frustum.planes, tree);
+		grid.QueryFrustum(frustum.planes, cells);
+		tree = Sorted(tree);
+		cells = Sorted(cells);
+		CHECK(tree == expected);
+		CHECK(Unique(cells));
+		CHECK(std::includes(expected.begin(), expected.end(), cells.begin(), cells.end()));
+		for (size_t i = 0; i < expected.size(); ++i)
+			if (CenterInside(frustum.planes, scene.boxes[expected[i]]))
+				CHECK(std::binary_search(cells.begin(), cells.end(), expected[i]));
+
+		//	Sphere, from a point to most of the world
+		FLOAT3 center(Random(-160.0f, 160.0f), Random(-5.0f, 5.0f), Random(-160.0f, 160.0f));
+		float radius = (q == 0) ? 0.0f : Random(0.5f, (q % 5 == 0) ? 200.0f : 25.0f);
+		expected = BruteSphere(scene, center, radius);
+		tree.clear();
+		cells.clear();
+		octree.QuerySphere(center, radius, tree);
+		grid.QuerySphere(center, radius, cells);
+		CHECK(Sorted(tree) == expected);
+		CHECK(Sorted(cells) == expected);
+
+		//	Ray, some along an axis so the slab test sees zero components
+		FLOAT3 origin(Random(-200.0f, 200.0f), Random(-2.0f, 2.0f), Random(-200.0f, 200.0f));
+		FLOAT3 dir(Random(-1.0f, 1.0f), Random(-0.1f, 0.1f), Random(-1.0f, 1.0f));
+		if (q % 4 == 0)
+			dir = FLOAT3(q % 8 == 0 ? 1.0f : -1.0f, 0.0f, 0.0f);
+		float maxT = Random(10.0f, 400.0f);
+		expected = BruteRay(scene, origin, dir, maxT);
+		tree.clear();
+		cells.clear();
+		octree.QueryRay(origin, dir, maxT, tree);
+		grid.QueryRay(origin, dir, maxT, cells);
+		CHECK(Sorted(tree) == expected);
+		CHECK(Sorted(cells) == expected);
+	}
+}
+
+int main(){
+	InstanceSoA forest;
+	MakeForest(forest, OBJECTS);
+
+	srand(6);
+	Scene scene;
+	scene.boxes.resize(OBJECTS);
+	scene.live.assign(OBJECTS, false);
+
+	LooseOctree octree;
+	HashGrid grid;
+	CHECK(octree.Size() == 0 && grid.Size() == 0);
+
+	for (unsigned int i = 0; i < OBJECTS; ++i){
+		float h = (i % 20 == 0) ? Random(4.0f, 30.0f) : 0.5f;
+		FLOAT3 p = forest.Get(i);
+		scene.boxes[i] = AABB(FLOAT3(p.x - h, p.y - h, p.z - h), FLOAT3(p.x + h, p.y + h, p.z + h));
+		scene.live[i] = true;
+		octree.Insert(i, scene.boxes[i]);
+		grid.Insert(i, scene.boxes[i]);
+	}
+	CheckQueries(scene, octree, grid, 0);
+
+	//	A few rounds of removes, re-inserts, small moves and jumps across the world
+	for (int round = 1; round <= 4; ++round){
+		for (unsigned int i = 0; i < OBJECTS; ++i){
+			int action = rand() % 10;
+			if (action == 0){
+				scene.live[i] = !scene.live[i];
+				if (scene.live[i]){
+					scene.boxes[i] = RandomBox();
+					octree.Insert(i, scene.boxes[i]);
+					grid.Insert(i, scene.boxes[i]);
+				}
+				else {
+					octree.Remove(i);
+					grid.Remove(i);
+				}
+			}
+			else if (action < 4 && scene.live[i]){
+				AABB box = (action == 1) ? RandomBox() : scene.boxes[i];
+				if (action != 1){
+					float dx = Random(-2.0f, 2.0f), dz = Random(-2.0f, 2.0f);
+					box.min.x += dx;
+					box.max.x += dx;
+					box.min.z += dz;
+					box.max.z += dz;
+				}
+				scene.boxes[i] = box;
+				octree.Move(i, box);
+				grid.Move(i, box);
+			}
+		}
+		CheckQueries(scene, octree, grid, round);
+	}
+
+	//	Removing what isn't there and moving something not inserted yet
+	octree.Remove(OBJECTS + 5);
+	grid.Remove(OBJECTS + 5);
+	size_t live = octree.Size();
+	AABB extra(FLOAT3(1.0f, 0.0f, 1.0f), FLOAT3(2.0f, 1.0f, 2.0f));
+	octree.Move(OBJECTS, extra);
+	grid.Move(OBJECTS, extra);
+	CHECK(octree.Size() == live + 1 && grid.Size() == live + 1);
+	CHECK(octree.Contains(OBJECTS) && grid.Contains(OBJECTS));
+
+	octree.Clear();
+	grid.Clear();
+	std::vector<unsigned int> none;
+	octree.QuerySphere(FLOAT3(0.0f, 0.0f, 0.0f), 1000.0f, none);
+	grid.QuerySphere(FLOAT3(0.0f, 0.0f, 0.0f), 1000.0f, none);
+	CHECK(none.empty());
+	CHECK(octree.Size() == 0 && grid.Size() == 0 && !octree.Contains(0) && !grid.Contains(0));
+
+	return CheckResult();
+}
@@ -0,0 +1,186 @@
+#include "TangentSpace.h"
+#include "ObjLoader.h"
+#include "JobSystem.h"
+#include "MeshScene.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+
+//	GenerateTangents against MikkTSpace. mikktspace.c isn't in the tree, so
+//	the reference below follows genTangSpace the way it runs there: the
+//	index buffer is treated as a triangle soup, corners are welded when
+//	position, normal and uv are identical, each corner averages the faces of
+//	its weld of the same uv orientation, weighted by the corner angle in the
+//	normal's plane, and the sign is the orientation's. Faces MikkTSpace would
+//	keep in separate groups around one vertex (two fans touching only at it)
+//	aren't modelled, none of the meshes here have them. The plane and the
+//	mirrored plane also check exact values, where MikkTSpace's output is
+//	dP/du by definition.
+
+#define MIKK_MIN_DOT	0.9999f		//	about 0.8 degrees
+
+static FLOAT3 Sub(const FLOAT3& a, const FLOAT3& b){ return FLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+static float Dot(const FLOAT3& a, const FLOAT3& b){ return a.x * b.x + a.y * b.y + a.z * b.z; }
+static FLOAT3 Scale(const FLOAT3& a, float s){ return FLOAT3(a.x * s, a.y * s, a.z * s); }
+static FLOAT3 Unit(const FLOAT3& a){ float l = sqrtf(Dot(a, a)); return l > 0.0f ? Scale(a, 1.0f / l) : a; }
+
+//	Tangent and sign per corner, w = 0 where MikkTSpace has nothing to go on
+static std::vector<FLOAT4> MikkReference(const std::vector<Vert>& verts, const std::vector<unsigned int>& indices){
+	size_t corners = indices.size();
+
+	//	Weld identical corners, as genTangSpaceDefault does before grouping
+	std::map<std::vector<float>, unsigned int> weldOf;
+	std::vector<unsigned int> weld(corners);
+	for (size_t c = 0; c < corners; ++c){
+		const Vert& v = verts[indices[c]];
+		std::vector<float> key = { v.Pos.x, v.Pos.y, v.Pos.z, v.Norms.x, v.Norms.y, v.Norms.z, v.Uvs.u, v.Uvs.v };
+		weld[c] = weldOf.insert(std::make_pair(key, (unsigned int)weldOf.size())).first->second;
+	}
+
+	//	Per face: fS * vOs / |vOs| and whether it keeps the uv orientation
+	size_t faces = corners / 3;
+	std::vector<FLOAT3> vOs(faces);
+	std::vector<int> orient(faces);
+	for (size_t f = 0; f < faces; ++f){
+		const Vert& v1 = verts[indices[f * 3]];
+		const Vert& v2 = verts[indices[f * 3 + 1]];
+		const Vert& v3 = verts[indices[f * 3 + 2]];
+		float t21x = v2.Uvs.u - v1.Uvs.u, t21y = v2.Uvs.v - v1.Uvs.v;
+		float t31x = v3.Uvs.u - v1.Uvs.u, t31y = v3.Uvs.v - v1.Uvs.v;
+		FLOAT3 d1 = Sub(v2.Pos, v1.Pos), d2 = Sub(v3.Pos, v1.Pos);
+
+		float signedAreaSTx2 = t21x * t31y - t21y * t31x;
+		FLOAT3 os = Sub(Scale(d1, t31y), Scale(d2, t21y));
+		float lenOs = sqrtf(Dot(os, os));
+		orient[f] = (signedAreaSTx2 == 0.0f || lenOs == 0.0f) ? 0 : (signedAreaSTx2 > 0.0f ? 1 : -1);
+		vOs[f] = orient[f] ? Scale(os, orient[f] / lenOs) : FLOAT3(0, 0, 0);
+	}
+
+	//	Sum per weld and orientation
+	std::map<std::pair<unsigned int, int>, FLOAT3> sums;
+	for (size_t c = 0; c < corners; ++c){
+		size_t f = c / 3;
+		if (!orient[f])
+			continue;
+		const Vert& v = verts[indices[c]];
+		FLOAT3 n = v.Norms;
+		FLOAT3 t = Unit(Sub(vOs[f], Scale(n, Dot(n, vOs[f]))));
+
+		FLOAT3 p0 = verts[indices[f * 3 + (c + 2) % 3]].Pos, p2 = verts[indices[f * 3 + (c + 1) % 3]].Pos;
+		FLOAT3 e1 = Sub(p0, v.Pos), e2 = Sub(p2, v.Pos);
+		e1 = Unit(Sub(e1, Scale(n, Dot(n, e1))));
+		e2 = Unit(Sub(e2, Scale(n, Dot(n, e2))));
+		float angle = acosf(std::min(std::max(Dot(e1, e2), -1.0f), 1.0f));
+
+		FLOAT3& sum = sums[std::make_pair(weld[c], orient[f])];
+		sum = FLOAT3(sum.x + t.x * angle, sum.y + t.y * angle, sum.z + t.z * angle);
+	}
+
+	std::vector<FLOAT4> out(corners, FLOAT4(0, 0, 0, 0));
+	for (size_t c = 0; c < corners; ++c){
+		int o = orient[c / 3];
+		if (!o)
+			continue;
+		FLOAT3 t = Unit(sums[std::make_pair(weld[c], o)]);
+		if (Dot(t, t) > 0.0f)
+			out[c] = FLOAT4(t.x, t.y, t.z, (float)o);
+	}
+	return out;
+}
+
+//	Runs GenerateTangents on m and compares every corner with the reference
+static size_t CompareWithReference(const char* name, Model& m){
+	std::vector<FLOAT4> reference = MikkReference(m.interleaved, m.out_Indicies);
+	std::vector<unsigned int> before = m.out_Indicies;
+	size_t original = m.interleaved.size();
+	size_t added = GenerateTangents(&m);
+	CHECK(m.out_Indicies.size() == before.size());
+
+	size_t compared = 0, wrong = 0;
+	float worst = 1.0f;
+	for (size_t c = 0; c < m.out_Indicies.size(); ++c){
+		if (reference[c].w == 0.0f)
+			continue;
+		const Vert& v = m.interleaved[m.out_Indicies[c]];
+		//	Corners only ever move to a split copy of their own vertex
+		CHECK(m.out_Indicies[c] == before[c] || m.out_Indicies[c] >= original);
+
+		float d = v.tangent.x * reference[c].x + v.tangent.y * reference[c].y + v.tangent.z * reference[c].z;
+		worst = std::min(worst, d);
+		if (d < MIKK_MIN_DOT || v.tangent.w != reference[c].w)
+			++wrong;
+		++compared;
+	}
+	printf("%-12s %7zu corners, %4zu split, worst %.2f degrees, %zu differ\n", name, compared, added,
+		acosf(std::min(worst, 1.0f)) * 57.29578f, wrong);
+	CHECK(compared > 0);
+	CHECK(wrong == 0);
+	return added;
+}
+
+//	size x size quads in the xy plane facing +z, front faces clockwise seen
+//	from +z. mirrored: u runs back down over the right half.
+static Model Plane(int size, bool mirrored){
+	Model m;
+	for (int y = 0; y <= size; ++y){
+		for (int x = 0; x <= size; ++x){
+			float u = (float)x / size;
+			if (mirrored && x > size / 2)
+				u = (float)(size - x) / size;
+			m.interleaved.push_back(Vert((float)x, (float)y, 0, u, (float)y / size, 0, 0, 1, 0, 0, 0));
+		}
+	}
+	for (int y = 0; y < size; ++y){
+		for (int x = 0; x < size; ++x){
+			unsigned int a = y * (size + 1) + x, b = a + size + 1;
+			unsigned int tris[6] = { a, a + 1, b, a + 1, b + 1, b };
+			m.out_Indicies.insert(m.out_Indicies.end(), tris, tris + 6);
+		}
+	}
+	return m;
+}
+
+int main(){
+	//	Flat plane: T = dP/du = +x, B = dP/dv = +y = w * cross(N, T)
+	Model plane = Plane(4, false);
+	CHECK(CompareWithReference("plane", plane) == 0);
+	for (size_t i = 0; i < plane.interleaved.size(); ++i){
+		const FLOAT4& t = plane.interleaved[i].tangent;
+		CHECK(t.x == 1.0f && t.y == 0.0f && t.z == 0.0f && t.w == 1.0f);
+	}
+
+	//	Mirrored right half: the seam column splits, the right side gets
+	//	T = -x and w = -1 so B stays +y
+	Model mirror = Plane(4, true);
+	CHECK(CompareWithReference("mirrored", mirror) == 5);
+	for (size_t c = 0; c < mirror.out_Indicies.size(); ++c){
+		const Vert& v = mirror.interleaved[mirror.out_Indicies[c]];
+		bool right = (c / 6) % 4 >= 2;
+		CHECK(v.tangent.x == (right ? -1.0f : 1.0f) && v.tangent.w == (right ? -1.0f : 1.0f));
+	}
+
+	Model sphere = Sphere(32, 64);
+	CompareWithReference("sphere", sphere);
+
+	Model tree;
+	CHECK(LoadOBJFile("Tree.obj", &tree));
+	CompareWithReference("Tree.obj", tree);
+
+	//	The job system path gives the same bits as the serial one
+	Model serial = Sphere(200, 200), parallel = serial;
+	CHECK(serial.out_Indicies.size() / 3 >= TANGENT_PARALLEL_MIN);
+	GenerateTangents(&serial);
+	JobSystem jobs;
+	jobs.Initialize(3);
+	GenerateTangents(&parallel, &jobs);
+	jobs.Shutdown();
+	CHECK(serial.out_Indicies == parallel.out_Indicies);
+	CHECK(serial.interleaved.size() == parallel.interleaved.size()
+		&& memcmp(serial.interleaved.data(), parallel.interleaved.data(), serial.interleaved.size() * sizeof(Vert)) == 0);
+
+	return CheckResult();
+}
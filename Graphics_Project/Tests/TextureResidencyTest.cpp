@@ -0,0 +1,177 @@
+#include "TextureResidency.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//	TextureResidency on its own, no files and no device: a hand checked
+//	sequence for the exact LRU decisions, then synthetic access traces of a
+//	sliding working set over 256 textures at budgets from roomy to
+//	thrashing. Throughout a trace the policy must hold: the budget is never
+//	exceeded (past what the tails need), a texture touched this frame is
+//	never a victim, every victim was touched before the texture it made room
+//	for, no texture drops below its tail and a refusal evicts nothing.
+
+#define TRACE_TEXTURES		256
+#define TRACE_FRAMES		3000
+#define TRACE_READS			8			//	mips the I/O side asks for per frame
+
+struct TraceResult{
+	size_t peak;
+	double wholeRate;					//	touched textures whole, fraction of touches
+	size_t evictions, refusals;
+};
+
+static TraceResult Trace(const char* name, size_t budget, int workingSet, int stride, std::mt19937& rng){
+	TextureResidency r(budget);
+	std::vector<std::vector<size_t>> mipBytes(TRACE_TEXTURES);
+	std::vector<size_t> tail(TRACE_TEXTURES);
+	for (int i = 0; i < TRACE_TEXTURES; ++i){
+		int top = 8 + rng() % 4;						//	256 - 2048 pixels
+		for (int m = 0; m <= top; ++m){
+			size_t side = (size_t)1 << (top - m);
+			mipBytes[i].push_back(side * side * 4);
+		}
+		tail[i] = mipBytes[i].size() - 7;				//	64 pixels and down
+		r.Add((TextureId)i, &mipBytes[i][0], mipBytes[i].size(), tail[i]);
+	}
+	size_t tailBytes = r.GetStats().residentBytes;
+	std::vector<unsigned long long> lastTouch(TRACE_TEXTURES, 0);
+
+	size_t over = 0, touchedVictims = 0, youngerVictims = 0, belowTail = 0, refusedButEvicted = 0;
+	size_t whole = 0, touches = 0;
+	std::vector<int> touched;
+	std::vector<TextureEviction> evicted;
+
+	for (int f = 0; f < TRACE_FRAMES; ++f){
+		//	A window sliding over the textures, plus a random one now and then
+		touched.clear();
+		int start = (f / stride) % TRACE_TEXTURES;
+		for (int k = 0; k < workingSet; ++k)
+			touched.push_back((start + k) % TRACE_TEXTURES);
+		if (rng() % 4 == 0)
+			touched.push_back(rng() % TRACE_TEXTURES);
+		for (size_t k = 0; k < touched.size(); ++k){
+			r.Touch((TextureId)touched[k]);
+			lastTouch[touched[k]] = r.GetFrame();
+		}
+
+		for (int s = 0; s < TRACE_READS; ++s){
+			int id = touched[rng() % touched.size()];
+			size_t mip = r.GetResidentMip((TextureId)id);
+			if (mip == 0)
+				continue;
+
+			evicted.clear();
+			size_t evictionsBefore = r.GetStats().evictions;
+			if (r.Reserve((TextureId)id, mip - 1, evicted)){
+				for (size_t e = 0; e < evicted.size(); ++e){
+					TextureId v = evicted[e].id;
+					touchedVictims += lastTouch[v] == r.GetFrame();
+					youngerVictims += lastTouch[v] >= lastTouch[id];
+					belowTail += evicted[e].residentMip > tail[v] || r.GetResidentMip(v) != evicted[e].residentMip;
+				}
+				r.Commit((TextureId)id);
+			}
+			else
+				refusedButEvicted += !evicted.empty() || r.GetStats().evictions != evictionsBefore;
+
+			TextureResidencyStats stats = r.GetStats();
+			over += stats.residentBytes + stats.reservedBytes > std::max(budget, tailBytes);
+		}
+
+		for (size_t k = 0; k < touched.size(); ++k){
+			++touches;
+			whole += r.GetResidentMip((TextureId)touched[k]) == 0;
+		}
+		r.BeginFrame();
+	}
+
+	TextureResidencyStats stats = r.GetStats();
+	TraceResult result = { stats.peakBytes, (double)whole / touches, stats.evictions, stats.refusals };
+	printf("%-22s budget %4zu MB, peak %4zu MB, touched whole %5.1f%%, %6zu evictions, %6zu refusals\n",
+		name, budget >> 20, stats.peakBytes >> 20, 100.0 * result.wholeRate, stats.evictions, stats.refusals);
+
+	CHECK(over == 0);
+	CHECK(touchedVictims == 0);
+	CHECK(youngerVictims == 0);
+	CHECK(belowTail == 0);
+	CHECK(refusedButEvicted == 0);
+	CHECK(stats.peakBytes <= std::max(budget, tailBytes));
+	return result;
+}
+
+int main(){
+	//	Three textures of 64, 16 and 4 bytes, the 4 byte mip is the tail
+	size_t mips[3] = { 64, 16, 4 };
+	TextureResidency r(3 * 4 + 64 + 16);
+	for (TextureId i = 0; i < 3; ++i)
+		r.Add(i, mips, 3, 2);
+	CHECK(r.GetStats().residentBytes == 12);
+
+	std::vector<TextureEviction> evicted;
+	CHECK(!r.Reserve(0, 0, evicted));					//	only the next finer mip
+	CHECK(!r.Reserve(7, 1, evicted));					//	unknown id
+
+	r.Touch(0);
+	r.BeginFrame();
+	r.Touch(1);
+	r.BeginFrame();
+	r.Touch(2);
+	CHECK(r.Reserve(0, 1, evicted));
+	CHECK(!r.Reserve(0, 1, evicted));					//	one reservation at a time
+	r.Commit(0);
+	CHECK(r.Reserve(1, 1, evicted));
+	r.Commit(1);
+	CHECK(r.GetStats().residentBytes == 44 && evicted.empty());
+
+	//	0 is the oldest, nobody older to evict: refused and nothing lost
+	CHECK(!r.Reserve(0, 0, evicted));
+	CHECK(evicted.empty() && r.GetStats().residentBytes == 44 && r.GetStats().refusals == 1);
+
+	//	Touched again, 1 is the oldest now and gives up its 16 byte mip
+	r.Touch(0);
+	CHECK(r.Reserve(0, 0, evicted));
+	r.Commit(0);
+	CHECK(evicted.size() == 1 && evicted[0].id == 1 && evicted[0].residentMip == 2);
+	CHECK(r.GetResidentMip(1) == 2 && r.GetStats().residentBytes == 92 && r.GetStats().peakBytes == 92);
+
+	//	Outside the touch window a texture prefetches into free memory only
+	TextureResidency idle(3 * 4 + 16);
+	for (TextureId i = 0; i < 3; ++i)
+		idle.Add(i, mips, 3, 2);
+	idle.Touch(0);
+	CHECK(idle.Reserve(0, 1, evicted));
+	idle.Commit(0);
+	for (int f = 0; f < TEXTURE_EVICT_WINDOW + 1; ++f)
+		idle.BeginFrame();
+	idle.Touch(2);
+	evicted.clear();
+	CHECK(!idle.Reserve(1, 1, evicted) && evicted.empty());	//	never touched
+	CHECK(idle.Reserve(2, 1, evicted));						//	0 is stale, 2 was just drawn
+	CHECK(evicted.size() == 1 && evicted[0].id == 0 && idle.GetResidentMip(0) == 2);
+
+	//	A texture with a reservation in flight is never a victim
+	evicted.clear();
+	idle.BeginFrame();
+	idle.Touch(1);
+	CHECK(!idle.Reserve(1, 1, evicted) && evicted.empty());
+	idle.Commit(2);
+	CHECK(idle.Reserve(1, 1, evicted) && evicted.size() == 1 && evicted[0].id == 2);
+
+	//	Remove gives back the tail and any reservation
+	idle.Remove(1);
+	CHECK(idle.GetStats().residentBytes == 8 && idle.GetStats().reservedBytes == 0 && idle.GetStats().textures == 2);
+
+	std::mt19937 rng(7);
+	TraceResult fits = Trace("working set fits", 256 << 20, 6, 20, rng);
+	TraceResult tight = Trace("working set tight", 96 << 20, 12, 20, rng);
+	TraceResult thrash = Trace("thrashing", 32 << 20, 24, 5, rng);
+
+	//	The policy earns its keep while the working set fits the budget
+	CHECK(fits.wholeRate > 0.9 && tight.wholeRate > 0.8);
+	CHECK(thrash.refusals > 0);
+	return CheckResult();
+}
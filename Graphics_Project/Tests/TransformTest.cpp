@@ -0,0 +1,133 @@
+#include "Transform.h"
+#include "MathFunc.h"
+#include "Check.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+//	Transform::ToMatrix against the Identity -> Rotate -> Translate -> Scale
+//	chains Update() used to build the link, barrel and cube worlds with, and
+//	ToInverseMatrix against ToMatrix
+
+static float Random(float lo, float hi){
+	return lo + (hi - lo) * ((float)rand() / RAND_MAX);
+}
+
+//	Every element within tolerance times the largest element of expected
+static bool Near(const MATRIX4X4& a, const MATRIX4X4& expected, float tolerance){
+	const float* fa = &a.a;
+	const float* fe = &expected.a;
+	float largest = 1.0f;
+	for (int i = 0; i < 16; ++i)
+		largest = fmaxf(largest, fabsf(fe[i]));
+	for (int i = 0; i < 16; ++i)
+		if (fabsf(fa[i] - fe[i]) > tolerance * largest)
+			return false;
+	return true;
+}
+
+//	Upper 3x4 and translation row checked apart, the translation error grows
+//	with how far out the transform puts things
+static bool NearIdentity(const MATRIX4X4& m, float rotationTolerance, float translationTolerance){
+	const MATRIX4X4 identity = Identity();
+	const float* fm = &m.a;
+	const float* fi = &identity.a;
+	for (int i = 0; i < 16; ++i)
+		if (fabsf(fm[i] - fi[i]) > (i < 12 ? rotationTolerance : translationTolerance))
+			return false;
+	return true;
+}
+
+static MATRIX4X4 Chain(bool aboutX, float rot, FLOAT3 pos, float scale){
+	MATRIX4X4 m = Identity();
+	m = aboutX ? RotateX(m, rot) : RotateZ(m, rot);
+	m = Translate(m, pos.x, pos.y, pos.z);
+	return Scale_4x4(m, scale, scale, scale);
+}
+
+static void CheckSceneWorlds(float rot){
+	FLOAT4 spinY = QuatRotationY(rot);
+
+	//	link & barrel, RotateZ in MathFunc spins about y
+	CHECK(Near(Transform(FLOAT3(0.0f, 0.8f, 15.0f), spinY, FLOAT3(0.25f, 0.25f, 0.25f)).ToMatrix(),
+		Chain(false, rot, FLOAT3(0.0f, 0.8f, 15.0f), 0.25f), 1e-6f));
+	CHECK(Near(Transform(FLOAT3(5.0f, 0.8f, 15.0f), QuatRotationY(-rot), FLOAT3(0.0025f, 0.0025f, 0.0025f)).ToMatrix(),
+		Chain(false, -rot, FLOAT3(5.0f, 0.8f, 15.0f), 0.0025f), 1e-6f));
+
+	//	cube1 translates then rotates, orbiting the origin
+	MATRIX4X4 cube1 = Translate(Identity(), 5.0f, 0.8f, 3.0f);
+	cube1 = RotateZ(cube1, rot);
+	CHECK(Near(Transform(QuatRotate(spinY, FLOAT3(5.0f, 0.8f, 3.0f)), spinY, FLOAT3(1.0f, 1.0f, 1.0f)).ToMatrix(), cube1, 1e-6f));
+
+	CHECK(Near(Transform(FLOAT3(0.0f, 1.0f, 0.0f), QuatRotationX(rot), FLOAT3(0.8f, 0.8f, 0.8f)).ToMatrix(),
+		Chain(true, rot, FLOAT3(0.0f, 1.0f, 0.0f), 0.8f), 1e-6f));
+	CHECK(Near(Transform(FLOAT3(0.0f, 2.0f, 3.0f), QuatRotationX(-rot), FLOAT3(1.4f, 1.4f, 1.4f)).ToMatrix(),
+		Chain(true, -rot, FLOAT3(0.0f, 2.0f, 3.0f), 1.4f), 1e-6f));
+	CHECK(Near(Transform(FLOAT3(0.0f, 2.8f, 10.0f), QuatRotationX(rot), FLOAT3(2.0f, 2.0f, 2.0f)).ToMatrix(),
+		Chain(true, rot, FLOAT3(0.0f, 2.8f, 10.0f), 2.0f), 1e-6f));
+
+	MATRIX4X4 ground = Translate(Identity(), 0.0f, 1.0f, 0.0f);
+	ground = Scale_4x4(ground, 100.0f, 1.0f, 100.0f);
+	CHECK(Near(Transform(FLOAT3(0.0f, 1.0f, 0.0f), QuatIdentity(), FLOAT3(100.0f, 1.0f, 100.0f)).ToMatrix(), ground, 0.0f));
+}
+
+int main(){
+	//	The angles Update() sees, including a large one after a long run
+	const float angles[] = { 0.0f, 0.01f, 0.5f, 1.5707963f, 2.0f, 3.1415926f, -1.0f, -4.0f, 37.5f, 1000.3f };
+	for (size_t a = 0; a < sizeof(angles) / sizeof(angles[0]); ++a)
+		CheckSceneWorlds(angles[a]);
+
+	srand(2);
+	const MATRIX4X4 identity = Identity();
+	std::vector<Transform> transforms;
+	for (int i = 0; i < 2000; ++i){
+		FLOAT3 axis(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+		FLOAT4 q = QuatRotationAxis(axis, Random(-10.0f, 10.0f));
+		FLOAT3 scale(Random(0.1f, 10.0f), Random(0.1f, 10.0f), Random(0.1f, 10.0f));
+		FLOAT3 pos(Random(-200.0f, 200.0f), Random(-200.0f, 200.0f), Random(-200.0f, 200.0f));
+		Transform t(pos, q, scale);
+		transforms.push_back(t);
+
+		//	Both orders come back to the identity. Over 100k of these the worst
+		//	was 2.7e-5 in the 3x3 and 3.7e-4 in the translation row.
+		MATRIX4X4 m = t.ToMatrix(), inv = t.ToInverseMatrix();
+		CHECK(NearIdentity(Mult_4x4(m, inv), 1e-4f, 1e-3f));
+		CHECK(NearIdentity(Mult_4x4(inv, m), 1e-4f, 1e-3f));
+
+		//	Point round trip, the way the frustum goes to Link's local space
+		FLOAT4 p(Random(-5.0f, 5.0f), Random(-5.0f, 5.0f), Random(-5.0f, 5.0f), 1.0f);
+		FLOAT4 back = Mult_Vertex4x4(Mult_Vertex4x4(p, m), inv);
+		CHECK(fabsf(back.x - p.x) + fabsf(back.y - p.y) + fabsf(back.z - p.z) < 1e-3f && back.w == 1.0f);
+
+		//	Rotation a then b is one matrix after the other
+		FLOAT4 b = QuatRotationAxis(FLOAT3(axis.z, axis.x, -axis.y), Random(-3.0f, 3.0f));
+		MATRIX4X4 ra = Transform(FLOAT3(0.0f, 0.0f, 0.0f), q, FLOAT3(1.0f, 1.0f, 1.0f)).ToMatrix();
+		MATRIX4X4 rb = Transform(FLOAT3(0.0f, 0.0f, 0.0f), b, FLOAT3(1.0f, 1.0f, 1.0f)).ToMatrix();
+		CHECK(Near(Transform(FLOAT3(0.0f, 0.0f, 0.0f), QuatMultiply(q, b), FLOAT3(1.0f, 1.0f, 1.0f)).ToMatrix(), Mult_4x4(ra, rb), 1e-5f));
+
+		//	QuatRotate agrees with the matrix
+		FLOAT3 v(p.x, p.y, p.z);
+		FLOAT3 rotated = QuatRotate(q, v);
+		FLOAT4 viaMatrix = Mult_Vertex4x4(FLOAT4(v.x, v.y, v.z, 0.0f), ra);
+		CHECK(fabsf(rotated.x - viaMatrix.x) + fabsf(rotated.y - viaMatrix.y) + fabsf(rotated.z - viaMatrix.z) < 1e-4f);
+	}
+
+	//	The batch is the same per transform call
+	std::vector<MATRIX4X4> batch(transforms.size());
+	ToMatrixBatch(&transforms[0], &batch[0], transforms.size());
+	bool same = true;
+	for (size_t i = 0; i < transforms.size(); ++i)
+		same = same && Near(batch[i], transforms[i].ToMatrix(), 0.0f);
+	CHECK(same);
+
+	//	Degenerate input
+	CHECK(Near(Transform().ToMatrix(), identity, 0.0f));
+	CHECK(Near(Transform().ToInverseMatrix(), identity, 0.0f));
+	FLOAT4 none = QuatRotationAxis(FLOAT3(0.0f, 0.0f, 0.0f), 1.0f);
+	CHECK(none.x == 0.0f && none.y == 0.0f && none.z == 0.0f && none.w == 1.0f);
+	FLOAT4 unit = QuatNormalize(FLOAT4(0.0f, 3.0f, 0.0f, 4.0f));
+	CHECK(fabsf(unit.y - 0.6f) < 1e-6f && fabsf(unit.w - 0.8f) < 1e-6f);
+
+	return CheckResult();
+}
@@ -0,0 +1,174 @@
+#include "VertexFormat.h"
+#include "ObjLoader.h"
+#include "TangentSpace.h"
+#include "Check.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+//	The CPU side of PackedVert: halves round trip and round to nearest even,
+//	octahedral normals stay within 0.01 degrees, and Tree.obj packs inside
+//	the position / uv / angle bounds the quantization allows.
+
+static float Random(float lo, float hi){
+	return lo + (hi - lo) * ((float)rand() / RAND_MAX);
+}
+
+static bool IsNaNHalf(unsigned short h){
+	return (h & 0x7C00) == 0x7C00 && (h & 0x3FF) != 0;
+}
+
+static void TestHalf(){
+	//	Every half that isn't a NaN comes back bit for bit, NaNs stay NaN
+	unsigned int kept = 0, numbers = 0;
+	for (unsigned int h = 0; h < 0x10000; ++h){
+		unsigned short back = FloatToHalf(HalfToFloat((unsigned short)h));
+		if (IsNaNHalf((unsigned short)h))
+			CHECK(IsNaNHalf(back));
+		else {
+			++numbers;
+			kept += back == h ? 1 : 0;
+		}
+	}
+	CHECK(numbers == 0x10000 - 2 * 1023 && kept == numbers);
+
+	//	Random floats over the whole half range land on the nearest half,
+	//	ties on the even one
+	srand(15);
+	bool nearest = true;
+	for (int i = 0; i < 2000000; ++i){
+		unsigned int bits = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+		bits = (bits & 0x807FFFFF) | ((unsigned int)(rand() % 46 + 97) << 23);		//	2^-30 .. 2^16
+		float f;
+		memcpy(&f, &bits, sizeof(f));
+		if (fabsf(f) >= 65504.0f)
+			continue;
+
+		unsigned short h = FloatToHalf(f);
+		double error = fabs((double)HalfToFloat(h) - f);
+		for (int step = -1; step <= 1; step += 2){
+			unsigned short other = (unsigned short)(h + step);
+			if ((other & 0x7FFF) >= 0x7C00 || (other & 0x8000) != (h & 0x8000))
+				continue;
+			double otherError = fabs((double)HalfToFloat(other) - f);
+			if (otherError < error || (otherError == error && (other & 1) == 0))
+				nearest = false;
+		}
+	}
+	CHECK(nearest);
+
+	CHECK(FloatToHalf(1.0f) == 0x3C00 && FloatToHalf(-2.0f) == 0xC000);
+	CHECK(FloatToHalf(65504.0f) == 0x7BFF && FloatToHalf(65520.0f) == 0x7C00 && FloatToHalf(-1e10f) == 0xFC00);
+	CHECK(FloatToHalf(1e-9f) == 0 && FloatToHalf(-1e-9f) == 0x8000 && FloatToHalf(5.9604645e-8f) == 1);
+	CHECK(IsNaNHalf(FloatToHalf(nanf(""))));
+}
+
+static float AngleDegrees(const FLOAT3& a, const FLOAT3& b){
+	double dot = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+	double la = sqrt((double)a.x * a.x + (double)a.y * a.y + (double)a.z * a.z);
+	double lb = sqrt((double)b.x * b.x + (double)b.y * b.y + (double)b.z * b.z);
+	return (float)(acos(fmin(fmax(dot / (la * lb), -1.0), 1.0)) * 180.0 / 3.14159265358979);
+}
+
+static void TestOctahedral(){
+	//	The axes and the octahedron's folded edges, then random directions
+	const FLOAT3 fixed[] = { FLOAT3(1.0f, 0.0f, 0.0f), FLOAT3(-1.0f, 0.0f, 0.0f), FLOAT3(0.0f, 1.0f, 0.0f), FLOAT3(0.0f, -1.0f, 0.0f),
+		FLOAT3(0.0f, 0.0f, 1.0f), FLOAT3(0.0f, 0.0f, -1.0f), FLOAT3(0.7071068f, 0.0f, -0.7071068f), FLOAT3(-0.5f, -0.5f, -0.7071068f) };
+	for (size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); ++i){
+		short packed[2];
+		OctEncode(fixed[i], packed);
+		CHECK(AngleDegrees(OctDecode(packed), fixed[i]) < 0.01f);
+	}
+
+	srand(16);
+	float worst = 0.0f;
+	for (int i = 0; i < 1000000; ++i){
+		FLOAT3 n(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+		float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+		if (len < 1e-3f || len > 1.0f)
+			continue;
+		n = FLOAT3(n.x / len, n.y / len, n.z / len);
+		short packed[2];
+		OctEncode(n, packed);
+		FLOAT3 back = OctDecode(packed);
+		worst = fmaxf(worst, AngleDegrees(back, n));
+	}
+	//	0.0073 measured in doubles, MeasureQuantizeError's float acos reads
+	//	the same vectors as up to 0.02
+	printf("octahedral worst %.4f degrees\n", worst);
+	CHECK(worst < 0.01f);
+
+	short zero[2] = { 5, 5 };
+	OctEncode(FLOAT3(0.0f, 0.0f, 0.0f), zero);
+	CHECK(zero[0] == 0 && zero[1] == 0);
+}
+
+static AABB Bounds(const std::vector<Vert>& verts){
+	AABB box(verts[0].Pos, verts[0].Pos);
+	for (size_t i = 1; i < verts.size(); ++i){
+		const FLOAT3& p = verts[i].Pos;
+		box.min = FLOAT3(fminf(box.min.x, p.x), fminf(box.min.y, p.y), fminf(box.min.z, p.z));
+		box.max = FLOAT3(fmaxf(box.max.x, p.x), fmaxf(box.max.y, p.y), fmaxf(box.max.z, p.z));
+	}
+	return box;
+}
+
+static void TestTree(){
+	Model tree;
+	CHECK(LoadOBJFile("Tree.obj", &tree));
+	GenerateTangents(&tree);
+	const std::vector<Vert>& verts = tree.interleaved;
+	CHECK(!verts.empty());
+	if (verts.empty())
+		return;
+
+	AABB bounds = Bounds(verts);
+	std::vector<PackedVert> packed(verts.size());
+	QuantizeVerts(&verts[0], verts.size(), bounds, &packed[0]);
+	QuantizeError error = MeasureQuantizeError(&verts[0], &packed[0], verts.size(), bounds);
+
+	//	Half a unorm16 step of the widest axis, uvs to a half's precision
+	float extent = fmaxf(bounds.max.x - bounds.min.x, fmaxf(bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z));
+	float largestUV = 0.0f;
+	for (size_t i = 0; i < verts.size(); ++i)
+		largestUV = fmaxf(largestUV, fmaxf(fabsf(verts[i].Uvs.u), fabsf(verts[i].Uvs.v)));
+	printf("Tree.obj: %zu verts, %zu -> %zu bytes, position %.2g of %.1f, uv %.2g, normal %.4f, tangent %.4f degrees\n",
+		verts.size(), verts.size() * sizeof(Vert), verts.size() * sizeof(PackedVert), error.position, extent,
+		error.uv, error.normalDegrees, error.tangentDegrees);
+	CHECK(sizeof(PackedVert) == 20);
+	CHECK(error.position <= extent / 65535.0f * 0.5f * 1.01f);
+	CHECK(error.uv <= largestUV / 2048.0f);
+	CHECK(error.normalDegrees < 0.035f && error.tangentDegrees < 0.035f);
+	CHECK(error.signFlips == 0);
+
+	//	The tangent sign comes back as exactly -1 or +1
+	std::vector<Vert> back(verts.size());
+	DequantizeVerts(&packed[0], packed.size(), bounds, &back[0]);
+	bool signs = true;
+	for (size_t i = 0; i < verts.size(); ++i)
+		signs = signs && (back[i].tangent.w == (verts[i].tangent.w < 0.0f ? -1.0f : 1.0f));
+	CHECK(signs);
+
+	//	A flat axis decodes to its bound, points outside clamp to the box
+	std::vector<Vert> flat(2, verts[0]);
+	flat[0].Pos = FLOAT3(-1.0f, 2.0f, 0.0f);
+	flat[1].Pos = FLOAT3(1.0f, 2.0f, 4.0f);
+	AABB flatBounds = Bounds(flat);
+	flat[1].Pos.z = 9.0f;
+	PackedVert two[2];
+	QuantizeVerts(&flat[0], 2, flatBounds, two);
+	Vert decoded[2];
+	DequantizeVerts(two, 2, flatBounds, decoded);
+	CHECK(decoded[0].Pos.y == 2.0f && decoded[1].Pos.y == 2.0f);
+	CHECK(decoded[0].Pos.x == -1.0f && decoded[1].Pos.z == 4.0f);
+}
+
+int main(){
+	TestHalf();
+	TestOctahedral();
+	TestTree();
+	return CheckResult();
+}
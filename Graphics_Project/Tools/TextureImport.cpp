@@ -0,0 +1,207 @@
+#include "BlockCompress.h"
+#include "JobSystem.h"
+#include "MipGenerate.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//	Import step for the game's textures. Reads an uncompressed 2D DDS
+//	(R8G8B8A8 / B8G8R8A8 / B8G8R8X8, whatever mips it has) and writes every
+//	subresource block compressed, UNORM like the input so the shaders see the
+//	same values:
+//	  TextureImport [-mips box|kaiser] [-wrap] [-srgb|-normal]
+//	                -format bc1|bc3|bc4|bc5|bc7 input.dds output.dds
+//	-mips rebuilds the full chain from the top level first (GenerateMipChain),
+//	-wrap for textures that tile, -srgb filters colour in linear light and
+//	-normal treats rgb as a tangent space normal. The import_textures target
+//	runs this over Assets with the flags each shipped texture was made with.
+//	Prints the PSNR of each mip decoded back against the input, over the
+//	channels the format keeps. input and output may be the same file.
+//	bc5 is for tangent space normal maps: the shader rebuilds z from x and y,
+//	so with bc5 or -normal every texel is renormalised with z >= 0 first.
+
+struct ImportFormat{
+	const char* name;
+	DXGI_FORMAT format;
+	unsigned int channels;		//	PSNR over the first this many of rgba
+};
+
+static const ImportFormat importFormats[] = {
+	{ "bc1", DXGI_FORMAT_BC1_UNORM, 3 },
+	{ "bc3", DXGI_FORMAT_BC3_UNORM, 4 },
+	{ "bc4", DXGI_FORMAT_BC4_UNORM, 1 },
+	{ "bc5", DXGI_FORMAT_BC5_UNORM, 2 },
+	{ "bc7", DXGI_FORMAT_BC7_UNORM, 4 }
+};
+
+static void DecodeBlock(DXGI_FORMAT format, const uint8_t* block, uint8_t* rgba){
+	switch (format){
+	case DXGI_FORMAT_BC1_UNORM:	DecodeBC1Block(block, rgba); break;
+	case DXGI_FORMAT_BC3_UNORM:	DecodeBC3Block(block, rgba); break;
+	case DXGI_FORMAT_BC4_UNORM:	DecodeBC4Block(block, 0, rgba); break;
+	case DXGI_FORMAT_BC5_UNORM:	DecodeBC5Block(block, rgba); break;
+	default:					DecodeBC7Block(block, rgba); break;
+	}
+}
+
+static bool ReadFileBytes(const char* path, std::vector<uint8_t>& bytes){
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	bytes.resize(size > 0 ? (size_t)size : 0);
+	bool ok = size > 0 && fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+	fclose(file);
+	return ok;
+}
+
+//	Unit length rgb with z >= 0 in every subresource, in place in the bytes src was parsed from
+static void NormalizeNormalMap(const DDSFile& src, std::vector<uint8_t>& bytes, bool bgra){
+	for (size_t i = 0; i < src.GetSubresourceCount(); ++i){
+		const DDSSubresource& sub = src.GetSubresources()[i];
+		uint8_t* data = bytes.data() + (sub.data - bytes.data());
+		for (size_t y = 0; y < sub.height; ++y){
+			for (size_t x = 0; x < sub.width; ++x){
+				uint8_t* t = data + y * sub.rowPitch + x * 4;
+				uint8_t* r = bgra ? t + 2 : t;
+				uint8_t* b = bgra ? t : t + 2;
+				float nx = *r / 127.5f - 1.0f, ny = t[1] / 127.5f - 1.0f, nz = fabsf(*b / 127.5f - 1.0f);
+				float length = sqrtf(nx * nx + ny * ny + nz * nz);
+				if (length < 1e-6f){
+					nx = ny = 0.0f;
+					nz = length = 1.0f;
+				}
+				*r = (uint8_t)lroundf((nx / length + 1.0f) * 127.5f);
+				t[1] = (uint8_t)lroundf((ny / length + 1.0f) * 127.5f);
+				*b = (uint8_t)lroundf((nz / length + 1.0f) * 127.5f);
+			}
+		}
+	}
+}
+
+//	PSNR in dB of a compressed subresource against the source texels, 99 when exact
+static double SurfacePSNR(const DDSSubresource& src, bool bgra, const DDSSubresource& dst, const ImportFormat& f){
+	double error = 0.0;
+	size_t blockBytes = dst.rowPitch / std::max<size_t>(1, (dst.width + 3) / 4);
+	for (size_t by = 0; by < dst.height; by += 4){
+		for (size_t bx = 0; bx < dst.width; bx += 4){
+			uint8_t rgba[64];
+			DecodeBlock(f.format, dst.data + (by / 4) * dst.rowPitch + (bx / 4) * blockBytes, rgba);
+
+			for (size_t y = by; y < by + 4 && y < dst.height; ++y){
+				for (size_t x = bx; x < bx + 4 && x < dst.width; ++x){
+					const uint8_t* s = src.data + y * src.rowPitch + x * 4;
+					const uint8_t* d = rgba + ((y - by) * 4 + (x - bx)) * 4;
+					uint8_t source[4] = { bgra ? s[2] : s[0], s[1], bgra ? s[0] : s[2], s[3] };
+					for (unsigned int c = 0; c < f.channels; ++c){
+						double diff = (double)source[c] - d[c];
+						error += diff * diff;
+					}
+				}
+			}
+		}
+	}
+	double mse = error / ((double)dst.width * dst.height * f.channels);
+	return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+int main(int argc, char** argv){
+	const ImportFormat* format = nullptr;
+	const char* paths[2] = { nullptr, nullptr };
+	int pathCount = 0;
+	bool mips = false, badArgument = false;
+	MipFilter filter = MIP_FILTER_KAISER;
+	unsigned int mipFlags = 0;
+
+	for (int i = 1; i < argc; ++i){
+		if (strcmp(argv[i], "-format") == 0 && i + 1 < argc){
+			++i;
+			for (size_t f = 0; f < sizeof(importFormats) / sizeof(importFormats[0]); ++f)
+				if (strcmp(argv[i], importFormats[f].name) == 0)
+					format = &importFormats[f];
+		}
+		else if (strcmp(argv[i], "-mips") == 0 && i + 1 < argc){
+			++i;
+			mips = true;
+			if (strcmp(argv[i], "box") == 0)
+				filter = MIP_FILTER_BOX;
+			else if (strcmp(argv[i], "kaiser") == 0)
+				filter = MIP_FILTER_KAISER;
+			else
+				badArgument = true;
+		}
+		else if (strcmp(argv[i], "-wrap") == 0)
+			mipFlags |= MIP_WRAP;
+		else if (strcmp(argv[i], "-srgb") == 0)
+			mipFlags |= MIP_SRGB;
+		else if (strcmp(argv[i], "-normal") == 0)
+			mipFlags |= MIP_NORMAL_MAP;
+		else if (argv[i][0] == '-')
+			badArgument = true;
+		else if (pathCount < 2)
+			paths[pathCount++] = argv[i];
+	}
+	if (!format || pathCount != 2 || badArgument || (mipFlags & (MIP_SRGB | MIP_NORMAL_MAP)) == (MIP_SRGB | MIP_NORMAL_MAP)){
+		printf("TextureImport [-mips box|kaiser] [-wrap] [-srgb|-normal] -format bc1|bc3|bc4|bc5|bc7 input.dds output.dds\n");
+		return 2;
+	}
+
+	JobSystem jobs;
+	jobs.Initialize();
+
+	std::vector<uint8_t> out;
+	bool bgra;
+	{
+		std::vector<uint8_t> bytes;
+		DDSFile src;
+		if (!ReadFileBytes(paths[0], bytes) || !src.Parse(bytes.data(), bytes.size())){
+			printf("%s: can't read (status %d)\n", paths[0], (int)src.GetStatus());
+			return 1;
+		}
+		if (mips){
+			std::vector<uint8_t> chain;
+			if (!GenerateMipChain(src, chain, filter, mipFlags, &jobs)){
+				printf("%s: not an uncompressed 2D RGBA8 texture, can't build mips\n", paths[0]);
+				return 1;
+			}
+			bytes.swap(chain);
+			src.Parse(bytes.data(), bytes.size());
+		}
+		DXGI_FORMAT in = src.GetInfo().format;
+		bgra = in == DXGI_FORMAT_B8G8R8A8_UNORM || in == DXGI_FORMAT_B8G8R8X8_UNORM
+			|| in == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || in == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+		if ((format->format == DXGI_FORMAT_BC5_UNORM || (mipFlags & MIP_NORMAL_MAP)) && BitsPerPixel(in) == 32 && !IsCompressed(in))
+			NormalizeNormalMap(src, bytes, bgra);
+		if (!CompressDDS(src, format->format, out, &jobs)){
+			printf("%s: not an uncompressed 2D RGBA8 texture with sides a multiple of 4\n", paths[0]);
+			return 1;
+		}
+
+		DDSFile dst;
+		if (!dst.Parse(out.data(), out.size())){
+			printf("%s: compressed result doesn't parse\n", paths[0]);
+			return 1;
+		}
+		const DDSInfo& info = src.GetInfo();
+		size_t inBytes = 0;
+		for (size_t s = 0; s < src.GetSubresourceCount(); ++s)
+			inBytes += src.GetSubresources()[s].size;
+		printf("%s: %zux%zu, %zu mips, %s, texels %zu -> %zu bytes\n", paths[0], info.width, info.height, info.mipCount,
+			format->name, inBytes, out.size());
+		printf("  PSNR by mip:");
+		for (size_t mip = 0; mip < info.mipCount; ++mip)
+			printf(" %.1f", SurfacePSNR(src.GetSubresource(0, mip), bgra, dst.GetSubresource(0, mip), *format));
+		printf(" dB\n");
+	}
+
+	if (!SaveDDSFile(paths[1], out)){
+		printf("%s: can't write\n", paths[1]);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,342 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#define BVH_BINS	12
+
+
+static inline float Axis(const FLOAT3& v, int axis){
+	return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+}
+
+static inline void Grow(AABB& box, const AABB& other){
+	box.min.x = std::min(box.min.x, other.min.x);
+	box.min.y = std::min(box.min.y, other.min.y);
+	box.min.z = std::min(box.min.z, other.min.z);
+	box.max.x = std::max(box.max.x, other.max.x);
+	box.max.y = std::max(box.max.y, other.max.y);
+	box.max.z = std::max(box.max.z, other.max.z);
+}
+
+static inline AABB EmptyBox(){
+	return AABB(FLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), FLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+}
+
+static inline float HalfArea(const AABB& box){
+	float x = box.max.x - box.min.x;
+	float y = box.max.y - box.min.y;
+	float z = box.max.z - box.min.z;
+	if (x < 0.0f || y < 0.0f || z < 0.0f)
+		return 0.0f;
+	return (x * y) + (y * z) + (z * x);
+}
+
+int ClassifyAABB(const FLOAT4& plane, const AABB& box){
+	//	Corner furthest along the normal, same sums as the flat culler
+	float px = (plane.x < 0.0f) ? box.min.x : box.max.x;
+	float py = (plane.y < 0.0f) ? box.min.y : box.max.y;
+	float pz = (plane.z < 0.0f) ? box.min.z : box.max.z;
+	if ((plane.x * px) + (plane.y * py) + (plane.z * pz) + plane.w < 0.0f)
+		return -1;
+
+	//	Nearest corner in front too, whole box is inside
+	float nx = (plane.x < 0.0f) ? box.max.x : box.min.x;
+	float ny = (plane.y < 0.0f) ? box.max.y : box.min.y;
+	float nz = (plane.z < 0.0f) ? box.max.z : box.min.z;
+	if ((plane.x * nx) + (plane.y * ny) + (plane.z * nz) + plane.w >= 0.0f)
+		return 1;
+
+	return 0;
+}
+
+//	Last frame's rejecting plane first, then whatever is left in planeMask.
+//	Returns false when outside, otherwise drops the planes box is fully inside of.
+static bool ClassifyCoherent(const FLOAT4* planes, const AABB& box, unsigned char& last, unsigned int& planeMask, CullStats& stats){
+	++stats.objects;
+
+	int cached = -1;
+	if (last != CULL_NO_PLANE && (planeMask & (1u << last))){
+		cached = last;
+		++stats.planeTests;
+
+		int side = ClassifyAABB(planes[cached], box);
+		if (side < 0){
+			++stats.cacheHits;
+			return false;
+		}
+		if (side > 0)
+			planeMask &= ~(1u << cached);
+	}
+
+	for (int p = 0; p < 6; ++p){
+		if (p == cached || !(planeMask & (1u << p)))
+			continue;
+		++stats.planeTests;
+
+		int side = ClassifyAABB(planes[p], box);
+		if (side < 0){
+			last = (unsigned char)p;
+			return false;
+		}
+		if (side > 0)
+			planeMask &= ~(1u << p);
+	}
+
+	last = CULL_NO_PLANE;
+	return true;
+}
+
+
+BVH::BVH() : maxLeafSize(8){
+}
+
+void BVH::Build(const AABB* bounds, size_t count, unsigned int leafSize){
+	nodes.clear();
+	primIndices.resize(count);
+	primBounds.assign(bounds, bounds + count);
+	maxLeafSize = (leafSize == 0) ? 1 : leafSize;
+
+	if (count == 0)
+		return;
+
+	std::vector<FLOAT3> centroids(count);
+	for (size_t i = 0; i < count; ++i){
+		primIndices[i] = (unsigned int)i;
+		centroids[i].x = (bounds[i].min.x + bounds[i].max.x) * 0.5f;
+		centroids[i].y = (bounds[i].min.y + bounds[i].max.y) * 0.5f;
+		centroids[i].z = (bounds[i].min.z + bounds[i].max.z) * 0.5f;
+	}
+
+	//	A binary tree with n leaves never needs more than 2n - 1 nodes
+	nodes.reserve(count * 2);
+
+	Node root;
+	root.first = 0;
+	root.count = (unsigned int)count;
+	nodes.push_back(root);
+
+	UpdateBounds(0);
+	Subdivide(0, centroids);
+}
+
+void BVH::UpdateBounds(unsigned int nodeIndex){
+	Node& node = nodes[nodeIndex];
+	node.bounds = EmptyBox();
+	for (unsigned int i = 0; i < node.count; ++i)
+		Grow(node.bounds, primBounds[primIndices[node.first + i]]);
+}
+
+void BVH::Subdivide(unsigned int nodeIndex, std::vector<FLOAT3>& centroids){
+	unsigned int first = nodes[nodeIndex].first;
+	unsigned int count = nodes[nodeIndex].count;
+	if (count <= maxLeafSize)
+		return;
+
+	//	Centroid bounds decide the bin ranges
+	AABB cb = EmptyBox();
+	for (unsigned int i = 0; i < count; ++i){
+		const FLOAT3& c = centroids[primIndices[first + i]];
+		Grow(cb, AABB(c, c));
+	}
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestSplit = 0;
+
+	for (int axis = 0; axis < 3; ++axis){
+		float lo = Axis(cb.min, axis);
+		float hi = Axis(cb.max, axis);
+		if (hi <= lo)
+			continue;
+
+		AABB binBox[BVH_BINS];
+		unsigned int binCount[BVH_BINS];
+		for (int b = 0; b < BVH_BINS; ++b){
+			binBox[b] = EmptyBox();
+			binCount[b] = 0;
+		}
+
+		float scale = BVH_BINS / (hi - lo);
+		for (unsigned int i = 0; i < count; ++i){
+			unsigned int p = primIndices[first + i];
+			int b = std::min(BVH_BINS - 1, (int)((Axis(centroids[p], axis) - lo) * scale));
+			binCount[b]++;
+			Grow(binBox[b], primBounds[p]);
+		}
+
+		//	Sweep from both ends for the area / count on each side of each split
+		float leftArea[BVH_BINS - 1], rightArea[BVH_BINS - 1];
+		unsigned int leftCount[BVH_BINS - 1], rightCount[BVH_BINS - 1];
+		AABB leftBox = EmptyBox(), rightBox = EmptyBox();
+		unsigned int leftSum = 0, rightSum = 0;
+		for (int b = 0; b < BVH_BINS - 1; ++b){
+			leftSum += binCount[b];
+			Grow(leftBox, binBox[b]);
+			leftCount[b] = leftSum;
+			leftArea[b] = HalfArea(leftBox);
+
+			rightSum += binCount[BVH_BINS - 1 - b];
+			Grow(rightBox, binBox[BVH_BINS - 1 - b]);
+			rightCount[BVH_BINS - 2 - b] = rightSum;
+			rightArea[BVH_BINS - 2 - b] = HalfArea(rightBox);
+		}
+
+		for (int b = 0; b < BVH_BINS - 1; ++b){
+			if (leftCount[b] == 0 || rightCount[b] == 0)
+				continue;
+			float cost = (leftCount[b] * leftArea[b]) + (rightCount[b] * rightArea[b]);
+			if (cost < bestCost){
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	//	Every centroid in one spot, split down the middle instead
+	unsigned int mid;
+	if (bestAxis < 0){
+		mid = first + count / 2;
+	}
+	else {
+		float lo = Axis(cb.min, bestAxis);
+		float scale = BVH_BINS / (Axis(cb.max, bestAxis) - lo);
+		unsigned int* begin = &primIndices[first];
+		unsigned int* split = std::partition(begin, begin + count, [&](unsigned int p){
+			int b = std::min(BVH_BINS - 1, (int)((Axis(centroids[p], bestAxis) - lo) * scale));
+			return b <= bestSplit;
+		});
+		mid = first + (unsigned int)(split - begin);
+	}
+
+	unsigned int leftIndex = (unsigned int)nodes.size();
+	Node left, right;
+	left.first = first;
+	left.count = mid - first;
+	right.first = mid;
+	right.count = first + count - mid;
+	nodes.push_back(left);
+	nodes.push_back(right);
+
+	nodes[nodeIndex].first = leftIndex;
+	nodes[nodeIndex].count = 0;
+
+	UpdateBounds(leftIndex);
+	UpdateBounds(leftIndex + 1);
+	Subdivide(leftIndex, centroids);
+	Subdivide(leftIndex + 1, centroids);
+}
+
+void BVH::SetBounds(unsigned int i, const AABB& bounds){
+	primBounds[i] = bounds;
+}
+
+AABB BVH::RefitNode(unsigned int nodeIndex){
+	Node& node = nodes[nodeIndex];
+	if (node.count > 0){
+		UpdateBounds(nodeIndex);
+		return node.bounds;
+	}
+
+	AABB box = RefitNode(node.first);
+	Grow(box, RefitNode(node.first + 1));
+	nodes[nodeIndex].bounds = box;
+	return box;
+}
+
+void BVH::Refit(){
+	if (!nodes.empty())
+		RefitNode(0);
+}
+
+void BVH::EmitAll(unsigned int nodeIndex, std::vector<unsigned int>& out) const{
+	const Node& node = nodes[nodeIndex];
+	if (node.count > 0){
+		out.insert(out.end(), primIndices.begin() + node.first, primIndices.begin() + node.first + node.count);
+		return;
+	}
+	EmitAll(node.first, out);
+	EmitAll(node.first + 1, out);
+}
+
+void BVH::Cull(unsigned int nodeIndex, const FLOAT4* planes, unsigned int planeMask, std::vector<unsigned int>& out) const{
+	const Node& node = nodes[nodeIndex];
+
+	//	Only planes the parent straddled still need testing
+	for (int p = 0; p < 6; ++p){
+		if (!(planeMask & (1u << p)))
+			continue;
+
+		int side = ClassifyAABB(planes[p], node.bounds);
+		if (side < 0)
+			return;
+		if (side > 0)
+			planeMask &= ~(1u << p);
+	}
+
+	if (planeMask == 0){
+		EmitAll(nodeIndex, out);
+		return;
+	}
+
+	if (node.count > 0){
+		for (unsigned int i = 0; i < node.count; ++i){
+			unsigned int prim = primIndices[node.first + i];
+			bool visible = true;
+			for (int p = 0; p < 6 && visible; ++p){
+				if ((planeMask & (1u << p)) && ClassifyAABB(planes[p], primBounds[prim]) < 0)
+					visible = false;
+			}
+			if (visible)
+				out.push_back(prim);
+		}
+		return;
+	}
+
+	Cull(node.first, planes, planeMask, out);
+	Cull(node.first + 1, planes, planeMask, out);
+}
+
+void BVH::CullFrustum(const FLOAT4* planes, std::vector<unsigned int>& out) const{
+	if (!nodes.empty())
+		Cull(0, planes, 0x3F, out);
+}
+
+void BVH::CullCoherent(unsigned int nodeIndex, const FLOAT4* planes, unsigned int planeMask, std::vector<unsigned int>& out, BVHCullCache& cache, CullStats& stats) const{
+	const Node& node = nodes[nodeIndex];
+	if (!ClassifyCoherent(planes, node.bounds, cache.nodePlane[nodeIndex], planeMask, stats))
+		return;
+
+	if (planeMask == 0){
+		EmitAll(nodeIndex, out);
+		return;
+	}
+
+	if (node.count > 0){
+		for (unsigned int i = 0; i < node.count; ++i){
+			unsigned int prim = primIndices[node.first + i];
+			unsigned int primMask = planeMask;
+			if (ClassifyCoherent(planes, primBounds[prim], cache.primPlane[prim], primMask, stats))
+				out.push_back(prim);
+		}
+		return;
+	}
+
+	CullCoherent(node.first, planes, planeMask, out, cache, stats);
+	CullCoherent(node.first + 1, planes, planeMask, out, cache, stats);
+}
+
+void BVH::CullFrustumCoherent(const FLOAT4* planes, std::vector<unsigned int>& out, BVHCullCache& cache, CullStats* stats) const{
+	if (nodes.empty())
+		return;
+
+	//	New or rebuilt tree, nothing cached yet
+	if (cache.nodePlane.size() != nodes.size() || cache.primPlane.size() != primBounds.size()){
+		cache.nodePlane.assign(nodes.size(), CULL_NO_PLANE);
+		cache.primPlane.assign(primBounds.size(), CULL_NO_PLANE);
+	}
+
+	CullStats local;
+	CullCoherent(0, planes, 0x3F, out, cache, stats ? *stats : local);
+}
@@ -0,0 +1,71 @@
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include "Defines.h"
+#include "FrustumCull.h"
+#include <cstddef>
+
+
+struct AABB{
+	FLOAT3 min, max;
+
+	AABB() = default;
+	AABB(FLOAT3 _min, FLOAT3 _max) : min(_min), max(_max){}
+};
+
+//	Per node / per box plane that rejected it in the last coherent cull
+struct BVHCullCache{
+	std::vector<unsigned char> nodePlane;
+	std::vector<unsigned char> primPlane;
+};
+
+//	Static bounding volume hierarchy over instance boxes, built with binned SAH.
+//	Leaves reference a contiguous run of primIndices.
+class BVH {
+
+	struct Node{
+		AABB bounds;
+		unsigned int first;		//	leaf: first primIndices slot, inner: left child
+		unsigned int count;		//	leaf: primitive count, inner: 0
+	};
+
+	std::vector<Node> nodes;
+	std::vector<unsigned int> primIndices;
+	std::vector<AABB> primBounds;
+
+	unsigned int maxLeafSize;
+
+	void Subdivide(unsigned int nodeIndex, std::vector<FLOAT3>& centroids);
+	void UpdateBounds(unsigned int nodeIndex);
+	AABB RefitNode(unsigned int nodeIndex);
+
+	void Cull(unsigned int nodeIndex, const FLOAT4* planes, unsigned int planeMask, std::vector<unsigned int>& out) const;
+	void CullCoherent(unsigned int nodeIndex, const FLOAT4* planes, unsigned int planeMask, std::vector<unsigned int>& out, BVHCullCache& cache, CullStats& stats) const;
+	void EmitAll(unsigned int nodeIndex, std::vector<unsigned int>& out) const;
+
+public:
+
+	BVH();
+
+	void Build(const AABB* bounds, size_t count, unsigned int leafSize = 8);
+
+	//	Instance i moved, call Refit() once after all updates
+	void SetBounds(unsigned int i, const AABB& bounds);
+	void Refit();
+
+	//	Appends the indices of every box touching the frustum (6 planes facing in).
+	//	Fully inside subtrees are taken whole, fully outside ones are skipped.
+	void CullFrustum(const FLOAT4* planes, std::vector<unsigned int>& out) const;
+
+	//	Same result as CullFrustum. Nodes and boxes try the plane that rejected
+	//	them last frame first, so a slowly moving camera mostly costs one test each.
+	void CullFrustumCoherent(const FLOAT4* planes, std::vector<unsigned int>& out, BVHCullCache& cache, CullStats* stats = nullptr) const;
+
+	size_t GetNodeCount() const { return nodes.size(); }
+	size_t GetPrimCount() const { return primBounds.size(); }
+};
+
+//	Box against one plane: -1 outside, 1 inside, 0 straddling
+int ClassifyAABB(const FLOAT4& plane, const AABB& box);
+
+#endif
@@ -0,0 +1,895 @@
+#include "BlockCompress.h"
+#include "JobSystem.h"
+#include "MathSIMD.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef MATHSIMD_X86
+#include <immintrin.h>
+#endif
+
+//	Power iterations for a block's principal axis, converges well before this
+#define BC_AXIS_ITERATIONS		8
+//	Least squares passes over the endpoints once the first indices are known
+#define BC_REFINE_ITERATIONS	2
+
+//	BC7 4 bit index weights, out of 64
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+//	and the 2 bit ones mode 5 uses
+static const int bc7Weights2[4] = { 0, 21, 43, 64 };
+
+
+#pragma region Palette Search
+//	A block laid out for the palette search. Red / green and blue / alpha sit
+//	in 16 bit pairs, so one madd gives the sum of two squared differences.
+struct BlockPixels {
+	int16_t rg[32];
+	int16_t ba[32];
+};
+
+//	channel < 4 keeps just that channel (in red), for BC4
+static void LoadPixels(const uint8_t* rgba, bool alpha, unsigned int channel, BlockPixels& px){
+	for (int i = 0; i < 16; ++i){
+		const uint8_t* t = rgba + 4 * i;
+		if (channel < 4){
+			px.rg[2 * i] = t[channel];
+			px.rg[2 * i + 1] = 0;
+			px.ba[2 * i] = 0;
+			px.ba[2 * i + 1] = 0;
+		}
+		else {
+			px.rg[2 * i] = t[0];
+			px.rg[2 * i + 1] = t[1];
+			px.ba[2 * i] = t[2];
+			px.ba[2 * i + 1] = alpha ? t[3] : 0;
+		}
+	}
+}
+
+//	Closest palette entry for every texel by squared RGBA distance, the first
+//	entry wins a tie. Returns the block's total squared error.
+static unsigned int NearestScalar(const BlockPixels& px, const int (*palette)[4], unsigned int count, uint8_t* indices){
+	unsigned int total = 0;
+	for (int i = 0; i < 16; ++i){
+		int best = 0x7fffffff;
+		unsigned int index = 0;
+		for (unsigned int k = 0; k < count; ++k){
+			int dr = px.rg[2 * i] - palette[k][0];
+			int dg = px.rg[2 * i + 1] - palette[k][1];
+			int db = px.ba[2 * i] - palette[k][2];
+			int da = px.ba[2 * i + 1] - palette[k][3];
+			int d = dr * dr + dg * dg + db * db + da * da;
+			if (d < best){
+				best = d;
+				index = k;
+			}
+		}
+		indices[i] = (uint8_t)index;
+		total += (unsigned int)best;
+	}
+	return total;
+}
+
+#ifdef MATHSIMD_X86
+//	Same search 4 texels at a time, the distances are exact in 32 bits so the
+//	indices match the scalar path bit for bit
+static unsigned int NearestSSE2(const BlockPixels& px, const int (*palette)[4], unsigned int count, uint8_t* indices){
+	__m128i rg[4], ba[4], best[4], index[4];
+	for (int q = 0; q < 4; ++q){
+		rg[q] = _mm_loadu_si128((const __m128i*)(px.rg + 8 * q));
+		ba[q] = _mm_loadu_si128((const __m128i*)(px.ba + 8 * q));
+		best[q] = _mm_set1_epi32(0x7fffffff);
+		index[q] = _mm_setzero_si128();
+	}
+
+	for (unsigned int k = 0; k < count; ++k){
+		__m128i prg = _mm_set1_epi32((palette[k][1] << 16) | palette[k][0]);
+		__m128i pba = _mm_set1_epi32((palette[k][3] << 16) | palette[k][2]);
+		__m128i kk = _mm_set1_epi32((int)k);
+
+		for (int q = 0; q < 4; ++q){
+			__m128i drg = _mm_sub_epi16(rg[q], prg);
+			__m128i dba = _mm_sub_epi16(ba[q], pba);
+			__m128i d = _mm_add_epi32(_mm_madd_epi16(drg, drg), _mm_madd_epi16(dba, dba));
+			__m128i less = _mm_cmplt_epi32(d, best[q]);
+			best[q] = _mm_or_si128(_mm_and_si128(less, d), _mm_andnot_si128(less, best[q]));
+			index[q] = _mm_or_si128(_mm_and_si128(less, kk), _mm_andnot_si128(less, index[q]));
+		}
+	}
+
+	int errors[16], found[16];
+	for (int q = 0; q < 4; ++q){
+		_mm_storeu_si128((__m128i*)(errors + 4 * q), best[q]);
+		_mm_storeu_si128((__m128i*)(found + 4 * q), index[q]);
+	}
+
+	unsigned int total = 0;
+	for (int i = 0; i < 16; ++i){
+		indices[i] = (uint8_t)found[i];
+		total += (unsigned int)errors[i];
+	}
+	return total;
+}
+#endif
+
+static unsigned int Nearest(const BlockPixels& px, const int (*palette)[4], unsigned int count, uint8_t* indices){
+#ifdef MATHSIMD_X86
+	if (GetSIMDLevel() >= SIMD_SSE2)
+		return NearestSSE2(px, palette, count, indices);
+#endif
+	return NearestScalar(px, palette, count, indices);
+}
+#pragma endregion
+
+#pragma region Endpoints
+//	Ends of the block's colours along their principal axis, channels 3 or 4
+static void FindEndpoints(const uint8_t* rgba, int channels, float* lo, float* hi){
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; ++i){
+		for (int c = 0; c < channels; ++c)
+			mean[c] += rgba[4 * i + c];
+	}
+	for (int c = 0; c < channels; ++c)
+		mean[c] /= 16.0f;
+
+	float cov[4][4] = {};
+	for (int i = 0; i < 16; ++i){
+		float d[4];
+		for (int c = 0; c < channels; ++c)
+			d[c] = rgba[4 * i + c] - mean[c];
+		for (int a = 0; a < channels; ++a){
+			for (int b = a; b < channels; ++b)
+				cov[a][b] += d[a] * d[b];
+		}
+	}
+	for (int a = 0; a < channels; ++a){
+		for (int b = 0; b < a; ++b)
+			cov[a][b] = cov[b][a];
+	}
+
+	//	Power iteration from the column of the widest channel. The diagonal
+	//	itself can be square to the axis (red up while green goes down) and
+	//	then collapses to nothing, the column never is.
+	int widest = 0;
+	for (int c = 1; c < channels; ++c)
+		widest = cov[c][c] > cov[widest][widest] ? c : widest;
+	float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int c = 0; c < channels; ++c)
+		axis[c] = cov[c][widest];
+
+	for (int it = 0; it < BC_AXIS_ITERATIONS; ++it){
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float largest = 0.0f;
+		for (int a = 0; a < channels; ++a){
+			for (int b = 0; b < channels; ++b)
+				next[a] += cov[a][b] * axis[b];
+			largest = std::fmax(largest, std::fabs(next[a]));
+		}
+		if (largest == 0.0f)
+			break;
+		for (int c = 0; c < channels; ++c)
+			axis[c] = next[c] / largest;
+	}
+
+	//	The extreme texels along it, always colours that are in the block
+	float minDot = 1e30f, maxDot = -1e30f;
+	int minIndex = 0, maxIndex = 0;
+	for (int i = 0; i < 16; ++i){
+		float dot = 0.0f;
+		for (int c = 0; c < channels; ++c)
+			dot += rgba[4 * i + c] * axis[c];
+		if (dot < minDot){
+			minDot = dot;
+			minIndex = i;
+		}
+		if (dot > maxDot){
+			maxDot = dot;
+			maxIndex = i;
+		}
+	}
+
+	for (int c = 0; c < channels; ++c){
+		lo[c] = rgba[4 * minIndex + c];
+		hi[c] = rgba[4 * maxIndex + c];
+	}
+}
+
+//	Endpoints minimising the squared error for fixed indices, weight[k] is how
+//	much of the first endpoint index k takes. False when the system is singular.
+static bool LeastSquares(const uint8_t* rgba, int channels, const uint8_t* indices, const float* weight, float* e0, float* e1){
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; ++i){
+		float a = weight[indices[i]], b = 1.0f - a;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < channels; ++c){
+			ax[c] += a * rgba[4 * i + c];
+			bx[c] += b * rgba[4 * i + c];
+		}
+	}
+
+	float det = aa * bb - ab * ab;
+	if (std::fabs(det) < 1e-6f)
+		return false;
+
+	for (int c = 0; c < channels; ++c){
+		e0[c] = std::fmin(255.0f, std::fmax(0.0f, (ax[c] * bb - bx[c] * ab) / det));
+		e1[c] = std::fmin(255.0f, std::fmax(0.0f, (bx[c] * aa - ax[c] * ab) / det));
+	}
+	return true;
+}
+#pragma endregion
+
+#pragma region BC1
+static inline int Expand5(int v){ return (v << 3) | (v >> 2); }
+static inline int Expand6(int v){ return (v << 2) | (v >> 4); }
+
+static inline int Quantize(float v, int maxValue){
+	int q = (int)(v * maxValue / 255.0f + 0.5f);
+	return q < 0 ? 0 : (q > maxValue ? maxValue : q);
+}
+
+static inline uint16_t Pack565(int r, int g, int b){
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void ColorPalette(uint16_t c0, uint16_t c1, bool four, int (*palette)[4]){
+	int p0[3] = { Expand5(c0 >> 11), Expand6((c0 >> 5) & 63), Expand5(c0 & 31) };
+	int p1[3] = { Expand5(c1 >> 11), Expand6((c1 >> 5) & 63), Expand5(c1 & 31) };
+	for (int c = 0; c < 3; ++c){
+		palette[0][c] = p0[c];
+		palette[1][c] = p1[c];
+		if (four){
+			palette[2][c] = (2 * p0[c] + p1[c] + 1) / 3;
+			palette[3][c] = (p0[c] + 2 * p1[c] + 1) / 3;
+		}
+		else {
+			palette[2][c] = (p0[c] + p1[c] + 1) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	for (int k = 0; k < 4; ++k)
+		palette[k][3] = 0;
+}
+
+//	Best 5 / 6 bit endpoint pairs for a solid colour, hit through palette entry 2
+struct SolidTable {
+	uint8_t match5[256][2];
+	uint8_t match6[256][2];
+
+	static void Build(uint8_t (*match)[2], int bits){
+		int size = 1 << bits;
+		for (int v = 0; v < 256; ++v){
+			int bestError = 256;
+			for (int a = 0; a < size; ++a){
+				for (int b = 0; b < size; ++b){
+					int ea = bits == 5 ? Expand5(a) : Expand6(a);
+					int eb = bits == 5 ? Expand5(b) : Expand6(b);
+					int error = std::abs((2 * ea + eb + 1) / 3 - v);
+					if (error < bestError){
+						bestError = error;
+						match[v][0] = (uint8_t)a;
+						match[v][1] = (uint8_t)b;
+					}
+				}
+			}
+		}
+	}
+
+	SolidTable(){
+		Build(match5, 5);
+		Build(match6, 6);
+	}
+};
+
+static const SolidTable solidTable;
+
+static unsigned int EvaluateColor(const BlockPixels& px, uint16_t c0, uint16_t c1, uint8_t* indices){
+	int palette[4][4];
+	ColorPalette(c0, c1, true, palette);
+	return Nearest(px, palette, 4, indices);
+}
+
+//	Four colour endpoints and indices for the RGB of a block
+static void EncodeColor(const uint8_t* rgba, uint16_t& c0, uint16_t& c1, uint8_t* indices){
+	bool solid = true;
+	for (int i = 1; i < 16 && solid; ++i)
+		solid = rgba[4 * i] == rgba[0] && rgba[4 * i + 1] == rgba[1] && rgba[4 * i + 2] == rgba[2];
+
+	if (solid){
+		c0 = Pack565(solidTable.match5[rgba[0]][0], solidTable.match6[rgba[1]][0], solidTable.match5[rgba[2]][0]);
+		c1 = Pack565(solidTable.match5[rgba[0]][1], solidTable.match6[rgba[1]][1], solidTable.match5[rgba[2]][1]);
+		memset(indices, 2, 16);
+	}
+	else {
+		BlockPixels px;
+		LoadPixels(rgba, false, 4, px);
+
+		float lo[4], hi[4];
+		FindEndpoints(rgba, 3, lo, hi);
+		c0 = Pack565(Quantize(hi[0], 31), Quantize(hi[1], 63), Quantize(hi[2], 31));
+		c1 = Pack565(Quantize(lo[0], 31), Quantize(lo[1], 63), Quantize(lo[2], 31));
+		unsigned int bestError = EvaluateColor(px, c0, c1, indices);
+
+		static const float weight[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		for (int it = 0; it < BC_REFINE_ITERATIONS && bestError > 0; ++it){
+			float e0[4], e1[4];
+			if (!LeastSquares(rgba, 3, indices, weight, e0, e1))
+				break;
+
+			uint16_t r0 = Pack565(Quantize(e0[0], 31), Quantize(e0[1], 63), Quantize(e0[2], 31));
+			uint16_t r1 = Pack565(Quantize(e1[0], 31), Quantize(e1[1], 63), Quantize(e1[2], 31));
+			uint8_t refined[16];
+			unsigned int error = EvaluateColor(px, r0, r1, refined);
+			if (error >= bestError)
+				break;
+
+			bestError = error;
+			c0 = r0;
+			c1 = r1;
+			memcpy(indices, refined, 16);
+		}
+	}
+
+	//	c0 > c1 is what selects four colours, swapping mirrors the indices
+	if (c0 < c1){
+		uint16_t t = c0;
+		c0 = c1;
+		c1 = t;
+		for (int i = 0; i < 16; ++i)
+			indices[i] ^= 1;
+	}
+	else if (c0 == c1)
+		memset(indices, 0, 16);
+}
+
+static void WriteColor(uint16_t c0, uint16_t c1, const uint8_t* indices, uint8_t* out){
+	uint32_t bits = 0;
+	for (int i = 0; i < 16; ++i)
+		bits |= (uint32_t)indices[i] << (2 * i);
+
+	out[0] = (uint8_t)c0;
+	out[1] = (uint8_t)(c0 >> 8);
+	out[2] = (uint8_t)c1;
+	out[3] = (uint8_t)(c1 >> 8);
+	memcpy(out + 4, &bits, 4);
+}
+
+void EncodeBC1Block(const uint8_t* rgba, uint8_t* out){
+	uint16_t c0, c1;
+	uint8_t indices[16];
+	EncodeColor(rgba, c0, c1, indices);
+	WriteColor(c0, c1, indices, out);
+}
+
+static void DecodeColor(const uint8_t* block, bool alwaysFour, uint8_t* rgba){
+	uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+	uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+	uint32_t bits;
+	memcpy(&bits, block + 4, 4);
+
+	int palette[4][4];
+	bool four = alwaysFour || c0 > c1;
+	ColorPalette(c0, c1, four, palette);
+
+	for (int i = 0; i < 16; ++i){
+		unsigned int k = (bits >> (2 * i)) & 3;
+		for (int c = 0; c < 3; ++c)
+			rgba[4 * i + c] = (uint8_t)palette[k][c];
+		rgba[4 * i + 3] = (!four && k == 3) ? 0 : 255;
+	}
+}
+
+void DecodeBC1Block(const uint8_t* block, uint8_t* rgba){
+	DecodeColor(block, false, rgba);
+}
+#pragma endregion
+
+#pragma region BC4
+static void ChannelPalette(int a0, int a1, int (*palette)[4]){
+	memset(palette, 0, sizeof(int) * 4 * 8);
+	palette[0][0] = a0;
+	palette[1][0] = a1;
+	if (a0 > a1){
+		for (int k = 2; k < 8; ++k)
+			palette[k][0] = ((8 - k) * a0 + (k - 1) * a1 + 3) / 7;
+	}
+	else {
+		for (int k = 2; k < 6; ++k)
+			palette[k][0] = ((6 - k) * a0 + (k - 1) * a1 + 2) / 5;
+		palette[6][0] = 0;
+		palette[7][0] = 255;
+	}
+}
+
+static unsigned int EvaluateChannel(const BlockPixels& px, int a0, int a1, uint8_t* indices){
+	int palette[8][4];
+	ChannelPalette(a0, a1, palette);
+	return Nearest(px, palette, 8, indices);
+}
+
+void EncodeBC4Block(const uint8_t* rgba, unsigned int channel, uint8_t* out){
+	BlockPixels px;
+	LoadPixels(rgba, false, channel & 3, px);
+
+	int lo = 255, hi = 0, innerLo = 255, innerHi = 0;
+	for (int i = 0; i < 16; ++i){
+		int v = rgba[4 * i + (channel & 3)];
+		lo = v < lo ? v : lo;
+		hi = v > hi ? v : hi;
+		if (v > 0 && v < 255){
+			innerLo = v < innerLo ? v : innerLo;
+			innerHi = v > innerHi ? v : innerHi;
+		}
+	}
+
+	int a0 = hi, a1 = lo;
+	uint8_t indices[16];
+	unsigned int bestError = 0;
+
+	if (lo == hi)
+		memset(indices, 0, 16);
+	else {
+		//	Eight interpolated values over the whole range
+		bestError = EvaluateChannel(px, a0, a1, indices);
+
+		uint8_t refined[16];
+		float weight[8] = { 1.0f, 0.0f };
+		for (int k = 2; k < 8; ++k)
+			weight[k] = (8 - k) / 7.0f;
+		float e0, e1;
+		if (bestError > 0 && LeastSquares(rgba + (channel & 3), 1, indices, weight, &e0, &e1)){
+			int r0 = (int)(e0 + 0.5f), r1 = (int)(e1 + 0.5f);
+			if (r0 > r1){
+				unsigned int error = EvaluateChannel(px, r0, r1, refined);
+				if (error < bestError){
+					bestError = error;
+					a0 = r0;
+					a1 = r1;
+					memcpy(indices, refined, 16);
+				}
+			}
+		}
+
+		//	Six over the values in between when the block also holds 0 or 255
+		if (bestError > 0 && (lo == 0 || hi == 255) && innerLo <= innerHi){
+			unsigned int error = EvaluateChannel(px, innerLo, innerHi, refined);
+			if (error < bestError){
+				a0 = innerLo;
+				a1 = innerHi;
+				memcpy(indices, refined, 16);
+			}
+		}
+	}
+
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; ++i)
+		bits |= (uint64_t)indices[i] << (3 * i);
+
+	out[0] = (uint8_t)a0;
+	out[1] = (uint8_t)a1;
+	for (int b = 0; b < 6; ++b)
+		out[2 + b] = (uint8_t)(bits >> (8 * b));
+}
+
+void DecodeBC4Block(const uint8_t* block, unsigned int channel, uint8_t* rgba){
+	int palette[8][4];
+	ChannelPalette(block[0], block[1], palette);
+
+	uint64_t bits = 0;
+	for (int b = 0; b < 6; ++b)
+		bits |= (uint64_t)block[2 + b] << (8 * b);
+
+	for (int i = 0; i < 16; ++i)
+		rgba[4 * i + (channel & 3)] = (uint8_t)palette[(bits >> (3 * i)) & 7][0];
+}
+#pragma endregion
+
+#pragma region BC3 BC5
+void EncodeBC3Block(const uint8_t* rgba, uint8_t* out){
+	EncodeBC4Block(rgba, 3, out);
+
+	//	The colour half of BC3 is four colour whatever the endpoint order
+	uint16_t c0, c1;
+	uint8_t indices[16];
+	EncodeColor(rgba, c0, c1, indices);
+	WriteColor(c0, c1, indices, out + 8);
+}
+
+void DecodeBC3Block(const uint8_t* block, uint8_t* rgba){
+	DecodeColor(block + 8, true, rgba);
+	DecodeBC4Block(block, 3, rgba);
+}
+
+void EncodeBC5Block(const uint8_t* rgba, uint8_t* out){
+	EncodeBC4Block(rgba, 0, out);
+	EncodeBC4Block(rgba, 1, out + 8);
+}
+
+void DecodeBC5Block(const uint8_t* block, uint8_t* rgba){
+	for (int i = 0; i < 16; ++i){
+		rgba[4 * i + 2] = 0;
+		rgba[4 * i + 3] = 255;
+	}
+	DecodeBC4Block(block, 0, rgba);
+	DecodeBC4Block(block + 8, 1, rgba);
+}
+#pragma endregion
+
+#pragma region BC7
+//	Mode 6 endpoint: 7 bits per channel plus a p bit shared by the channels
+struct BC7Endpoint {
+	int q[4];
+	int p;
+
+	int Value(int c) const { return (q[c] << 1) | p; }
+};
+
+static BC7Endpoint QuantizeBC7(const float* v, int p){
+	BC7Endpoint e;
+	e.p = p;
+	for (int c = 0; c < 4; ++c){
+		int q = (int)((v[c] - p) / 2.0f + 0.5f);
+		e.q[c] = q < 0 ? 0 : (q > 127 ? 127 : q);
+	}
+	return e;
+}
+
+static void BC7Palette(const BC7Endpoint& e0, const BC7Endpoint& e1, int (*palette)[4]){
+	for (int k = 0; k < 16; ++k){
+		for (int c = 0; c < 4; ++c)
+			palette[k][c] = ((64 - bc7Weights[k]) * e0.Value(c) + bc7Weights[k] * e1.Value(c) + 32) >> 6;
+	}
+}
+
+//	Best of the four p bit pairs for these endpoints
+static unsigned int FitBC7(const BlockPixels& px, const float* lo, const float* hi, BC7Endpoint& e0, BC7Endpoint& e1, uint8_t* indices){
+	unsigned int bestError = 0xffffffff;
+	for (int p = 0; p < 4; ++p){
+		BC7Endpoint t0 = QuantizeBC7(lo, p & 1);
+		BC7Endpoint t1 = QuantizeBC7(hi, p >> 1);
+
+		int palette[16][4];
+		BC7Palette(t0, t1, palette);
+		uint8_t found[16];
+		unsigned int error = Nearest(px, palette, 16, found);
+		if (error < bestError){
+			bestError = error;
+			e0 = t0;
+			e1 = t1;
+			memcpy(indices, found, 16);
+		}
+	}
+	return bestError;
+}
+
+//	Little endian bit writer over the 128 bit block
+static void PutBits(uint8_t* out, unsigned int& pos, unsigned int value, unsigned int count){
+	for (unsigned int b = 0; b < count; ++b, ++pos){
+		if (value & (1u << b))
+			out[pos >> 3] |= (uint8_t)(1u << (pos & 7));
+	}
+}
+
+static unsigned int GetBits(const uint8_t* block, unsigned int& pos, unsigned int count){
+	unsigned int value = 0;
+	for (unsigned int b = 0; b < count; ++b, ++pos)
+		value |= (unsigned int)((block[pos >> 3] >> (pos & 7)) & 1) << b;
+	return value;
+}
+
+//	Mode 5 endpoint pairs that hit each 8 bit value exactly through index 1.
+//	Mode 6 shares a p bit across the channels, so a solid colour like opaque
+//	black can't be stored exactly there.
+struct BC7SolidTable {
+	uint8_t match7[256][2];
+
+	static int Expand7(int v){ return (v << 1) | (v >> 6); }
+
+	BC7SolidTable(){
+		for (int v = 0; v < 256; ++v){
+			int bestError = 256;
+			for (int a = 0; a < 128 && bestError > 0; ++a){
+				for (int b = 0; b < 128 && bestError > 0; ++b){
+					int error = std::abs(((64 - bc7Weights2[1]) * Expand7(a) + bc7Weights2[1] * Expand7(b) + 32) / 64 - v);
+					if (error < bestError){
+						bestError = error;
+						match7[v][0] = (uint8_t)a;
+						match7[v][1] = (uint8_t)b;
+					}
+				}
+			}
+		}
+	}
+};
+
+static const BC7SolidTable bc7SolidTable;
+
+//	Mode 5, no rotation: colour from the table, alpha straight into both 8 bit ends
+static bool EncodeBC7Solid(const uint8_t* rgba, uint8_t* out){
+	for (int i = 1; i < 16; ++i){
+		if (memcmp(rgba + 4 * i, rgba, 4) != 0)
+			return false;
+	}
+
+	memset(out, 0, 16);
+	unsigned int pos = 0;
+	PutBits(out, pos, 1u << 5, 6);
+	PutBits(out, pos, 0, 2);
+	for (int c = 0; c < 3; ++c){
+		PutBits(out, pos, bc7SolidTable.match7[rgba[c]][0], 7);
+		PutBits(out, pos, bc7SolidTable.match7[rgba[c]][1], 7);
+	}
+	PutBits(out, pos, rgba[3], 8);
+	PutBits(out, pos, rgba[3], 8);
+	for (int i = 0; i < 16; ++i)
+		PutBits(out, pos, 1, i == 0 ? 1 : 2);
+	return true;
+}
+
+void EncodeBC7Block(const uint8_t* rgba, uint8_t* out){
+	if (EncodeBC7Solid(rgba, out))
+		return;
+
+	BlockPixels px;
+	LoadPixels(rgba, true, 4, px);
+
+	float lo[4], hi[4];
+	FindEndpoints(rgba, 4, lo, hi);
+
+	BC7Endpoint e0, e1;
+	uint8_t indices[16];
+	unsigned int bestError = FitBC7(px, lo, hi, e0, e1, indices);
+
+	float weight[16];
+	for (int k = 0; k < 16; ++k)
+		weight[k] = (64 - bc7Weights[k]) / 64.0f;
+
+	for (int it = 0; it < BC_REFINE_ITERATIONS && bestError > 0; ++it){
+		float r0[4], r1[4];
+		if (!LeastSquares(rgba, 4, indices, weight, r0, r1))
+			break;
+
+		BC7Endpoint t0, t1;
+		uint8_t refined[16];
+		unsigned int error = FitBC7(px, r0, r1, t0, t1, refined);
+		if (error >= bestError)
+			break;
+
+		bestError = error;
+		e0 = t0;
+		e1 = t1;
+		memcpy(indices, refined, 16);
+	}
+
+	//	Texel 0's index has an implied top bit of 0, swapping ends makes it so
+	if (indices[0] & 8){
+		BC7Endpoint t = e0;
+		e0 = e1;
+		e1 = t;
+		for (int i = 0; i < 16; ++i)
+			indices[i] = (uint8_t)(15 - indices[i]);
+	}
+
+	memset(out, 0, 16);
+	unsigned int pos = 0;
+	PutBits(out, pos, 1u << 6, 7);
+	for (int c = 0; c < 4; ++c){
+		PutBits(out, pos, (unsigned int)e0.q[c], 7);
+		PutBits(out, pos, (unsigned int)e1.q[c], 7);
+	}
+	PutBits(out, pos, (unsigned int)e0.p, 1);
+	PutBits(out, pos, (unsigned int)e1.p, 1);
+	PutBits(out, pos, indices[0], 3);
+	for (int i = 1; i < 16; ++i)
+		PutBits(out, pos, indices[i], 4);
+}
+
+static void DecodeBC7Mode5(const uint8_t* block, uint8_t* rgba){
+	unsigned int pos = 6;
+	unsigned int rotation = GetBits(block, pos, 2);
+
+	int e0[4], e1[4];
+	for (int c = 0; c < 3; ++c){
+		e0[c] = BC7SolidTable::Expand7((int)GetBits(block, pos, 7));
+		e1[c] = BC7SolidTable::Expand7((int)GetBits(block, pos, 7));
+	}
+	e0[3] = (int)GetBits(block, pos, 8);
+	e1[3] = (int)GetBits(block, pos, 8);
+
+	unsigned int colorIndex[16], alphaIndex[16];
+	for (int i = 0; i < 16; ++i)
+		colorIndex[i] = GetBits(block, pos, i == 0 ? 1 : 2);
+	for (int i = 0; i < 16; ++i)
+		alphaIndex[i] = GetBits(block, pos, i == 0 ? 1 : 2);
+
+	for (int i = 0; i < 16; ++i){
+		uint8_t* t = rgba + 4 * i;
+		for (int c = 0; c < 4; ++c){
+			int w = bc7Weights2[c < 3 ? colorIndex[i] : alphaIndex[i]];
+			t[c] = (uint8_t)(((64 - w) * e0[c] + w * e1[c] + 32) >> 6);
+		}
+		//	Rotation swaps alpha with red, green or blue
+		if (rotation > 0){
+			uint8_t a = t[3];
+			t[3] = t[rotation - 1];
+			t[rotation - 1] = a;
+		}
+	}
+}
+
+void DecodeBC7Block(const uint8_t* block, uint8_t* rgba){
+	if ((block[0] & 0x3f) == 0x20){
+		DecodeBC7Mode5(block, rgba);
+		return;
+	}
+	if ((block[0] & 0x7f) != 0x40){
+		memset(rgba, 0, 64);
+		return;
+	}
+
+	unsigned int pos = 7;
+	BC7Endpoint e0, e1;
+	for (int c = 0; c < 4; ++c){
+		e0.q[c] = (int)GetBits(block, pos, 7);
+		e1.q[c] = (int)GetBits(block, pos, 7);
+	}
+	e0.p = (int)GetBits(block, pos, 1);
+	e1.p = (int)GetBits(block, pos, 1);
+
+	int palette[16][4];
+	BC7Palette(e0, e1, palette);
+	for (int i = 0; i < 16; ++i){
+		unsigned int k = GetBits(block, pos, i == 0 ? 3 : 4);
+		for (int c = 0; c < 4; ++c)
+			rgba[4 * i + c] = (uint8_t)palette[k][c];
+	}
+}
+#pragma endregion
+
+#pragma region Surfaces
+typedef void (*BlockEncoder)(const uint8_t* rgba, uint8_t* out);
+
+static void EncodeBC4RedBlock(const uint8_t* rgba, uint8_t* out){
+	EncodeBC4Block(rgba, 0, out);
+}
+
+static BlockEncoder GetEncoder(DXGI_FORMAT format, size_t* blockBytes){
+	switch (format){
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		*blockBytes = 8;
+		return EncodeBC1Block;
+
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+		*blockBytes = 16;
+		return EncodeBC3Block;
+
+	case DXGI_FORMAT_BC4_UNORM:
+		*blockBytes = 8;
+		return EncodeBC4RedBlock;
+
+	case DXGI_FORMAT_BC5_UNORM:
+		*blockBytes = 16;
+		return EncodeBC5Block;
+
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		*blockBytes = 16;
+		return EncodeBC7Block;
+
+	default:
+		return nullptr;
+	}
+}
+
+bool CanEncode(DXGI_FORMAT format){
+	size_t blockBytes;
+	return GetEncoder(format, &blockBytes) != nullptr;
+}
+
+bool CompressSurface(const uint8_t* rgba, size_t width, size_t height, size_t rowPitch,
+	DXGI_FORMAT format, uint8_t* out, JobSystem* jobs){
+
+	size_t blockBytes;
+	BlockEncoder encode = GetEncoder(format, &blockBytes);
+	if (!encode)
+		return false;
+
+	size_t blocksWide = (width + 3) / 4;
+	size_t blocksHigh = (height + 3) / 4;
+
+	auto encodeRows = [&](size_t begin, size_t end){
+		uint8_t block[64];
+		for (size_t by = begin; by < end; ++by){
+			for (size_t bx = 0; bx < blocksWide; ++bx){
+				for (size_t y = 0; y < 4; ++y){
+					size_t sy = by * 4 + y < height ? by * 4 + y : height - 1;
+					for (size_t x = 0; x < 4; ++x){
+						size_t sx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+						memcpy(block + 4 * (y * 4 + x), rgba + sy * rowPitch + sx * 4, 4);
+					}
+				}
+				encode(block, out + (by * blocksWide + bx) * blockBytes);
+			}
+		}
+	};
+
+	if (jobs && blocksHigh > BC_ROWS_PER_JOB)
+		jobs->ParallelFor(blocksHigh, BC_ROWS_PER_JOB, [&](size_t, size_t begin, size_t end, unsigned int){ encodeRows(begin, end); });
+	else
+		encodeRows(0, blocksHigh);
+	return true;
+}
+
+bool CompressDDS(const DDSFile& src, DXGI_FORMAT format, std::vector<uint8_t>& out, JobSystem* jobs){
+	const DDSInfo& info = src.GetInfo();
+	if (src.GetStatus() != DDS_OK || !CanEncode(format) || info.dimension != DDS_DIMENSION_TEXTURE2D)
+		return false;
+	if (info.width % 4 != 0 || info.height % 4 != 0)
+		return false;
+
+	bool bgra = false, opaque = false;
+	switch (info.format){
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		break;
+
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		bgra = true;
+		break;
+
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+		bgra = true;
+		opaque = true;
+		break;
+
+	default:
+		return false;
+	}
+
+	DDSInfo dst = info;
+	dst.format = format;
+	out.clear();
+	WriteDDSHeader(dst, out);
+
+	std::vector<uint8_t> swizzled;
+	for (size_t i = 0; i < src.GetSubresourceCount(); ++i){
+		const DDSSubresource& sub = src.GetSubresources()[i];
+		const uint8_t* pixels = sub.data;
+		size_t pitch = sub.rowPitch;
+
+		//	The encoders read RGBA
+		if (bgra){
+			swizzled.resize(sub.width * sub.height * 4);
+			for (size_t y = 0; y < sub.height; ++y){
+				const uint8_t* row = sub.data + y * sub.rowPitch;
+				uint8_t* to = &swizzled[y * sub.width * 4];
+				for (size_t x = 0; x < sub.width; ++x){
+					to[4 * x] = row[4 * x + 2];
+					to[4 * x + 1] = row[4 * x + 1];
+					to[4 * x + 2] = row[4 * x];
+					to[4 * x + 3] = opaque ? 255 : row[4 * x + 3];
+				}
+			}
+			pixels = &swizzled[0];
+			pitch = sub.width * 4;
+		}
+
+		size_t numBytes;
+		GetSurfaceInfo(sub.width, sub.height, format, &numBytes, nullptr, nullptr);
+		size_t at = out.size();
+		out.resize(at + numBytes);
+		if (!CompressSurface(pixels, sub.width, sub.height, pitch, format, &out[at], jobs))
+			return false;
+	}
+	return true;
+}
+#pragma endregion
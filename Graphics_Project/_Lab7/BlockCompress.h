@@ -0,0 +1,49 @@
+#ifndef _BLOCKCOMPRESS_H_
+#define _BLOCKCOMPRESS_H_
+
+#include "DDSFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+//	Block rows per job when a surface is split across the job system
+#define BC_ROWS_PER_JOB		4
+
+
+//	Block encoders, rgba is one 4x4 block of RGBA8 texels, row major (64 bytes).
+//	BC1 and the colour half of BC3 are opaque four colour blocks. BC4 packs one
+//	channel, BC5 packs red and green (tangent space normals, z is rebuilt in the
+//	shader). BC7 uses mode 6: one subset, RGBA endpoints and 4 bit indices, and
+//	mode 5 for solid blocks, which it stores exactly.
+void EncodeBC1Block(const uint8_t* rgba, uint8_t* out);			//	8 bytes
+void EncodeBC3Block(const uint8_t* rgba, uint8_t* out);			//	16 bytes
+void EncodeBC4Block(const uint8_t* rgba, unsigned int channel, uint8_t* out);	//	8 bytes
+void EncodeBC5Block(const uint8_t* rgba, uint8_t* out);			//	16 bytes
+void EncodeBC7Block(const uint8_t* rgba, uint8_t* out);			//	16 bytes
+
+//	Back to RGBA8, for measuring the encoders. BC1 and BC3 give opaque colour,
+//	BC4 writes only its channel, BC5 gives blue 0 and alpha 255.
+//	DecodeBC7Block knows modes 5 and 6 only and decodes anything else to black.
+void DecodeBC1Block(const uint8_t* block, uint8_t* rgba);
+void DecodeBC3Block(const uint8_t* block, uint8_t* rgba);
+void DecodeBC4Block(const uint8_t* block, unsigned int channel, uint8_t* rgba);
+void DecodeBC5Block(const uint8_t* block, uint8_t* rgba);
+void DecodeBC7Block(const uint8_t* block, uint8_t* rgba);
+
+//	BC1 / BC3 / BC4 / BC5 / BC7, UNORM or SRGB, the formats the encoders write
+bool CanEncode(DXGI_FORMAT format);
+
+//	Compresses a width x height RGBA8 surface into rows of blocks, the edge
+//	blocks of sizes that aren't a multiple of 4 repeat the last row / column.
+//	With jobs the block rows are spread over its threads.
+bool CompressSurface(const uint8_t* rgba, size_t width, size_t height, size_t rowPitch,
+	DXGI_FORMAT format, uint8_t* out, JobSystem* jobs = nullptr);
+
+//	Every subresource of a 2D R8G8B8A8 / B8G8R8A8 / B8G8R8X8 file as format,
+//	written as a whole DDS file (DX10 header) to out. The top level has to be a
+//	multiple of 4 on both sides for D3D11 to take the result.
+bool CompressDDS(const DDSFile& src, DXGI_FORMAT format, std::vector<uint8_t>& out, JobSystem* jobs = nullptr);
+
+#endif
@@ -0,0 +1,608 @@
+#include "DDSFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+//	B4G4R4A4 needs DXGI 1.2 (Windows 8), the Windows build stays on Windows 7
+#if !defined(_WIN32) && !defined(DXGI_1_2_FORMATS)
+#define DXGI_1_2_FORMATS
+#endif
+
+#define ISBITMASK(r, g, b, a) (ddpf.RBitMask == r && ddpf.GBitMask == g && ddpf.BBitMask == b && ddpf.ABitMask == a)
+
+
+#pragma region Formats
+size_t BitsPerPixel(DXGI_FORMAT fmt){
+	switch (fmt){
+	case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_UINT:
+	case DXGI_FORMAT_R32G32B32A32_SINT:
+		return 128;
+
+	case DXGI_FORMAT_R32G32B32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+	case DXGI_FORMAT_R32G32B32_UINT:
+	case DXGI_FORMAT_R32G32B32_SINT:
+		return 96;
+
+	case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_UINT:
+	case DXGI_FORMAT_R16G16B16A16_SNORM:
+	case DXGI_FORMAT_R16G16B16A16_SINT:
+	case DXGI_FORMAT_R32G32_TYPELESS:
+	case DXGI_FORMAT_R32G32_FLOAT:
+	case DXGI_FORMAT_R32G32_UINT:
+	case DXGI_FORMAT_R32G32_SINT:
+	case DXGI_FORMAT_R32G8X24_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+	case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+	case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+		return 64;
+
+	case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+	case DXGI_FORMAT_R10G10B10A2_UINT:
+	case DXGI_FORMAT_R11G11B10_FLOAT:
+	case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R8G8B8A8_UINT:
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+	case DXGI_FORMAT_R8G8B8A8_SINT:
+	case DXGI_FORMAT_R16G16_TYPELESS:
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_UINT:
+	case DXGI_FORMAT_R16G16_SNORM:
+	case DXGI_FORMAT_R16G16_SINT:
+	case DXGI_FORMAT_R32_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT:
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_R32_UINT:
+	case DXGI_FORMAT_R32_SINT:
+	case DXGI_FORMAT_R24G8_TYPELESS:
+	case DXGI_FORMAT_D24_UNORM_S8_UINT:
+	case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+	case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+	case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+	case DXGI_FORMAT_R8G8_B8G8_UNORM:
+	case DXGI_FORMAT_G8R8_G8B8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+		return 32;
+
+	case DXGI_FORMAT_R8G8_TYPELESS:
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_R8G8_UINT:
+	case DXGI_FORMAT_R8G8_SNORM:
+	case DXGI_FORMAT_R8G8_SINT:
+	case DXGI_FORMAT_R16_TYPELESS:
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_D16_UNORM:
+	case DXGI_FORMAT_R16_UNORM:
+	case DXGI_FORMAT_R16_UINT:
+	case DXGI_FORMAT_R16_SNORM:
+	case DXGI_FORMAT_R16_SINT:
+	case DXGI_FORMAT_B5G6R5_UNORM:
+	case DXGI_FORMAT_B5G5R5A1_UNORM:
+#ifdef DXGI_1_2_FORMATS
+	case DXGI_FORMAT_B4G4R4A4_UNORM:
+#endif
+		return 16;
+
+	case DXGI_FORMAT_R8_TYPELESS:
+	case DXGI_FORMAT_R8_UNORM:
+	case DXGI_FORMAT_R8_UINT:
+	case DXGI_FORMAT_R8_SNORM:
+	case DXGI_FORMAT_R8_SINT:
+	case DXGI_FORMAT_A8_UNORM:
+		return 8;
+
+	case DXGI_FORMAT_R1_UNORM:
+		return 1;
+
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		return 4;
+
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return 8;
+
+	default:
+		return 0;
+	}
+}
+
+bool IsCompressed(DXGI_FORMAT fmt){
+	switch (fmt){
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void GetSurfaceInfo(size_t width, size_t height, DXGI_FORMAT fmt, size_t* outNumBytes, size_t* outRowBytes, size_t* outNumRows){
+	size_t rowBytes = 0;
+	size_t numRows = 0;
+	size_t bytesPerBlock = 0;
+	bool packed = false;
+
+	switch (fmt){
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		bytesPerBlock = 8;
+		break;
+
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		bytesPerBlock = 16;
+		break;
+
+	case DXGI_FORMAT_R8G8_B8G8_UNORM:
+	case DXGI_FORMAT_G8R8_G8B8_UNORM:
+		packed = true;
+		break;
+
+	default:
+		break;
+	}
+
+	if (bytesPerBlock){
+		//	4x4 blocks, a row is a row of blocks
+		size_t blocksWide = width > 0 ? std::max<size_t>(1, (width + 3) / 4) : 0;
+		size_t blocksHigh = height > 0 ? std::max<size_t>(1, (height + 3) / 4) : 0;
+		rowBytes = blocksWide * bytesPerBlock;
+		numRows = blocksHigh;
+	}
+	else if (packed){
+		rowBytes = ((width + 1) >> 1) * 4;
+		numRows = height;
+	}
+	else {
+		rowBytes = (width * BitsPerPixel(fmt) + 7) / 8;
+		numRows = height;
+	}
+
+	if (outNumBytes)
+		*outNumBytes = rowBytes * numRows;
+	if (outRowBytes)
+		*outRowBytes = rowBytes;
+	if (outNumRows)
+		*outNumRows = numRows;
+}
+
+//	Legacy (pre DX10 header) pixel formats
+static DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf){
+	if (ddpf.flags & DDS_RGB){
+		//	sRGB formats are only written with the DX10 header
+		switch (ddpf.RGBBitCount){
+		case 32:
+			if (ISBITMASK(0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+				return DXGI_FORMAT_R8G8B8A8_UNORM;
+			if (ISBITMASK(0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
+				return DXGI_FORMAT_B8G8R8A8_UNORM;
+			if (ISBITMASK(0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000))
+				return DXGI_FORMAT_B8G8R8X8_UNORM;
+
+			//	D3DX writes 10:10:10:2 with red and blue masks swapped, this
+			//	takes the swapped masks to be the common case
+			if (ISBITMASK(0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000))
+				return DXGI_FORMAT_R10G10B10A2_UNORM;
+
+			if (ISBITMASK(0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
+				return DXGI_FORMAT_R16G16_UNORM;
+
+			//	The only 32 bit single channel D3D9 format was R32F
+			if (ISBITMASK(0xffffffff, 0x00000000, 0x00000000, 0x00000000))
+				return DXGI_FORMAT_R32_FLOAT;
+			break;
+
+		case 16:
+			if (ISBITMASK(0x7c00, 0x03e0, 0x001f, 0x8000))
+				return DXGI_FORMAT_B5G5R5A1_UNORM;
+			if (ISBITMASK(0xf800, 0x07e0, 0x001f, 0x0000))
+				return DXGI_FORMAT_B5G6R5_UNORM;
+#ifdef DXGI_1_2_FORMATS
+			if (ISBITMASK(0x0f00, 0x00f0, 0x000f, 0xf000))
+				return DXGI_FORMAT_B4G4R4A4_UNORM;
+#endif
+			break;
+		}
+	}
+	else if (ddpf.flags & DDS_LUMINANCE){
+		if (ddpf.RGBBitCount == 8 && ISBITMASK(0x000000ff, 0x00000000, 0x00000000, 0x00000000))
+			return DXGI_FORMAT_R8_UNORM;
+
+		if (ddpf.RGBBitCount == 16){
+			if (ISBITMASK(0x0000ffff, 0x00000000, 0x00000000, 0x00000000))
+				return DXGI_FORMAT_R16_UNORM;
+			if (ISBITMASK(0x000000ff, 0x00000000, 0x00000000, 0x0000ff00))
+				return DXGI_FORMAT_R8G8_UNORM;
+		}
+	}
+	else if (ddpf.flags & DDS_ALPHA){
+		if (ddpf.RGBBitCount == 8)
+			return DXGI_FORMAT_A8_UNORM;
+	}
+	else if (ddpf.flags & DDS_FOURCC){
+		switch (ddpf.fourCC){
+		case MAKEFOURCC('D', 'X', 'T', '1'):	return DXGI_FORMAT_BC1_UNORM;
+		case MAKEFOURCC('D', 'X', 'T', '3'):	return DXGI_FORMAT_BC2_UNORM;
+		case MAKEFOURCC('D', 'X', 'T', '5'):	return DXGI_FORMAT_BC3_UNORM;
+
+		//	Premultiplied alpha has no DXGI format of its own, the blocks are the same
+		case MAKEFOURCC('D', 'X', 'T', '2'):	return DXGI_FORMAT_BC2_UNORM;
+		case MAKEFOURCC('D', 'X', 'T', '4'):	return DXGI_FORMAT_BC3_UNORM;
+
+		case MAKEFOURCC('A', 'T', 'I', '1'):	return DXGI_FORMAT_BC4_UNORM;
+		case MAKEFOURCC('B', 'C', '4', 'U'):	return DXGI_FORMAT_BC4_UNORM;
+		case MAKEFOURCC('B', 'C', '4', 'S'):	return DXGI_FORMAT_BC4_SNORM;
+
+		case MAKEFOURCC('A', 'T', 'I', '2'):	return DXGI_FORMAT_BC5_UNORM;
+		case MAKEFOURCC('B', 'C', '5', 'U'):	return DXGI_FORMAT_BC5_UNORM;
+		case MAKEFOURCC('B', 'C', '5', 'S'):	return DXGI_FORMAT_BC5_SNORM;
+
+		case MAKEFOURCC('R', 'G', 'B', 'G'):	return DXGI_FORMAT_R8G8_B8G8_UNORM;
+		case MAKEFOURCC('G', 'R', 'G', 'B'):	return DXGI_FORMAT_G8R8_G8B8_UNORM;
+
+		//	D3DFORMAT values stored as the fourCC
+		case 36:	return DXGI_FORMAT_R16G16B16A16_UNORM;		//	D3DFMT_A16B16G16R16
+		case 110:	return DXGI_FORMAT_R16G16B16A16_SNORM;		//	D3DFMT_Q16W16V16U16
+		case 111:	return DXGI_FORMAT_R16_FLOAT;				//	D3DFMT_R16F
+		case 112:	return DXGI_FORMAT_R16G16_FLOAT;			//	D3DFMT_G16R16F
+		case 113:	return DXGI_FORMAT_R16G16B16A16_FLOAT;		//	D3DFMT_A16B16G16R16F
+		case 114:	return DXGI_FORMAT_R32_FLOAT;				//	D3DFMT_R32F
+		case 115:	return DXGI_FORMAT_R32G32_FLOAT;			//	D3DFMT_G32R32F
+		case 116:	return DXGI_FORMAT_R32G32B32A32_FLOAT;		//	D3DFMT_A32B32G32R32F
+		}
+	}
+
+	return DXGI_FORMAT_UNKNOWN;
+}
+#pragma endregion
+
+#pragma region DDSFile
+DDSFile::DDSFile() : status(DDS_INVALID){
+	memset(&header, 0, sizeof(header));
+	memset(&info, 0, sizeof(info));
+}
+
+bool DDSFile::Open(const char* path){
+	Close();
+	if (!file.Open(path)){
+		status = DDS_OPEN_FAILED;
+		return false;
+	}
+	return ParseMapped();
+}
+
+#ifdef _WIN32
+bool DDSFile::Open(const wchar_t* path){
+	Close();
+	if (!file.Open(path)){
+		status = DDS_OPEN_FAILED;
+		return false;
+	}
+	return ParseMapped();
+}
+#endif
+
+//	Parses what file just mapped, closing it again when that fails
+bool DDSFile::ParseMapped(){
+	if (!Parse(file.GetData(), file.GetSize())){
+		file.Close();
+		return false;
+	}
+	return true;
+}
+
+void DDSFile::Close(){
+	file.Close();
+	subresources.clear();
+	memset(&header, 0, sizeof(header));
+	memset(&info, 0, sizeof(info));
+	status = DDS_INVALID;
+}
+
+DDSStatus DDSFile::ParseHeader(const uint8_t* data, size_t size, size_t* bitOffset){
+	if (!data || size < sizeof(uint32_t) + sizeof(DDS_HEADER))
+		return DDS_INVALID;
+
+	//	Copied out, the bytes have no alignment guarantee
+	uint32_t magic;
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&header, data + sizeof(uint32_t), sizeof(header));
+	if (magic != DDS_MAGIC || header.size != sizeof(DDS_HEADER) || header.ddspf.size != sizeof(DDS_PIXELFORMAT))
+		return DDS_INVALID;
+
+	info.width = header.width;
+	info.height = header.height;
+	info.depth = header.depth;
+	info.mipCount = header.mipMapCount ? header.mipMapCount : 1;
+	info.arraySize = 1;
+	info.isCubeMap = false;
+	*bitOffset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+
+	if ((header.ddspf.flags & DDS_FOURCC) && header.ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0')){
+		if (size < *bitOffset + sizeof(DDS_HEADER_DXT10))
+			return DDS_INVALID;
+
+		DDS_HEADER_DXT10 ext;
+		memcpy(&ext, data + *bitOffset, sizeof(ext));
+		*bitOffset += sizeof(DDS_HEADER_DXT10);
+
+		info.arraySize = ext.arraySize;
+		if (info.arraySize == 0)
+			return DDS_INVALID;
+
+		info.format = (DXGI_FORMAT)ext.dxgiFormat;
+		if (BitsPerPixel(info.format) == 0)
+			return DDS_UNSUPPORTED;
+
+		switch (ext.resourceDimension){
+		case DDS_DIMENSION_TEXTURE1D:
+			//	D3DX writes 1D textures with a height of 1
+			if ((header.flags & DDS_HEIGHT) && info.height != 1)
+				return DDS_INVALID;
+			info.height = info.depth = 1;
+			break;
+
+		case DDS_DIMENSION_TEXTURE2D:
+			if (ext.miscFlag & DDS_MISC_TEXTURECUBE){
+				if (info.arraySize > DDS_MAX_ARRAY_SIZE / 6)
+					return DDS_UNSUPPORTED;
+				info.arraySize *= 6;
+				info.isCubeMap = true;
+			}
+			info.depth = 1;
+			break;
+
+		case DDS_DIMENSION_TEXTURE3D:
+			if (!(header.flags & DDS_HEADER_FLAGS_VOLUME))
+				return DDS_INVALID;
+			if (info.arraySize > 1)
+				return DDS_UNSUPPORTED;
+			break;
+
+		default:
+			return DDS_UNSUPPORTED;
+		}
+		info.dimension = ext.resourceDimension;
+	}
+	else {
+		info.format = GetDXGIFormat(header.ddspf);
+		if (info.format == DXGI_FORMAT_UNKNOWN)
+			return DDS_UNSUPPORTED;
+
+		if (header.flags & DDS_HEADER_FLAGS_VOLUME)
+			info.dimension = DDS_DIMENSION_TEXTURE3D;
+		else {
+			if (header.caps2 & DDS_CUBEMAP){
+				//	All six faces or nothing
+				if ((header.caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
+					return DDS_UNSUPPORTED;
+				info.arraySize = 6;
+				info.isCubeMap = true;
+			}
+			//	A legacy header has no way to say 1D
+			info.depth = 1;
+			info.dimension = DDS_DIMENSION_TEXTURE2D;
+		}
+	}
+
+	if (info.width == 0 || info.height == 0 || info.depth == 0)
+		return DDS_INVALID;
+
+	if (info.mipCount > DDS_MAX_MIP_LEVELS)
+		return DDS_UNSUPPORTED;
+
+	switch (info.dimension){
+	case DDS_DIMENSION_TEXTURE1D:
+		if (info.arraySize > DDS_MAX_ARRAY_SIZE || info.width > DDS_MAX_TEXTURE1D)
+			return DDS_UNSUPPORTED;
+		break;
+
+	case DDS_DIMENSION_TEXTURE2D:
+		if (info.arraySize > DDS_MAX_ARRAY_SIZE)
+			return DDS_UNSUPPORTED;
+		if (info.isCubeMap ? (info.width > DDS_MAX_TEXTURECUBE || info.height > DDS_MAX_TEXTURECUBE)
+			: (info.width > DDS_MAX_TEXTURE2D || info.height > DDS_MAX_TEXTURE2D))
+			return DDS_UNSUPPORTED;
+		break;
+
+	case DDS_DIMENSION_TEXTURE3D:
+		if (info.width > DDS_MAX_TEXTURE3D || info.height > DDS_MAX_TEXTURE3D || info.depth > DDS_MAX_TEXTURE3D)
+			return DDS_UNSUPPORTED;
+		break;
+	}
+
+	//	No more mips than halving the largest side down to 1 gives
+	size_t largest = std::max(info.width, std::max(info.height, info.depth));
+	size_t fullChain = 1;
+	while (largest >>= 1)
+		++fullChain;
+	if (info.mipCount > fullChain)
+		return DDS_INVALID;
+
+	return DDS_OK;
+}
+
+bool DDSFile::Parse(const void* data, size_t size){
+	subresources.clear();
+
+	const uint8_t* bytes = (const uint8_t*)data;
+	size_t offset = 0;
+	status = ParseHeader(bytes, size, &offset);
+	if (status != DDS_OK)
+		return false;
+
+	//	Sizes are bounded by the checks above, so in 64 bits even the largest
+	//	subresource (2048^3 of 128 bit texels) can't overflow on 32 bit builds
+	subresources.reserve(info.arraySize * info.mipCount);
+	for (size_t item = 0; item < info.arraySize; ++item){
+		size_t w = info.width, h = info.height, d = info.depth;
+		for (size_t mip = 0; mip < info.mipCount; ++mip){
+			size_t rowBytes, numRows;
+			GetSurfaceInfo(w, h, info.format, nullptr, &rowBytes, &numRows);
+
+			unsigned long long total = (unsigned long long)rowBytes * numRows * d;
+			if (total > size - offset){
+				subresources.clear();
+				status = DDS_TRUNCATED;
+				return false;
+			}
+
+			DDSSubresource sub;
+			sub.data = bytes + offset;
+			sub.rowPitch = rowBytes;
+			sub.slicePitch = rowBytes * numRows;
+			sub.size = (size_t)total;
+			sub.width = w;
+			sub.height = h;
+			sub.depth = d;
+			subresources.push_back(sub);
+			offset += (size_t)total;
+
+			w = std::max<size_t>(1, w >> 1);
+			h = std::max<size_t>(1, h >> 1);
+			d = std::max<size_t>(1, d >> 1);
+		}
+	}
+	return true;
+}
+#pragma endregion
+
+#pragma region Writer
+void WriteDDSHeader(const DDSInfo& info, std::vector<uint8_t>& out){
+	size_t numBytes, rowBytes;
+	GetSurfaceInfo(info.width, info.height, info.format, &numBytes, &rowBytes, nullptr);
+
+	DDS_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE;
+	header.height = (uint32_t)info.height;
+	header.width = (uint32_t)info.width;
+	header.mipMapCount = (uint32_t)info.mipCount;
+	header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header.ddspf.flags = DDS_FOURCC;
+	header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+	//	Block formats give the top level's size, the rest a row's
+	if (IsCompressed(info.format)){
+		header.flags |= DDS_HEADER_FLAGS_LINEARSIZE;
+		header.pitchOrLinearSize = (uint32_t)numBytes;
+	}
+	else {
+		header.flags |= DDS_HEADER_FLAGS_PITCH;
+		header.pitchOrLinearSize = (uint32_t)rowBytes;
+	}
+
+	if (info.mipCount > 1){
+		header.flags |= DDS_HEADER_FLAGS_MIPMAP;
+		header.caps |= DDS_SURFACE_FLAGS_MIPMAP;
+	}
+
+	DDS_HEADER_DXT10 ext;
+	memset(&ext, 0, sizeof(ext));
+	ext.dxgiFormat = (uint32_t)info.format;
+	ext.resourceDimension = (uint32_t)info.dimension;
+	ext.arraySize = (uint32_t)info.arraySize;
+
+	if (info.dimension == DDS_DIMENSION_TEXTURE3D){
+		header.flags |= DDS_HEADER_FLAGS_VOLUME;
+		header.depth = (uint32_t)info.depth;
+		header.caps2 = DDS_FLAGS_VOLUME;
+	}
+	else if (info.isCubeMap){
+		//	The DX10 header counts cubes, not faces
+		header.caps |= DDS_SURFACE_FLAGS_CUBEMAP;
+		header.caps2 = DDS_CUBEMAP_ALLFACES;
+		ext.miscFlag = DDS_MISC_TEXTURECUBE;
+		ext.arraySize = (uint32_t)(info.arraySize / 6);
+	}
+
+	uint32_t magic = DDS_MAGIC;
+	size_t at = out.size();
+	out.resize(at + sizeof(magic) + sizeof(header) + sizeof(ext));
+	memcpy(&out[at], &magic, sizeof(magic));
+	memcpy(&out[at + sizeof(magic)], &header, sizeof(header));
+	memcpy(&out[at + sizeof(magic) + sizeof(header)], &ext, sizeof(ext));
+}
+
+bool SaveDDSFile(const char* path, const std::vector<uint8_t>& bytes){
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return false;
+
+	bool written = bytes.empty() || fwrite(&bytes[0], 1, bytes.size(), file) == bytes.size();
+	return fclose(file) == 0 && written;
+}
+#pragma endregion
@@ -0,0 +1,187 @@
+#ifndef _DDSFILE_H_
+#define _DDSFILE_H_
+
+#include "DXGIFormat.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef MAKEFOURCC
+#define MAKEFOURCC(ch0, ch1, ch2, ch3) \
+	((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) | \
+	((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24))
+#endif
+
+//	File layout, see DDS.h in DirectXTex
+#define DDS_MAGIC		0x20534444		//	"DDS "
+
+#define DDS_FOURCC		0x00000004		//	DDPF_FOURCC
+#define DDS_RGB			0x00000040		//	DDPF_RGB
+#define DDS_RGBA		0x00000041		//	DDPF_RGB | DDPF_ALPHAPIXELS
+#define DDS_LUMINANCE	0x00020000		//	DDPF_LUMINANCE
+#define DDS_LUMINANCEA	0x00020001		//	DDPF_LUMINANCE | DDPF_ALPHAPIXELS
+#define DDS_ALPHA		0x00000002		//	DDPF_ALPHA
+#define DDS_PAL8		0x00000020		//	DDPF_PALETTEINDEXED8
+
+#define DDS_HEADER_FLAGS_TEXTURE	0x00001007		//	DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+#define DDS_HEADER_FLAGS_MIPMAP		0x00020000		//	DDSD_MIPMAPCOUNT
+#define DDS_HEADER_FLAGS_VOLUME		0x00800000		//	DDSD_DEPTH
+#define DDS_HEADER_FLAGS_PITCH		0x00000008		//	DDSD_PITCH
+#define DDS_HEADER_FLAGS_LINEARSIZE	0x00080000		//	DDSD_LINEARSIZE
+
+#define DDS_HEIGHT		0x00000002		//	DDSD_HEIGHT
+#define DDS_WIDTH		0x00000004		//	DDSD_WIDTH
+
+#define DDS_SURFACE_FLAGS_TEXTURE	0x00001000		//	DDSCAPS_TEXTURE
+#define DDS_SURFACE_FLAGS_MIPMAP	0x00400008		//	DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+#define DDS_SURFACE_FLAGS_CUBEMAP	0x00000008		//	DDSCAPS_COMPLEX
+
+#define DDS_CUBEMAP_POSITIVEX	0x00000600		//	DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX	0x00000a00		//	DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY	0x00001200		//	DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY	0x00002200		//	DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ	0x00004200		//	DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ	0x00008200		//	DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES	(DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX | \
+								 DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY | \
+								 DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ)
+
+#define DDS_CUBEMAP			0x00000200		//	DDSCAPS2_CUBEMAP
+#define DDS_FLAGS_VOLUME	0x00200000		//	DDSCAPS2_VOLUME
+
+//	Same values as D3D11_RESOURCE_DIMENSION / D3D11_RESOURCE_MISC_TEXTURECUBE
+#define DDS_DIMENSION_TEXTURE1D		2
+#define DDS_DIMENSION_TEXTURE2D		3
+#define DDS_DIMENSION_TEXTURE3D		4
+#define DDS_MISC_TEXTURECUBE		0x4
+
+//	D3D11 hardware limits, nothing bigger is trusted from a file
+#define DDS_MAX_MIP_LEVELS		15
+#define DDS_MAX_ARRAY_SIZE		2048
+#define DDS_MAX_TEXTURE1D		16384
+#define DDS_MAX_TEXTURE2D		16384
+#define DDS_MAX_TEXTURECUBE		16384
+#define DDS_MAX_TEXTURE3D		2048
+
+#pragma pack(push, 1)
+struct DDS_PIXELFORMAT{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t RGBBitCount;
+	uint32_t RBitMask;
+	uint32_t GBitMask;
+	uint32_t BBitMask;
+	uint32_t ABitMask;
+};
+
+struct DDS_HEADER{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;				//	only if DDS_HEADER_FLAGS_VOLUME is set in flags
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DDS_PIXELFORMAT ddspf;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+
+struct DDS_HEADER_DXT10{
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag;			//	see D3D11_RESOURCE_MISC_FLAG
+	uint32_t arraySize;
+	uint32_t reserved;
+};
+#pragma pack(pop)
+
+enum DDSStatus{
+	DDS_OK,
+	DDS_OPEN_FAILED,
+	DDS_INVALID,			//	not a DDS file or the header contradicts itself
+	DDS_UNSUPPORTED,		//	valid, but a format or size D3D11 can't take
+	DDS_TRUNCATED			//	the file ends before the last subresource does
+};
+
+struct DDSInfo{
+	size_t width, height, depth;
+	size_t mipCount;
+	size_t arraySize;			//	6 per cube for cube maps
+	DXGI_FORMAT format;
+	unsigned int dimension;		//	DDS_DIMENSION_*
+	bool isCubeMap;
+};
+
+//	One mip of one array item, data points into the parsed bytes
+struct DDSSubresource{
+	const uint8_t* data;
+	size_t rowPitch;			//	bytes per row of pixels or of 4x4 blocks
+	size_t slicePitch;			//	bytes per depth slice
+	size_t size;				//	slicePitch * depth
+	size_t width, height, depth;
+};
+
+//	Bits per pixel of fmt, 0 for formats the parser doesn't know
+size_t BitsPerPixel(DXGI_FORMAT fmt);
+
+//	BC1 - BC7, stored as 4x4 blocks
+bool IsCompressed(DXGI_FORMAT fmt);
+
+//	Bytes of one width x height surface of fmt, per row and in total
+void GetSurfaceInfo(size_t width, size_t height, DXGI_FORMAT fmt, size_t* outNumBytes, size_t* outRowBytes, size_t* outNumRows);
+
+//	Magic, header and DX10 header describing info, appended to out. The
+//	subresources go after it in DDSFile order, each packed as GetSurfaceInfo says.
+void WriteDDSHeader(const DDSInfo& info, std::vector<uint8_t>& out);
+
+//	Whole file in one write, false if it can't be created or written
+bool SaveDDSFile(const char* path, const std::vector<uint8_t>& bytes);
+
+//	Device independent DDS reader. Validates the headers and builds a table
+//	of every subresource pointing straight into the file bytes, so the upload
+//	path copies nothing. Open maps the file and keeps the mapping, Parse works
+//	on memory the caller keeps alive. Subresources are item major, mip minor
+//	(D3D11 subresource order).
+class DDSFile {
+
+	MappedFile file;
+	DDS_HEADER header;
+	DDSInfo info;
+	std::vector<DDSSubresource> subresources;
+	DDSStatus status;
+
+	DDSFile(const DDSFile&) = delete;
+	DDSFile& operator=(const DDSFile&) = delete;
+
+	DDSStatus ParseHeader(const uint8_t* data, size_t size, size_t* bitOffset);
+	bool ParseMapped();
+
+public:
+
+	DDSFile();
+
+	bool Open(const char* path);
+#ifdef _WIN32
+	bool Open(const wchar_t* path);
+#endif
+	bool Parse(const void* data, size_t size);
+	void Close();
+
+	DDSStatus GetStatus() const { return status; }
+	const DDS_HEADER& GetHeader() const { return header; }
+	const DDSInfo& GetInfo() const { return info; }
+
+	size_t GetSubresourceCount() const { return subresources.size(); }
+	const DDSSubresource* GetSubresources() const { return subresources.data(); }
+	const DDSSubresource& GetSubresource(size_t item, size_t mip) const { return subresources[item * info.mipCount + mip]; }
+};
+
+#endif
@@ -2,8 +2,12 @@
 #define _DEFINES_H_
 
 #include <vector>
+#include <cstring>
+#include <string>
+#ifdef _WIN32
 #include <d3d11.h>
 #pragma comment (lib, "d3d11.lib")
+#endif
 using namespace std;
 
 #define NUMTREES	400
@@ -69,18 +73,31 @@ struct Vert{
 	Vert(float x, float y, float z,
 		float u, float v,
 		float nx, float ny, float nz,
-		float tx, float ty, float tz)
-		: Pos(x, y, z), Uvs(u, v), Norms(nx, ny, nz), tangent(tx, ty, tz){}
+		float tx, float ty, float tz, float tw = 1.0f)
+		: Pos(x, y, z), Uvs(u, v), Norms(nx, ny, nz), tangent(tx, ty, tz, tw){}
 	FLOAT3 Pos;
 	FLOAT2 Uvs;
 	FLOAT3 Norms;
 
-	FLOAT3 tangent;
+	FLOAT4 tangent;		//	w is the bitangent sign, B = w * cross(N, T)
+};
+
+//	Faces sharing a group and a material, drawn as one range of the index buffer
+struct SubMesh{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	unsigned int material;		//	into Model::materials
+	unsigned int group;			//	into Model::groups
 };
 
 struct Model{
 	std::vector<Vert> interleaved;
 	std::vector<unsigned int> out_Indicies;
+
+	std::vector<SubMesh> subMeshes;			//	cover out_Indicies in order
+	std::vector<std::string> materials;		//	usemtl names, [0] is "" for faces before any
+	std::vector<std::string> groups;		//	g / o names, [0] is "" likewise
+	std::string materialLib;				//	first mtllib, "" when there is none
 };
 
 
@@ -113,7 +130,7 @@ struct MATRIX4X4{
 };
 
 struct Light{
-	Light(){ ZeroMemory(this, sizeof(Light)); }
+	Light(){ memset(this, 0, sizeof(Light)); }
 
 	FLOAT3 direction;
 	float pad;
@@ -138,4 +155,10 @@ struct cbPerFrame{
 	Light light;
 };
 
+//	VS_Quantized position decode, pos = posOffset + packed * posScale
+struct cbQuantize{
+	FLOAT4 posOffset;
+	FLOAT4 posScale;
+};
+
 #endif
\ No newline at end of file
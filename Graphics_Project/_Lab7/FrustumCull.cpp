@@ -0,0 +1,243 @@
+#include "FrustumCull.h"
+#include "MathSIMD.h"
+#include "JobSystem.h"
+
+#include <cstring>
+
+#ifdef MATHSIMD_X86
+#include <immintrin.h>
+#endif
+
+
+void InstanceSoA::Clear(){
+	x.clear();
+	y.clear();
+	z.clear();
+}
+
+void InstanceSoA::Reserve(size_t n){
+	x.reserve(n);
+	y.reserve(n);
+	z.reserve(n);
+}
+
+void InstanceSoA::Add(FLOAT3 pos){
+	x.push_back(pos.x);
+	y.push_back(pos.y);
+	z.push_back(pos.z);
+}
+
+void BuildCullPlanes(const FLOAT4* planes, FLOAT3 aabbMin, FLOAT3 aabbMax, CullPlanes& out){
+	for (int p = 0; p < 6; ++p){
+		out.nx[p] = planes[p].x;
+		out.ny[p] = planes[p].y;
+		out.nz[p] = planes[p].z;
+		out.d[p] = planes[p].w;
+
+		//	Corner furthest along the normal
+		out.cx[p] = (planes[p].x < 0.0f) ? aabbMin.x : aabbMax.x;
+		out.cy[p] = (planes[p].y < 0.0f) ? aabbMin.y : aabbMax.y;
+		out.cz[p] = (planes[p].z < 0.0f) ? aabbMin.z : aabbMax.z;
+	}
+}
+
+static inline bool IsOutside(const CullPlanes& planes, int p, FLOAT3 pos){
+	float vx = planes.cx[p] + pos.x;
+	float vy = planes.cy[p] + pos.y;
+	float vz = planes.cz[p] + pos.z;
+
+	//	((x + y) + z) + w, the order XMVector3Dot sums in
+	float dist = (planes.nx[p] * vx) + (planes.ny[p] * vy);
+	dist = dist + (planes.nz[p] * vz);
+	return dist + planes.d[p] < 0.0f;
+}
+
+bool IsInstanceVisible(const CullPlanes& planes, FLOAT3 pos){
+	for (int p = 0; p < 6; ++p){
+		if (IsOutside(planes, p, pos))
+			return false;
+	}
+	return true;
+}
+
+static size_t CullScalar(const CullPlanes& planes, const InstanceSoA& inst, size_t begin, size_t end, unsigned int* out){
+	size_t count = 0;
+	for (size_t i = begin; i < end; ++i){
+		if (IsInstanceVisible(planes, FLOAT3(inst.x[i], inst.y[i], inst.z[i])))
+			out[count++] = (unsigned int)i;
+	}
+	return count;
+}
+
+#ifdef MATHSIMD_X86
+//	Visible lane numbers for every 4 bit mask, packed to the front
+struct LaneTable{
+	unsigned int lanes[16][4];
+	unsigned int count[16];
+
+	LaneTable(){
+		for (unsigned int mask = 0; mask < 16; ++mask){
+			count[mask] = 0;
+			for (unsigned int k = 0; k < 4; ++k){
+				lanes[mask][k] = 0;
+				if (mask & (1u << k))
+					lanes[mask][count[mask]++] = k;
+			}
+		}
+	}
+};
+
+static const LaneTable laneTable;
+
+//	Appends the indices of lanes that passed every plane (NaN distances pass too,
+//	as in the scalar test). Always stores 4 entries and only advances by the
+//	visible count, so there is no branch on the mask. The spill past count stays
+//	inside the caller's buffer because count never runs ahead of the lane index.
+static inline size_t Compact4(unsigned int mask, size_t base, unsigned int* out, size_t count){
+	__m128i idx = _mm_loadu_si128((const __m128i*)laneTable.lanes[mask]);
+	idx = _mm_add_epi32(idx, _mm_set1_epi32((int)base));
+	_mm_storeu_si128((__m128i*)(out + count), idx);
+	return count + laneTable.count[mask];
+}
+
+static size_t CullSSE(const CullPlanes& planes, const InstanceSoA& inst, size_t begin, size_t end, unsigned int* out){
+	const float* px = inst.x.data();
+	const float* py = inst.y.data();
+	const float* pz = inst.z.data();
+	__m128 zero = _mm_setzero_ps();
+
+	__m128 nx[6], ny[6], nz[6], d[6], cx[6], cy[6], cz[6];
+	for (int p = 0; p < 6; ++p){
+		nx[p] = _mm_set1_ps(planes.nx[p]);
+		ny[p] = _mm_set1_ps(planes.ny[p]);
+		nz[p] = _mm_set1_ps(planes.nz[p]);
+		d[p] = _mm_set1_ps(planes.d[p]);
+		cx[p] = _mm_set1_ps(planes.cx[p]);
+		cy[p] = _mm_set1_ps(planes.cy[p]);
+		cz[p] = _mm_set1_ps(planes.cz[p]);
+	}
+
+	size_t count = 0;
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4){
+		__m128 x = _mm_loadu_ps(px + i);
+		__m128 y = _mm_loadu_ps(py + i);
+		__m128 z = _mm_loadu_ps(pz + i);
+
+		int mask = 0xF;
+		for (int p = 0; p < 6; ++p){
+			__m128 vx = _mm_add_ps(cx[p], x);
+			__m128 vy = _mm_add_ps(cy[p], y);
+			__m128 vz = _mm_add_ps(cz[p], z);
+
+			__m128 dist = _mm_add_ps(_mm_mul_ps(nx[p], vx), _mm_mul_ps(ny[p], vy));
+			dist = _mm_add_ps(dist, _mm_mul_ps(nz[p], vz));
+			dist = _mm_add_ps(dist, d[p]);
+
+			mask &= _mm_movemask_ps(_mm_cmpnlt_ps(dist, zero));
+		}
+		count = Compact4((unsigned int)mask, i, out, count);
+	}
+
+	return count + CullScalar(planes, inst, i, end, out + count);
+}
+
+SIMD_TARGET_AVX static size_t CullAVX(const CullPlanes& planes, const InstanceSoA& inst, size_t begin, size_t end, unsigned int* out){
+	const float* px = inst.x.data();
+	const float* py = inst.y.data();
+	const float* pz = inst.z.data();
+	__m256 zero = _mm256_setzero_ps();
+
+	__m256 nx[6], ny[6], nz[6], d[6], cx[6], cy[6], cz[6];
+	for (int p = 0; p < 6; ++p){
+		nx[p] = _mm256_set1_ps(planes.nx[p]);
+		ny[p] = _mm256_set1_ps(planes.ny[p]);
+		nz[p] = _mm256_set1_ps(planes.nz[p]);
+		d[p] = _mm256_set1_ps(planes.d[p]);
+		cx[p] = _mm256_set1_ps(planes.cx[p]);
+		cy[p] = _mm256_set1_ps(planes.cy[p]);
+		cz[p] = _mm256_set1_ps(planes.cz[p]);
+	}
+
+	size_t count = 0;
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8){
+		__m256 x = _mm256_loadu_ps(px + i);
+		__m256 y = _mm256_loadu_ps(py + i);
+		__m256 z = _mm256_loadu_ps(pz + i);
+
+		int mask = 0xFF;
+		for (int p = 0; p < 6; ++p){
+			__m256 vx = _mm256_add_ps(cx[p], x);
+			__m256 vy = _mm256_add_ps(cy[p], y);
+			__m256 vz = _mm256_add_ps(cz[p], z);
+
+			__m256 dist = _mm256_add_ps(_mm256_mul_ps(nx[p], vx), _mm256_mul_ps(ny[p], vy));
+			dist = _mm256_add_ps(dist, _mm256_mul_ps(nz[p], vz));
+			dist = _mm256_add_ps(dist, d[p]);
+
+			mask &= _mm256_movemask_ps(_mm256_cmp_ps(dist, zero, _CMP_NLT_UQ));
+		}
+		count = Compact4((unsigned int)mask & 0xF, i, out, count);
+		count = Compact4((unsigned int)mask >> 4, i + 4, out, count);
+	}
+
+	return count + CullScalar(planes, inst, i, end, out + count);
+}
+#endif
+
+size_t CullInstances(const CullPlanes& planes, const InstanceSoA& inst, size_t begin, size_t end, unsigned int* outIndices){
+	if (end > inst.Size())
+		end = inst.Size();
+	if (begin >= end)
+		return 0;
+
+#ifdef MATHSIMD_X86
+	SIMDLevel level = GetSIMDLevel();
+	if (level == SIMD_AVX)
+		return CullAVX(planes, inst, begin, end, outIndices);
+	if (level == SIMD_SSE2)
+		return CullSSE(planes, inst, begin, end, outIndices);
+#endif
+	return CullScalar(planes, inst, begin, end, outIndices);
+}
+
+size_t CullInstancesParallel(JobSystem& jobs, const CullPlanes& planes, const InstanceSoA& inst,
+	CullScratch& scratch, unsigned int* outIndices, size_t chunkSize){
+
+	size_t count = inst.Size();
+	if (count == 0)
+		return 0;
+
+	//	Keep chunks a multiple of 8 so only the last one has a scalar tail
+	chunkSize = (chunkSize + 7) & ~(size_t)7;
+	size_t numChunks = (count + chunkSize - 1) / chunkSize;
+
+	if (scratch.indices.size() < count)
+		scratch.indices.resize(count);
+	if (scratch.counts.size() < numChunks){
+		scratch.counts.resize(numChunks);
+		scratch.offsets.resize(numChunks);
+	}
+
+	unsigned int* slices = &scratch.indices[0];
+	size_t* counts = &scratch.counts[0];
+
+	jobs.ParallelFor(count, chunkSize, [&](size_t chunk, size_t begin, size_t end, unsigned int){
+		counts[chunk] = CullInstances(planes, inst, begin, end, slices + begin);
+	});
+
+	size_t total = 0;
+	for (size_t c = 0; c < numChunks; ++c){
+		scratch.offsets[c] = total;
+		total += counts[c];
+	}
+
+	size_t* offsets = &scratch.offsets[0];
+	jobs.ParallelFor(numChunks, 1, [&](size_t chunk, size_t, size_t, unsigned int){
+		if (counts[chunk])
+			memcpy(outIndices + offsets[chunk], slices + chunk * chunkSize, counts[chunk] * sizeof(unsigned int));
+	});
+
+	return total;
+}
@@ -0,0 +1,71 @@
+#ifndef _FRUSTUMCULL_H_
+#define _FRUSTUMCULL_H_
+
+#include "Defines.h"
+#include <cstddef>
+
+class JobSystem;
+
+
+//	Left, right, top, bottom, near, far planes with normals facing in,
+//	a plain value so per frame extraction never touches the heap
+struct Frustum{
+	FLOAT4 planes[6];
+};
+
+//	Instance positions split per axis so 4 / 8 of them load in one go
+struct InstanceSoA{
+	std::vector<float> x, y, z;
+
+	void Clear();
+	void Reserve(size_t n);
+	void Add(FLOAT3 pos);
+	size_t Size() const { return x.size(); }
+	FLOAT3 Get(size_t i) const { return FLOAT3(x[i], y[i], z[i]); }
+};
+
+//	Frustum planes with the AABB corner for each plane picked ahead of time,
+//	so the per instance test has no branching on the plane signs
+struct CullPlanes{
+	float nx[6], ny[6], nz[6], d[6];
+	float cx[6], cy[6], cz[6];
+};
+
+void BuildCullPlanes(const FLOAT4* planes, FLOAT3 aabbMin, FLOAT3 aabbMax, CullPlanes& out);
+
+//	Same test and arithmetic order as the original per tree loop
+bool IsInstanceVisible(const CullPlanes& planes, FLOAT3 pos);
+
+//	Tests instances [begin, end) and writes the visible ones' indices in order.
+//	outIndices needs room for (end - begin) entries. Returns the visible count.
+size_t CullInstances(const CullPlanes& planes, const InstanceSoA& inst, size_t begin, size_t end, unsigned int* outIndices);
+
+//	Per chunk output slices and counts, kept between frames
+struct CullScratch{
+	std::vector<unsigned int> indices;
+	std::vector<size_t> counts;
+	std::vector<size_t> offsets;
+};
+
+//	Chunks of instances are culled on the job system, each into its own slice of
+//	scratch.indices. A prefix sum over the chunk counts then packs the slices into
+//	outIndices (room for inst.Size() entries), so the order matches CullInstances.
+size_t CullInstancesParallel(JobSystem& jobs, const CullPlanes& planes, const InstanceSoA& inst,
+	CullScratch& scratch, unsigned int* outIndices, size_t chunkSize = 16384);
+
+//	Plane test counters for the coherent BVH cull. Skipped tests are counted
+//	against testing all 6 planes per object, as the SIMD path does.
+struct CullStats{
+	size_t objects;			//	instances / nodes looked at
+	size_t planeTests;
+	size_t cacheHits;		//	rejected straight away by last frame's plane
+
+	CullStats() : objects(0), planeTests(0), cacheHits(0){}
+	void Reset(){ objects = planeTests = cacheHits = 0; }
+	size_t TestsSkipped() const { return objects * 6 - planeTests; }
+};
+
+//	BVHCullCache entry for a node / box nothing rejected last time
+#define CULL_NO_PLANE	0xFF
+
+#endif
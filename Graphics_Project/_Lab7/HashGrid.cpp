@@ -0,0 +1,320 @@
+#include "HashGrid.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+
+HashGrid::HashGrid(float _cellSize) : count(0), cellSize(_cellSize), invCellSize(1.0f / _cellSize), queryStamp(0){
+	Clear();
+}
+
+void HashGrid::Clear(){
+	cells.clear();
+	entries.clear();
+	seen.clear();
+	count = 0;
+	queryStamp = 0;
+
+	for (int a = 0; a < 3; ++a){
+		usedLo[a] = INT_MAX;
+		usedHi[a] = INT_MIN;
+	}
+}
+
+unsigned long long HashGrid::Key(int x, int y, int z){
+	const unsigned long long mask = (1ull << 21) - 1;
+	return ((unsigned long long)(x + (1 << 20)) & mask) |
+		(((unsigned long long)(y + (1 << 20)) & mask) << 21) |
+		(((unsigned long long)(z + (1 << 20)) & mask) << 42);
+}
+
+int HashGrid::CellCoord(float v) const{
+	return (int)floorf(v * invCellSize);
+}
+
+void HashGrid::CellRange(const AABB& bounds, int lo[3], int hi[3]) const{
+	lo[0] = CellCoord(bounds.min.x);	hi[0] = CellCoord(bounds.max.x);
+	lo[1] = CellCoord(bounds.min.y);	hi[1] = CellCoord(bounds.max.y);
+	lo[2] = CellCoord(bounds.min.z);	hi[2] = CellCoord(bounds.max.z);
+}
+
+AABB HashGrid::CellBounds(int x, int y, int z) const{
+	return AABB(FLOAT3(x * cellSize, y * cellSize, z * cellSize),
+		FLOAT3((x + 1) * cellSize, (y + 1) * cellSize, (z + 1) * cellSize));
+}
+
+void HashGrid::AddToCells(unsigned int id){
+	Entry& e = entries[id];
+	CellRange(e.bounds, e.lo, e.hi);
+
+	for (int z = e.lo[2]; z <= e.hi[2]; ++z)
+		for (int y = e.lo[1]; y <= e.hi[1]; ++y)
+			for (int x = e.lo[0]; x <= e.hi[0]; ++x){
+				Cell& cell = cells[Key(x, y, z)];
+				cell.x = x;
+				cell.y = y;
+				cell.z = z;
+				cell.objects.push_back(id);
+			}
+
+	for (int a = 0; a < 3; ++a){
+		usedLo[a] = std::min(usedLo[a], e.lo[a]);
+		usedHi[a] = std::max(usedHi[a], e.hi[a]);
+	}
+}
+
+void HashGrid::RemoveFromCells(unsigned int id){
+	Entry& e = entries[id];
+
+	for (int z = e.lo[2]; z <= e.hi[2]; ++z)
+		for (int y = e.lo[1]; y <= e.hi[1]; ++y)
+			for (int x = e.lo[0]; x <= e.hi[0]; ++x){
+				std::unordered_map<unsigned long long, Cell>::iterator it = cells.find(Key(x, y, z));
+				if (it == cells.end())
+					continue;
+
+				//	Cells hold a handful of ids, a linear search is fine
+				std::vector<unsigned int>& objects = it->second.objects;
+				std::vector<unsigned int>::iterator o = std::find(objects.begin(), objects.end(), id);
+				if (o != objects.end()){
+					*o = objects.back();
+					objects.pop_back();
+				}
+				if (objects.empty())
+					cells.erase(it);
+			}
+}
+
+void HashGrid::Insert(unsigned int id, const AABB& bounds){
+	if (id >= entries.size()){
+		Entry empty;
+		empty.inserted = false;
+		entries.resize(id + 1, empty);
+		seen.resize(id + 1, 0);
+	}
+
+	if (entries[id].inserted){
+		Move(id, bounds);
+		return;
+	}
+
+	entries[id].bounds = bounds;
+	entries[id].inserted = true;
+	AddToCells(id);
+	++count;
+}
+
+void HashGrid::Remove(unsigned int id){
+	if (!Contains(id))
+		return;
+
+	RemoveFromCells(id);
+	entries[id].inserted = false;
+	--count;
+}
+
+void HashGrid::Move(unsigned int id, const AABB& bounds){
+	if (!Contains(id)){
+		Insert(id, bounds);
+		return;
+	}
+
+	Entry& e = entries[id];
+	int lo[3], hi[3];
+	CellRange(bounds, lo, hi);
+
+	//	Same cells, only the box changes
+	if (lo[0] == e.lo[0] && lo[1] == e.lo[1] && lo[2] == e.lo[2] &&
+		hi[0] == e.hi[0] && hi[1] == e.hi[1] && hi[2] == e.hi[2]){
+		e.bounds = bounds;
+		return;
+	}
+
+	RemoveFromCells(id);
+	e.bounds = bounds;
+	AddToCells(id);
+}
+
+bool HashGrid::Contains(unsigned int id) const{
+	return id < entries.size() && entries[id].inserted;
+}
+
+unsigned int HashGrid::NextStamp() const{
+	//	On wrap the old marks could read as current, start them over
+	if (++queryStamp == 0){
+		std::fill(seen.begin(), seen.end(), 0);
+		queryStamp = 1;
+	}
+	return queryStamp;
+}
+
+bool HashGrid::MarkSeen(unsigned int id, unsigned int stamp) const{
+	if (seen[id] == stamp)
+		return false;
+	seen[id] = stamp;
+	return true;
+}
+
+void HashGrid::QueryFrustum(const FLOAT4* planes, std::vector<unsigned int>& out) const{
+	unsigned int stamp = NextStamp();
+
+	//	The frustum has no cheap cell range, walk the occupied cells instead
+	for (std::unordered_map<unsigned long long, Cell>::const_iterator it = cells.begin(); it != cells.end(); ++it){
+		const Cell& cell = it->second;
+		AABB cb = CellBounds(cell.x, cell.y, cell.z);
+
+		unsigned int planeMask = 0x3F;
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; ++p){
+			int side = ClassifyAABB(planes[p], cb);
+			if (side < 0)
+				outside = true;
+			else if (side > 0)
+				planeMask &= ~(1u << p);
+		}
+		if (outside)
+			continue;
+
+		for (size_t i = 0; i < cell.objects.size(); ++i){
+			unsigned int id = cell.objects[i];
+			if (!MarkSeen(id, stamp))
+				continue;
+
+			//	Anything touching a cell fully inside is visible
+			bool visible = true;
+			for (int p = 0; p < 6 && visible; ++p){
+				if ((planeMask & (1u << p)) && ClassifyAABB(planes[p], entries[id].bounds) < 0)
+					visible = false;
+			}
+			if (visible)
+				out.push_back(id);
+		}
+	}
+}
+
+void HashGrid::QuerySphere(const FLOAT3& center, float radius, std::vector<unsigned int>& out) const{
+	unsigned int stamp = NextStamp();
+
+	int lo[3], hi[3];
+	CellRange(AABB(FLOAT3(center.x - radius, center.y - radius, center.z - radius),
+		FLOAT3(center.x + radius, center.y + radius, center.z + radius)), lo, hi);
+
+	for (int a = 0; a < 3; ++a){
+		lo[a] = std::max(lo[a], usedLo[a]);
+		hi[a] = std::min(hi[a], usedHi[a]);
+		if (lo[a] > hi[a])
+			return;
+	}
+
+	double rangeCells = (double)(hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+
+	//	Look cells up by coordinate unless the sphere spans more cells than exist
+	if (rangeCells <= (double)cells.size()){
+		for (int z = lo[2]; z <= hi[2]; ++z)
+			for (int y = lo[1]; y <= hi[1]; ++y)
+				for (int x = lo[0]; x <= hi[0]; ++x){
+					std::unordered_map<unsigned long long, Cell>::const_iterator it = cells.find(Key(x, y, z));
+					if (it == cells.end())
+						continue;
+
+					const std::vector<unsigned int>& objects = it->second.objects;
+					for (size_t i = 0; i < objects.size(); ++i){
+						if (MarkSeen(objects[i], stamp) && SphereOverlapsAABB(center, radius, entries[objects[i]].bounds))
+							out.push_back(objects[i]);
+					}
+				}
+		return;
+	}
+
+	for (std::unordered_map<unsigned long long, Cell>::const_iterator it = cells.begin(); it != cells.end(); ++it){
+		const Cell& cell = it->second;
+		if (!SphereOverlapsAABB(center, radius, CellBounds(cell.x, cell.y, cell.z)))
+			continue;
+
+		for (size_t i = 0; i < cell.objects.size(); ++i){
+			if (MarkSeen(cell.objects[i], stamp) && SphereOverlapsAABB(center, radius, entries[cell.objects[i]].bounds))
+				out.push_back(cell.objects[i]);
+		}
+	}
+}
+
+void HashGrid::QueryRay(const FLOAT3& origin, const FLOAT3& dir, float maxT, std::vector<unsigned int>& out) const{
+	if (cells.empty())
+		return;
+
+	unsigned int stamp = NextStamp();
+	FLOAT3 invDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+
+	//	Clip the segment to the occupied cells so the walk always ends
+	AABB used(FLOAT3(usedLo[0] * cellSize, usedLo[1] * cellSize, usedLo[2] * cellSize),
+		FLOAT3((usedHi[0] + 1) * cellSize, (usedHi[1] + 1) * cellSize, (usedHi[2] + 1) * cellSize));
+
+	float o[3] = { origin.x, origin.y, origin.z };
+	float d[3] = { dir.x, dir.y, dir.z };
+	float inv[3] = { invDir.x, invDir.y, invDir.z };
+	float lo[3] = { used.min.x, used.min.y, used.min.z };
+	float hi[3] = { used.max.x, used.max.y, used.max.z };
+
+	float tEnter = 0.0f, tExit = maxT;
+	for (int a = 0; a < 3; ++a){
+		if (d[a] == 0.0f){
+			if (o[a] < lo[a] || o[a] > hi[a])
+				return;
+			continue;
+		}
+		float t1 = (lo[a] - o[a]) * inv[a];
+		float t2 = (hi[a] - o[a]) * inv[a];
+		tEnter = std::max(tEnter, std::min(t1, t2));
+		tExit = std::min(tExit, std::max(t1, t2));
+	}
+	if (tEnter > tExit)
+		return;
+
+	//	3D DDA from the entry point, one cell step at a time
+	int cell[3], step[3], last[3];
+	float tMax[3], tDelta[3];
+	for (int a = 0; a < 3; ++a){
+		float p = o[a] + d[a] * tEnter;
+		cell[a] = std::min(std::max(CellCoord(p), usedLo[a]), usedHi[a]);
+		last[a] = std::min(std::max(CellCoord(o[a] + d[a] * tExit), usedLo[a]), usedHi[a]);
+
+		if (d[a] > 0.0f){
+			step[a] = 1;
+			tMax[a] = ((cell[a] + 1) * cellSize - o[a]) * inv[a];
+			tDelta[a] = cellSize * inv[a];
+		}
+		else if (d[a] < 0.0f){
+			step[a] = -1;
+			tMax[a] = (cell[a] * cellSize - o[a]) * inv[a];
+			tDelta[a] = -cellSize * inv[a];
+		}
+		else {
+			step[a] = 0;
+			tMax[a] = INFINITY;
+			tDelta[a] = INFINITY;
+		}
+	}
+
+	for (;;){
+		std::unordered_map<unsigned long long, Cell>::const_iterator it = cells.find(Key(cell[0], cell[1], cell[2]));
+		if (it != cells.end()){
+			const std::vector<unsigned int>& objects = it->second.objects;
+			for (size_t i = 0; i < objects.size(); ++i){
+				if (MarkSeen(objects[i], stamp) && RayHitsAABB(origin, invDir, maxT, entries[objects[i]].bounds))
+					out.push_back(objects[i]);
+			}
+		}
+
+		if (cell[0] == last[0] && cell[1] == last[1] && cell[2] == last[2])
+			break;
+
+		int a = (tMax[0] < tMax[1]) ? ((tMax[0] < tMax[2]) ? 0 : 2) : ((tMax[1] < tMax[2]) ? 1 : 2);
+		if (tMax[a] > tExit)
+			break;
+		cell[a] += step[a];
+		if (cell[a] < usedLo[a] || cell[a] > usedHi[a])
+			break;
+		tMax[a] += tDelta[a];
+	}
+}
@@ -0,0 +1,70 @@
+#ifndef _HASHGRID_H_
+#define _HASHGRID_H_
+
+#include "SpatialIndex.h"
+#include <unordered_map>
+
+
+//	Uniform grid of cubic cells, only occupied cells are stored (hashed on
+//	their integer coordinates). An object is listed in every cell its box
+//	touches, so queries mark objects as seen to report each one once.
+//	Cell coordinates wrap past +-2^20, keep cellSize in proportion to the world.
+//	Queries share the seen marks: one query at a time per grid.
+class HashGrid : public SpatialIndex {
+
+	struct Cell{
+		int x, y, z;
+		std::vector<unsigned int> objects;
+	};
+
+	struct Entry{
+		AABB bounds;
+		int lo[3], hi[3];			//	inclusive cell range
+		bool inserted;
+	};
+
+	std::unordered_map<unsigned long long, Cell> cells;
+	std::vector<Entry> entries;
+	size_t count;
+
+	float cellSize;
+	float invCellSize;
+
+	//	Range of cells ever occupied, bounds the ray walk
+	int usedLo[3], usedHi[3];
+
+	mutable std::vector<unsigned int> seen;
+	mutable unsigned int queryStamp;
+
+	static unsigned long long Key(int x, int y, int z);
+	int CellCoord(float v) const;
+	void CellRange(const AABB& bounds, int lo[3], int hi[3]) const;
+	AABB CellBounds(int x, int y, int z) const;
+
+	void AddToCells(unsigned int id);
+	void RemoveFromCells(unsigned int id);
+
+	unsigned int NextStamp() const;
+	bool MarkSeen(unsigned int id, unsigned int stamp) const;
+
+public:
+
+	HashGrid(float cellSize = 8.0f);
+
+	void Clear();
+
+	void Insert(unsigned int id, const AABB& bounds);
+	void Remove(unsigned int id);
+	void Move(unsigned int id, const AABB& bounds);
+
+	bool Contains(unsigned int id) const;
+	size_t Size() const { return count; }
+
+	void QueryFrustum(const FLOAT4* planes, std::vector<unsigned int>& out) const;
+	void QuerySphere(const FLOAT3& center, float radius, std::vector<unsigned int>& out) const;
+	void QueryRay(const FLOAT3& origin, const FLOAT3& dir, float maxT, std::vector<unsigned int>& out) const;
+
+	size_t GetCellCount() const { return cells.size(); }
+};
+
+#endif
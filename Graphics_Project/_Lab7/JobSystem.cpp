@@ -0,0 +1,173 @@
+#include "JobSystem.h"
+
+
+JobSystem::JobSystem() : queuedJobs(0), quit(false) {
+}
+
+JobSystem::~JobSystem() {
+	Shutdown();
+}
+
+bool JobSystem::Initialize(unsigned int numThreads) {
+	Shutdown();
+
+	if (numThreads == 0)
+		numThreads = std::thread::hardware_concurrency();
+	if (numThreads == 0)
+		numThreads = 1;
+
+	quit = false;
+	queues.clear();
+	for (unsigned int i = 0; i < numThreads; ++i)
+		queues.push_back(std::unique_ptr<Queue>(new Queue));
+
+	//	Slot 0 belongs to whoever calls ParallelFor
+	for (unsigned int i = 1; i < numThreads; ++i)
+		threads.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+
+	return true;
+}
+
+void JobSystem::Shutdown() {
+	{
+		std::lock_guard<std::mutex> guard(wakeLock);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (unsigned int i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	threads.clear();
+}
+
+unsigned int JobSystem::GetNumThreads() const {
+	return queues.empty() ? 1 : (unsigned int)queues.size();
+}
+
+bool JobSystem::PopOwn(unsigned int index, Job& job) {
+	Queue& q = *queues[index];
+	std::lock_guard<std::mutex> guard(q.lock);
+	if (q.count == 0)
+		return false;
+
+	--q.count;
+	job = q.jobs[(q.first + q.count) % JOB_QUEUE_CAPACITY];
+	return true;
+}
+
+bool JobSystem::Steal(unsigned int index, Job& job) {
+	unsigned int count = (unsigned int)queues.size();
+	for (unsigned int i = 1; i < count; ++i) {
+		Queue& q = *queues[(index + i) % count];
+		std::lock_guard<std::mutex> guard(q.lock);
+		if (q.count == 0)
+			continue;
+
+		job = q.jobs[q.first];
+		q.first = (q.first + 1) % JOB_QUEUE_CAPACITY;
+		--q.count;
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::FindJob(unsigned int index, Job& job) {
+	if (queuedJobs.load() == 0)
+		return false;
+
+	if (PopOwn(index, job) || Steal(index, job)) {
+		queuedJobs.fetch_sub(1);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::Run(const Job& job, unsigned int index) {
+	job.fn(job.chunk, job.begin, job.end, index);
+
+	//	remaining lives on the caller's stack, it's gone once the caller wakes
+	if (job.remaining->fetch_sub(1) == 1) {
+		std::lock_guard<std::mutex> guard(doneLock);
+		done.notify_all();
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int index) {
+	Job job;
+	while (true) {
+		if (FindJob(index, job)) {
+			Run(job, index);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wakeLock);
+		wake.wait(lock, [this] { return quit || queuedJobs.load() > 0; });
+		if (quit)
+			return;
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t chunkSize, RangeFn fn) {
+	if (count == 0)
+		return;
+	if (chunkSize == 0)
+		chunkSize = count;
+
+	size_t numChunks = (count + chunkSize - 1) / chunkSize;
+
+	//	Not initialized or nothing to split, just run inline
+	if (queues.size() <= 1 || numChunks == 1) {
+		for (size_t c = 0; c < numChunks; ++c) {
+			size_t begin = c * chunkSize;
+			size_t end = (begin + chunkSize < count) ? begin + chunkSize : count;
+			fn(c, begin, end, 0);
+		}
+		return;
+	}
+
+	//	Each ring takes an even share of what's left, as much as it has room
+	//	for. Rings full of other callers' work push the rest to a later round.
+	unsigned int numQueues = (unsigned int)queues.size();
+	size_t next = 0;
+	while (next < numChunks) {
+		//	Counts everything left until the rings say how much went in, so a
+		//	worker finishing early can't bring it to 0
+		std::atomic<size_t> remaining(numChunks - next);
+		size_t share = (numChunks - next + numQueues - 1) / numQueues;
+		size_t roundStart = next;
+
+		for (unsigned int q = 0; q < numQueues && next < numChunks; ++q) {
+			Queue& queue = *queues[q];
+			std::lock_guard<std::mutex> guard(queue.lock);
+			for (size_t c = 0; c < share && queue.count < JOB_QUEUE_CAPACITY && next < numChunks; ++c, ++next) {
+				size_t begin = next * chunkSize;
+				Job job = { fn, &remaining, next, begin, (begin + chunkSize < count) ? begin + chunkSize : count };
+				queue.jobs[(queue.first + queue.count) % JOB_QUEUE_CAPACITY] = job;
+				++queue.count;
+				queuedJobs.fetch_add(1);
+			}
+		}
+		remaining.fetch_sub(numChunks - next);
+
+		//	No room anywhere, take one chunk here and try again
+		if (next == roundStart) {
+			size_t begin = next * chunkSize;
+			fn(next, begin, (begin + chunkSize < count) ? begin + chunkSize : count, 0);
+			++next;
+			continue;
+		}
+
+		//	A worker between its wait check and sleeping holds wakeLock
+		{
+			std::lock_guard<std::mutex> guard(wakeLock);
+		}
+		wake.notify_all();
+
+		Job job;
+		while (FindJob(0, job))
+			Run(job, 0);
+
+		std::unique_lock<std::mutex> lock(doneLock);
+		done.wait(lock, [&remaining] { return remaining.load() == 0; });
+	}
+}
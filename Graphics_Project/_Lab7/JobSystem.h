@@ -0,0 +1,99 @@
+#ifndef _JOBSYSTEM_H_
+#define _JOBSYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//	Chunks each queue holds, bigger loops are posted in rounds
+#define JOB_QUEUE_CAPACITY	256
+
+
+//	Fixed pool of worker threads, one fixed size job ring each. Owners pop from
+//	the back of their own ring, idle threads steal from the front of someone
+//	else's. A thread calling ParallelFor works as thread 0, taking chunks
+//	until none are left to take, then sleeps until the ones still running are
+//	done. Nothing is allocated after Initialize.
+class JobSystem {
+
+public:
+	//	fn(chunkIndex, begin, end, threadIndex), a reference to any callable.
+	//	It doesn't own or copy it: the callable has to outlive the ParallelFor,
+	//	which a lambda written in the call does.
+	class RangeFn {
+		const void* object;
+		void (*call)(const void*, size_t, size_t, size_t, unsigned int);
+
+		template <typename Fn>
+		static void Call(const void* object, size_t chunk, size_t begin, size_t end, unsigned int thread) {
+			(*static_cast<const Fn*>(object))(chunk, begin, end, thread);
+		}
+
+	public:
+		RangeFn() : object(nullptr), call(nullptr) {}
+
+		template <typename Fn, typename = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type, RangeFn>::value>::type>
+		RangeFn(const Fn& fn) : object(&fn), call(&Call<Fn>) {}
+
+		void operator()(size_t chunk, size_t begin, size_t end, unsigned int thread) const {
+			call(object, chunk, begin, end, thread);
+		}
+	};
+
+private:
+	struct Job {
+		RangeFn fn;
+		std::atomic<size_t>* remaining;
+		size_t chunk, begin, end;
+	};
+
+	//	Ring of jobs, first is the oldest (stolen), first + count - 1 the newest (popped)
+	struct Queue {
+		std::mutex lock;
+		Job jobs[JOB_QUEUE_CAPACITY];
+		unsigned int first;
+		unsigned int count;
+
+		Queue() : first(0), count(0) {}
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+
+	std::mutex wakeLock;
+	std::condition_variable wake;
+	std::atomic<size_t> queuedJobs;
+	bool quit;
+
+	//	Signalled when the last chunk of a ParallelFor round finishes
+	std::mutex doneLock;
+	std::condition_variable done;
+
+	bool PopOwn(unsigned int index, Job& job);
+	bool Steal(unsigned int index, Job& job);
+	bool FindJob(unsigned int index, Job& job);
+	void Run(const Job& job, unsigned int index);
+	void WorkerLoop(unsigned int index);
+
+public:
+
+	JobSystem();
+	~JobSystem();
+
+	//	numThreads counts the calling thread, 0 = one per hardware thread
+	bool Initialize(unsigned int numThreads = 0);
+	void Shutdown();
+
+	unsigned int GetNumThreads() const;
+
+	//	Splits [0, count) into chunkSize ranges and blocks until all have run.
+	//	Several threads may call it at once, each caller runs as thread 0 and
+	//	may help with the others' chunks. fn must not call ParallelFor itself.
+	void ParallelFor(size_t count, size_t chunkSize, RangeFn fn);
+};
+#endif
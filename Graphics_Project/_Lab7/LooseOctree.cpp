@@ -0,0 +1,251 @@
+#include "LooseOctree.h"
+
+#include <algorithm>
+
+
+static inline int Octant(const FLOAT3& p, const FLOAT3& center){
+	return ((p.x >= center.x) ? 1 : 0) | ((p.y >= center.y) ? 2 : 0) | ((p.z >= center.z) ? 4 : 0);
+}
+
+
+LooseOctree::LooseOctree(FLOAT3 center, float halfSize, unsigned int _maxDepth)
+	: count(0), rootCenter(center), rootHalfSize(halfSize), maxDepth(_maxDepth){
+	Clear();
+}
+
+void LooseOctree::Clear(){
+	nodes.clear();
+	entries.clear();
+	count = 0;
+
+	Node root;
+	root.center = rootCenter;
+	root.halfSize = rootHalfSize;
+	root.parent = -1;
+	std::fill(root.children, root.children + 8, -1);
+	root.subtreeCount = 0;
+	nodes.push_back(root);
+}
+
+AABB LooseOctree::LooseBounds(const Node& node) const{
+	float h = node.halfSize * 2.0f;
+	return AABB(FLOAT3(node.center.x - h, node.center.y - h, node.center.z - h),
+		FLOAT3(node.center.x + h, node.center.y + h, node.center.z + h));
+}
+
+int LooseOctree::AddChild(int nodeIndex, int octant){
+	Node child;
+	float h = nodes[nodeIndex].halfSize * 0.5f;
+	child.center.x = nodes[nodeIndex].center.x + ((octant & 1) ? h : -h);
+	child.center.y = nodes[nodeIndex].center.y + ((octant & 2) ? h : -h);
+	child.center.z = nodes[nodeIndex].center.z + ((octant & 4) ? h : -h);
+	child.halfSize = h;
+	child.parent = nodeIndex;
+	std::fill(child.children, child.children + 8, -1);
+	child.subtreeCount = 0;
+
+	int childIndex = (int)nodes.size();
+	nodes.push_back(child);
+	nodes[nodeIndex].children[octant] = childIndex;
+	return childIndex;
+}
+
+int LooseOctree::FindNode(const AABB& bounds, bool create){
+	FLOAT3 c((bounds.min.x + bounds.max.x) * 0.5f, (bounds.min.y + bounds.max.y) * 0.5f, (bounds.min.z + bounds.max.z) * 0.5f);
+	float extent = std::max(std::max(bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y), bounds.max.z - bounds.min.z) * 0.5f;
+
+	//	Centers outside the root cell would not be covered by any child's loose bounds
+	if (c.x < rootCenter.x - rootHalfSize || c.x > rootCenter.x + rootHalfSize ||
+		c.y < rootCenter.y - rootHalfSize || c.y > rootCenter.y + rootHalfSize ||
+		c.z < rootCenter.z - rootHalfSize || c.z > rootCenter.z + rootHalfSize)
+		return 0;
+
+	int nodeIndex = 0;
+	for (unsigned int depth = 0; depth < maxDepth; ++depth){
+		//	A child's loose bounds reach its half size past its cell, the object has to fit in that
+		if (extent > nodes[nodeIndex].halfSize * 0.5f)
+			break;
+
+		int octant = Octant(c, nodes[nodeIndex].center);
+		int child = nodes[nodeIndex].children[octant];
+		if (child < 0){
+			if (!create)
+				return -1;
+			child = AddChild(nodeIndex, octant);
+		}
+		nodeIndex = child;
+	}
+	return nodeIndex;
+}
+
+void LooseOctree::Link(unsigned int id, int nodeIndex){
+	Entry& e = entries[id];
+	e.node = nodeIndex;
+	e.slot = (unsigned int)nodes[nodeIndex].objects.size();
+	nodes[nodeIndex].objects.push_back(id);
+
+	for (int n = nodeIndex; n >= 0; n = nodes[n].parent)
+		nodes[n].subtreeCount++;
+}
+
+void LooseOctree::Unlink(unsigned int id){
+	Entry& e = entries[id];
+	std::vector<unsigned int>& objects = nodes[e.node].objects;
+
+	//	Swap remove, the moved object's slot follows it
+	unsigned int last = objects.back();
+	objects[e.slot] = last;
+	entries[last].slot = e.slot;
+	objects.pop_back();
+
+	for (int n = e.node; n >= 0; n = nodes[n].parent)
+		nodes[n].subtreeCount--;
+
+	e.node = -1;
+}
+
+void LooseOctree::Insert(unsigned int id, const AABB& bounds){
+	if (id >= entries.size()){
+		Entry empty;
+		empty.node = -1;
+		empty.slot = 0;
+		entries.resize(id + 1, empty);
+	}
+
+	if (entries[id].node >= 0){
+		Move(id, bounds);
+		return;
+	}
+
+	entries[id].bounds = bounds;
+	Link(id, FindNode(bounds, true));
+	++count;
+}
+
+void LooseOctree::Remove(unsigned int id){
+	if (!Contains(id))
+		return;
+
+	Unlink(id);
+	--count;
+}
+
+void LooseOctree::Move(unsigned int id, const AABB& bounds){
+	if (!Contains(id)){
+		Insert(id, bounds);
+		return;
+	}
+
+	entries[id].bounds = bounds;
+
+	//	Small moves usually stay in the same node and just update the box
+	int nodeIndex = FindNode(bounds, true);
+	if (nodeIndex != entries[id].node){
+		Unlink(id);
+		Link(id, nodeIndex);
+	}
+}
+
+bool LooseOctree::Contains(unsigned int id) const{
+	return id < entries.size() && entries[id].node >= 0;
+}
+
+void LooseOctree::EmitAll(int nodeIndex, std::vector<unsigned int>& out) const{
+	const Node& node = nodes[nodeIndex];
+	out.insert(out.end(), node.objects.begin(), node.objects.end());
+	for (int i = 0; i < 8; ++i){
+		if (node.children[i] >= 0 && nodes[node.children[i]].subtreeCount > 0)
+			EmitAll(node.children[i], out);
+	}
+}
+
+void LooseOctree::Frustum(int nodeIndex, const FLOAT4* planes, unsigned int planeMask, std::vector<unsigned int>& out) const{
+	const Node& node = nodes[nodeIndex];
+	if (node.subtreeCount == 0)
+		return;
+
+	//	The root also holds whatever lies outside its cell, so its bounds are not tested
+	if (nodeIndex != 0){
+		AABB loose = LooseBounds(node);
+		for (int p = 0; p < 6; ++p){
+			if (!(planeMask & (1u << p)))
+				continue;
+
+			int side = ClassifyAABB(planes[p], loose);
+			if (side < 0)
+				return;
+			if (side > 0)
+				planeMask &= ~(1u << p);
+		}
+
+		if (planeMask == 0){
+			EmitAll(nodeIndex, out);
+			return;
+		}
+	}
+
+	for (size_t i = 0; i < node.objects.size(); ++i){
+		unsigned int id = node.objects[i];
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; ++p){
+			if ((planeMask & (1u << p)) && ClassifyAABB(planes[p], entries[id].bounds) < 0)
+				visible = false;
+		}
+		if (visible)
+			out.push_back(id);
+	}
+
+	for (int i = 0; i < 8; ++i){
+		if (node.children[i] >= 0)
+			Frustum(node.children[i], planes, planeMask, out);
+	}
+}
+
+void LooseOctree::Sphere(int nodeIndex, const FLOAT3& center, float radius, std::vector<unsigned int>& out) const{
+	const Node& node = nodes[nodeIndex];
+	if (node.subtreeCount == 0)
+		return;
+	if (nodeIndex != 0 && !SphereOverlapsAABB(center, radius, LooseBounds(node)))
+		return;
+
+	for (size_t i = 0; i < node.objects.size(); ++i){
+		if (SphereOverlapsAABB(center, radius, entries[node.objects[i]].bounds))
+			out.push_back(node.objects[i]);
+	}
+
+	for (int i = 0; i < 8; ++i){
+		if (node.children[i] >= 0)
+			Sphere(node.children[i], center, radius, out);
+	}
+}
+
+void LooseOctree::Ray(int nodeIndex, const FLOAT3& origin, const FLOAT3& invDir, float maxT, std::vector<unsigned int>& out) const{
+	const Node& node = nodes[nodeIndex];
+	if (node.subtreeCount == 0)
+		return;
+	if (nodeIndex != 0 && !RayHitsAABB(origin, invDir, maxT, LooseBounds(node)))
+		return;
+
+	for (size_t i = 0; i < node.objects.size(); ++i){
+		if (RayHitsAABB(origin, invDir, maxT, entries[node.objects[i]].bounds))
+			out.push_back(node.objects[i]);
+	}
+
+	for (int i = 0; i < 8; ++i){
+		if (node.children[i] >= 0)
+			Ray(node.children[i], origin, invDir, maxT, out);
+	}
+}
+
+void LooseOctree::QueryFrustum(const FLOAT4* planes, std::vector<unsigned int>& out) const{
+	Frustum(0, planes, 0x3F, out);
+}
+
+void LooseOctree::QuerySphere(const FLOAT3& center, float radius, std::vector<unsigned int>& out) const{
+	Sphere(0, center, radius, out);
+}
+
+void LooseOctree::QueryRay(const FLOAT3& origin, const FLOAT3& dir, float maxT, std::vector<unsigned int>& out) const{
+	FLOAT3 invDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+	Ray(0, origin, invDir, maxT, out);
+}
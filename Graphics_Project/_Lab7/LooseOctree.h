@@ -0,0 +1,70 @@
+#ifndef _LOOSEOCTREE_H_
+#define _LOOSEOCTREE_H_
+
+#include "SpatialIndex.h"
+
+
+//	Octree whose nodes overlap their neighbours by half a cell on each side
+//	(loose factor 2). An object sits in the deepest node whose cell holds its
+//	center and whose half size covers its largest half extent, so insert and
+//	move never split an object across nodes. Objects outside the root cell
+//	stay at the root.
+class LooseOctree : public SpatialIndex {
+
+	struct Node{
+		FLOAT3 center;
+		float halfSize;				//	of the cell, loose bounds are twice this
+		int parent;
+		int children[8];			//	-1 until something lands there
+		unsigned int subtreeCount;	//	objects here and below, empty branches are skipped
+		std::vector<unsigned int> objects;
+	};
+
+	struct Entry{
+		AABB bounds;
+		int node;					//	-1 when not in the tree
+		unsigned int slot;			//	position in node.objects
+	};
+
+	std::vector<Node> nodes;
+	std::vector<Entry> entries;
+	size_t count;
+
+	FLOAT3 rootCenter;
+	float rootHalfSize;
+	unsigned int maxDepth;
+
+	int FindNode(const AABB& bounds, bool create);
+	int AddChild(int nodeIndex, int octant);
+	void Link(unsigned int id, int nodeIndex);
+	void Unlink(unsigned int id);
+
+	AABB LooseBounds(const Node& node) const;
+
+	void Frustum(int nodeIndex, const FLOAT4* planes, unsigned int planeMask, std::vector<unsigned int>& out) const;
+	void EmitAll(int nodeIndex, std::vector<unsigned int>& out) const;
+	void Sphere(int nodeIndex, const FLOAT3& center, float radius, std::vector<unsigned int>& out) const;
+	void Ray(int nodeIndex, const FLOAT3& origin, const FLOAT3& invDir, float maxT, std::vector<unsigned int>& out) const;
+
+public:
+
+	//	Cube covering most of the world, deeper nodes halve the size each level
+	LooseOctree(FLOAT3 center = FLOAT3(0.0f, 0.0f, 0.0f), float halfSize = 128.0f, unsigned int maxDepth = 8);
+
+	void Clear();
+
+	void Insert(unsigned int id, const AABB& bounds);
+	void Remove(unsigned int id);
+	void Move(unsigned int id, const AABB& bounds);
+
+	bool Contains(unsigned int id) const;
+	size_t Size() const { return count; }
+
+	void QueryFrustum(const FLOAT4* planes, std::vector<unsigned int>& out) const;
+	void QuerySphere(const FLOAT3& center, float radius, std::vector<unsigned int>& out) const;
+	void QueryRay(const FLOAT3& origin, const FLOAT3& dir, float maxT, std::vector<unsigned int>& out) const;
+
+	size_t GetNodeCount() const { return nodes.size(); }
+};
+
+#endif
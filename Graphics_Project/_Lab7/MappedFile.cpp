@@ -0,0 +1,151 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+MappedFile::MappedFile() : data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(NULL){
+}
+
+bool MappedFile::Open(const char* path){
+	Close();
+	return Map(CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+}
+
+bool MappedFile::Open(const wchar_t* path){
+	Close();
+	return Map(CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+}
+
+//	Takes over a freshly opened file handle
+bool MappedFile::Map(void* handle){
+	HANDLE f = (HANDLE)handle;
+	if (f == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(f, &fileSize) || (unsigned long long)fileSize.QuadPart > (size_t)-1){
+		CloseHandle(f);
+		return false;
+	}
+
+	file = f;
+	size = (size_t)fileSize.QuadPart;
+	if (size == 0)
+		return true;
+
+	mapping = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL){
+		Close();
+		return false;
+	}
+
+	data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr){
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close(){
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	data = nullptr;
+	size = 0;
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+}
+
+bool MappedFile::IsOpen() const{
+	return file != INVALID_HANDLE_VALUE;
+}
+
+void MappedFile::Release(size_t offset, size_t length){
+	if (!data || offset >= size || length == 0)
+		return;
+	if (length > size - offset)
+		length = size - offset;
+
+	//	On pages that were never locked this only trims them from the working set
+	VirtualUnlock((void*)(data + offset), length);
+}
+#else
+MappedFile::MappedFile() : data(nullptr), size(0), fd(-1){
+}
+
+bool MappedFile::Open(const char* path){
+	Close();
+
+	int f = open(path, O_RDONLY);
+	if (f < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(f, &info) != 0){
+		close(f);
+		return false;
+	}
+
+	fd = f;
+	size = (size_t)info.st_size;
+	if (size == 0)
+		return true;
+
+	void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED){
+		Close();
+		return false;
+	}
+
+	//	Parsers read front to back
+	madvise(view, size, MADV_SEQUENTIAL);
+	data = (const char*)view;
+	return true;
+}
+
+void MappedFile::Close(){
+	if (data)
+		munmap((void*)data, size);
+	if (fd >= 0)
+		close(fd);
+
+	data = nullptr;
+	size = 0;
+	fd = -1;
+}
+
+bool MappedFile::IsOpen() const{
+	return fd >= 0;
+}
+
+void MappedFile::Release(size_t offset, size_t length){
+	if (!data || offset >= size || length == 0)
+		return;
+	if (length > size - offset)
+		length = size - offset;
+
+	//	Whole pages inside the range only, the neighbours may still be in use
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t first = (offset + page - 1) / page * page;
+	size_t last = (offset + length) / page * page;
+	if (last > first)
+		madvise((void*)(data + first), last - first, MADV_DONTNEED);
+}
+#endif
+
+MappedFile::~MappedFile(){
+	Close();
+}
@@ -0,0 +1,50 @@
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#include <cstddef>
+
+
+//	Read only view of a whole file through the OS page cache
+//	(CreateFileMapping on Windows, mmap elsewhere). Nothing is copied,
+//	the data stays valid until Close() or destruction.
+class MappedFile {
+
+	const char* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* file;			//	HANDLEs, kept as void* so windows.h stays out of the header
+	void* mapping;
+
+	bool Map(void* handle);
+#else
+	int fd;
+#endif
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	//	An empty file opens fine with a null data pointer
+	bool Open(const char* path);
+#ifdef _WIN32
+	//	UTF-16 path as the rest of Windows takes it, any characters work
+	bool Open(const wchar_t* path);
+#endif
+	void Close();
+
+	bool IsOpen() const;
+
+	//	Drops the resident pages inside [offset, offset + length) from the
+	//	working set, reading there again just pages them back in. Lets a front
+	//	to back reader keep its footprint flat on files bigger than memory.
+	void Release(size_t offset, size_t length);
+	const char* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+};
+
+#endif
@@ -1,7 +1,11 @@
 #include "MathFunc.h"
 
+#include <cmath>
+#include <cstring>
 
+#ifdef _WIN32
 using namespace DirectX;
+#endif
 
 
 unsigned int Convert2D_1D(unsigned int x, unsigned int y, unsigned int width){
@@ -266,6 +270,7 @@ MATRIX4X4 FastInverse(MATRIX4X4 Mat){
 	return Mat;
 }
 
+#ifdef _WIN32
 MATRIX4X4 XMConverter(XMMATRIX& A){
 	MATRIX4X4 output = {
 		A.r[0].m128_f32[0], A.r[0].m128_f32[1], A.r[0].m128_f32[2], A.r[0].m128_f32[3],
@@ -301,4 +306,5 @@ MATRIX4X4 CreateProjectionMatrix(float zfar, float znear, unsigned int fov, floa
 	XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(fov), ar, znear, zfar);
 	memcpy(&tmp, &proj, sizeof(float) * 16);
 	return tmp;
-}
\ No newline at end of file
+}
+#endif
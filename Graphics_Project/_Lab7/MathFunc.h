@@ -2,7 +2,11 @@
 #define _MATHFUNC_H_
 
 #include "Defines.h"
+//	DirectXMath only backs the converters and the view / projection builders,
+//	the rest also builds for the Linux tests and benchmarks
+#ifdef _WIN32
 #include <DirectXMath.h>
+#endif
 
 
 unsigned int Convert2D_1D(unsigned int x, unsigned int y, unsigned int width);
@@ -19,9 +23,11 @@ FLOAT4 Negate_Vec3(FLOAT4 A);
 
 FLOAT4 Subtract_F4(FLOAT4 A, FLOAT4 B);
 
+#ifdef _WIN32
 MATRIX4X4 XMConverter(DirectX::XMMATRIX& A);
 
 DirectX::XMMATRIX XMConverter(MATRIX4X4 A);
+#endif
 
 MATRIX3X3 Transpose(MATRIX4X4 A);
 
@@ -57,8 +63,10 @@ MATRIX4X4 Translate(MATRIX4X4 A, float x, float y, float z);
 
 MATRIX4X4 FastInverse(MATRIX4X4 Mat);
 
+#ifdef _WIN32
 MATRIX4X4 CreateViewMatrix(FLOAT4 EyePos, FLOAT4 FocusPos, FLOAT4 UpDir);
 
 MATRIX4X4 CreateProjectionMatrix(float zfar, float znear, unsigned int fov, float ar);
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include "MathSIMD.h"
+
+#include <cstring>
+
+#ifdef MATHSIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+//	Every path accumulates row by row in the same order as Mult_4x4,
+//	so the scalar, SSE and AVX results are bit for bit the same.
+
+static inline const float* Floats(const MATRIX4X4& m){ return &m.a; }
+static inline float* Floats(MATRIX4X4& m){ return &m.a; }
+
+#pragma region CPUID
+#ifdef MATHSIMD_X86
+static void ReadCPUID(int leaf, unsigned int regs[4]){
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, leaf);
+	for (int i = 0; i < 4; ++i)
+		regs[i] = (unsigned int)info[i];
+#else
+	__cpuid(leaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long ReadXCR0(){
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+#endif
+
+SIMDLevel DetectSIMDLevel(){
+#ifdef MATHSIMD_X86
+	unsigned int regs[4];
+	ReadCPUID(0, regs);
+	if (regs[0] < 1)
+		return SIMD_SCALAR;
+
+	ReadCPUID(1, regs);
+	bool sse2 = (regs[3] & (1u << 26)) != 0;
+	bool osxsave = (regs[2] & (1u << 27)) != 0;
+	bool avx = (regs[2] & (1u << 28)) != 0;
+
+	//	AVX also needs the OS to save the ymm registers
+	if (avx && osxsave && (ReadXCR0() & 0x6) == 0x6)
+		return SIMD_AVX;
+	if (sse2)
+		return SIMD_SSE2;
+#endif
+	return SIMD_SCALAR;
+}
+
+static SIMDLevel detectedLevel = DetectSIMDLevel();
+static SIMDLevel activeLevel = detectedLevel;
+
+SIMDLevel GetSIMDLevel(){
+	return activeLevel;
+}
+
+void SetSIMDLevel(SIMDLevel level){
+	activeLevel = (level > detectedLevel) ? detectedLevel : level;
+}
+#pragma endregion
+
+#pragma region Scalar
+static void MulScalar(const float* A, const float* B, float* out){
+	for (int r = 0; r < 4; ++r){
+		const float* a = A + r * 4;
+		for (int c = 0; c < 4; ++c)
+			out[r * 4 + c] = (a[0] * B[c]) + (a[1] * B[4 + c]) + (a[2] * B[8 + c]) + (a[3] * B[12 + c]);
+	}
+}
+
+static void TransformScalar(const float* v, const float* M, float* out){
+	for (int c = 0; c < 4; ++c)
+		out[c] = (v[0] * M[c]) + (v[1] * M[4 + c]) + (v[2] * M[8 + c]) + (v[3] * M[12 + c]);
+}
+#pragma endregion
+
+#ifdef MATHSIMD_X86
+#pragma region SSE
+static inline __m128 MulRowSSE(__m128 a, __m128 b0, __m128 b1, __m128 b2, __m128 b3){
+	__m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, 0x00), b0);
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0x55), b1));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0xAA), b2));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0xFF), b3));
+	return r;
+}
+
+static void MulSSE(const float* A, const float* B, float* out){
+	__m128 b0 = _mm_loadu_ps(B);
+	__m128 b1 = _mm_loadu_ps(B + 4);
+	__m128 b2 = _mm_loadu_ps(B + 8);
+	__m128 b3 = _mm_loadu_ps(B + 12);
+
+	_mm_storeu_ps(out, MulRowSSE(_mm_loadu_ps(A), b0, b1, b2, b3));
+	_mm_storeu_ps(out + 4, MulRowSSE(_mm_loadu_ps(A + 4), b0, b1, b2, b3));
+	_mm_storeu_ps(out + 8, MulRowSSE(_mm_loadu_ps(A + 8), b0, b1, b2, b3));
+	_mm_storeu_ps(out + 12, MulRowSSE(_mm_loadu_ps(A + 12), b0, b1, b2, b3));
+}
+
+static void MulOneSSE(const float* a, const float* B, float* out, size_t n){
+	__m128 b0 = _mm_loadu_ps(B);
+	__m128 b1 = _mm_loadu_ps(B + 4);
+	__m128 b2 = _mm_loadu_ps(B + 8);
+	__m128 b3 = _mm_loadu_ps(B + 12);
+
+	for (size_t x = 0; x < n; ++x){
+		const float* A = a + 16 * x;
+		float* o = out + 16 * x;
+		_mm_storeu_ps(o, MulRowSSE(_mm_loadu_ps(A), b0, b1, b2, b3));
+		_mm_storeu_ps(o + 4, MulRowSSE(_mm_loadu_ps(A + 4), b0, b1, b2, b3));
+		_mm_storeu_ps(o + 8, MulRowSSE(_mm_loadu_ps(A + 8), b0, b1, b2, b3));
+		_mm_storeu_ps(o + 12, MulRowSSE(_mm_loadu_ps(A + 12), b0, b1, b2, b3));
+	}
+}
+
+static void TransformSSE(const float* in, const float* M, float* out, size_t n){
+	__m128 m0 = _mm_loadu_ps(M);
+	__m128 m1 = _mm_loadu_ps(M + 4);
+	__m128 m2 = _mm_loadu_ps(M + 8);
+	__m128 m3 = _mm_loadu_ps(M + 12);
+
+	for (size_t x = 0; x < n; ++x)
+		_mm_storeu_ps(out + 4 * x, MulRowSSE(_mm_loadu_ps(in + 4 * x), m0, m1, m2, m3));
+}
+
+static void TransformPointSSE(const FLOAT3* in, const float* M, FLOAT3* out, size_t n){
+	__m128 m0 = _mm_loadu_ps(M);
+	__m128 m1 = _mm_loadu_ps(M + 4);
+	__m128 m2 = _mm_loadu_ps(M + 8);
+	__m128 m3 = _mm_loadu_ps(M + 12);
+
+	for (size_t x = 0; x < n; ++x){
+		__m128 r = _mm_mul_ps(_mm_set1_ps(in[x].x), m0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[x].y), m1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[x].z), m2));
+		r = _mm_add_ps(r, m3);
+
+		float tmp[4];
+		_mm_storeu_ps(tmp, r);
+		out[x] = FLOAT3(tmp[0], tmp[1], tmp[2]);
+	}
+}
+#pragma endregion
+
+#pragma region AVX
+//	Two rows (or two vertices) per register, one per 128 bit lane
+SIMD_TARGET_AVX static inline __m256 MulRowPairAVX(__m256 a, __m256 b0, __m256 b1, __m256 b2, __m256 b3){
+	__m256 r = _mm256_mul_ps(_mm256_permute_ps(a, 0x00), b0);
+	r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, 0x55), b1));
+	r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, 0xAA), b2));
+	r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, 0xFF), b3));
+	return r;
+}
+
+SIMD_TARGET_AVX static void MulAVX(const float* a, const float* b, float* out, size_t n){
+	for (size_t x = 0; x < n; ++x){
+		const float* A = a + 16 * x;
+		const float* B = b + 16 * x;
+		float* o = out + 16 * x;
+
+		__m256 b0 = _mm256_broadcast_ps((const __m128*)B);
+		__m256 b1 = _mm256_broadcast_ps((const __m128*)(B + 4));
+		__m256 b2 = _mm256_broadcast_ps((const __m128*)(B + 8));
+		__m256 b3 = _mm256_broadcast_ps((const __m128*)(B + 12));
+
+		_mm256_storeu_ps(o, MulRowPairAVX(_mm256_loadu_ps(A), b0, b1, b2, b3));
+		_mm256_storeu_ps(o + 8, MulRowPairAVX(_mm256_loadu_ps(A + 8), b0, b1, b2, b3));
+	}
+}
+
+SIMD_TARGET_AVX static void MulOneAVX(const float* a, const float* B, float* out, size_t n){
+	__m256 b0 = _mm256_broadcast_ps((const __m128*)B);
+	__m256 b1 = _mm256_broadcast_ps((const __m128*)(B + 4));
+	__m256 b2 = _mm256_broadcast_ps((const __m128*)(B + 8));
+	__m256 b3 = _mm256_broadcast_ps((const __m128*)(B + 12));
+
+	for (size_t x = 0; x < n; ++x){
+		const float* A = a + 16 * x;
+		float* o = out + 16 * x;
+		_mm256_storeu_ps(o, MulRowPairAVX(_mm256_loadu_ps(A), b0, b1, b2, b3));
+		_mm256_storeu_ps(o + 8, MulRowPairAVX(_mm256_loadu_ps(A + 8), b0, b1, b2, b3));
+	}
+}
+
+SIMD_TARGET_AVX static void TransformAVX(const float* in, const float* M, float* out, size_t n){
+	__m256 m0 = _mm256_broadcast_ps((const __m128*)M);
+	__m256 m1 = _mm256_broadcast_ps((const __m128*)(M + 4));
+	__m256 m2 = _mm256_broadcast_ps((const __m128*)(M + 8));
+	__m256 m3 = _mm256_broadcast_ps((const __m128*)(M + 12));
+
+	size_t x = 0;
+	for (; x + 2 <= n; x += 2)
+		_mm256_storeu_ps(out + 4 * x, MulRowPairAVX(_mm256_loadu_ps(in + 4 * x), m0, m1, m2, m3));
+
+	if (x < n){
+		float tmp[4];
+		TransformScalar(in + 4 * x, M, tmp);
+		memcpy(out + 4 * x, tmp, sizeof(tmp));
+	}
+}
+#pragma endregion
+#endif
+
+#pragma region Dispatch
+//	a, b and out are arrays of 16 float matrices, out may alias a or b
+static void MulPairs(const float* a, const float* b, float* out, size_t n){
+#ifdef MATHSIMD_X86
+	if (activeLevel == SIMD_AVX){
+		MulAVX(a, b, out, n);
+		return;
+	}
+	if (activeLevel == SIMD_SSE2){
+		for (size_t x = 0; x < n; ++x)
+			MulSSE(a + 16 * x, b + 16 * x, out + 16 * x);
+		return;
+	}
+#endif
+	for (size_t x = 0; x < n; ++x){
+		//	Copy first so out may alias a or b
+		float tmp[16];
+		MulScalar(a + 16 * x, b + 16 * x, tmp);
+		memcpy(out + 16 * x, tmp, sizeof(tmp));
+	}
+}
+
+static void MulOne(const float* a, const float* b, float* out, size_t n){
+	float B[16];	//	b may live inside out
+	memcpy(B, b, sizeof(B));
+
+#ifdef MATHSIMD_X86
+	if (activeLevel == SIMD_AVX){
+		MulOneAVX(a, B, out, n);
+		return;
+	}
+	if (activeLevel == SIMD_SSE2){
+		MulOneSSE(a, B, out, n);
+		return;
+	}
+#endif
+	for (size_t x = 0; x < n; ++x){
+		float tmp[16];
+		MulScalar(a + 16 * x, B, tmp);
+		memcpy(out + 16 * x, tmp, sizeof(tmp));
+	}
+}
+
+static void Transform(const float* in, const float* m, float* out, size_t n){
+	float M[16];
+	memcpy(M, m, sizeof(M));
+
+#ifdef MATHSIMD_X86
+	if (activeLevel == SIMD_AVX){
+		TransformAVX(in, M, out, n);
+		return;
+	}
+	if (activeLevel == SIMD_SSE2){
+		TransformSSE(in, M, out, n);
+		return;
+	}
+#endif
+	for (size_t x = 0; x < n; ++x){
+		float tmp[4];
+		TransformScalar(in + 4 * x, M, tmp);
+		memcpy(out + 4 * x, tmp, sizeof(tmp));
+	}
+}
+#pragma endregion
+
+void MulBatch(const MATRIX4X4* a, const MATRIX4X4* b, MATRIX4X4* out, size_t n){
+	if (n)
+		MulPairs(Floats(a[0]), Floats(b[0]), Floats(out[0]), n);
+}
+
+void MulBatch(const MATRIX4X4* a, const MATRIX4X4& b, MATRIX4X4* out, size_t n){
+	if (n)
+		MulOne(Floats(a[0]), Floats(b), Floats(out[0]), n);
+}
+
+void TransformBatch(const FLOAT4* in, const MATRIX4X4& mat, FLOAT4* out, size_t n){
+	if (n)
+		Transform(&in[0].x, Floats(mat), &out[0].x, n);
+}
+
+void Mul(const SIMDMatrix& a, const SIMDMatrix& b, SIMDMatrix& out){
+	MulPairs(a.m, b.m, out.m, 1);
+}
+
+void MulBatch(const SIMDMatrix* a, const SIMDMatrix* b, SIMDMatrix* out, size_t n){
+	if (n)
+		MulPairs(a[0].m, b[0].m, out[0].m, n);
+}
+
+void MulBatch(const SIMDMatrix* a, const SIMDMatrix& b, SIMDMatrix* out, size_t n){
+	if (n)
+		MulOne(a[0].m, b.m, out[0].m, n);
+}
+
+void TransformBatch(const SIMDVector* in, const SIMDMatrix& mat, SIMDVector* out, size_t n){
+	if (n)
+		Transform(&in[0].x, mat.m, &out[0].x, n);
+}
+
+void TransformPointBatch(const FLOAT3* in, const MATRIX4X4& mat, FLOAT3* out, size_t n){
+	MATRIX4X4 M = mat;
+
+#ifdef MATHSIMD_X86
+	if (activeLevel >= SIMD_SSE2){
+		TransformPointSSE(in, Floats(M), out, n);
+		return;
+	}
+#endif
+	const float* m = Floats(M);
+	for (size_t x = 0; x < n; ++x){
+		FLOAT3 p = in[x];
+		out[x].x = (p.x * m[0]) + (p.y * m[4]) + (p.z * m[8]) + m[12];
+		out[x].y = (p.x * m[1]) + (p.y * m[5]) + (p.z * m[9]) + m[13];
+		out[x].z = (p.x * m[2]) + (p.y * m[6]) + (p.z * m[10]) + m[14];
+	}
+}
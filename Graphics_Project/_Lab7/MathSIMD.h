@@ -0,0 +1,76 @@
+#ifndef _MATHSIMD_H_
+#define _MATHSIMD_H_
+
+#include "Defines.h"
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MATHSIMD_X86
+#endif
+
+//	Lets GCC / Clang emit AVX in one function without -mavx for the whole file
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#else
+#define SIMD_TARGET_AVX
+#endif
+
+
+//	16 byte aligned matrix / vector for the batch routines, same layout as
+//	MATRIX4X4 / FLOAT4, so no row ever straddles a cache line. Pass them by
+//	const reference: MSVC rejects over-aligned by-value parameters on Win32,
+//	which is why MATRIX4X4 (taken by value all over MathFunc) stays as it is.
+struct alignas(16) SIMDMatrix {
+	float m[16];
+
+	SIMDMatrix() = default;
+	explicit SIMDMatrix(const MATRIX4X4& src){ memcpy(m, &src.a, sizeof(m)); }
+	MATRIX4X4 ToMatrix() const { MATRIX4X4 out; memcpy(&out.a, m, sizeof(m)); return out; }
+};
+
+struct alignas(16) SIMDVector {
+	float x, y, z, w;
+
+	SIMDVector() = default;
+	SIMDVector(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w){}
+	explicit SIMDVector(const FLOAT4& v) : x(v.x), y(v.y), z(v.z), w(v.w){}
+	FLOAT4 ToFloat4() const { return FLOAT4(x, y, z, w); }
+};
+
+
+//	Widest instruction set the batch routines may use
+enum SIMDLevel {
+	SIMD_SCALAR = 0,
+	SIMD_SSE2,
+	SIMD_AVX
+};
+
+//	What the CPU (and OS) supports, read once from CPUID
+SIMDLevel DetectSIMDLevel();
+
+//	Level in use, defaults to DetectSIMDLevel()
+SIMDLevel GetSIMDLevel();
+
+//	Force a lower level (tests / benchmarks), clamped to what the CPU supports
+void SetSIMDLevel(SIMDLevel level);
+
+//	out[x] = a[x] * b[x], same result as Mult_4x4
+void MulBatch(const MATRIX4X4* a, const MATRIX4X4* b, MATRIX4X4* out, size_t n);
+
+//	out[x] = a[x] * b, e.g. many worlds against one viewProj
+void MulBatch(const MATRIX4X4* a, const MATRIX4X4& b, MATRIX4X4* out, size_t n);
+
+//	out[x] = in[x] * mat, same result as Mult_Vertex4x4
+void TransformBatch(const FLOAT4* in, const MATRIX4X4& mat, FLOAT4* out, size_t n);
+
+//	The same for the aligned types, results match the MATRIX4X4 versions bit
+//	for bit. out may alias a or b.
+void Mul(const SIMDMatrix& a, const SIMDMatrix& b, SIMDMatrix& out);
+void MulBatch(const SIMDMatrix* a, const SIMDMatrix* b, SIMDMatrix* out, size_t n);
+void MulBatch(const SIMDMatrix* a, const SIMDMatrix& b, SIMDMatrix* out, size_t n);
+void TransformBatch(const SIMDVector* in, const SIMDMatrix& mat, SIMDVector* out, size_t n);
+
+//	Points with an implied w of 1, w of the result is dropped
+void TransformPointBatch(const FLOAT3* in, const MATRIX4X4& mat, FLOAT3* out, size_t n);
+
+#endif
@@ -0,0 +1,249 @@
+#include "MeshCache.h"
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+//	Blobs start on this boundary so the mapped vertices are SIMD friendly
+#define MESH_CACHE_ALIGN	64
+
+
+#pragma region Layout
+static unsigned long long AlignUp(unsigned long long v){
+	return (v + MESH_CACHE_ALIGN - 1) & ~(unsigned long long)(MESH_CACHE_ALIGN - 1);
+}
+#pragma endregion
+
+#pragma region Hashing
+static inline unsigned long long HashMix(unsigned long long h, unsigned long long word){
+	h ^= word;
+	h *= 0x9E3779B97F4A7C15ull;
+	return h ^ (h >> 29);
+}
+
+//	Four independent lanes over 32 byte blocks keep the multiplies overlapped,
+//	so this runs near memory speed on a freshly mapped file
+unsigned long long HashBytes(const void* data, size_t size){
+	const unsigned char* p = (const unsigned char*)data;
+	unsigned long long lanes[4] = {
+		0x243F6A8885A308D3ull, 0x13198A2E03707344ull,
+		0xA4093822299F31D0ull, 0x082EFA98EC4E6C89ull
+	};
+
+	size_t blocks = size / 32;
+	for (size_t b = 0; b < blocks; ++b, p += 32){
+		unsigned long long words[4];
+		memcpy(words, p, 32);
+		lanes[0] = HashMix(lanes[0], words[0]);
+		lanes[1] = HashMix(lanes[1], words[1]);
+		lanes[2] = HashMix(lanes[2], words[2]);
+		lanes[3] = HashMix(lanes[3], words[3]);
+	}
+
+	unsigned long long tail[4] = { 0, 0, 0, 0 };
+	memcpy(tail, p, size - blocks * 32);
+	for (int i = 0; i < 4; ++i)
+		lanes[i] = HashMix(lanes[i], tail[i]);
+
+	unsigned long long h = size;
+	for (int i = 0; i < 4; ++i)
+		h = HashMix(h ^ (h << 7), lanes[i]);
+
+	//	Final avalanche (MurmurHash3 fmix64)
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+	return h;
+}
+#pragma endregion
+
+MeshView MakeMeshView(const Model& m){
+	MeshView view;
+	view.verts = m.interleaved.data();
+	view.vertexCount = m.interleaved.size();
+	view.indices = m.out_Indicies.data();
+	view.indexCount = m.out_Indicies.size();
+	view.subMeshes = m.subMeshes.data();
+	view.subMeshCount = m.subMeshes.size();
+	view.bounds = ComputeModelBounds(m);
+	return view;
+}
+
+#pragma region Cache File
+bool MeshCache::Open(const char* path, unsigned long long sourceHash, unsigned long long sourceSize, unsigned int flags){
+	Close();
+
+	if (!file.Open(path))
+		return false;
+
+	const char* data = file.GetData();
+	unsigned long long size = file.GetSize();
+
+	MeshCacheHeader header;
+	if (size < sizeof(header)){
+		Close();
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	MeshVertexElement expected[MESH_MAX_ELEMENTS];
+	unsigned int expectedCount = DescribeVert(expected);
+
+	bool valid = header.magic == MESH_CACHE_MAGIC
+		&& header.version == MESH_CACHE_VERSION
+		&& header.loaderVersion == MESH_LOADER_VERSION
+		&& header.flags == flags
+		&& header.sourceHash == sourceHash
+		&& header.sourceSize == sourceSize
+		&& header.vertexStride == sizeof(Vert)
+		&& header.elementCount == expectedCount
+		&& memcmp(header.elements, expected, sizeof(MeshVertexElement) * expectedCount) == 0;
+
+	//	Blobs have to be aligned and inside the file, a truncated write fails here
+	valid = valid
+		&& header.vertexOffset % MESH_CACHE_ALIGN == 0
+		&& header.indexOffset % MESH_CACHE_ALIGN == 0
+		&& header.subMeshOffset % MESH_CACHE_ALIGN == 0
+		&& header.vertexOffset <= size
+		&& header.indexOffset <= size
+		&& header.subMeshOffset <= size
+		&& header.namesOffset <= size
+		&& header.vertexCount <= (size - header.vertexOffset) / sizeof(Vert)
+		&& header.indexCount <= (size - header.indexOffset) / sizeof(unsigned int)
+		&& header.subMeshCount <= (size - header.subMeshOffset) / sizeof(SubMesh)
+		&& header.namesSize <= size - header.namesOffset;
+
+	if (!valid){
+		Close();
+		return false;
+	}
+
+	//	Every range inside the index list and naming something in the tables
+	const SubMesh* subMeshes = (const SubMesh*)(data + header.subMeshOffset);
+	for (unsigned long long i = 0; i < header.subMeshCount && valid; ++i){
+		const SubMesh& sub = subMeshes[i];
+		valid = sub.firstIndex <= header.indexCount
+			&& sub.indexCount <= header.indexCount - sub.firstIndex
+			&& sub.material < header.materialCount
+			&& sub.group < header.groupCount;
+	}
+
+	//	Indices get used straight into the vertices (occlusion, meshlets, LODs),
+	//	so a stale or damaged file must not point past them
+	const unsigned int* indices = (const unsigned int*)(data + header.indexOffset);
+	unsigned int maxIndex = 0;
+	for (unsigned long long i = 0; i < header.indexCount; ++i)
+		maxIndex = std::max(maxIndex, indices[i]);
+	valid = valid && (header.indexCount == 0 || maxIndex < header.vertexCount);
+
+	//	Names have to come out as exactly 1 + materialCount + groupCount strings
+	const char* names = data + header.namesOffset;
+	const char* namesEnd = names + header.namesSize;
+	std::vector<std::string> strings;
+	for (const char* p = names; p < namesEnd && valid;){
+		const char* zero = (const char*)memchr(p, 0, namesEnd - p);
+		valid = zero != nullptr;
+		if (valid){
+			strings.push_back(std::string(p, zero));
+			p = zero + 1;
+		}
+	}
+	valid = valid && strings.size() == 1ull + header.materialCount + header.groupCount;
+
+	if (!valid){
+		Close();
+		return false;
+	}
+
+	materialLib = strings[0];
+	materials.assign(strings.begin() + 1, strings.begin() + 1 + header.materialCount);
+	groups.assign(strings.begin() + 1 + header.materialCount, strings.end());
+
+	view.verts = (const Vert*)(data + header.vertexOffset);
+	view.vertexCount = (size_t)header.vertexCount;
+	view.indices = indices;
+	view.indexCount = (size_t)header.indexCount;
+	view.subMeshes = subMeshes;
+	view.subMeshCount = (size_t)header.subMeshCount;
+	view.bounds = header.bounds;
+	return true;
+}
+
+void MeshCache::Close(){
+	file.Close();
+	view = MeshView();
+	materialLib.clear();
+	materials.clear();
+	groups.clear();
+}
+
+bool MeshCache::Write(const char* path, const Model& m, unsigned long long sourceHash, unsigned long long sourceSize, unsigned int flags){
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.loaderVersion = MESH_LOADER_VERSION;
+	header.flags = flags;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.vertexStride = sizeof(Vert);
+	header.elementCount = DescribeVert(header.elements);
+	header.vertexCount = m.interleaved.size();
+	header.vertexOffset = AlignUp(sizeof(header));
+	header.indexCount = m.out_Indicies.size();
+	header.indexOffset = AlignUp(header.vertexOffset + header.vertexCount * sizeof(Vert));
+	header.subMeshCount = m.subMeshes.size();
+	header.subMeshOffset = AlignUp(header.indexOffset + header.indexCount * sizeof(unsigned int));
+	header.bounds = ComputeModelBounds(m);
+
+	std::string names = m.materialLib;
+	names += '\0';
+	for (size_t i = 0; i < m.materials.size(); ++i){
+		names += m.materials[i];
+		names += '\0';
+	}
+	for (size_t i = 0; i < m.groups.size(); ++i){
+		names += m.groups[i];
+		names += '\0';
+	}
+	header.materialCount = (unsigned int)m.materials.size();
+	header.groupCount = (unsigned int)m.groups.size();
+	header.namesSize = names.size();
+	header.namesOffset = header.subMeshOffset + header.subMeshCount * sizeof(SubMesh);
+
+	FILE* f = fopen(path, "wb");
+	if (!f)
+		return false;
+
+	static const char padding[MESH_CACHE_ALIGN] = {};
+	unsigned long long vertexEnd = header.vertexOffset + header.vertexCount * sizeof(Vert);
+	unsigned long long indexEnd = header.indexOffset + header.indexCount * sizeof(unsigned int);
+
+	//	Magic goes in last, a crash half way leaves a file Open turns down
+	unsigned int magic = header.magic;
+	header.magic = 0;
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+		&& fwrite(padding, 1, (size_t)(header.vertexOffset - sizeof(header)), f) == header.vertexOffset - sizeof(header)
+		&& fwrite(m.interleaved.data(), sizeof(Vert), m.interleaved.size(), f) == m.interleaved.size()
+		&& fwrite(padding, 1, (size_t)(header.indexOffset - vertexEnd), f) == header.indexOffset - vertexEnd
+		&& fwrite(m.out_Indicies.data(), sizeof(unsigned int), m.out_Indicies.size(), f) == m.out_Indicies.size()
+		&& fwrite(padding, 1, (size_t)(header.subMeshOffset - indexEnd), f) == header.subMeshOffset - indexEnd
+		&& fwrite(m.subMeshes.data(), sizeof(SubMesh), m.subMeshes.size(), f) == m.subMeshes.size()
+		&& fwrite(names.data(), 1, names.size(), f) == names.size();
+
+	ok = ok && fflush(f) == 0
+		&& fseek(f, offsetof(MeshCacheHeader, magic), SEEK_SET) == 0
+		&& fwrite(&magic, sizeof(magic), 1, f) == 1;
+
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		remove(path);
+	return ok;
+}
+#pragma endregion
@@ -0,0 +1,96 @@
+#ifndef _MESHCACHE_H_
+#define _MESHCACHE_H_
+
+#include "Defines.h"
+#include "BVH.h"
+#include "MappedFile.h"
+#include "VertexFormat.h"
+#include <cstddef>
+
+#define MESH_CACHE_MAGIC		0x4853454D		//	"MESH"
+#define MESH_CACHE_VERSION		2				//	file layout
+#define MESH_LOADER_VERSION		4				//	bump whenever the OBJ loader or mesh passes change their output
+
+//	What went into the cached vertices besides the plain parse
+#define MESH_CACHE_TANGENTS		0x1
+
+
+//	Start of every cache file, the blobs follow at the given offsets
+struct MeshCacheHeader{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int loaderVersion;
+	unsigned int flags;
+	unsigned long long sourceHash;
+	unsigned long long sourceSize;
+
+	unsigned int vertexStride;
+	unsigned int elementCount;
+	MeshVertexElement elements[MESH_MAX_ELEMENTS];
+
+	unsigned long long vertexCount, vertexOffset;
+	unsigned long long indexCount, indexOffset;
+	unsigned long long subMeshCount, subMeshOffset;
+
+	//	'\0' terminated: the mtllib, then materialCount materials, then groupCount groups
+	unsigned long long namesSize, namesOffset;
+	unsigned int materialCount, groupCount;
+	AABB bounds;
+};
+
+//	Read only vertices / indices ready for upload, either from a Model or
+//	straight out of a mapped cache file
+struct MeshView{
+	const Vert* verts;
+	size_t vertexCount;
+	const unsigned int* indices;
+	size_t indexCount;
+	const SubMesh* subMeshes;		//	one draw each, cover indices in order
+	size_t subMeshCount;
+	AABB bounds;
+
+	MeshView() : verts(nullptr), vertexCount(0), indices(nullptr), indexCount(0), subMeshes(nullptr), subMeshCount(0),
+		bounds(FLOAT3(0.0f, 0.0f, 0.0f), FLOAT3(0.0f, 0.0f, 0.0f)){}
+};
+
+//	View over m's vectors, valid while m is unchanged
+MeshView MakeMeshView(const Model& m);
+
+//	64 bit hash of a whole buffer, used to notice edited source files
+unsigned long long HashBytes(const void* data, size_t size);
+
+//	Binary mesh file holding one Model after loading and processing.
+//	Open maps it and hands out pointers into the mapping, nothing is copied.
+class MeshCache {
+
+	MappedFile file;
+	MeshView view;
+
+	//	Copied out of the names blob, SubMesh::material / group index them
+	std::string materialLib;
+	std::vector<std::string> materials;
+	std::vector<std::string> groups;
+
+	MeshCache(const MeshCache&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+
+public:
+
+	MeshCache(){}
+
+	//	Fails when the file is missing, damaged (an index past the vertices
+	//	counts), from another loader version, was built from different source
+	//	bytes or with different flags
+	bool Open(const char* path, unsigned long long sourceHash, unsigned long long sourceSize, unsigned int flags);
+	void Close();
+
+	bool IsOpen() const { return file.IsOpen(); }
+	const MeshView& GetView() const { return view; }
+	const std::string& GetMaterialLib() const { return materialLib; }
+	const std::vector<std::string>& GetMaterials() const { return materials; }
+	const std::vector<std::string>& GetGroups() const { return groups; }
+
+	static bool Write(const char* path, const Model& m, unsigned long long sourceHash, unsigned long long sourceSize, unsigned int flags);
+};
+
+#endif
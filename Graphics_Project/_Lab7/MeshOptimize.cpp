@@ -0,0 +1,479 @@
+#include "MeshOptimize.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+//	Forsyth's tuning: the model LRU is bigger than the real FIFO on purpose
+#define FORSYTH_CACHE_SIZE		32
+#define FORSYTH_DECAY_POWER		1.5f
+#define FORSYTH_LAST_TRI_SCORE	0.75f
+#define FORSYTH_VALENCE_SCALE	2.0f
+#define FORSYTH_VALENCE_POWER	0.5f
+#define FORSYTH_MAX_VALENCE		32
+
+
+#pragma region Cache Simulation
+//	FIFO cache without a queue, a vertex is resident while fewer than cacheSize
+//	misses happened since it was last loaded
+class FIFOCache{
+	std::vector<unsigned int> stamps;
+	unsigned int time;
+	unsigned int size;
+
+public:
+	FIFOCache(size_t vertexCount, unsigned int cacheSize) : stamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize){}
+
+	//	Returns 1 on a miss
+	unsigned int Touch(unsigned int v){
+		if (time - stamps[v] > size){
+			stamps[v] = time++;
+			return 1;
+		}
+		return 0;
+	}
+
+	unsigned int TouchTriangle(const unsigned int* tri){
+		return Touch(tri[0]) + Touch(tri[1]) + Touch(tri[2]);
+	}
+
+	//	Everything currently cached becomes a miss
+	void Flush(){
+		time += size + 1;
+	}
+};
+
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize){
+	VertexCacheStats stats;
+	stats.transformed = 0;
+	stats.acmr = 0.0f;
+	stats.atvr = 0.0f;
+
+	if (indexCount < 3 || vertexCount == 0)
+		return stats;
+
+	FIFOCache cache(vertexCount, cacheSize);
+	std::vector<unsigned char> used(vertexCount, 0);
+	size_t referenced = 0;
+
+	for (size_t i = 0; i < indexCount; ++i){
+		unsigned int v = indices[i];
+		stats.transformed += cache.Touch(v);
+		if (!used[v]){
+			used[v] = 1;
+			++referenced;
+		}
+	}
+
+	stats.acmr = (float)stats.transformed / (float)(indexCount / 3);
+	stats.atvr = (float)stats.transformed / (float)referenced;
+	return stats;
+}
+
+//	Edge function, positive when p is left of a -> b
+static inline float Edge(const float* a, const float* b, float px, float py){
+	return (b[0] - a[0]) * (py - a[1]) - (b[1] - a[1]) * (px - a[0]);
+}
+
+//	Pixel centres inside, shared edges drawn once (top left rule)
+static void RasterOverdraw(const float* v0, const float* v1, const float* v2, std::vector<float>& depth, OverdrawStats& stats){
+	float minX = std::min(v0[0], std::min(v1[0], v2[0])), maxX = std::max(v0[0], std::max(v1[0], v2[0]));
+	float minY = std::min(v0[1], std::min(v1[1], v2[1])), maxY = std::max(v0[1], std::max(v1[1], v2[1]));
+	int x0 = std::max(0, (int)floorf(minX)), x1 = std::min(MESH_OVERDRAW_SIZE - 1, (int)ceilf(maxX));
+	int y0 = std::max(0, (int)floorf(minY)), y1 = std::min(MESH_OVERDRAW_SIZE - 1, (int)ceilf(maxY));
+
+	float area = Edge(v0, v1, v2[0], v2[1]);
+	if (area <= 0.0f)
+		return;
+
+	//	Top or left edges own the pixels exactly on them
+	const float* edges[3][2] = { { v1, v2 }, { v2, v0 }, { v0, v1 } };
+	bool owns[3];
+	for (int e = 0; e < 3; ++e){
+		float dx = edges[e][1][0] - edges[e][0][0], dy = edges[e][1][1] - edges[e][0][1];
+		owns[e] = (dy < 0.0f) || (dy == 0.0f && dx > 0.0f);
+	}
+
+	for (int y = y0; y <= y1; ++y){
+		for (int x = x0; x <= x1; ++x){
+			float px = x + 0.5f, py = y + 0.5f;
+			float w0 = Edge(v1, v2, px, py), w1 = Edge(v2, v0, px, py), w2 = Edge(v0, v1, px, py);
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+				continue;
+			if ((w0 == 0.0f && !owns[0]) || (w1 == 0.0f && !owns[1]) || (w2 == 0.0f && !owns[2]))
+				continue;
+
+			float z = (w0 * v0[2] + w1 * v1[2] + w2 * v2[2]) / area;
+			float& stored = depth[y * MESH_OVERDRAW_SIZE + x];
+			if (z < stored){
+				if (stored == FLT_MAX)
+					++stats.covered;
+				stored = z;
+				++stats.shaded;
+			}
+		}
+	}
+}
+
+OverdrawStats AnalyzeOverdraw(const unsigned int* indices, size_t indexCount, const Vert* verts, size_t vertexCount){
+	OverdrawStats stats = { 0, 0, 0.0f };
+	if (indexCount < 3 || vertexCount == 0)
+		return stats;
+
+	FLOAT3 lo = verts[0].Pos, hi = verts[0].Pos;
+	for (size_t v = 1; v < vertexCount; ++v){
+		const FLOAT3& p = verts[v].Pos;
+		lo = FLOAT3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+		hi = FLOAT3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+	}
+	float extent = std::max(hi.x - lo.x, std::max(hi.y - lo.y, hi.z - lo.z));
+	float scale = (extent > 0.0f) ? (MESH_OVERDRAW_SIZE - 1) / extent : 0.0f;
+
+	std::vector<float> depth(MESH_OVERDRAW_SIZE * MESH_OVERDRAW_SIZE);
+	for (int axis = 0; axis < 3; ++axis){
+		for (int side = 0; side < 2; ++side){
+			std::fill(depth.begin(), depth.end(), FLT_MAX);
+
+			for (size_t i = 0; i + 2 < indexCount; i += 3){
+				float screen[3][3];
+				for (int k = 0; k < 3; ++k){
+					const FLOAT3& p = verts[indices[i + k]].Pos;
+					float c[3] = { (p.x - lo.x) * scale, (p.y - lo.y) * scale, (p.z - lo.z) * scale };
+
+					//	Screen x, y from the other two axes, depth along this one.
+					//	Looking from the far side mirrors x so winding still says facing.
+					float u = c[(axis + 1) % 3], v = c[(axis + 2) % 3], d = c[axis];
+					screen[k][0] = side ? (MESH_OVERDRAW_SIZE - 1) - u : u;
+					screen[k][1] = v;
+					screen[k][2] = side ? d : (MESH_OVERDRAW_SIZE - 1) - d;
+				}
+				RasterOverdraw(screen[0], screen[1], screen[2], depth, stats);
+			}
+		}
+	}
+
+	stats.overdraw = stats.covered ? (float)stats.shaded / (float)stats.covered : 0.0f;
+	return stats;
+}
+#pragma endregion
+
+#pragma region Vertex Cache
+void OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount){
+	size_t triCount = indexCount / 3;
+	if (triCount == 0 || vertexCount == 0)
+		return;
+
+	float cacheScore[FORSYTH_CACHE_SIZE];
+	float valenceScore[FORSYTH_MAX_VALENCE + 1];
+
+	for (unsigned int i = 0; i < FORSYTH_CACHE_SIZE; ++i){
+		//	The last triangle's corners score the same whatever order they went in,
+		//	so a strip is not favoured over a fan
+		if (i < 3)
+			cacheScore[i] = FORSYTH_LAST_TRI_SCORE;
+		else
+			cacheScore[i] = powf(1.0f - (float)(i - 3) / (float)(FORSYTH_CACHE_SIZE - 3), FORSYTH_DECAY_POWER);
+	}
+	valenceScore[0] = 0.0f;
+	for (unsigned int i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+		valenceScore[i] = FORSYTH_VALENCE_SCALE * powf((float)i, -FORSYTH_VALENCE_POWER);
+
+	//	Triangles around each vertex, the first remaining[v] entries are still to be drawn
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triCount * 3; ++i)
+		++remaining[indices[i]];
+	for (size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + remaining[v];
+
+	std::vector<unsigned int> adjacency(triCount * 3);
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < triCount * 3; ++i)
+		adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+	std::vector<int> cachePos(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+
+	auto ScoreVertex = [&](unsigned int v) -> float {
+		unsigned int valence = remaining[v];
+		if (valence == 0)
+			return -1.0f;
+		float s = valenceScore[std::min(valence, (unsigned int)FORSYTH_MAX_VALENCE)];
+		if (cachePos[v] >= 0)
+			s += cacheScore[cachePos[v]];
+		return s;
+	};
+
+	for (size_t v = 0; v < vertexCount; ++v)
+		score[v] = ScoreVertex((unsigned int)v);
+
+	std::vector<unsigned char> emitted(triCount, 0);
+	std::vector<unsigned int> out(triCount * 3);
+
+	unsigned int cache[FORSYTH_CACHE_SIZE + 3];
+	unsigned int newCache[FORSYTH_CACHE_SIZE + 3];
+	unsigned int cacheCount = 0;
+
+	size_t cursor = 0;
+	long long best = -1;
+
+	for (size_t t = 0; t < triCount; ++t){
+		//	Nothing in the cache touches an undrawn triangle, take the next in input order
+		if (best < 0){
+			while (emitted[cursor])
+				++cursor;
+			best = (long long)cursor;
+		}
+
+		const unsigned int* tri = indices + best * 3;
+		memcpy(&out[t * 3], tri, sizeof(unsigned int) * 3);
+		emitted[best] = 1;
+
+		unsigned int newCount = 0;
+		for (unsigned int c = 0; c < 3; ++c){
+			unsigned int v = tri[c];
+
+			unsigned int* list = &adjacency[offsets[v]];
+			unsigned int n = remaining[v];
+			for (unsigned int k = 0; k < n; ++k){
+				if (list[k] == (unsigned int)best){
+					list[k] = list[n - 1];
+					break;
+				}
+			}
+			--remaining[v];
+
+			if (std::find(newCache, newCache + newCount, v) == newCache + newCount)
+				newCache[newCount++] = v;
+		}
+		for (unsigned int k = 0; k < cacheCount; ++k){
+			unsigned int v = cache[k];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCount++] = v;
+		}
+
+		//	Entries pushed past the end are evicted but still get rescored
+		for (unsigned int k = 0; k < newCount; ++k){
+			unsigned int v = newCache[k];
+			cachePos[v] = (k < FORSYTH_CACHE_SIZE) ? (int)k : -1;
+			score[v] = ScoreVertex(v);
+		}
+
+		cacheCount = std::min(newCount, (unsigned int)FORSYTH_CACHE_SIZE);
+		memcpy(cache, newCache, sizeof(unsigned int) * cacheCount);
+
+		best = -1;
+		float bestScore = -1.0f;
+		for (unsigned int k = 0; k < cacheCount; ++k){
+			unsigned int v = cache[k];
+			const unsigned int* list = &adjacency[offsets[v]];
+			for (unsigned int n = 0; n < remaining[v]; ++n){
+				const unsigned int* other = indices + list[n] * 3;
+				float s = score[other[0]] + score[other[1]] + score[other[2]];
+				if (s > bestScore){
+					bestScore = s;
+					best = list[n];
+				}
+			}
+		}
+	}
+
+	memcpy(indices, out.data(), sizeof(unsigned int) * triCount * 3);
+}
+#pragma endregion
+
+#pragma region Overdraw
+struct MeshCluster{
+	size_t first, count;	//	in triangles
+	float sortKey;
+};
+
+void OptimizeOverdraw(unsigned int* indices, size_t indexCount, const Vert* verts, size_t vertexCount, float threshold){
+	size_t triCount = indexCount / 3;
+	if (triCount < 2 || vertexCount == 0)
+		return;
+
+	//	Hard boundaries: the reorder jumped somewhere the cache had nothing of
+	std::vector<size_t> hard;
+	FIFOCache cache(vertexCount, MESH_CACHE_SIZE);
+	for (size_t t = 0; t < triCount; ++t){
+		if (cache.TouchTriangle(indices + t * 3) == 3)
+			hard.push_back(t);
+	}
+	if (hard.empty() || hard[0] != 0)
+		hard.insert(hard.begin(), 0);
+	hard.push_back(triCount);
+
+	//	Soft boundaries: inside a hard cluster, cut once the running ACMR falls
+	//	back under threshold times the cluster's own
+	std::vector<MeshCluster> clusters;
+	for (size_t h = 0; h + 1 < hard.size(); ++h){
+		size_t begin = hard[h], end = hard[h + 1];
+
+		cache.Flush();
+		unsigned int misses = 0;
+		for (size_t t = begin; t < end; ++t)
+			misses += cache.TouchTriangle(indices + t * 3);
+		float limit = threshold * (float)misses / (float)(end - begin);
+
+		cache.Flush();
+		MeshCluster current = { begin, 0, 0.0f };
+		misses = 0;
+		for (size_t t = begin; t < end; ++t){
+			misses += cache.TouchTriangle(indices + t * 3);
+			++current.count;
+			if (t + 1 < end && (float)misses <= limit * (float)current.count){
+				clusters.push_back(current);
+				current.first = t + 1;
+				current.count = 0;
+				misses = 0;
+				cache.Flush();
+			}
+		}
+		if (current.count)
+			clusters.push_back(current);
+	}
+
+	//	Area weighted centroid of the whole mesh
+	FLOAT3 meshCenter(0, 0, 0);
+	float meshArea = 0.0f;
+	std::vector<FLOAT3> triNormal(triCount), triCenter(triCount);
+	for (size_t t = 0; t < triCount; ++t){
+		const FLOAT3& a = verts[indices[t * 3]].Pos;
+		const FLOAT3& b = verts[indices[t * 3 + 1]].Pos;
+		const FLOAT3& c = verts[indices[t * 3 + 2]].Pos;
+
+		FLOAT3 e1(b.x - a.x, b.y - a.y, b.z - a.z);
+		FLOAT3 e2(c.x - a.x, c.y - a.y, c.z - a.z);
+		//	Length is twice the area
+		FLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+		float area = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+
+		triNormal[t] = n;
+		triCenter[t] = FLOAT3((a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f);
+
+		meshCenter.x += triCenter[t].x * area;
+		meshCenter.y += triCenter[t].y * area;
+		meshCenter.z += triCenter[t].z * area;
+		meshArea += area;
+	}
+	if (meshArea > 0.0f){
+		meshCenter.x /= meshArea;
+		meshCenter.y /= meshArea;
+		meshCenter.z /= meshArea;
+	}
+
+	//	How far the cluster faces away from the middle of the mesh
+	for (size_t i = 0; i < clusters.size(); ++i){
+		MeshCluster& cl = clusters[i];
+		FLOAT3 n(0, 0, 0), center(0, 0, 0);
+		float area = 0.0f;
+
+		for (size_t t = cl.first; t < cl.first + cl.count; ++t){
+			const FLOAT3& tn = triNormal[t];
+			float a = sqrtf(tn.x * tn.x + tn.y * tn.y + tn.z * tn.z);
+			n.x += tn.x;
+			n.y += tn.y;
+			n.z += tn.z;
+			center.x += triCenter[t].x * a;
+			center.y += triCenter[t].y * a;
+			center.z += triCenter[t].z * a;
+			area += a;
+		}
+
+		float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+		if (area <= 0.0f || len <= 0.0f){
+			cl.sortKey = 0.0f;
+			continue;
+		}
+
+		FLOAT3 d(center.x / area - meshCenter.x, center.y / area - meshCenter.y, center.z / area - meshCenter.z);
+		cl.sortKey = (d.x * n.x + d.y * n.y + d.z * n.z) / len;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const MeshCluster& a, const MeshCluster& b){
+		return a.sortKey > b.sortKey;
+	});
+
+	std::vector<unsigned int> out;
+	out.reserve(triCount * 3);
+	for (size_t i = 0; i < clusters.size(); ++i)
+		out.insert(out.end(), indices + clusters[i].first * 3, indices + (clusters[i].first + clusters[i].count) * 3);
+
+	memcpy(indices, out.data(), sizeof(unsigned int) * triCount * 3);
+}
+#pragma endregion
+
+#pragma region Vertex Fetch
+size_t OptimizeVertexFetch(Model* m){
+	std::vector<unsigned int> remap(m->interleaved.size(), ~0u);
+	std::vector<Vert> verts;
+	verts.reserve(m->interleaved.size());
+
+	for (size_t i = 0; i < m->out_Indicies.size(); ++i){
+		unsigned int& index = m->out_Indicies[i];
+		if (remap[index] == ~0u){
+			remap[index] = (unsigned int)verts.size();
+			verts.push_back(m->interleaved[index]);
+		}
+		index = remap[index];
+	}
+
+	m->interleaved.swap(verts);
+	return m->interleaved.size();
+}
+#pragma endregion
+
+//	A sub-mesh renumbered to its own vertices, so the passes only size their
+//	tables by what it uses. remap is sized once for the whole model and put
+//	back to ~0u after each use.
+struct SubMeshScratch{
+	std::vector<unsigned int> remap;
+	std::vector<unsigned int> vertices;		//	local -> model vertex
+	std::vector<unsigned int> local;		//	indices in local numbering
+	std::vector<Vert> verts;				//	local copies for the overdraw pass
+};
+
+static void OptimizeRange(Model* m, unsigned int* indices, size_t count, unsigned int flags, SubMeshScratch& scratch){
+	scratch.vertices.clear();
+	scratch.local.resize(count);
+	for (size_t i = 0; i < count; ++i){
+		unsigned int& local = scratch.remap[indices[i]];
+		if (local == ~0u){
+			local = (unsigned int)scratch.vertices.size();
+			scratch.vertices.push_back(indices[i]);
+		}
+		scratch.local[i] = local;
+	}
+	for (size_t v = 0; v < scratch.vertices.size(); ++v)
+		scratch.remap[scratch.vertices[v]] = ~0u;
+
+	size_t vertexCount = scratch.vertices.size();
+	OptimizeVertexCache(scratch.local.data(), count, vertexCount);
+
+	if (flags & MESH_OPTIMIZE_OVERDRAW){
+		scratch.verts.resize(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+			scratch.verts[v] = m->interleaved[scratch.vertices[v]];
+		OptimizeOverdraw(scratch.local.data(), count, scratch.verts.data(), vertexCount);
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		indices[i] = scratch.vertices[scratch.local[i]];
+}
+
+void OptimizeModel(Model* m, unsigned int flags){
+	if (m->out_Indicies.size() < 3)
+		return;
+
+	SubMeshScratch scratch;
+	scratch.remap.assign(m->interleaved.size(), ~0u);
+
+	//	Triangles only move inside their own sub-mesh so the draw ranges stay valid
+	if (m->subMeshes.empty())
+		OptimizeRange(m, m->out_Indicies.data(), m->out_Indicies.size(), flags, scratch);
+	for (size_t i = 0; i < m->subMeshes.size(); ++i)
+		OptimizeRange(m, m->out_Indicies.data() + m->subMeshes[i].firstIndex, m->subMeshes[i].indexCount, flags, scratch);
+	OptimizeVertexFetch(m);
+}
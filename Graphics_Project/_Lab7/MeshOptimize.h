@@ -0,0 +1,58 @@
+#ifndef _MESHOPTIMIZE_H_
+#define _MESHOPTIMIZE_H_
+
+#include "Defines.h"
+#include <cstddef>
+
+//	Post transform cache size the reorder targets and the simulator defaults to
+#define MESH_CACHE_SIZE		16
+
+//	Side of the square AnalyzeOverdraw rasterizes each view into
+#define MESH_OVERDRAW_SIZE	256
+
+//	OptimizeModel options
+#define MESH_OPTIMIZE_OVERDRAW	0x1		//	also sort clusters for overdraw, costs some ACMR
+
+
+//	Result of running an index list through a FIFO post transform cache
+struct VertexCacheStats{
+	unsigned int transformed;	//	cache misses, i.e. vertex shader runs
+	float acmr;					//	misses per triangle, 0.5 best, 3 worst
+	float atvr;					//	misses per referenced vertex, 1 best
+};
+
+//	Simulates a FIFO cache of cacheSize entries over a triangle list
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = MESH_CACHE_SIZE);
+
+//	Pixels drawn against pixels covered over the six axis views
+struct OverdrawStats{
+	unsigned int covered;		//	pixels with something on them at the end
+	unsigned int shaded;		//	pixels passing the depth test when drawn
+	float overdraw;				//	shaded / covered, 1 best
+};
+
+//	Rasterizes the triangle list in order from +-x, +-y and +-z, orthographic
+//	over the mesh bounds, depth tested like early z would. Triangles facing
+//	away from the view are culled.
+OverdrawStats AnalyzeOverdraw(const unsigned int* indices, size_t indexCount, const Vert* verts, size_t vertexCount);
+
+//	Reorders triangles for the post transform cache (Forsyth's linear speed
+//	vertex cache optimisation). Vertices are untouched.
+void OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+//	Splits a cache optimised list into clusters where the cache restarts and
+//	sorts them outward facing first, so the near side of convex parts tends to
+//	draw before the far side. threshold > 1 lets clusters break a little
+//	earlier (more clusters, better overdraw, slightly worse ACMR).
+void OptimizeOverdraw(unsigned int* indices, size_t indexCount, const Vert* verts, size_t vertexCount, float threshold = 1.05f);
+
+//	Renumbers vertices in order of first use and drops unreferenced ones.
+//	Returns the new vertex count.
+size_t OptimizeVertexFetch(Model* m);
+
+//	Vertex cache then vertex fetch, with MESH_OPTIMIZE_OVERDRAW the overdraw
+//	sort in between. Sub-meshes are reordered one at a time in their own
+//	vertex numbering, so the work follows the sub-mesh size, not the model's.
+void OptimizeModel(Model* m, unsigned int flags = 0);
+
+#endif
@@ -0,0 +1,399 @@
+#include "MeshSimplify.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+//	Border planes count this much more than faces so outlines hold their shape
+#define BORDER_WEIGHT		10.0
+
+//	Levels never go past this fraction of the mesh's diagonal
+#define LOD_MAX_ERROR		0.25f
+
+
+enum VertexKind {
+	KIND_MANIFOLD = 0,		//	free to collapse onto any neighbour
+	KIND_BORDER,			//	on one open border, slides along it
+	KIND_LOCKED				//	border corner or non manifold, never moves
+};
+
+#pragma region Quadrics
+//	Symmetric plane quadric (A, b, c) plus the weight it was built with,
+//	error(p) = p'Ap + 2b'p + c, divided by the weight to stay a squared distance
+struct Quadric{
+	double a00, a01, a02, a11, a12, a22;
+	double b0, b1, b2;
+	double c;
+	double w;
+};
+
+static void QuadricFromPlane(Quadric& q, double nx, double ny, double nz, double d, double w){
+	q.a00 = w * nx * nx;	q.a01 = w * nx * ny;	q.a02 = w * nx * nz;
+	q.a11 = w * ny * ny;	q.a12 = w * ny * nz;	q.a22 = w * nz * nz;
+	q.b0 = w * nx * d;		q.b1 = w * ny * d;		q.b2 = w * nz * d;
+	q.c = w * d * d;
+	q.w = w;
+}
+
+static void QuadricAdd(Quadric& q, const Quadric& r){
+	q.a00 += r.a00;	q.a01 += r.a01;	q.a02 += r.a02;
+	q.a11 += r.a11;	q.a12 += r.a12;	q.a22 += r.a22;
+	q.b0 += r.b0;	q.b1 += r.b1;	q.b2 += r.b2;
+	q.c += r.c;
+	q.w += r.w;
+}
+
+static double QuadricError(const Quadric& q, const FLOAT3& p){
+	if (q.w <= 0.0)
+		return 0.0;
+
+	double x = p.x, y = p.y, z = p.z;
+	double e = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+		+ 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+		+ 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z)
+		+ q.c;
+	return fabs(e) / q.w;
+}
+#pragma endregion
+
+static inline FLOAT3 Cross(const FLOAT3& a, const FLOAT3& b, const FLOAT3& c){
+	FLOAT3 e1(b.x - a.x, b.y - a.y, b.z - a.z);
+	FLOAT3 e2(c.x - a.x, c.y - a.y, c.z - a.z);
+	return FLOAT3(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+}
+
+static inline unsigned long long EdgeKey(unsigned int a, unsigned int b){
+	return (a < b) ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+}
+
+struct Collapse{
+	unsigned int from, to;
+	double cost;
+};
+
+size_t SimplifyMesh(const Vert* verts, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+	size_t targetIndexCount, float maxError, unsigned int* out, float* resultError){
+
+	size_t count = (indexCount / 3) * 3;
+	std::vector<unsigned int> tris(indices, indices + count);
+	double reached = 0.0;
+
+	//	Vertices sharing a position are wedges of one point, rep[] is the first
+	//	of them and stands for the point in everything topological
+	std::vector<unsigned int> order(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+		order[i] = (unsigned int)i;
+	std::sort(order.begin(), order.end(), [verts](unsigned int a, unsigned int b){
+		const FLOAT3& p = verts[a].Pos;
+		const FLOAT3& q = verts[b].Pos;
+		if (p.x != q.x) return p.x < q.x;
+		if (p.y != q.y) return p.y < q.y;
+		if (p.z != q.z) return p.z < q.z;
+		return a < b;
+	});
+
+	std::vector<unsigned int> rep(vertexCount), wedgeFirst(vertexCount, 0), wedgeCount(vertexCount, 0);
+	for (size_t i = 0; i < vertexCount; ++i){
+		unsigned int v = order[i];
+		if (i > 0 && memcmp(&verts[v].Pos, &verts[order[i - 1]].Pos, sizeof(FLOAT3)) == 0)
+			rep[v] = rep[order[i - 1]];
+		else {
+			rep[v] = v;
+			wedgeFirst[v] = (unsigned int)i;
+		}
+		++wedgeCount[rep[v]];
+	}
+
+	//	Later collapses point a vertex at a surviving wedge of its neighbour
+	std::vector<unsigned int> redirect(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+		redirect[i] = (unsigned int)i;
+
+	auto Resolve = [&redirect](unsigned int v) -> unsigned int {
+		unsigned int r = v;
+		while (redirect[r] != r)
+			r = redirect[r];
+		while (redirect[v] != r){
+			unsigned int next = redirect[v];
+			redirect[v] = r;
+			v = next;
+		}
+		return r;
+	};
+
+	std::unordered_map<unsigned long long, unsigned int> edges;
+	auto CountEdges = [&](){
+		edges.clear();
+		for (size_t t = 0; t < tris.size(); t += 3){
+			unsigned int a = rep[tris[t]], b = rep[tris[t + 1]], c = rep[tris[t + 2]];
+			++edges[EdgeKey(a, b)];
+			++edges[EdgeKey(b, c)];
+			++edges[EdgeKey(c, a)];
+		}
+	};
+
+	//	Kinds and quadrics come from the input once, collapses only add up quadrics
+	CountEdges();
+
+	std::vector<unsigned char> kind(vertexCount, KIND_MANIFOLD);
+	std::vector<unsigned int> borderEdges(vertexCount, 0);
+	for (auto it = edges.begin(); it != edges.end(); ++it){
+		unsigned int a = (unsigned int)(it->first >> 32), b = (unsigned int)(it->first & 0xFFFFFFFF);
+		if (it->second == 1){
+			++borderEdges[a];
+			++borderEdges[b];
+		}
+		else if (it->second > 2){
+			kind[a] = KIND_LOCKED;
+			kind[b] = KIND_LOCKED;
+		}
+	}
+	for (size_t v = 0; v < vertexCount; ++v){
+		if (rep[v] != v || kind[v] == KIND_LOCKED)
+			continue;
+		if (borderEdges[v] != 0 && borderEdges[v] != 2)
+			kind[v] = KIND_LOCKED;
+		else if (borderEdges[v] == 2)
+			kind[v] = KIND_BORDER;
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	memset(quadrics.data(), 0, sizeof(Quadric) * vertexCount);
+
+	for (size_t t = 0; t < tris.size(); t += 3){
+		unsigned int r[3] = { rep[tris[t]], rep[tris[t + 1]], rep[tris[t + 2]] };
+		const FLOAT3& a = verts[r[0]].Pos;
+		FLOAT3 n = Cross(a, verts[r[1]].Pos, verts[r[2]].Pos);
+
+		double len = sqrt((double)n.x * n.x + (double)n.y * n.y + (double)n.z * n.z);
+		if (len == 0.0)
+			continue;
+
+		double nx = n.x / len, ny = n.y / len, nz = n.z / len;
+		Quadric q;
+		QuadricFromPlane(q, nx, ny, nz, -(nx * a.x + ny * a.y + nz * a.z), len * 0.5);
+		for (int c = 0; c < 3; ++c)
+			QuadricAdd(quadrics[r[c]], q);
+
+		//	Plane through each open edge, standing on the face
+		for (int c = 0; c < 3; ++c){
+			unsigned int e0 = r[c], e1 = r[(c + 1) % 3];
+			if (edges[EdgeKey(e0, e1)] != 1)
+				continue;
+
+			const FLOAT3& p0 = verts[e0].Pos;
+			const FLOAT3& p1 = verts[e1].Pos;
+			double ex = p1.x - p0.x, ey = p1.y - p0.y, ez = p1.z - p0.z;
+			double bx = ey * nz - ez * ny, by = ez * nx - ex * nz, bz = ex * ny - ey * nx;
+			double blen = sqrt(bx * bx + by * by + bz * bz);
+			if (blen == 0.0)
+				continue;
+
+			bx /= blen; by /= blen; bz /= blen;
+			Quadric bq;
+			QuadricFromPlane(bq, bx, by, bz, -(bx * p0.x + by * p0.y + bz * p0.z), (ex * ex + ey * ey + ez * ez) * BORDER_WEIGHT);
+			QuadricAdd(quadrics[e0], bq);
+			QuadricAdd(quadrics[e1], bq);
+		}
+	}
+
+	double limit = (double)maxError * maxError;
+	std::vector<Collapse> candidates;
+	std::vector<unsigned int> adjOffset(vertexCount + 1), adjacency;
+	std::vector<unsigned char> touched(vertexCount);
+
+	while (tris.size() > targetIndexCount){
+		CountEdges();
+
+		//	Triangles around every point
+		std::fill(adjOffset.begin(), adjOffset.end(), 0);
+		for (size_t i = 0; i < tris.size(); ++i)
+			++adjOffset[rep[tris[i]] + 1];
+		for (size_t v = 0; v < vertexCount; ++v)
+			adjOffset[v + 1] += adjOffset[v];
+		adjacency.resize(tris.size());
+		std::vector<unsigned int> fill(adjOffset.begin(), adjOffset.end() - 1);
+		for (size_t i = 0; i < tris.size(); ++i)
+			adjacency[fill[rep[tris[i]]]++] = (unsigned int)(i / 3);
+
+		candidates.clear();
+		for (size_t t = 0; t < tris.size(); t += 3){
+			for (int c = 0; c < 3; ++c){
+				unsigned int a = rep[tris[t + c]], b = rep[tris[t + (c + 1) % 3]];
+				bool border = edges[EdgeKey(a, b)] == 1;
+
+				for (int dir = 0; dir < 2; ++dir){
+					unsigned int from = dir ? b : a, to = dir ? a : b;
+					if (kind[from] == KIND_LOCKED || (kind[from] == KIND_BORDER && !border))
+						continue;
+
+					Quadric q = quadrics[from];
+					QuadricAdd(q, quadrics[to]);
+					Collapse col = { from, to, QuadricError(q, verts[to].Pos) };
+					candidates.push_back(col);
+				}
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b){
+			return a.cost < b.cost;
+		});
+
+		//	Each point moves or receives at most once per pass
+		std::fill(touched.begin(), touched.end(), 0);
+		size_t remaining = tris.size() / 3;
+		size_t collapsed = 0;
+
+		for (size_t i = 0; i < candidates.size(); ++i){
+			const Collapse& col = candidates[i];
+			if (col.cost > limit || remaining * 3 <= targetIndexCount)
+				break;
+			if (touched[col.from] || touched[col.to])
+				continue;
+
+			//	Faces that keep existing must not turn over
+			const FLOAT3& target = verts[col.to].Pos;
+			size_t dying = 0;
+			bool flips = false;
+
+			for (unsigned int k = adjOffset[col.from]; k < adjOffset[col.from + 1] && !flips; ++k){
+				const unsigned int* tri = &tris[adjacency[k] * 3];
+				unsigned int r[3] = { rep[Resolve(tri[0])], rep[Resolve(tri[1])], rep[Resolve(tri[2])] };
+
+				if (r[0] == r[1] || r[1] == r[2] || r[2] == r[0])
+					continue;
+				if (r[0] == col.to || r[1] == col.to || r[2] == col.to){
+					++dying;
+					continue;
+				}
+
+				FLOAT3 p[3] = { verts[r[0]].Pos, verts[r[1]].Pos, verts[r[2]].Pos };
+				FLOAT3 before = Cross(p[0], p[1], p[2]);
+				for (int c = 0; c < 3; ++c){
+					if (r[c] == col.from)
+						p[c] = target;
+				}
+				FLOAT3 after = Cross(p[0], p[1], p[2]);
+
+				flips = before.x * after.x + before.y * after.y + before.z * after.z <= 0.0f;
+			}
+			if (flips)
+				continue;
+
+			//	Every wedge of from goes to the closest surviving wedge of to, so
+			//	uv and normal seams travel with the point instead of tearing
+			for (unsigned int fw = 0; fw < wedgeCount[col.from]; ++fw){
+				unsigned int moving = order[wedgeFirst[col.from] + fw];
+				if (redirect[moving] != moving)
+					continue;
+
+				const Vert& src = verts[moving];
+				unsigned int best = col.to;
+				float bestDist = FLT_MAX;
+				for (unsigned int w = 0; w < wedgeCount[col.to]; ++w){
+					unsigned int cand = order[wedgeFirst[col.to] + w];
+					if (redirect[cand] != cand)
+						continue;
+
+					const Vert& v = verts[cand];
+					float du = v.Uvs.u - src.Uvs.u, dv = v.Uvs.v - src.Uvs.v;
+					float dx = v.Norms.x - src.Norms.x, dy = v.Norms.y - src.Norms.y, dz = v.Norms.z - src.Norms.z;
+					float dist = du * du + dv * dv + dx * dx + dy * dy + dz * dz;
+					if (dist < bestDist){
+						bestDist = dist;
+						best = cand;
+					}
+				}
+				redirect[moving] = best;
+			}
+
+			QuadricAdd(quadrics[col.to], quadrics[col.from]);
+			touched[col.from] = touched[col.to] = 1;
+
+			remaining -= dying;
+			reached = std::max(reached, col.cost);
+			++collapsed;
+		}
+
+		if (collapsed == 0)
+			break;
+
+		//	Point corners at their survivors and drop what folded flat
+		size_t write = 0;
+		for (size_t t = 0; t < tris.size(); t += 3){
+			unsigned int v[3] = { Resolve(tris[t]), Resolve(tris[t + 1]), Resolve(tris[t + 2]) };
+			if (rep[v[0]] == rep[v[1]] || rep[v[1]] == rep[v[2]] || rep[v[2]] == rep[v[0]])
+				continue;
+			tris[write++] = v[0];
+			tris[write++] = v[1];
+			tris[write++] = v[2];
+		}
+		tris.resize(write);
+	}
+
+	if (!tris.empty())
+		memcpy(out, tris.data(), sizeof(unsigned int) * tris.size());
+	if (resultError)
+		*resultError = (float)sqrt(reached);
+	return tris.size();
+}
+
+unsigned int BuildLODChain(const Vert* verts, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+	std::vector<unsigned int>& lodIndices, MeshLOD* lods, unsigned int maxLods, float reduction){
+
+	size_t count = (indexCount / 3) * 3;
+	lodIndices.assign(indices, indices + count);
+
+	lods[0].firstIndex = 0;
+	lods[0].indexCount = (unsigned int)count;
+	lods[0].error = 0.0f;
+
+	if (count == 0 || maxLods < 2)
+		return 1;
+
+	FLOAT3 lo(FLT_MAX, FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (size_t i = 0; i < count; ++i){
+		const FLOAT3& p = verts[indices[i]].Pos;
+		lo.x = std::min(lo.x, p.x); hi.x = std::max(hi.x, p.x);
+		lo.y = std::min(lo.y, p.y); hi.y = std::max(hi.y, p.y);
+		lo.z = std::min(lo.z, p.z); hi.z = std::max(hi.z, p.z);
+	}
+	float diagonal = sqrtf((hi.x - lo.x) * (hi.x - lo.x) + (hi.y - lo.y) * (hi.y - lo.y) + (hi.z - lo.z) * (hi.z - lo.z));
+
+	//	Every level starts from the full mesh so its error is against the original
+	std::vector<unsigned int> buffer(count);
+	unsigned int levels = 1;
+	float fraction = 1.0f;
+
+	while (levels < maxLods){
+		fraction *= reduction;
+		size_t target = (size_t)(count / 3 * fraction) * 3;
+
+		float error = 0.0f;
+		size_t result = SimplifyMesh(verts, vertexCount, indices, count, target, diagonal * LOD_MAX_ERROR, buffer.data(), &error);
+
+		const MeshLOD& prev = lods[levels - 1];
+		if (result == 0 || result > prev.indexCount * 0.9f)
+			break;
+
+		MeshLOD& lod = lods[levels++];
+		lod.firstIndex = (unsigned int)lodIndices.size();
+		lod.indexCount = (unsigned int)result;
+		lod.error = std::max(error, prev.error);
+		lodIndices.insert(lodIndices.end(), buffer.begin(), buffer.begin() + result);
+	}
+	return levels;
+}
+
+unsigned int SelectLOD(const MeshLOD* lods, unsigned int count, float distance, float pixelsPerUnit, float pixelError){
+	if (distance <= 0.0f)
+		return 0;
+
+	for (unsigned int l = count - 1; l > 0; --l){
+		if (lods[l].error / distance * pixelsPerUnit <= pixelError)
+			return l;
+	}
+	return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef _MESHSIMPLIFY_H_
+#define _MESHSIMPLIFY_H_
+
+#include "Defines.h"
+#include <cstddef>
+
+#define MESH_MAX_LODS		4
+
+
+//	One level of detail, a range of a shared index list over the full vertex buffer
+struct MeshLOD{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float error;			//	estimated deviation from the full mesh, model units
+};
+
+//	Quadric error metric edge collapse. Vertices only ever collapse onto a
+//	neighbour, so the result indexes the original vertex buffer. Open borders
+//	only slide along themselves and non manifold vertices stay. Seam wedges
+//	follow their point onto the neighbour wedge with the closest uv and normal.
+//	Stops at targetIndexCount or when the next collapse would cost more than
+//	maxError (model units). Writes into out (indexCount entries is always
+//	enough), returns the new index count and the reached error in *resultError.
+size_t SimplifyMesh(const Vert* verts, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+	size_t targetIndexCount, float maxError, unsigned int* out, float* resultError = nullptr);
+
+//	lods[0] is the full mesh, each next level aims for reduction times the
+//	triangles of the one before. All levels go one after another into
+//	lodIndices. Stops early once a level shrinks by less than 10%.
+//	Returns the number of levels.
+unsigned int BuildLODChain(const Vert* verts, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+	std::vector<unsigned int>& lodIndices, MeshLOD* lods, unsigned int maxLods = MESH_MAX_LODS, float reduction = 0.5f);
+
+//	Coarsest level whose error, projected at distance, stays under pixelError.
+//	pixelsPerUnit is the screen height in pixels of one unit at distance 1
+//	(0.5 * height * projection[1][1]).
+unsigned int SelectLOD(const MeshLOD* lods, unsigned int count, float distance, float pixelsPerUnit, float pixelError);
+
+#endif
@@ -0,0 +1,180 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+static inline FLOAT3 Sub(const FLOAT3& a, const FLOAT3& b){
+	return FLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static inline float Dot3(const FLOAT3& a, const FLOAT3& b){
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+#pragma region Bounds
+//	Sphere around the middle of the run's box, loose by at most sqrt(3)
+//	against the minimal one but cheap and stable
+static void BoundSphere(const Vert* verts, const unsigned int* corners, size_t count, Meshlet& out){
+	FLOAT3 lo(FLT_MAX, FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (size_t i = 0; i < count; ++i){
+		const FLOAT3& p = verts[corners[i]].Pos;
+		lo.x = std::min(lo.x, p.x); hi.x = std::max(hi.x, p.x);
+		lo.y = std::min(lo.y, p.y); hi.y = std::max(hi.y, p.y);
+		lo.z = std::min(lo.z, p.z); hi.z = std::max(hi.z, p.z);
+	}
+
+	out.center = FLOAT3((lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f);
+
+	float r2 = 0.0f;
+	for (size_t i = 0; i < count; ++i){
+		FLOAT3 d = Sub(verts[corners[i]].Pos, out.center);
+		r2 = std::max(r2, Dot3(d, d));
+	}
+	out.radius = sqrtf(r2);
+}
+
+//	Cone around the average face normal that holds every face normal
+static void BoundCone(const Vert* verts, const unsigned int* indices, size_t triCount, Meshlet& out){
+	std::vector<FLOAT3> normals;
+	normals.reserve(triCount);
+
+	FLOAT3 sum(0.0f, 0.0f, 0.0f);
+	for (size_t t = 0; t < triCount; ++t){
+		const FLOAT3& a = verts[indices[t * 3]].Pos;
+		FLOAT3 e1 = Sub(verts[indices[t * 3 + 1]].Pos, a);
+		FLOAT3 e2 = Sub(verts[indices[t * 3 + 2]].Pos, a);
+		FLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+
+		float len = sqrtf(Dot3(n, n));
+		if (len == 0.0f)
+			continue;		//	degenerate, can never be seen
+
+		n = FLOAT3(n.x / len, n.y / len, n.z / len);
+		normals.push_back(n);
+		sum.x += n.x;
+		sum.y += n.y;
+		sum.z += n.z;
+	}
+
+	out.coneAxis = FLOAT3(0.0f, 0.0f, 0.0f);
+	out.coneCutoff = MESHLET_NO_CONE;
+
+	float len = sqrtf(Dot3(sum, sum));
+	if (len == 0.0f)
+		return;
+	out.coneAxis = FLOAT3(sum.x / len, sum.y / len, sum.z / len);
+
+	float minDot = 1.0f;
+	for (size_t i = 0; i < normals.size(); ++i)
+		minDot = std::min(minDot, Dot3(normals[i], out.coneAxis));
+
+	if (minDot > 0.0f)
+		out.coneCutoff = sqrtf(1.0f - minDot * minDot);
+}
+#pragma endregion
+
+void MeshletSet::Build(const Vert* verts, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+	std::vector<unsigned int>& clusterIndices, unsigned int maxVerts, unsigned int maxTris){
+
+	meshlets.clear();
+	clusterIndices.assign(indices, indices + (indexCount / 3) * 3);
+
+	size_t triCount = indexCount / 3;
+	if (triCount == 0)
+		return;
+
+	//	stamp[v] == meshlet number + 1 while v is in the open meshlet
+	std::vector<unsigned int> stamp(vertexCount, 0);
+
+	Meshlet current;
+	current.firstIndex = 0;
+	current.triangleCount = 0;
+	current.vertexCount = 0;
+
+	auto Close = [&](){
+		const unsigned int* run = clusterIndices.data() + current.firstIndex;
+		BoundSphere(verts, run, current.triangleCount * 3, current);
+		BoundCone(verts, run, current.triangleCount, current);
+		meshlets.push_back(current);
+	};
+
+	for (size_t t = 0; t < triCount; ++t){
+		const unsigned int* tri = indices + t * 3;
+		unsigned int id = (unsigned int)meshlets.size() + 1;
+
+		unsigned int added = 0;
+		for (unsigned int c = 0; c < 3; ++c){
+			if (stamp[tri[c]] != id && (c < 1 || tri[c] != tri[0]) && (c < 2 || tri[c] != tri[1]))
+				++added;
+		}
+
+		if (current.triangleCount && (current.vertexCount + added > maxVerts || current.triangleCount + 1 > maxTris)){
+			Close();
+			current.firstIndex = (unsigned int)(t * 3);
+			current.triangleCount = 0;
+			current.vertexCount = 0;
+			id = (unsigned int)meshlets.size() + 1;
+		}
+
+		for (unsigned int c = 0; c < 3; ++c){
+			if (stamp[tri[c]] != id){
+				stamp[tri[c]] = id;
+				++current.vertexCount;
+			}
+		}
+		++current.triangleCount;
+	}
+	Close();
+}
+
+size_t MeshletSet::Cull(const FLOAT4* localPlanes, const FLOAT3& localEye, std::vector<unsigned int>& visible) const{
+	size_t rejected = 0;
+
+	for (size_t i = 0; i < meshlets.size(); ++i){
+		const Meshlet& m = meshlets[i];
+		bool culled = false;
+
+		for (int p = 0; p < 6 && !culled; ++p){
+			const FLOAT4& pl = localPlanes[p];
+			culled = pl.x * m.center.x + pl.y * m.center.y + pl.z * m.center.z + pl.w < -m.radius;
+		}
+
+		//	Every face is back facing when the whole sphere sits at least the
+		//	cone's half angle behind the cone's base plane as seen from the eye.
+		//	D3D's clockwise front faces have normals toward the eye.
+		if (!culled && m.coneCutoff < 1.0f){
+			FLOAT3 v = Sub(m.center, localEye);
+			float dist = sqrtf(Dot3(v, v));
+			culled = Dot3(v, m.coneAxis) >= m.coneCutoff * dist + m.radius * (1.0f + m.coneCutoff);
+		}
+
+		if (culled)
+			rejected += m.triangleCount;
+		else
+			visible.push_back((unsigned int)i);
+	}
+	return rejected;
+}
+
+void FrustumToLocal(const FLOAT4* worldPlanes, const MATRIX4X4& world, FLOAT4* localPlanes){
+	//	p_world = p_local * world, so dot(p_world, plane) = dot(p_local, world * plane)
+	for (int i = 0; i < 6; ++i){
+		const FLOAT4& w = worldPlanes[i];
+		FLOAT4 l(
+			world.a * w.x + world.b * w.y + world.c * w.z + world.d * w.w,
+			world.e * w.x + world.f * w.y + world.g * w.z + world.h * w.w,
+			world.i * w.x + world.j * w.y + world.k * w.z + world.l * w.w,
+			world.m * w.x + world.n * w.y + world.o * w.z + world.p * w.w);
+
+		float len = sqrtf(l.x * l.x + l.y * l.y + l.z * l.z);
+		if (len > 0.0f){
+			l.x /= len;
+			l.y /= len;
+			l.z /= len;
+			l.w /= len;
+		}
+		localPlanes[i] = l;
+	}
+}
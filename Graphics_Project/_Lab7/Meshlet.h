@@ -0,0 +1,54 @@
+#ifndef _MESHLET_H_
+#define _MESHLET_H_
+
+#include "Defines.h"
+#include <cstddef>
+
+#define MESHLET_MAX_VERTS	64
+#define MESHLET_MAX_TRIS	124
+
+//	coneCutoff for clusters whose normals spread too far to ever be all back facing
+#define MESHLET_NO_CONE		2.0f
+
+
+//	Contiguous run of triangles in the cluster ordered index list
+struct Meshlet{
+	unsigned int firstIndex;
+	unsigned int triangleCount;
+	unsigned int vertexCount;		//	distinct vertices the run touches
+
+	FLOAT3 center;					//	bounding sphere, model space
+	float radius;
+
+	FLOAT3 coneAxis;				//	average face normal
+	float coneCutoff;				//	sin of the cone's half angle, MESHLET_NO_CONE when it is 90 or more
+};
+
+//	Meshlets of one model. Culling runs in model space, so callers move the
+//	frustum and the eye in instead of moving every sphere and cone out.
+class MeshletSet {
+
+	std::vector<Meshlet> meshlets;
+
+public:
+
+	//	Cuts the triangle list into runs of at most maxVerts vertices and maxTris
+	//	triangles, in the order given (run it after OptimizeVertexCache so
+	//	neighbours are already close). clusterIndices receives the index list
+	//	the Meshlet ranges refer to, the same triangles as indices.
+	void Build(const Vert* verts, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+		std::vector<unsigned int>& clusterIndices, unsigned int maxVerts = MESHLET_MAX_VERTS, unsigned int maxTris = MESHLET_MAX_TRIS);
+
+	//	localPlanes: 6 normalized planes facing in, localEye: camera position,
+	//	both in model space. Appends the surviving meshlet indices and returns
+	//	how many triangles were rejected.
+	size_t Cull(const FLOAT4* localPlanes, const FLOAT3& localEye, std::vector<unsigned int>& visible) const;
+
+	const Meshlet* GetMeshlets() const { return meshlets.data(); }
+	size_t GetCount() const { return meshlets.size(); }
+};
+
+//	World frustum planes to model space (normalized), world is the model's row vector matrix
+void FrustumToLocal(const FLOAT4* worldPlanes, const MATRIX4X4& world, FLOAT4* localPlanes);
+
+#endif
@@ -0,0 +1,377 @@
+#include "MipGenerate.h"
+#include "JobSystem.h"
+#include "MathSIMD.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef MATHSIMD_X86
+#include <immintrin.h>
+#endif
+
+//	Entries in the linear to sRGB table, fine enough that the darkest codes round right
+#define MIP_SRGB_TABLE_SIZE		65536
+
+
+#pragma region Kernels
+//	One axis of a downsample. Destination texel i sums weight * source texel
+//	index over [first[i], first[i + 1]), the edges already clamped or wrapped.
+struct MipKernel {
+	std::vector<unsigned int> first;
+	std::vector<unsigned int> index;
+	std::vector<float> weight;
+};
+
+static double BesselI0(double x){
+	double sum = 1.0, term = 1.0, half = x * 0.5;
+	for (int k = 1; k < 32; ++k){
+		term *= (half / k) * (half / k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+//	t in destination texels from the centre
+static double Kaiser(double t){
+	double x = t / MIP_KAISER_WIDTH;
+	if (x <= -1.0 || x >= 1.0)
+		return 0.0;
+	double sinc = t == 0.0 ? 1.0 : sin(3.14159265358979323846 * t) / (3.14159265358979323846 * t);
+	return sinc * BesselI0(MIP_KAISER_ALPHA * sqrt(1.0 - x * x)) / BesselI0(MIP_KAISER_ALPHA);
+}
+
+static void BuildKernel(size_t srcSize, size_t dstSize, MipFilter filter, bool wrap, MipKernel& k){
+	double scale = (double)srcSize / dstSize;
+	double radius = filter == MIP_FILTER_BOX ? 0.5 * scale : MIP_KAISER_WIDTH * scale;
+
+	k.first.assign(1, 0);
+	k.index.clear();
+	k.weight.clear();
+
+	for (size_t i = 0; i < dstSize; ++i){
+		double center = (i + 0.5) * scale;
+		long long lo = (long long)floor(center - radius);
+		long long hi = (long long)ceil(center + radius);
+		size_t start = k.index.size();
+		double sum = 0.0;
+
+		for (long long j = lo; j < hi; ++j){
+			double w;
+			if (filter == MIP_FILTER_BOX)
+				w = std::min<double>(j + 1.0, center + radius) - std::max<double>((double)j, center - radius);
+			else
+				w = Kaiser((j + 0.5 - center) / scale);
+			if (w == 0.0)
+				continue;
+
+			long long n = (long long)srcSize;
+			unsigned int s = (unsigned int)(wrap ? ((j % n) + n) % n : std::min<long long>(std::max<long long>(j, 0), n - 1));
+
+			//	Texels past the edge land on ones already in the kernel
+			size_t at = start;
+			while (at < k.index.size() && k.index[at] != s)
+				++at;
+			if (at == k.index.size()){
+				k.index.push_back(s);
+				k.weight.push_back(0.0f);
+			}
+			k.weight[at] += (float)w;
+			sum += w;
+		}
+
+		for (size_t at = start; at < k.index.size(); ++at)
+			k.weight[at] = (float)(k.weight[at] / sum);
+		k.first.push_back((unsigned int)k.index.size());
+	}
+}
+#pragma endregion
+
+#pragma region Filtering
+//	The SSE2 rows add in the same order, one channel per lane, so both paths
+//	give the same floats
+static void HorizontalRowScalar(const float* src, float* dst, size_t dstWidth, const MipKernel& k){
+	for (size_t x = 0; x < dstWidth; ++x){
+		float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (unsigned int t = k.first[x]; t < k.first[x + 1]; ++t){
+			const float* s = src + 4 * k.index[t];
+			float w = k.weight[t];
+			for (int c = 0; c < 4; ++c)
+				acc[c] += w * s[c];
+		}
+		memcpy(dst + 4 * x, acc, sizeof(acc));
+	}
+}
+
+//	rows[t] is the start of the tap's source row, columns are floats
+static void VerticalRowScalar(const float* const* rows, const float* weights, unsigned int taps, size_t columns, float* dst){
+	for (size_t x = 0; x < columns; ++x){
+		float acc = 0.0f;
+		for (unsigned int t = 0; t < taps; ++t)
+			acc += weights[t] * rows[t][x];
+		dst[x] = acc;
+	}
+}
+
+#ifdef MATHSIMD_X86
+static void HorizontalRowSSE2(const float* src, float* dst, size_t dstWidth, const MipKernel& k){
+	for (size_t x = 0; x < dstWidth; ++x){
+		__m128 acc = _mm_setzero_ps();
+		for (unsigned int t = k.first[x]; t < k.first[x + 1]; ++t)
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k.weight[t]), _mm_loadu_ps(src + 4 * k.index[t])));
+		_mm_storeu_ps(dst + 4 * x, acc);
+	}
+}
+
+static void VerticalRowSSE2(const float* const* rows, const float* weights, unsigned int taps, size_t columns, float* dst){
+	//	columns is always 4 per texel
+	for (size_t x = 0; x < columns; x += 4){
+		__m128 acc = _mm_setzero_ps();
+		for (unsigned int t = 0; t < taps; ++t)
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(rows[t] + x)));
+		_mm_storeu_ps(dst + x, acc);
+	}
+}
+#endif
+
+static void HorizontalRow(const float* src, float* dst, size_t dstWidth, const MipKernel& k){
+#ifdef MATHSIMD_X86
+	if (GetSIMDLevel() >= SIMD_SSE2)
+		return HorizontalRowSSE2(src, dst, dstWidth, k);
+#endif
+	HorizontalRowScalar(src, dst, dstWidth, k);
+}
+
+static void VerticalRow(const float* const* rows, const float* weights, unsigned int taps, size_t columns, float* dst){
+#ifdef MATHSIMD_X86
+	if (GetSIMDLevel() >= SIMD_SSE2)
+		return VerticalRowSSE2(rows, weights, taps, columns, dst);
+#endif
+	VerticalRowScalar(rows, weights, taps, columns, dst);
+}
+
+static void Renormalize(float* texels, size_t count){
+	for (size_t i = 0; i < count; ++i){
+		float* n = texels + 4 * i;
+		float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		//	Opposing normals cancel out, point those straight up
+		if (length < 1e-6f){
+			n[0] = 0.0f;
+			n[1] = 0.0f;
+			n[2] = 1.0f;
+			continue;
+		}
+		n[0] /= length;
+		n[1] /= length;
+		n[2] /= length;
+	}
+}
+
+template <typename RowFunc>
+static void ForRows(JobSystem* jobs, size_t rows, const RowFunc& fn){
+	if (jobs && rows > MIP_ROWS_PER_JOB)
+		jobs->ParallelFor(rows, MIP_ROWS_PER_JOB, [&](size_t, size_t begin, size_t end, unsigned int){ fn(begin, end); });
+	else
+		fn(0, rows);
+}
+
+size_t FullMipCount(size_t width, size_t height){
+	size_t count = 1;
+	for (size_t size = std::max<size_t>(width, height); size > 1; size >>= 1)
+		++count;
+	return count;
+}
+
+void DownsampleLevel(const float* src, size_t width, size_t height, float* dst,
+	MipFilter filter, unsigned int flags, JobSystem* jobs){
+
+	size_t dstWidth = std::max<size_t>(width / 2, 1);
+	size_t dstHeight = std::max<size_t>(height / 2, 1);
+	bool wrap = (flags & MIP_WRAP) != 0;
+
+	MipKernel kx, ky;
+	BuildKernel(width, dstWidth, filter, wrap, kx);
+	BuildKernel(height, dstHeight, filter, wrap, ky);
+
+	//	Each destination row goes down the source rows under it into one line,
+	//	then across that line, so there's no half filtered copy of the level
+	ForRows(jobs, dstHeight, [&](size_t begin, size_t end){
+		std::vector<float> line(width * 4);
+		std::vector<const float*> rows;
+		for (size_t y = begin; y < end; ++y){
+			unsigned int first = ky.first[y], taps = ky.first[y + 1] - first;
+			rows.resize(taps);
+			for (unsigned int t = 0; t < taps; ++t)
+				rows[t] = src + ky.index[first + t] * width * 4;
+			VerticalRow(&rows[0], &ky.weight[first], taps, width * 4, &line[0]);
+
+			float* row = dst + y * dstWidth * 4;
+			HorizontalRow(&line[0], row, dstWidth, kx);
+			if (flags & MIP_NORMAL_MAP)
+				Renormalize(row, dstWidth);
+		}
+	});
+}
+#pragma endregion
+
+#pragma region Conversion
+static float SRGBToLinear(float s){
+	return s <= 0.04045f ? s / 12.92f : powf((s + 0.055f) / 1.055f, 2.4f);
+}
+
+//	8 bit channels to float for each kind of texture, and linear back to the
+//	nearest 8 bit sRGB code
+struct ChannelTable {
+	float toLinear[256];
+	float toUnorm[256];
+	float toSnorm[256];
+	uint8_t fromLinear[MIP_SRGB_TABLE_SIZE];
+
+	ChannelTable(){
+		for (int c = 0; c < 256; ++c){
+			toLinear[c] = SRGBToLinear(c / 255.0f);
+			toUnorm[c] = c / 255.0f;
+			toSnorm[c] = c / 127.5f - 1.0f;
+		}
+
+		//	Code c starts where linear passes the midpoint between c - 1 and c
+		int code = 0;
+		float next = SRGBToLinear(0.5f / 255.0f);
+		for (int i = 0; i < MIP_SRGB_TABLE_SIZE; ++i){
+			float v = (float)i / (MIP_SRGB_TABLE_SIZE - 1);
+			while (code < 255 && v >= next){
+				++code;
+				next = code < 255 ? SRGBToLinear((code + 0.5f) / 255.0f) : 2.0f;
+			}
+			fromLinear[i] = (uint8_t)code;
+		}
+	}
+};
+
+static const ChannelTable channelTable;
+
+static inline uint8_t ToUnorm(float v){
+	return (uint8_t)(std::min<float>(std::max<float>(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+static inline uint8_t ToSRGB(float v){
+	float c = std::min<float>(std::max<float>(v, 0.0f), 1.0f);
+	return channelTable.fromLinear[(int)(c * (MIP_SRGB_TABLE_SIZE - 1) + 0.5f)];
+}
+
+//	Texels keep their byte order, bgra only matters for which byte is alpha
+static void DecodeRows(const uint8_t* src, size_t rowPitch, size_t width, size_t begin, size_t end, unsigned int flags, bool opaque, float* dst){
+	const float* rgb = (flags & MIP_NORMAL_MAP) ? channelTable.toSnorm : (flags & MIP_SRGB) ? channelTable.toLinear : channelTable.toUnorm;
+	for (size_t y = begin; y < end; ++y){
+		const uint8_t* row = src + y * rowPitch;
+		float* to = dst + y * width * 4;
+		for (size_t x = 0; x < width; ++x){
+			to[4 * x] = rgb[row[4 * x]];
+			to[4 * x + 1] = rgb[row[4 * x + 1]];
+			to[4 * x + 2] = rgb[row[4 * x + 2]];
+			to[4 * x + 3] = opaque ? 1.0f : channelTable.toUnorm[row[4 * x + 3]];
+		}
+	}
+}
+
+static void EncodeRows(const float* src, size_t width, size_t begin, size_t end, unsigned int flags, bool opaque, uint8_t* dst){
+	for (size_t y = begin; y < end; ++y){
+		const float* row = src + y * width * 4;
+		uint8_t* to = dst + y * width * 4;
+		for (size_t x = 0; x < width; ++x){
+			for (int c = 0; c < 3; ++c){
+				float v = row[4 * x + c];
+				if (flags & MIP_NORMAL_MAP)
+					to[4 * x + c] = ToUnorm(v * 0.5f + 0.5f);
+				else if (flags & MIP_SRGB)
+					to[4 * x + c] = ToSRGB(v);
+				else
+					to[4 * x + c] = ToUnorm(v);
+			}
+			to[4 * x + 3] = opaque ? 255 : ToUnorm(row[4 * x + 3]);
+		}
+	}
+}
+
+bool GenerateMipChain(const DDSFile& src, std::vector<uint8_t>& out, MipFilter filter,
+	unsigned int flags, JobSystem* jobs){
+
+	const DDSInfo& info = src.GetInfo();
+	if (src.GetStatus() != DDS_OK || info.dimension != DDS_DIMENSION_TEXTURE2D)
+		return false;
+
+	bool opaque = false;
+	switch (info.format){
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		flags |= MIP_SRGB;
+		break;
+
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+		flags |= MIP_SRGB;
+		opaque = true;
+		break;
+
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+		opaque = true;
+		break;
+
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+		break;
+
+	default:
+		return false;
+	}
+	if (flags & MIP_NORMAL_MAP)
+		flags &= ~MIP_SRGB;
+
+	DDSInfo dst = info;
+	dst.mipCount = FullMipCount(info.width, info.height);
+	out.clear();
+	WriteDDSHeader(dst, out);
+
+	size_t total = out.size();
+	for (size_t mip = 0; mip < dst.mipCount; ++mip)
+		total += std::max<size_t>(info.width >> mip, 1) * std::max<size_t>(info.height >> mip, 1) * 4 * info.arraySize;
+	out.reserve(total);
+
+	std::vector<float> level, next;
+	for (size_t item = 0; item < info.arraySize; ++item){
+		const DDSSubresource& top = src.GetSubresource(item, 0);
+		size_t width = top.width, height = top.height;
+
+		//	The top goes out as it came in
+		size_t at = out.size();
+		out.resize(at + width * height * 4);
+		for (size_t y = 0; y < height; ++y)
+			memcpy(&out[at + y * width * 4], top.data + y * top.rowPitch, width * 4);
+
+		level.resize(width * height * 4);
+		ForRows(jobs, height, [&](size_t begin, size_t end){
+			DecodeRows(top.data, top.rowPitch, width, begin, end, flags, opaque, &level[0]);
+		});
+
+		for (size_t mip = 1; mip < dst.mipCount; ++mip){
+			size_t w = std::max<size_t>(width / 2, 1);
+			size_t h = std::max<size_t>(height / 2, 1);
+			next.resize(w * h * 4);
+			DownsampleLevel(&level[0], width, height, &next[0], filter, flags, jobs);
+
+			at = out.size();
+			out.resize(at + w * h * 4);
+			uint8_t* to = &out[at];
+			ForRows(jobs, h, [&](size_t begin, size_t end){
+				EncodeRows(&next[0], w, begin, end, flags, opaque, to);
+			});
+
+			level.swap(next);
+			width = w;
+			height = h;
+		}
+	}
+	return true;
+}
+#pragma endregion
@@ -0,0 +1,44 @@
+#ifndef _MIPGENERATE_H_
+#define _MIPGENERATE_H_
+
+#include "DDSFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+#define MIP_SRGB			0x1			//	colour is sRGB encoded, filtered in linear light
+#define MIP_NORMAL_MAP		0x2			//	rgb holds a tangent space normal, renormalised every level
+#define MIP_WRAP			0x4			//	the texture tiles, filters wrap around the edges instead of clamping
+
+#define MIP_KAISER_WIDTH	3.0f		//	kernel radius in destination texels
+#define MIP_KAISER_ALPHA	4.0f
+#define MIP_ROWS_PER_JOB	16
+
+enum MipFilter {
+	MIP_FILTER_BOX,						//	average of the texels each destination texel covers
+	MIP_FILTER_KAISER					//	Kaiser windowed sinc, sharper, can ring a little
+};
+
+
+//	Levels in a full chain for a width x height top, down to 1x1
+size_t FullMipCount(size_t width, size_t height);
+
+//	Next level of a float RGBA image: max(1, width / 2) x max(1, height / 2),
+//	4 floats per texel, rows packed. Works in whatever space src is in, so
+//	for sRGB colour hand it linear values. MIP_NORMAL_MAP renormalises rgb as
+//	a -1..1 vector afterwards. Odd sizes filter over the texels each
+//	destination texel covers, nothing is dropped. Rows go across jobs.
+void DownsampleLevel(const float* src, size_t width, size_t height, float* dst,
+	MipFilter filter, unsigned int flags, JobSystem* jobs = nullptr);
+
+//	Full chain for every item of a 2D R8G8B8A8 / B8G8R8A8 / B8G8R8X8 file,
+//	written as a DDS of the same format to out. The top level is kept
+//	byte for byte, the mips the file had are replaced. Each level is filtered
+//	from the float level above, so rounding doesn't pile up down the chain.
+//	An _SRGB format implies MIP_SRGB unless it's a normal map.
+bool GenerateMipChain(const DDSFile& src, std::vector<uint8_t>& out, MipFilter filter = MIP_FILTER_KAISER,
+	unsigned int flags = MIP_SRGB, JobSystem* jobs = nullptr);
+
+#endif
@@ -0,0 +1,899 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+//	Files smaller than this per thread are not worth splitting
+#define OBJ_MIN_CHUNK	(1 << 20)
+
+
+//	Everything below assumes the text it walks ends in '\n', every scan stops
+//	there, so no loop needs an end pointer. ParseOBJ feeds a last line without
+//	one through a small copy.
+
+#pragma region Number Parsing
+static inline bool IsBlank(char c){
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline const char* SkipBlanks(const char* p){
+	while (IsBlank(*p))
+		++p;
+	return p;
+}
+
+static inline bool IsDigit(char c){
+	return (unsigned char)(c - '0') < 10;
+}
+
+//	Slow but always correctly rounded, for whatever the fast path turns down
+static const char* ParseFloatSlow(const char* start, float& out){
+	char buffer[128];
+	size_t len = 0;
+	while (len < sizeof(buffer) - 1 && !IsBlank(start[len]) && start[len] != '\n' && start[len] != '/')
+		++len;
+	memcpy(buffer, start, len);
+	buffer[len] = 0;
+
+	char* stop = nullptr;
+	out = strtof(buffer, &stop);
+	if (stop == buffer)
+		return nullptr;
+	return start + (stop - buffer);
+}
+
+//	Decimal float, same result as strtof / scanf("%f").
+//	Up to 19 digits go into an integer mantissa m. When m <= 2^53 and the power
+//	of ten is at most 22 both are exact doubles, so m * / 10^e is the correctly
+//	rounded double. Rounding that to float again can only go wrong when the
+//	double lands exactly halfway between two floats, those go to strtof.
+static const char* ParseFloat(const char* p, float& out){
+	static const double powers[23] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char* start = p;
+	bool negative = (*p == '-');
+	if (*p == '-' || *p == '+')
+		++p;
+
+	//	Leading zeros carry nothing, the rest is counted against the 19 digit limit
+	const char* digitsStart = p;
+	while (*p == '0')
+		++p;
+
+	unsigned long long mantissa = 0;
+	const char* first = p;
+	while (IsDigit(*p)){
+		mantissa = mantissa * 10 + (*p - '0');
+		++p;
+	}
+	int digits = (int)(p - first);
+	int exponent = 0;
+	bool any = (p != digitsStart);
+
+	if (*p == '.'){
+		++p;
+		const char* fraction = p;
+		if (mantissa == 0){
+			while (*p == '0')
+				++p;
+			exponent -= (int)(p - fraction);
+		}
+		const char* fractionDigits = p;
+		while (IsDigit(*p)){
+			mantissa = mantissa * 10 + (*p - '0');
+			++p;
+		}
+		digits += (int)(p - fractionDigits);
+		exponent -= (int)(p - fractionDigits);
+		any = any || (p != fraction);
+	}
+
+	//	inf, nan, hex and the like
+	if (!any)
+		return ParseFloatSlow(start, out);
+
+	if (*p == 'e' || *p == 'E'){
+		const char* q = p + 1;
+		bool expNegative = (*q == '-');
+		if (*q == '-' || *q == '+')
+			++q;
+		if (IsDigit(*q)){
+			int e = 0;
+			while (IsDigit(*q)){
+				if (e < 100000)
+					e = e * 10 + (*q - '0');
+				++q;
+			}
+			exponent += expNegative ? -e : e;
+			p = q;
+		}
+	}
+
+	//	More than 19 digits overflowed the mantissa
+	if (digits > 19 || mantissa > (1ull << 53) || exponent < -22 || exponent > 22)
+		return ParseFloatSlow(start, out);
+
+	double value = (double)mantissa;
+	value = (exponent < 0) ? value / powers[-exponent] : value * powers[exponent];
+
+	unsigned long long bits;
+	memcpy(&bits, &value, sizeof(bits));
+	if (value != 0.0 && (bits & ((1ull << 29) - 1)) == (1ull << 28))
+		return ParseFloatSlow(start, out);
+
+	out = negative ? -(float)value : (float)value;
+	return p;
+}
+
+//	OBJ counts from 1 either way, 0 and -0 fail like a missing number
+static const char* ParseIndex(const char* p, unsigned int& out, bool& negative){
+	negative = (*p == '-');
+	if (*p == '-' || *p == '+')
+		++p;
+	if (!IsDigit(*p))
+		return nullptr;
+
+	unsigned int value = 0;
+	while (IsDigit(*p)){
+		value = value * 10 + (*p - '0');
+		++p;
+	}
+	out = value;
+	return value ? p : nullptr;
+}
+#pragma endregion
+
+#pragma region Records
+//	g / o / usemtl / mtllib line, applies to the faces from corner on
+struct ObjState{
+	enum { GROUP, MATERIAL, LIBRARY };
+
+	size_t corner;				//	corners.size() when the line came
+	int kind;
+	std::string name;
+};
+
+//	Raw attribute streams of one chunk, faces are already cut into triangles
+//	and still hold OBJ's 1 based indices, 0 for a missing uv / normal.
+//	Negative (relative) indices are resolved against the chunk's own counts,
+//	relative[] lists them so the merge can add the earlier chunks' counts.
+//	A chunk can't know the group / material it starts in, so the lines that
+//	change them are kept in states[] and replayed in file order by the merge.
+struct ObjData{
+	std::vector<FLOAT3> pos;
+	std::vector<FLOAT2> uvs;
+	std::vector<FLOAT3> norms;
+	std::vector<unsigned int> corners;		//	pos, uv, norm per triangle corner
+	std::vector<size_t> relative;			//	slots in corners
+	std::vector<ObjState> states;
+
+	const char* begin;
+	const char* end;
+	bool ok;
+};
+
+//	Relative index resolved against the earlier attributes. One that reaches
+//	back past the first lands on 0, the missing uv / normal, so it gets an
+//	index no range check passes instead.
+static inline unsigned int ResolveRelative(unsigned int index, size_t before){
+	index += (unsigned int)before;
+	return index ? index : ~0u;
+}
+
+static inline const char* NextLine(const char* p, const char* end){
+	const char* nl = (const char*)memchr(p, '\n', end - p);
+	return nl ? nl + 1 : end;
+}
+
+static void CountRecords(const char* p, const char* end, size_t counts[4]){
+	for (const char* line = p; line < end; line = NextLine(line, end)){
+		const char* c = SkipBlanks(line);
+		if (c[0] == 'v'){
+			if (IsBlank(c[1]))
+				++counts[0];
+			else if (c[1] == 't')
+				++counts[1];
+			else if (c[1] == 'n')
+				++counts[2];
+		}
+		else if (c[0] == 'f' && (IsBlank(c[1]) || c[1] == '\n'))
+			++counts[3];
+	}
+}
+
+static const char* ParseFloats(const char* p, float* out, int count){
+	for (int k = 0; k < count && p; ++k)
+		p = ParseFloat(SkipBlanks(p), out[k]);
+	return p;
+}
+
+//	Rest of the line without the blanks around it
+static void AddState(ObjData& obj, int kind, const char* p){
+	p = SkipBlanks(p);
+	const char* last = p;
+	while (*last != '\n')
+		++last;
+	while (last > p && IsBlank(last[-1]))
+		--last;
+
+	ObjState state;
+	state.corner = obj.corners.size();
+	state.kind = kind;
+	state.name.assign(p, last);
+	obj.states.push_back(state);
+}
+
+//	[p, end) is whole lines, the last one ending in '\n'
+static bool ParseLines(const char* p, const char* end, ObjData& obj){
+	std::vector<unsigned int> face;
+	std::vector<unsigned char> faceNegative;
+
+	for (const char* line = p; line < end; line = NextLine(line, end)){
+		const char* c = SkipBlanks(line);
+
+		//	pos
+		if (c[0] == 'v' && IsBlank(c[1])){
+			FLOAT3 f3(0.0f, 0.0f, 0.0f);
+			ParseFloats(c + 2, &f3.x, 3);
+			obj.pos.push_back(f3);
+		}
+		//	uvs
+		else if (c[0] == 'v' && c[1] == 't' && IsBlank(c[2])){
+			FLOAT2 uv(0.0f, 0.0f);
+			ParseFloats(c + 3, &uv.u, 2);
+			obj.uvs.push_back(uv);
+		}
+		//	normals
+		else if (c[0] == 'v' && c[1] == 'n' && IsBlank(c[2])){
+			FLOAT3 normal(0.0f, 0.0f, 0.0f);
+			ParseFloats(c + 3, &normal.x, 3);
+			obj.norms.push_back(normal);
+		}
+		//	v, v/vt, v//vn or v/vt/vn corners, any count, fanned into triangles
+		else if (c[0] == 'f' && (IsBlank(c[1]) || c[1] == '\n')){
+			face.clear();
+			faceNegative.clear();
+			bool anyNegative = false;
+
+			c = SkipBlanks(c + 1);
+			while (c && *c != '\n' && *c != '#'){
+				unsigned int idx[3] = { 0, 0, 0 };
+				bool negative[3] = { false, false, false };
+
+				c = ParseIndex(c, idx[0], negative[0]);
+				if (c && *c == '/'){
+					++c;
+					if (*c != '/')
+						c = ParseIndex(c, idx[1], negative[1]);
+					if (c && *c == '/')
+						c = ParseIndex(c + 1, idx[2], negative[2]);
+				}
+				if (!c || (!IsBlank(*c) && *c != '\n'))
+					break;
+
+				//	-1 is the latest one so far, counted from this chunk's start for now
+				size_t seen[3] = { obj.pos.size(), obj.uvs.size(), obj.norms.size() };
+				for (int k = 0; k < 3; ++k){
+					if (negative[k]){
+						idx[k] = (unsigned int)seen[k] + 1 - idx[k];
+						anyNegative = true;
+					}
+				}
+				face.insert(face.end(), idx, idx + 3);
+				faceNegative.insert(faceNegative.end(), negative, negative + 3);
+				c = SkipBlanks(c);
+			}
+			if (!c || (*c != '\n' && *c != '#') || face.size() < 9){
+				printf("Cannot be read properly!");
+				return false;
+			}
+
+			//	Plain triangles, the common case, go in as they are
+			size_t count = face.size() / 3;
+			if (count == 3 && !anyNegative){
+				obj.corners.insert(obj.corners.end(), face.begin(), face.end());
+				continue;
+			}
+
+			for (size_t t = 1; t + 1 < count; ++t){
+				size_t fan[3] = { 0, t, t + 1 };
+				for (int k = 0; k < 3; ++k){
+					for (int a = 0; a < 3; ++a){
+						if (faceNegative[fan[k] * 3 + a])
+							obj.relative.push_back(obj.corners.size() + a);
+					}
+					obj.corners.insert(obj.corners.end(), &face[fan[k] * 3], &face[fan[k] * 3] + 3);
+				}
+			}
+		}
+		else if (c[0] == 'g' && IsBlank(c[1]))
+			AddState(obj, ObjState::GROUP, c + 2);
+		else if (c[0] == 'o' && IsBlank(c[1]))
+			AddState(obj, ObjState::GROUP, c + 2);
+		else if (strncmp(c, "usemtl", 6) == 0 && IsBlank(c[6]))
+			AddState(obj, ObjState::MATERIAL, c + 7);
+		else if (strncmp(c, "mtllib", 6) == 0 && IsBlank(c[6]))
+			AddState(obj, ObjState::LIBRARY, c + 7);
+	}
+	return true;
+}
+
+static void ParseChunk(ObjData* obj){
+	size_t counts[4] = { 0, 0, 0, 0 };
+	CountRecords(obj->begin, obj->end, counts);
+
+	obj->pos.reserve(counts[0]);
+	obj->uvs.reserve(counts[1]);
+	obj->norms.reserve(counts[2]);
+	obj->corners.reserve(counts[3] * 9);		//	exact for triangles, n-gons grow it
+
+	obj->ok = ParseLines(obj->begin, obj->end, *obj);
+}
+
+//	Open addressing table from (pos, uv, norm) index triples to vertices
+class CornerTable{
+	std::vector<unsigned int> slots;		//	vertex + 1, 0 = empty
+	std::vector<unsigned int> keys;			//	3 per vertex
+	size_t mask;
+
+	static inline size_t Hash(const unsigned int* k){
+		unsigned int h = k[0] * 0x9E3779B1u;
+		h ^= k[1] * 0x85EBCA77u + (h << 6) + (h >> 2);
+		h ^= k[2] * 0xC2B2AE3Du + (h << 6) + (h >> 2);
+		return h ^ (h >> 15);
+	}
+
+public:
+	CornerTable(size_t maxVertices){
+		size_t capacity = 16;
+		while (capacity < maxVertices * 2)
+			capacity <<= 1;
+		slots.assign(capacity, 0);
+		keys.reserve(maxVertices * 3);
+		mask = capacity - 1;
+	}
+
+	//	Most vertices a table fits in bytes at half load, 20 bytes each. The
+	//	slots round to a power of two, so this rounds down to one as well.
+	static size_t EntriesFor(size_t bytes){
+		size_t entries = 8;
+		while ((entries * 2) * 20 <= bytes)
+			entries <<= 1;
+		return entries;
+	}
+
+	const unsigned int* Key(unsigned int v) const { return &keys[v * 3]; }
+	size_t Count() const { return keys.size() / 3; }
+	size_t Bytes() const { return slots.capacity() * sizeof(unsigned int) + keys.capacity() * sizeof(unsigned int); }
+
+	void Clear(){
+		std::fill(slots.begin(), slots.end(), 0);
+		keys.clear();
+	}
+
+	//	Vertex for the triple, isNew when it was just added as vertex Count() - 1
+	unsigned int Find(const unsigned int* k, bool& isNew){
+		for (size_t i = Hash(k) & mask;; i = (i + 1) & mask){
+			unsigned int v = slots[i];
+			if (v == 0){
+				v = (unsigned int)(keys.size() / 3);
+				keys.insert(keys.end(), k, k + 3);
+				slots[i] = v + 1;
+				isNew = true;
+				return v;
+			}
+
+			const unsigned int* stored = &keys[(v - 1) * 3];
+			if (stored[0] == k[0] && stored[1] == k[1] && stored[2] == k[2]){
+				isNew = false;
+				return v - 1;
+			}
+		}
+	}
+};
+
+//	Index of name in names, added at the end when it is new
+static unsigned int NameIndex(std::vector<std::string>& names, std::unordered_map<std::string, unsigned int>& lookup, const std::string& name){
+	auto it = lookup.find(name);
+	if (it != lookup.end())
+		return it->second;
+
+	unsigned int index = (unsigned int)names.size();
+	names.push_back(name);
+	lookup[name] = index;
+	return index;
+}
+
+//	Replays the g / o / usemtl / mtllib lines in file order, new names go
+//	into the given tables
+struct ObjNameState{
+	std::vector<std::string>& materials;
+	std::vector<std::string>& groups;
+	std::string& materialLib;
+	std::unordered_map<std::string, unsigned int> materialLookup, groupLookup;
+	unsigned int material, group;
+
+	ObjNameState(std::vector<std::string>& mats, std::vector<std::string>& grps, std::string& lib)
+		: materials(mats), groups(grps), materialLib(lib){
+		for (size_t i = 0; i < materials.size(); ++i)
+			materialLookup[materials[i]] = (unsigned int)i;
+		for (size_t i = 0; i < groups.size(); ++i)
+			groupLookup[groups[i]] = (unsigned int)i;
+
+		material = NameIndex(materials, materialLookup, "");
+		group = NameIndex(groups, groupLookup, "");
+	}
+
+	void Apply(const ObjState& state){
+		if (state.kind == ObjState::MATERIAL)
+			material = NameIndex(materials, materialLookup, state.name);
+		else if (state.kind == ObjState::GROUP)
+			group = NameIndex(groups, groupLookup, state.name);
+		else if (materialLib.empty())
+			materialLib = state.name;
+	}
+};
+
+//	Corners without a vn get the area weighted sum of their faces' normals.
+//	They are their own vertices (the key holds normal 0), so smoothing runs
+//	across faces sharing the position and uv only.
+static void FillMissingNormals(Model* m, size_t baseIndex, const std::vector<unsigned char>& missing, size_t base){
+	for (size_t i = baseIndex; i + 2 < m->out_Indicies.size(); i += 3){
+		const unsigned int* tri = &m->out_Indicies[i];
+		const FLOAT3& a = m->interleaved[tri[0]].Pos;
+		const FLOAT3& b = m->interleaved[tri[1]].Pos;
+		const FLOAT3& c = m->interleaved[tri[2]].Pos;
+
+		FLOAT3 e1(b.x - a.x, b.y - a.y, b.z - a.z);
+		FLOAT3 e2(c.x - a.x, c.y - a.y, c.z - a.z);
+		FLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+
+		for (int k = 0; k < 3; ++k){
+			if (!missing[tri[k] - base])
+				continue;
+			FLOAT3& sum = m->interleaved[tri[k]].Norms;
+			sum.x += n.x;
+			sum.y += n.y;
+			sum.z += n.z;
+		}
+	}
+
+	for (size_t v = 0; v < missing.size(); ++v){
+		if (!missing[v])
+			continue;
+		FLOAT3& n = m->interleaved[base + v].Norms;
+		float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+		if (len > 0.0f)
+			n = FLOAT3(n.x / len, n.y / len, n.z / len);
+	}
+}
+
+//	One Vert per distinct (pos, uv, norm) triple in first use order,
+//	faces become indices into them. Replays the chunks' group / material
+//	lines in file order and cuts a SubMesh wherever either changes.
+static bool BuildModel(const std::vector<ObjData>& chunks, const ObjData& merged, size_t numCorners, Model* m){
+	size_t posCount = merged.pos.size(), uvCount = merged.uvs.size(), normCount = merged.norms.size();
+	size_t base = m->interleaved.size();
+	size_t baseIndex = m->out_Indicies.size();
+	size_t baseSubMesh = m->subMeshes.size();
+
+	CornerTable table(numCorners);
+	m->out_Indicies.reserve(baseIndex + numCorners);
+	bool anyMissing = false;
+
+	ObjNameState names(m->materials, m->groups, m->materialLib);
+
+	//	Range being filled, goes into m->subMeshes once the next one starts
+	SubMesh current = { (unsigned int)baseIndex, 0, names.material, names.group };
+
+	for (size_t ci = 0; ci < chunks.size(); ++ci){
+		const std::vector<unsigned int>& corners = chunks[ci].corners;
+		const std::vector<ObjState>& states = chunks[ci].states;
+		size_t nextState = 0;
+
+		for (size_t t = 0; t < corners.size(); t += 9){
+			//	The lines before this triangle, then maybe a new range
+			for (; nextState < states.size() && states[nextState].corner <= t; ++nextState)
+				names.Apply(states[nextState]);
+
+			if (current.material != names.material || current.group != names.group){
+				if (current.indexCount)
+					m->subMeshes.push_back(current);
+				current.firstIndex = (unsigned int)m->out_Indicies.size();
+				current.indexCount = 0;
+				current.material = names.material;
+				current.group = names.group;
+			}
+			current.indexCount += 3;
+
+			for (size_t i = t; i < t + 9; i += 3){
+				const unsigned int* c = &corners[i];
+				unsigned int pi = c[0] - 1, ti = c[1] - 1, ni = c[2] - 1;
+				if (pi >= posCount || (c[1] && ti >= uvCount) || (c[2] && ni >= normCount)){
+					printf("Face index out of range!\n");
+					m->interleaved.resize(base);
+					m->out_Indicies.resize(baseIndex);
+					m->subMeshes.resize(baseSubMesh);
+					return false;
+				}
+
+				bool isNew;
+				unsigned int v = table.Find(c, isNew);
+				if (isNew){
+					Vert temp;
+					temp.Pos = merged.pos[pi];
+					temp.Uvs = c[1] ? merged.uvs[ti] : FLOAT2(0.0f, 0.0f);
+					temp.Norms = c[2] ? merged.norms[ni] : FLOAT3(0.0f, 0.0f, 0.0f);
+					temp.tangent = FLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+					m->interleaved.push_back(temp);
+					anyMissing = anyMissing || c[2] == 0;
+				}
+				m->out_Indicies.push_back((unsigned int)(base + v));
+			}
+		}
+
+		//	Lines after the chunk's last face carry over into the next chunk
+		for (; nextState < states.size(); ++nextState)
+			names.Apply(states[nextState]);
+	}
+
+	if (current.indexCount)
+		m->subMeshes.push_back(current);
+
+	if (anyMissing){
+		std::vector<unsigned char> missing(m->interleaved.size() - base);
+		for (size_t v = 0; v < missing.size(); ++v)
+			missing[v] = table.Key((unsigned int)v)[2] == 0;
+		FillMissingNormals(m, baseIndex, missing, base);
+	}
+	return true;
+}
+
+//	Runs fn(i) for every chunk i, one job each
+template<typename Fn>
+static void ForChunks(JobSystem* jobs, size_t count, const Fn& fn){
+	if (jobs)
+		jobs->ParallelFor(count, 1, [&fn](size_t i, size_t, size_t, unsigned int){ fn(i); });
+	else{
+		for (size_t i = 0; i < count; ++i)
+			fn(i);
+	}
+}
+#pragma endregion
+
+bool ParseOBJ(const char* data, size_t size, Model* m, JobSystem* jobs){
+	const char* end = data + size;
+
+	//	Text after the last '\n' gets its own terminated copy
+	const char* bodyEnd = data;
+	for (const char* s = end; s > data; --s){
+		if (s[-1] == '\n'){
+			bodyEnd = s;
+			break;
+		}
+	}
+	std::string tail(bodyEnd, end);
+	tail += '\n';
+
+	size_t numThreads = jobs ? jobs->GetNumThreads() : 1;
+	size_t bodySize = bodyEnd - data;
+	size_t numBody = bodySize / OBJ_MIN_CHUNK;
+	if (numBody > numThreads)
+		numBody = numThreads;
+	if (numBody < 1)
+		numBody = 1;
+
+	//	Line aligned chunks of about equal size, then the tail
+	std::vector<ObjData> chunks(numBody + 1);
+	const char* cut = data;
+	for (size_t i = 0; i < numBody; ++i){
+		chunks[i].begin = cut;
+		if (i + 1 < numBody){
+			const char* target = data + bodySize * (i + 1) / numBody;
+			cut = (target > cut) ? NextLine(target, bodyEnd) : cut;
+		}
+		else
+			cut = bodyEnd;
+		chunks[i].end = cut;
+	}
+	chunks[numBody].begin = tail.data();
+	chunks[numBody].end = tail.data() + tail.size();
+
+	ForChunks(jobs, chunks.size(), [&chunks](size_t i){ ParseChunk(&chunks[i]); });
+
+	//	Where each chunk's attributes start in the whole file
+	std::vector<size_t> starts(chunks.size() * 3);
+	size_t totals[4] = { 0, 0, 0, 0 };
+	for (size_t i = 0; i < chunks.size(); ++i){
+		if (!chunks[i].ok)
+			return false;
+
+		starts[i * 3 + 0] = totals[0];
+		starts[i * 3 + 1] = totals[1];
+		starts[i * 3 + 2] = totals[2];
+		totals[0] += chunks[i].pos.size();
+		totals[1] += chunks[i].uvs.size();
+		totals[2] += chunks[i].norms.size();
+		totals[3] += chunks[i].corners.size() / 3;
+	}
+
+	//	Merge in file order, a job per chunk. Absolute indices already count
+	//	from the file start, relative ones get the earlier chunks' attributes added.
+	ObjData merged;
+	merged.pos.resize(totals[0]);
+	merged.uvs.resize(totals[1]);
+	merged.norms.resize(totals[2]);
+	ForChunks(jobs, chunks.size(), [&](size_t i){
+		ObjData& chunk = chunks[i];
+		const size_t* start = &starts[i * 3];
+		for (size_t r = 0; r < chunk.relative.size(); ++r){
+			size_t slot = chunk.relative[r];
+			chunk.corners[slot] = ResolveRelative(chunk.corners[slot], start[slot % 3]);
+		}
+
+		std::copy(chunk.pos.begin(), chunk.pos.end(), merged.pos.begin() + start[0]);
+		std::copy(chunk.uvs.begin(), chunk.uvs.end(), merged.uvs.begin() + start[1]);
+		std::copy(chunk.norms.begin(), chunk.norms.end(), merged.norms.begin() + start[2]);
+	});
+
+	//	Vertices are numbered in first use order across the whole file, so the
+	//	dedup stays one pass
+	return BuildModel(chunks, merged, totals[3], m);
+}
+
+bool LoadOBJFile(const char* path, Model* m, JobSystem* jobs){
+	MappedFile file;
+	if (!file.Open(path)){
+		printf("Impossible to open!\n");
+		return false;
+	}
+	return ParseOBJ(file.GetData(), file.GetSize(), m, jobs);
+}
+
+#pragma region Streaming
+//	Append only array in fixed blocks, growing never moves or copies what is there
+template<typename T>
+class BlockArray{
+	static const size_t BLOCK = 65536;
+
+	std::vector<std::unique_ptr<T[]>> blocks;
+	size_t count;
+
+public:
+	BlockArray() : count(0){}
+
+	void Append(const T* items, size_t n){
+		for (size_t i = 0; i < n; ++i, ++count){
+			if (count % BLOCK == 0)
+				blocks.push_back(std::unique_ptr<T[]>(new T[BLOCK]));
+			blocks[count / BLOCK][count % BLOCK] = items[i];
+		}
+	}
+
+	const T& operator[](size_t i) const { return blocks[i / BLOCK][i % BLOCK]; }
+	size_t Size() const { return count; }
+	size_t Bytes() const { return blocks.size() * BLOCK * sizeof(T) + blocks.capacity() * sizeof(blocks[0]); }
+};
+
+static size_t ObjDataBytes(const ObjData& obj){
+	return obj.pos.capacity() * sizeof(FLOAT3) + obj.uvs.capacity() * sizeof(FLOAT2) + obj.norms.capacity() * sizeof(FLOAT3)
+		+ obj.corners.capacity() * sizeof(unsigned int) + obj.relative.capacity() * sizeof(size_t);
+}
+
+bool ModelSink::Vertices(const Vert* verts, size_t count){
+	model->interleaved.insert(model->interleaved.end(), verts, verts + count);
+	return true;
+}
+
+bool ModelSink::Indices(const unsigned int* indices, size_t count){
+	model->out_Indicies.insert(model->out_Indicies.end(), indices, indices + count);
+	return true;
+}
+
+bool ModelSink::Finish(const std::vector<SubMesh>& subMeshes, const std::vector<std::string>& materials,
+	const std::vector<std::string>& groups, const std::string& materialLib){
+	model->subMeshes = subMeshes;
+	model->materials = materials;
+	model->groups = groups;
+	model->materialLib = materialLib;
+	return true;
+}
+
+bool StreamOBJ(const char* path, ObjSink* sink, size_t memoryBudget, ObjStreamStats* stats){
+	if (memoryBudget < OBJ_STREAM_MIN_BUDGET){
+		printf("OBJ stream budget too small!\n");
+		return false;
+	}
+
+	MappedFile file;
+	if (!file.Open(path)){
+		printf("Impossible to open!\n");
+		return false;
+	}
+	const char* data = file.GetData();
+	const char* end = data + file.GetSize();
+
+	const char* bodyEnd = data;
+	for (const char* s = end; s > data; --s){
+		if (s[-1] == '\n'){
+			bodyEnd = s;
+			break;
+		}
+	}
+	std::string tail(bodyEnd, end);
+	tail += '\n';
+
+	//	Output blocks and the parse window are fixed, the table takes up to a
+	//	quarter of the rest and the attributes may grow into the remainder
+	std::vector<Vert> vertBlock;
+	std::vector<unsigned int> indexBlock;
+	vertBlock.reserve(OBJ_STREAM_BLOCK);
+	indexBlock.reserve(OBJ_STREAM_BLOCK * 3);
+	size_t fixedBytes = OBJ_STREAM_BLOCK * (sizeof(Vert) + 3 * sizeof(unsigned int)) + OBJ_STREAM_WINDOW * 2;
+
+	size_t tableEntries = CornerTable::EntriesFor((memoryBudget - fixedBytes) / 4);
+	CornerTable table(tableEntries);
+	size_t attributeBudget = memoryBudget - fixedBytes - table.Bytes();
+
+	BlockArray<FLOAT3> pos, norms;
+	BlockArray<FLOAT2> uvs;
+	ObjData window;
+
+	std::vector<SubMesh> subMeshes;
+	std::vector<std::string> materials, groups;
+	std::string materialLib;
+	ObjNameState names(materials, groups, materialLib);
+	SubMesh current = { 0, 0, names.material, names.group };
+
+	size_t emitted = 0, indexCount = 0, tableBase = 0, peak = 0;
+	unsigned int resets = 0;
+	bool ok = true;
+
+	auto FlushVerts = [&](){
+		ok = ok && (vertBlock.empty() || sink->Vertices(vertBlock.data(), vertBlock.size()));
+		vertBlock.clear();
+	};
+	auto FlushIndices = [&](){
+		//	Every index in the block has its vertex sent already
+		FlushVerts();
+		ok = ok && (indexBlock.empty() || sink->Indices(indexBlock.data(), indexBlock.size()));
+		indexBlock.clear();
+	};
+
+	//	One window of whole lines: parse, make the indices global, emit
+	auto Consume = [&](const char* begin, const char* stop) -> bool {
+		window.pos.clear();
+		window.uvs.clear();
+		window.norms.clear();
+		window.corners.clear();
+		window.relative.clear();
+		window.states.clear();
+
+		if (!ParseLines(begin, stop, window))
+			return false;
+
+		size_t before[3] = { pos.Size(), uvs.Size(), norms.Size() };
+		for (size_t r = 0; r < window.relative.size(); ++r){
+			size_t slot = window.relative[r];
+			window.corners[slot] = ResolveRelative(window.corners[slot], before[slot % 3]);
+		}
+		pos.Append(window.pos.data(), window.pos.size());
+		uvs.Append(window.uvs.data(), window.uvs.size());
+		norms.Append(window.norms.data(), window.norms.size());
+
+		size_t attributeBytes = pos.Bytes() + uvs.Bytes() + norms.Bytes();
+		if (attributeBytes > attributeBudget){
+			printf("OBJ attributes exceed the stream budget!\n");
+			return false;
+		}
+
+		size_t nextState = 0;
+		for (size_t t = 0; t < window.corners.size() && ok; t += 9){
+			for (; nextState < window.states.size() && window.states[nextState].corner <= t; ++nextState)
+				names.Apply(window.states[nextState]);
+
+			if (current.material != names.material || current.group != names.group){
+				if (current.indexCount)
+					subMeshes.push_back(current);
+				current.firstIndex = (unsigned int)indexCount;
+				current.indexCount = 0;
+				current.material = names.material;
+				current.group = names.group;
+			}
+
+			const unsigned int* tri = &window.corners[t];
+			for (int k = 0; k < 3; ++k){
+				const unsigned int* c = tri + k * 3;
+				if (c[0] - 1 >= pos.Size() || (c[1] && c[1] - 1 >= uvs.Size()) || (c[2] && c[2] - 1 >= norms.Size())){
+					printf("Face index out of range!\n");
+					return false;
+				}
+			}
+
+			//	The whole triangle's vertices come from one table generation
+			if (table.Count() + 3 > tableEntries){
+				table.Clear();
+				tableBase = emitted;
+				++resets;
+			}
+
+			for (int k = 0; k < 3; ++k){
+				const unsigned int* c = tri + k * 3;
+				bool isNew;
+				unsigned int v = table.Find(c, isNew);
+				if (isNew){
+					Vert temp;
+					temp.Pos = pos[c[0] - 1];
+					temp.Uvs = c[1] ? uvs[c[1] - 1] : FLOAT2(0.0f, 0.0f);
+					temp.tangent = FLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+					if (c[2])
+						temp.Norms = norms[c[2] - 1];
+					else {
+						const FLOAT3& a = pos[tri[0] - 1];
+						const FLOAT3& b = pos[tri[3] - 1];
+						const FLOAT3& d = pos[tri[6] - 1];
+						FLOAT3 e1(b.x - a.x, b.y - a.y, b.z - a.z);
+						FLOAT3 e2(d.x - a.x, d.y - a.y, d.z - a.z);
+						FLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+						float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+						temp.Norms = len > 0.0f ? FLOAT3(n.x / len, n.y / len, n.z / len) : n;
+					}
+
+					vertBlock.push_back(temp);
+					++emitted;
+					if (vertBlock.size() == OBJ_STREAM_BLOCK)
+						FlushVerts();
+				}
+				indexBlock.push_back((unsigned int)(tableBase + v));
+			}
+			current.indexCount += 3;
+			indexCount += 3;
+			if (indexBlock.size() >= OBJ_STREAM_BLOCK * 3)
+				FlushIndices();
+		}
+
+		for (; nextState < window.states.size(); ++nextState)
+			names.Apply(window.states[nextState]);
+
+		peak = std::max(peak, attributeBytes + table.Bytes() + ObjDataBytes(window)
+			+ vertBlock.capacity() * sizeof(Vert) + indexBlock.capacity() * sizeof(unsigned int));
+		return ok;
+	};
+
+	for (const char* begin = data; begin < bodyEnd && ok;){
+		const char* stop = begin + std::min((size_t)(bodyEnd - begin), (size_t)OBJ_STREAM_WINDOW);
+		if (stop < bodyEnd)
+			stop = NextLine(stop, bodyEnd);
+
+		ok = Consume(begin, stop);
+		file.Release(begin - data, stop - begin);
+		begin = stop;
+	}
+	ok = ok && Consume(tail.data(), tail.data() + tail.size());
+
+	FlushIndices();
+	if (current.indexCount)
+		subMeshes.push_back(current);
+	ok = ok && sink->Finish(subMeshes, materials, groups, materialLib);
+
+	if (stats){
+		stats->vertices = emitted;
+		stats->indices = indexCount;
+		stats->attributeBytes = pos.Bytes() + uvs.Bytes() + norms.Bytes();
+		stats->peakBytes = peak;
+		stats->tableResets = resets;
+	}
+	return ok;
+}
+#pragma endregion
@@ -0,0 +1,85 @@
+#ifndef _OBJLOADER_H_
+#define _OBJLOADER_H_
+
+#include "Defines.h"
+#include <cstddef>
+
+class JobSystem;
+
+
+//	OBJ text already in memory -> m, an indexed triangle list with one Vert
+//	per distinct (pos, uv, norm) triple in order of first use.
+//	Faces can be v, v/vt, v//vn or v/vt/vn with any number of corners
+//	(fanned into triangles), negative indices count back from the latest
+//	attribute. Missing uvs are 0, missing normals are smoothed from the faces.
+//	Every run of faces under one g / o and usemtl becomes a SubMesh, the names
+//	go into m->groups / m->materials and the first mtllib into m->materialLib.
+//	Big files are split into line aligned chunks, one per job system thread,
+//	parsed and merged as jobs. The result does not depend on the split.
+//	Without jobs everything runs on the caller.
+bool ParseOBJ(const char* data, size_t size, Model* m, JobSystem* jobs = nullptr);
+
+//	Maps the file and runs ParseOBJ over it
+bool LoadOBJFile(const char* path, Model* m, JobSystem* jobs = nullptr);
+
+//	Vertices per ObjSink::Vertices call, Indices gets up to 3 times as many
+#define OBJ_STREAM_BLOCK		65536
+
+//	Text parsed per step, and released behind the parser
+#define OBJ_STREAM_WINDOW		(4 << 20)
+
+//	Less than this leaves no room for the blocks and a useful vertex table
+#define OBJ_STREAM_MIN_BUDGET	(32 << 20)
+
+
+//	Receives StreamOBJ's output a block at a time. Vertices are numbered in
+//	the order they arrive, indices refer to that numbering. Returning false
+//	stops the stream.
+class ObjSink {
+
+public:
+	virtual ~ObjSink(){}
+
+	virtual bool Vertices(const Vert* verts, size_t count) = 0;
+	virtual bool Indices(const unsigned int* indices, size_t count) = 0;
+
+	//	Once after the last block, same meaning as the Model members
+	virtual bool Finish(const std::vector<SubMesh>& subMeshes, const std::vector<std::string>& materials,
+		const std::vector<std::string>& groups, const std::string& materialLib) = 0;
+};
+
+//	Collects everything into a Model, for files that fit in memory anyway
+class ModelSink : public ObjSink {
+
+	Model* model;
+
+public:
+	ModelSink(Model* m) : model(m){}
+
+	bool Vertices(const Vert* verts, size_t count) override;
+	bool Indices(const unsigned int* indices, size_t count) override;
+	bool Finish(const std::vector<SubMesh>& subMeshes, const std::vector<std::string>& materials,
+		const std::vector<std::string>& groups, const std::string& materialLib) override;
+};
+
+struct ObjStreamStats{
+	size_t vertices;
+	size_t indices;
+	size_t attributeBytes;			//	pos / uv / normal streams at the end
+	size_t peakBytes;				//	most the streamer held at once, the mapped text aside
+	unsigned int tableResets;		//	times the vertex table filled up and started over
+};
+
+//	Single threaded, single pass reader for files too big for ParseOBJ.
+//	Positions, uvs and normals stay resident since faces may point anywhere
+//	back, in blocks so growing never copies them. Everything else is reused:
+//	the text goes through OBJ_STREAM_WINDOW at a time and is released behind
+//	the parser, finished vertices and indices go to sink in fixed blocks.
+//	The (pos, uv, norm) table gets at most a quarter of what the budget
+//	leaves and starts over when full, a vertex used on both sides of a
+//	restart is emitted twice (the indices stay right).
+//	Fails when the attributes alone outgrow memoryBudget.
+//	Unlike ParseOBJ, a vertex without vn takes the normal of its first face.
+bool StreamOBJ(const char* path, ObjSink* sink, size_t memoryBudget, ObjStreamStats* stats = nullptr);
+
+#endif
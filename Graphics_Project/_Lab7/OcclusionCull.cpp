@@ -0,0 +1,297 @@
+#include "OcclusionCull.h"
+#include "MathSIMD.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef MATHSIMD_X86
+#include <emmintrin.h>
+#endif
+
+//	Anything this close to the eye (or behind it) is treated as visible
+#define OCCLUSION_MIN_W	1e-4f
+
+
+static inline FLOAT4 ToClip(const FLOAT3& p, const MATRIX4X4& m){
+	return FLOAT4(p.x * m.a + p.y * m.e + p.z * m.i + m.m,
+		p.x * m.b + p.y * m.f + p.z * m.j + m.n,
+		p.x * m.c + p.y * m.g + p.z * m.k + m.o,
+		p.x * m.d + p.y * m.h + p.z * m.l + m.p);
+}
+
+
+OcclusionBuffer::OcclusionBuffer() : width(0), height(0), tilesX(0), tilesY(0){
+}
+
+void OcclusionBuffer::Initialize(unsigned int _width, unsigned int _height){
+	tilesX = (_width + OCCLUSION_TILE - 1) / OCCLUSION_TILE;
+	tilesY = (_height + OCCLUSION_TILE - 1) / OCCLUSION_TILE;
+	width = tilesX * OCCLUSION_TILE;
+	height = _height;
+
+	depth.assign(width * height, 1.0f);
+	tileMax.assign(tilesX * tilesY, 1.0f);
+}
+
+void OcclusionBuffer::Clear(){
+	std::fill(depth.begin(), depth.end(), 1.0f);
+	std::fill(tileMax.begin(), tileMax.end(), 1.0f);
+}
+
+#pragma region Rasterize
+void OcclusionBuffer::RasterizeOccluder(const FLOAT3* positions, size_t stride, const unsigned int* indices, size_t numIndices, const MATRIX4X4& worldViewProj){
+	const unsigned char* base = (const unsigned char*)positions;
+
+	for (size_t i = 0; i + 2 < numIndices; i += 3){
+		FLOAT4 v[3];
+		bool clipped = false;
+		for (int k = 0; k < 3; ++k){
+			v[k] = ToClip(*(const FLOAT3*)(base + indices[i + k] * stride), worldViewProj);
+			if (v[k].w < OCCLUSION_MIN_W)
+				clipped = true;
+		}
+
+		//	Dropping an occluder triangle only loses occlusion, never hides anything
+		if (clipped)
+			continue;
+
+		RasterTriangle(v[0], v[1], v[2]);
+	}
+}
+
+void OcclusionBuffer::RasterizeBox(const AABB& box, const MATRIX4X4& worldViewProj){
+	//	Corner k has max x / y / z where bit 0 / 1 / 2 is set
+	static const unsigned int boxIndices[36] = {
+		0, 2, 3, 0, 3, 1,	4, 5, 7, 4, 7, 6,
+		0, 4, 6, 0, 6, 2,	1, 3, 7, 1, 7, 5,
+		0, 1, 5, 0, 5, 4,	2, 6, 7, 2, 7, 3
+	};
+
+	FLOAT3 corners[8];
+	for (int k = 0; k < 8; ++k)
+		corners[k] = FLOAT3((k & 1) ? box.max.x : box.min.x, (k & 2) ? box.max.y : box.min.y, (k & 4) ? box.max.z : box.min.z);
+
+	RasterizeOccluder(corners, sizeof(FLOAT3), boxIndices, 36, worldViewProj);
+}
+
+void OcclusionBuffer::RasterTriangle(const FLOAT4& c0, const FLOAT4& c1, const FLOAT4& c2){
+	//	Clip -> pixel space, y down
+	float hw = width * 0.5f, hh = height * 0.5f;
+	float x0 = (c0.x / c0.w + 1.0f) * hw, y0 = (1.0f - c0.y / c0.w) * hh, z0 = c0.z / c0.w;
+	float x1 = (c1.x / c1.w + 1.0f) * hw, y1 = (1.0f - c1.y / c1.w) * hh, z1 = c1.z / c1.w;
+	float x2 = (c2.x / c2.w + 1.0f) * hw, y2 = (1.0f - c2.y / c2.w) * hh, z2 = c2.z / c2.w;
+
+	//	Past the far plane there is nothing left to hide
+	if (z0 > 1.0f || z1 > 1.0f || z2 > 1.0f)
+		return;
+
+	float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+	if (fabsf(area) < 1e-8f)
+		return;
+
+	//	Either winding, flip so inside is positive
+	if (area < 0.0f){
+		std::swap(x1, x2);
+		std::swap(y1, y2);
+		std::swap(z1, z2);
+		area = -area;
+	}
+
+	int minX = std::max(0, (int)floorf(std::min(x0, std::min(x1, x2))));
+	int maxX = std::min((int)width - 1, (int)ceilf(std::max(x0, std::max(x1, x2))));
+	int minY = std::max(0, (int)floorf(std::min(y0, std::min(y1, y2))));
+	int maxY = std::min((int)height - 1, (int)ceilf(std::max(y0, std::max(y1, y2))));
+	if (minX > maxX || minY > maxY)
+		return;
+
+	//	Edge e(x, y) = a * x + b * y + c, positive inside, sampled at pixel centers.
+	//	Pulling edges in to fully covered pixels would open cracks along every
+	//	edge shared inside a mesh, so coverage stays at the center like the GPU.
+	float ea[3], eb[3], ec[3];
+	float ex[3] = { x0, x1, x2 }, ey[3] = { y0, y1, y2 };
+	for (int e = 0; e < 3; ++e){
+		int n = (e + 1) % 3;
+		ea[e] = ey[e] - ey[n];
+		eb[e] = ex[n] - ex[e];
+		ec[e] = ex[e] * ey[n] - ex[n] * ey[e];
+	}
+
+	//	Depth is affine in screen space
+	float invArea = 1.0f / area;
+	float za = ((z1 - z0) * (y2 - y0) - (z2 - z0) * (y1 - y0)) * invArea;
+	float zb = ((z2 - z0) * (x1 - x0) - (z1 - z0) * (x2 - x0)) * invArea;
+	float zc = z0 - za * x0 - zb * y0;
+
+	//	Store the farthest depth over the pixel, not its center, so the occluder
+	//	never ends up nearer than it is. Never past the farthest vertex either.
+	zc += 0.5f * (fabsf(za) + fabsf(zb));
+	float zMax = std::max(z0, std::max(z1, z2));
+
+#ifdef MATHSIMD_X86
+	if (GetSIMDLevel() >= SIMD_SSE2){
+		//	Four pixels per step, the bounding box start is aligned down to 4
+		int startX = minX & ~3;
+		__m128 offs = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		__m128 vzMax = _mm_set1_ps(zMax);
+		__m128 zero = _mm_setzero_ps();
+
+		for (int y = minY; y <= maxY; ++y){
+			float py = y + 0.5f;
+			float* row = &depth[y * width];
+
+			__m128 e0Row = _mm_set1_ps(eb[0] * py + ec[0]);
+			__m128 e1Row = _mm_set1_ps(eb[1] * py + ec[1]);
+			__m128 e2Row = _mm_set1_ps(eb[2] * py + ec[2]);
+			__m128 zRow = _mm_set1_ps(zb * py + zc);
+
+			for (int x = startX; x <= maxX; x += 4){
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x), offs);
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[0]), px), e0Row);
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[1]), px), e1Row);
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[2]), px), e2Row);
+
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 z = _mm_min_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), zRow), vzMax);
+				__m128 old = _mm_loadu_ps(row + x);
+				__m128 nearer = _mm_min_ps(old, z);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+			}
+		}
+		return;
+	}
+#endif
+
+	for (int y = minY; y <= maxY; ++y){
+		float py = y + 0.5f;
+		float* row = &depth[y * width];
+		for (int x = minX; x <= maxX; ++x){
+			float px = x + 0.5f;
+			if (ea[0] * px + (eb[0] * py + ec[0]) < 0.0f ||
+				ea[1] * px + (eb[1] * py + ec[1]) < 0.0f ||
+				ea[2] * px + (eb[2] * py + ec[2]) < 0.0f)
+				continue;
+
+			float z = std::min(za * px + (zb * py + zc), zMax);
+			if (z < row[x])
+				row[x] = z;
+		}
+	}
+}
+
+void OcclusionBuffer::BuildHiZ(){
+	for (unsigned int ty = 0; ty < tilesY; ++ty){
+		unsigned int yEnd = std::min(height, (ty + 1) * OCCLUSION_TILE);
+		for (unsigned int tx = 0; tx < tilesX; ++tx){
+			float farthest = 0.0f;
+			for (unsigned int y = ty * OCCLUSION_TILE; y < yEnd; ++y){
+				const float* row = &depth[y * width + tx * OCCLUSION_TILE];
+				for (int x = 0; x < OCCLUSION_TILE; ++x)
+					farthest = std::max(farthest, row[x]);
+			}
+			tileMax[ty * tilesX + tx] = farthest;
+		}
+	}
+}
+#pragma endregion
+
+#pragma region Test
+bool OcclusionBuffer::IsRectVisible(float minX, float minY, float maxX, float maxY, float minDepth) const{
+	//	Every pixel the rect touches, rounded outwards
+	int x0 = std::max(0, (int)floorf(minX));
+	int y0 = std::max(0, (int)floorf(minY));
+	int x1 = std::min((int)width - 1, (int)ceilf(maxX));
+	int y1 = std::min((int)height - 1, (int)ceilf(maxY));
+	if (x0 > x1 || y0 > y1)
+		return false;
+
+	//	Tiles first, only tiles with something farther than the box get the per pixel look
+	for (int ty = y0 / OCCLUSION_TILE; ty <= y1 / OCCLUSION_TILE; ++ty){
+		for (int tx = x0 / OCCLUSION_TILE; tx <= x1 / OCCLUSION_TILE; ++tx){
+			if (tileMax[ty * tilesX + tx] < minDepth)
+				continue;
+
+			int py0 = std::max(y0, ty * OCCLUSION_TILE), py1 = std::min(y1, ty * OCCLUSION_TILE + OCCLUSION_TILE - 1);
+			int px0 = std::max(x0, tx * OCCLUSION_TILE), px1 = std::min(x1, tx * OCCLUSION_TILE + OCCLUSION_TILE - 1);
+			for (int y = py0; y <= py1; ++y){
+				const float* row = &depth[y * width];
+				for (int x = px0; x <= px1; ++x){
+					if (row[x] >= minDepth)
+						return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+bool OcclusionBuffer::IsClipBoxVisible(const FLOAT4* corners) const{
+	float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+	float hw = width * 0.5f, hh = height * 0.5f;
+
+	for (int k = 0; k < 8; ++k){
+		const FLOAT4& c = corners[k];
+		if (c.w < OCCLUSION_MIN_W)
+			return true;
+
+		float iw = 1.0f / c.w;
+		float sx = (c.x * iw + 1.0f) * hw;
+		float sy = (1.0f - c.y * iw) * hh;
+		minX = std::min(minX, sx);	maxX = std::max(maxX, sx);
+		minY = std::min(minY, sy);	maxY = std::max(maxY, sy);
+		minZ = std::min(minZ, c.z * iw);
+	}
+
+	//	Off screen boxes are the frustum test's call, not ours
+	if (maxX < 0.0f || maxY < 0.0f || minX > (float)width || minY > (float)height)
+		return true;
+
+	return IsRectVisible(minX, minY, maxX, maxY, minZ);
+}
+
+bool OcclusionBuffer::IsVisible(const AABB& box, const MATRIX4X4& viewProj) const{
+	if (depth.empty())
+		return true;
+
+	FLOAT4 corners[8];
+	for (int k = 0; k < 8; ++k){
+		FLOAT3 p((k & 1) ? box.max.x : box.min.x, (k & 2) ? box.max.y : box.min.y, (k & 4) ? box.max.z : box.min.z);
+		corners[k] = ToClip(p, viewProj);
+	}
+	return IsClipBoxVisible(corners);
+}
+
+size_t OcclusionBuffer::FilterInstances(const unsigned int* in, size_t count, const InstanceSoA& inst, FLOAT3 aabbMin, FLOAT3 aabbMax, const MATRIX4X4& viewProj, unsigned int* out) const{
+	if (depth.empty()){
+		std::copy(in, in + count, out);
+		return count;
+	}
+
+	//	Instances only translate the box, so (local + pos) * VP = local * VP + pos * VP.
+	//	The 8 local corners go through the matrix once, each instance adds one row.
+	FLOAT4 local[8];
+	for (int k = 0; k < 8; ++k){
+		FLOAT3 p((k & 1) ? aabbMax.x : aabbMin.x, (k & 2) ? aabbMax.y : aabbMin.y, (k & 4) ? aabbMax.z : aabbMin.z);
+		local[k] = FLOAT4(p.x * viewProj.a + p.y * viewProj.e + p.z * viewProj.i,
+			p.x * viewProj.b + p.y * viewProj.f + p.z * viewProj.j,
+			p.x * viewProj.c + p.y * viewProj.g + p.z * viewProj.k,
+			p.x * viewProj.d + p.y * viewProj.h + p.z * viewProj.l);
+	}
+
+	size_t kept = 0;
+	for (size_t i = 0; i < count; ++i){
+		unsigned int id = in[i];
+		FLOAT4 t = ToClip(inst.Get(id), viewProj);
+
+		FLOAT4 corners[8];
+		for (int k = 0; k < 8; ++k)
+			corners[k] = FLOAT4(local[k].x + t.x, local[k].y + t.y, local[k].z + t.z, local[k].w + t.w);
+
+		if (IsClipBoxVisible(corners))
+			out[kept++] = id;
+	}
+	return kept;
+}
+#pragma endregion
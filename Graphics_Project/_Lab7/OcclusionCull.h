@@ -0,0 +1,60 @@
+#ifndef _OCCLUSIONCULL_H_
+#define _OCCLUSIONCULL_H_
+
+#include "Defines.h"
+#include "BVH.h"
+#include "FrustumCull.h"
+#include <cstddef>
+
+//	Pixels per side of a Hi-Z tile
+#define OCCLUSION_TILE	8
+
+
+//	Low resolution CPU depth buffer for occlusion culling.
+//	Occluders are rasterized with center sampled coverage and the farthest
+//	depth over each pixel, each 8x8 tile keeps its farthest depth, and boxes
+//	are occluded when every tile / pixel they touch is nearer than the box's
+//	nearest point. Depth is D3D style z / w, 0 near and 1 far.
+class OcclusionBuffer {
+
+	unsigned int width, height;
+	unsigned int tilesX, tilesY;
+
+	std::vector<float> depth;		//	row major, width * height
+	std::vector<float> tileMax;		//	farthest depth per tile after BuildHiZ
+
+	void RasterTriangle(const FLOAT4& v0, const FLOAT4& v1, const FLOAT4& v2);
+	bool IsRectVisible(float minX, float minY, float maxX, float maxY, float minDepth) const;
+	bool IsClipBoxVisible(const FLOAT4* corners) const;
+
+public:
+
+	OcclusionBuffer();
+
+	//	Width is rounded up to a whole number of tiles
+	void Initialize(unsigned int width, unsigned int height);
+
+	void Clear();
+
+	//	Triangle list, positions read with a byte stride so Vert / VERTEX arrays
+	//	can be passed directly. Triangles crossing the near plane are skipped.
+	void RasterizeOccluder(const FLOAT3* positions, size_t stride, const unsigned int* indices, size_t numIndices, const MATRIX4X4& worldViewProj);
+
+	//	The 12 triangles of a box, e.g. the cubes
+	void RasterizeBox(const AABB& box, const MATRIX4X4& worldViewProj);
+
+	//	Call once all occluders are in, before testing
+	void BuildHiZ();
+
+	bool IsVisible(const AABB& worldBox, const MATRIX4X4& viewProj) const;
+
+	//	Keeps the instances of in[] whose box (pos + [aabbMin, aabbMax]) is not
+	//	occluded, in order. in and out may be the same array. Returns the count kept.
+	size_t FilterInstances(const unsigned int* in, size_t count, const InstanceSoA& inst, FLOAT3 aabbMin, FLOAT3 aabbMax, const MATRIX4X4& viewProj, unsigned int* out) const;
+
+	unsigned int GetWidth() const { return width; }
+	unsigned int GetHeight() const { return height; }
+	const float* GetDepth() const { return depth.empty() ? nullptr : &depth[0]; }
+};
+
+#endif
@@ -33,14 +33,14 @@ float4 main(VS_INPUT input) : SV_TARGET {
 	//	Surface color
 	float4 diffuse = ObjTexture.Sample(ObjSamplerState, input.tex);
 
-	//	Normal Map
-	float4 normalMap = ObjNormMap.Sample(ObjSamplerState, input.tex);
-	normalMap = (2.0f * normalMap) - 1.0f;
+	//	Normal Map, BC5 only stores x and y so z is rebuilt
+	float2 xy = ObjNormMap.Sample(ObjSamplerState, input.tex).xy * 2.0f - 1.0f;
+	float3 normalMap = float3(xy, sqrt(saturate(1.0f - dot(xy, xy))));
 
 	input.tangent = normalize(input.tangent - dot(input.tangent, n) * n);
 
 	float3x3 texSpace = float3x3(input.tangent, input.biTan, n);
-	input.norm = normalize(mul(normalMap, texSpace));
+	n = normalize(mul(normalMap, texSpace));
 	
 	//	Point Light
 	float3 lightDir = normalize(light.position - input.worldPos);
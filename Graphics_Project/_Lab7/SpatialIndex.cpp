@@ -0,0 +1,70 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+bool SphereOverlapsAABB(const FLOAT3& center, float radius, const AABB& box){
+	//	Squared distance from the center to the closest point on the box
+	float dx = std::max(std::max(box.min.x - center.x, 0.0f), center.x - box.max.x);
+	float dy = std::max(std::max(box.min.y - center.y, 0.0f), center.y - box.max.y);
+	float dz = std::max(std::max(box.min.z - center.z, 0.0f), center.z - box.max.z);
+	return (dx * dx) + (dy * dy) + (dz * dz) <= radius * radius;
+}
+
+bool RayHitsAABB(const FLOAT3& origin, const FLOAT3& invDir, float maxT, const AABB& box){
+	//	Slab test clipped to [0, maxT]. A zero direction component gives +-inf,
+	//	or NaN right on a slab, which the min / max ordering leaves out.
+	float tNear = 0.0f;
+	float tFar = maxT;
+
+	float t1 = (box.min.x - origin.x) * invDir.x;
+	float t2 = (box.max.x - origin.x) * invDir.x;
+	tNear = std::max(tNear, std::min(t1, t2));
+	tFar = std::min(tFar, std::max(t1, t2));
+
+	t1 = (box.min.y - origin.y) * invDir.y;
+	t2 = (box.max.y - origin.y) * invDir.y;
+	tNear = std::max(tNear, std::min(t1, t2));
+	tFar = std::min(tFar, std::max(t1, t2));
+
+	t1 = (box.min.z - origin.z) * invDir.z;
+	t2 = (box.max.z - origin.z) * invDir.z;
+	tNear = std::max(tNear, std::min(t1, t2));
+	tFar = std::min(tFar, std::max(t1, t2));
+
+	return tNear <= tFar;
+}
+
+AABB TransformAABB(const AABB& box, const MATRIX4X4& mat){
+	FLOAT3 c((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f);
+	FLOAT3 e((box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f, (box.max.z - box.min.z) * 0.5f);
+
+	//	Center goes through the full matrix, extents through |upper 3x3|
+	FLOAT3 wc(c.x * mat.a + c.y * mat.e + c.z * mat.i + mat.m,
+		c.x * mat.b + c.y * mat.f + c.z * mat.j + mat.n,
+		c.x * mat.c + c.y * mat.g + c.z * mat.k + mat.o);
+	FLOAT3 we(e.x * fabsf(mat.a) + e.y * fabsf(mat.e) + e.z * fabsf(mat.i),
+		e.x * fabsf(mat.b) + e.y * fabsf(mat.f) + e.z * fabsf(mat.j),
+		e.x * fabsf(mat.c) + e.y * fabsf(mat.g) + e.z * fabsf(mat.k));
+
+	return AABB(FLOAT3(wc.x - we.x, wc.y - we.y, wc.z - we.z), FLOAT3(wc.x + we.x, wc.y + we.y, wc.z + we.z));
+}
+
+AABB ComputeModelBounds(const Model& model){
+	if (model.interleaved.empty())
+		return AABB(FLOAT3(0.0f, 0.0f, 0.0f), FLOAT3(0.0f, 0.0f, 0.0f));
+
+	AABB box(FLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), FLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+	for (size_t i = 0; i < model.interleaved.size(); ++i){
+		const FLOAT3& p = model.interleaved[i].Pos;
+		box.min.x = std::min(box.min.x, p.x);
+		box.min.y = std::min(box.min.y, p.y);
+		box.min.z = std::min(box.min.z, p.z);
+		box.max.x = std::max(box.max.x, p.x);
+		box.max.y = std::max(box.max.y, p.y);
+		box.max.z = std::max(box.max.z, p.z);
+	}
+	return box;
+}
@@ -0,0 +1,46 @@
+#ifndef _SPATIALINDEX_H_
+#define _SPATIALINDEX_H_
+
+#include "Defines.h"
+#include "BVH.h"
+#include <cstddef>
+
+
+//	Common interface for the dynamic scene structures (LooseOctree, HashGrid).
+//	Ids are picked by the caller and should be small and dense, they index
+//	straight into per object arrays.
+class SpatialIndex {
+
+public:
+	virtual ~SpatialIndex(){}
+
+	virtual void Clear() = 0;
+
+	virtual void Insert(unsigned int id, const AABB& bounds) = 0;
+	virtual void Remove(unsigned int id) = 0;
+	virtual void Move(unsigned int id, const AABB& bounds) = 0;
+
+	virtual bool Contains(unsigned int id) const = 0;
+	virtual size_t Size() const = 0;
+
+	//	All queries append ids to out, in no particular order, each id once.
+	//	Frustum uses the same conservative box test as the tree culling, a grid
+	//	may also drop big boxes that only pass it across a frustum corner.
+	virtual void QueryFrustum(const FLOAT4* planes, std::vector<unsigned int>& out) const = 0;
+	virtual void QuerySphere(const FLOAT3& center, float radius, std::vector<unsigned int>& out) const = 0;
+
+	//	Boxes the segment origin + dir * [0, maxT] passes through
+	virtual void QueryRay(const FLOAT3& origin, const FLOAT3& dir, float maxT, std::vector<unsigned int>& out) const = 0;
+};
+
+//	Shared box tests
+bool SphereOverlapsAABB(const FLOAT3& center, float radius, const AABB& box);
+bool RayHitsAABB(const FLOAT3& origin, const FLOAT3& invDir, float maxT, const AABB& box);
+
+//	Box around box once run through a (row vector) world matrix
+AABB TransformAABB(const AABB& box, const MATRIX4X4& mat);
+
+//	Local space bounds of a loaded model
+AABB ComputeModelBounds(const Model& model);
+
+#endif
@@ -0,0 +1,172 @@
+#include "TangentSpace.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define TANGENT_CHUNK		16384
+
+//	Face orientation in uv space
+#define ORIENT_NONE			0		//	no uv area, adds nothing
+#define ORIENT_PRESERVING	1
+#define ORIENT_MIRRORED		2
+
+
+static inline FLOAT3 Sub(const FLOAT3& a, const FLOAT3& b){
+	return FLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static inline float Dot3(const FLOAT3& a, const FLOAT3& b){
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline FLOAT3 Normalize(const FLOAT3& v){
+	float len = sqrtf(Dot3(v, v));
+	return len > 0.0f ? FLOAT3(v.x / len, v.y / len, v.z / len) : FLOAT3(0.0f, 0.0f, 0.0f);
+}
+
+//	v without its part along unit n
+static inline FLOAT3 Reject(const FLOAT3& v, const FLOAT3& n){
+	float d = Dot3(v, n);
+	return FLOAT3(v.x - n.x * d, v.y - n.y * d, v.z - n.z * d);
+}
+
+//	Runs fn over [0, count) in chunks, on the job system when it is worth it
+template <typename Fn>
+static void ForRange(JobSystem* jobs, size_t count, size_t parallelMin, const Fn& fn){
+	if (jobs && count >= parallelMin)
+		jobs->ParallelFor(count, TANGENT_CHUNK, [&fn](size_t, size_t begin, size_t end, unsigned int){ fn(begin, end); });
+	else
+		fn(0, count);
+}
+
+size_t GenerateTangents(Model* m, JobSystem* jobs){
+	std::vector<Vert>& verts = m->interleaved;
+	std::vector<unsigned int>& indices = m->out_Indicies;
+	size_t triCount = indices.size() / 3;
+
+#pragma region Faces
+	//	Unit uv gradient along u of every face, already flipped for mirrored
+	//	faces like MikkTSpace does (fS * vOs / |vOs|)
+	std::vector<FLOAT3> faceTangent(triCount);
+	std::vector<unsigned char> faceOrient(triCount);
+
+	ForRange(jobs, triCount, TANGENT_PARALLEL_MIN, [&](size_t begin, size_t end){
+		for (size_t t = begin; t < end; ++t){
+			const Vert& v0 = verts[indices[t * 3]];
+			const Vert& v1 = verts[indices[t * 3 + 1]];
+			const Vert& v2 = verts[indices[t * 3 + 2]];
+
+			FLOAT3 d1 = Sub(v1.Pos, v0.Pos);
+			FLOAT3 d2 = Sub(v2.Pos, v0.Pos);
+			float s1 = v1.Uvs.u - v0.Uvs.u, t1 = v1.Uvs.v - v0.Uvs.v;
+			float s2 = v2.Uvs.u - v0.Uvs.u, t2 = v2.Uvs.v - v0.Uvs.v;
+
+			float area = s1 * t2 - t1 * s2;
+			FLOAT3 os(d1.x * t2 - d2.x * t1, d1.y * t2 - d2.y * t1, d1.z * t2 - d2.z * t1);
+			float len = sqrtf(Dot3(os, os));
+
+			if (area == 0.0f || len == 0.0f){
+				faceOrient[t] = ORIENT_NONE;
+				faceTangent[t] = FLOAT3(0.0f, 0.0f, 0.0f);
+				continue;
+			}
+
+			float scale = (area > 0.0f ? 1.0f : -1.0f) / len;
+			faceOrient[t] = area > 0.0f ? ORIENT_PRESERVING : ORIENT_MIRRORED;
+			faceTangent[t] = FLOAT3(os.x * scale, os.y * scale, os.z * scale);
+		}
+	});
+#pragma endregion
+
+#pragma region Handedness Split
+	//	One sign per vertex, so a vertex both kinds of face use gets a copy
+	//	for the mirrored ones
+	size_t original = verts.size();
+	std::vector<unsigned char> used(original, 0);
+	for (size_t t = 0; t < triCount; ++t){
+		for (int c = 0; c < 3; ++c)
+			used[indices[t * 3 + c]] |= faceOrient[t];
+	}
+
+	std::vector<unsigned int> mirror(original, 0);
+	for (size_t v = 0; v < original; ++v){
+		if (used[v] == (ORIENT_PRESERVING | ORIENT_MIRRORED)){
+			mirror[v] = (unsigned int)verts.size();
+			verts.push_back(verts[v]);
+		}
+	}
+
+	size_t added = verts.size() - original;
+	if (added){
+		for (size_t t = 0; t < triCount; ++t){
+			if (faceOrient[t] != ORIENT_MIRRORED)
+				continue;
+			for (int c = 0; c < 3; ++c){
+				unsigned int& i = indices[t * 3 + c];
+				if (i < original && mirror[i])
+					i = mirror[i];
+			}
+		}
+	}
+#pragma endregion
+
+#pragma region Vertex Sums
+	//	Corners grouped per vertex, so each vertex sums its own faces and the
+	//	threads never write to the same vertex
+	size_t vertCount = verts.size();
+	std::vector<unsigned int> cornerStart(vertCount + 1, 0);
+	std::vector<unsigned int> corners(triCount * 3);
+
+	for (size_t i = 0; i < triCount * 3; ++i)
+		++cornerStart[indices[i] + 1];
+	for (size_t v = 0; v < vertCount; ++v)
+		cornerStart[v + 1] += cornerStart[v];
+
+	std::vector<unsigned int> fill(cornerStart.begin(), cornerStart.end() - 1);
+	for (size_t i = 0; i < triCount * 3; ++i)
+		corners[fill[indices[i]]++] = (unsigned int)i;
+
+	ForRange(jobs, vertCount, TANGENT_PARALLEL_MIN, [&](size_t begin, size_t end){
+		for (size_t v = begin; v < end; ++v){
+			Vert& vert = verts[v];
+			FLOAT3 n = Normalize(vert.Norms);
+			FLOAT3 sum(0.0f, 0.0f, 0.0f);
+			float sign = 1.0f;
+
+			for (unsigned int k = cornerStart[v]; k < cornerStart[v + 1]; ++k){
+				unsigned int corner = corners[k];
+				size_t t = corner / 3;
+				if (faceOrient[t] == ORIENT_NONE)
+					continue;
+				sign = faceOrient[t] == ORIENT_MIRRORED ? -1.0f : 1.0f;
+
+				//	Both the gradient and the corner's edges go into the normal's plane first
+				FLOAT3 tan = Normalize(Reject(faceTangent[t], n));
+
+				unsigned int c = corner % 3;
+				const FLOAT3& next = verts[indices[t * 3 + (c + 1) % 3]].Pos;
+				const FLOAT3& prev = verts[indices[t * 3 + (c + 2) % 3]].Pos;
+				FLOAT3 e1 = Normalize(Reject(Sub(next, vert.Pos), n));
+				FLOAT3 e2 = Normalize(Reject(Sub(prev, vert.Pos), n));
+				float angle = acosf(std::min(std::max(Dot3(e1, e2), -1.0f), 1.0f));
+
+				sum.x += tan.x * angle;
+				sum.y += tan.y * angle;
+				sum.z += tan.z * angle;
+			}
+
+			FLOAT3 t = Normalize(sum);
+
+			//	Nothing usable around it, any direction in the normal's plane will do
+			if (Dot3(t, t) == 0.0f){
+				FLOAT3 axis = fabsf(n.x) < 0.9f ? FLOAT3(1.0f, 0.0f, 0.0f) : FLOAT3(0.0f, 1.0f, 0.0f);
+				t = Normalize(Reject(axis, n));
+			}
+			vert.tangent = FLOAT4(t.x, t.y, t.z, sign);
+		}
+	});
+#pragma endregion
+
+	return added;
+}
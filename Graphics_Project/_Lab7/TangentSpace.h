@@ -0,0 +1,21 @@
+#ifndef _TANGENTSPACE_H_
+#define _TANGENTSPACE_H_
+
+#include "Defines.h"
+#include <cstddef>
+
+class JobSystem;
+
+//	Below this many triangles the jobs cost more than they save
+#define TANGENT_PARALLEL_MIN	65536
+
+
+//	Per vertex tangents following MikkTSpace: each face's uv gradient is
+//	projected onto the vertex normal's plane and summed weighted by the corner
+//	angle, w holds the bitangent sign (-1 where the uvs are mirrored).
+//	Vertices shared by mirrored and unmirrored faces are split, the copies are
+//	appended to m->interleaved and the mirrored faces repointed at them.
+//	Normals must already be set. Returns the number of vertices added.
+size_t GenerateTangents(Model* m, JobSystem* jobs = nullptr);
+
+#endif
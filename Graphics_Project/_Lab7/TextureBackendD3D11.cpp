@@ -0,0 +1,258 @@
+#include "TextureBackendD3D11.h"
+
+#include <algorithm>
+
+
+D3D11TextureBackend::~D3D11TextureBackend(){
+	Shutdown();
+}
+
+bool D3D11TextureBackend::Initialize(ID3D11Device* d, ID3D11DeviceContext* c){
+	Shutdown();
+	if (!d || !c)
+		return false;
+
+	device = d;
+	context = c;
+	return true;
+}
+
+void D3D11TextureBackend::Shutdown(){
+	for (size_t i = 0; i < textures.size(); ++i)
+		Destroy((TextureId)i);
+	textures.clear();
+
+	for (size_t i = 0; i < fallbacks.size(); ++i)
+		fallbacks[i].view->Release();
+	fallbacks.clear();
+
+	device = nullptr;
+	context = nullptr;
+}
+
+ID3D11ShaderResourceView* D3D11TextureBackend::GetFallback(unsigned int color, bool cube){
+	for (size_t i = 0; i < fallbacks.size(); ++i){
+		if (fallbacks[i].color == color && fallbacks[i].cube == cube)
+			return fallbacks[i].view;
+	}
+
+	D3D11_TEXTURE2D_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.MipLevels = 1;
+	desc.ArraySize = cube ? 6 : 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = cube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+	D3D11_SUBRESOURCE_DATA init[6];
+	for (unsigned int i = 0; i < 6; ++i){
+		init[i].pSysMem = &color;
+		init[i].SysMemPitch = sizeof(color);
+		init[i].SysMemSlicePitch = sizeof(color);
+	}
+
+	ID3D11Texture2D* tex = nullptr;
+	if (FAILED(device->CreateTexture2D(&desc, init, &tex)))
+		return nullptr;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	ZeroMemory(&srvDesc, sizeof(srvDesc));
+	srvDesc.Format = desc.Format;
+	srvDesc.ViewDimension = cube ? D3D11_SRV_DIMENSION_TEXTURECUBE : D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+
+	Fallback fallback = { color, cube, nullptr };
+	HRESULT result = device->CreateShaderResourceView(tex, &srvDesc, &fallback.view);
+	tex->Release();
+	if (FAILED(result))
+		return nullptr;
+
+	fallbacks.push_back(fallback);
+	return fallback.view;
+}
+
+size_t D3D11TextureBackend::AllocationBase(const Texture& t, size_t mip) const{
+	if (mip >= t.info.mipCount)
+		return mip;
+
+	//	Block compressed resources need a top level that's whole blocks, a
+	//	chain that doesn't allow it keeps a finer top than strictly needed
+	if (IsCompressed(t.info.format)){
+		while (mip > 0){
+			size_t w = t.info.width >> mip, h = t.info.height >> mip;
+			if (w > 0 && h > 0 && w % 4 == 0 && h % 4 == 0)
+				break;
+			--mip;
+		}
+	}
+	return mip;
+}
+
+bool D3D11TextureBackend::Allocate(Texture& t, size_t base){
+	ID3D11Texture2D* tex = nullptr;
+	if (base < t.info.mipCount){
+		D3D11_TEXTURE2D_DESC desc;
+		ZeroMemory(&desc, sizeof(desc));
+		desc.Width = (UINT)std::max<size_t>(1, t.info.width >> base);
+		desc.Height = (UINT)std::max<size_t>(1, t.info.height >> base);
+		desc.MipLevels = (UINT)(t.info.mipCount - base);
+		desc.ArraySize = (UINT)t.info.arraySize;
+		desc.Format = t.info.format;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.MiscFlags = t.info.isCubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+		if (FAILED(device->CreateTexture2D(&desc, nullptr, &tex)))
+			return false;
+
+		//	Carry over what's filled and still wanted, the copy stays on the GPU
+		if (t.resource){
+			UINT oldLevels = (UINT)(t.info.mipCount - t.baseMip);
+			for (size_t mip = std::max<size_t>(t.filledMip, base); mip < t.info.mipCount; ++mip){
+				for (size_t item = 0; item < t.info.arraySize; ++item){
+					UINT dst = D3D11CalcSubresource((UINT)(mip - base), (UINT)item, desc.MipLevels);
+					UINT src = D3D11CalcSubresource((UINT)(mip - t.baseMip), (UINT)item, oldLevels);
+					context->CopySubresourceRegion(tex, dst, 0, 0, 0, t.resource, src, nullptr);
+				}
+			}
+		}
+	}
+
+	if (t.view)
+		t.view->Release();
+	if (t.resource)
+		t.resource->Release();
+	t.view = nullptr;
+	t.resource = tex;
+	t.baseMip = base;
+	return true;
+}
+
+void D3D11TextureBackend::CreateView(Texture& t){
+	if (t.view)
+		t.view->Release();
+	t.view = nullptr;
+	if (!t.resource || t.publishedMip >= t.info.mipCount)
+		return;
+
+	UINT mostDetailed = (UINT)(t.publishedMip - t.baseMip);
+	UINT levels = (UINT)(t.info.mipCount - t.publishedMip);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	ZeroMemory(&srvDesc, sizeof(srvDesc));
+	srvDesc.Format = t.info.format;
+
+	if (t.info.isCubeMap && t.info.arraySize > 6){
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+		srvDesc.TextureCubeArray.MostDetailedMip = mostDetailed;
+		srvDesc.TextureCubeArray.MipLevels = levels;
+		srvDesc.TextureCubeArray.NumCubes = (UINT)(t.info.arraySize / 6);
+	}
+	else if (t.info.isCubeMap){
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+		srvDesc.TextureCube.MostDetailedMip = mostDetailed;
+		srvDesc.TextureCube.MipLevels = levels;
+	}
+	else if (t.info.arraySize > 1){
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MostDetailedMip = mostDetailed;
+		srvDesc.Texture2DArray.MipLevels = levels;
+		srvDesc.Texture2DArray.ArraySize = (UINT)t.info.arraySize;
+	}
+	else {
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MostDetailedMip = mostDetailed;
+		srvDesc.Texture2D.MipLevels = levels;
+	}
+
+	//	A failed view leaves the fallback bound rather than a stale resource
+	if (FAILED(device->CreateShaderResourceView(t.resource, &srvDesc, &t.view)))
+		t.view = nullptr;
+}
+
+bool D3D11TextureBackend::Create(TextureId id, const DDSFile& file, size_t firstMip, unsigned int fallback){
+	const DDSInfo& info = file.GetInfo();
+
+	//	The game only samples 2D textures, arrays and cubes
+	if (!device || info.dimension != DDS_DIMENSION_TEXTURE2D)
+		return false;
+
+	Texture t = Texture();
+	t.fallback = GetFallback(fallback, info.isCubeMap);
+	t.info = info;
+	t.baseMip = info.mipCount;
+	t.filledMip = info.mipCount;
+	t.publishedMip = info.mipCount;
+	t.live = true;
+
+	//	Only the tail for now, no initial data, the mips come in one at a time
+	if (firstMip < info.mipCount && !Allocate(t, AllocationBase(t, firstMip)))
+		return false;
+
+	if (textures.size() <= id)
+		textures.resize(id + 1, Texture());
+	textures[id] = t;
+
+	for (size_t mip = info.mipCount; mip > firstMip; --mip)
+		Upload(id, file, mip - 1);
+	return true;
+}
+
+void D3D11TextureBackend::Upload(TextureId id, const DDSFile& file, size_t mip){
+	Texture& t = textures[id];
+	if (mip < t.baseMip && !Allocate(t, AllocationBase(t, mip)))
+		return;
+
+	for (size_t item = 0; item < t.info.arraySize; ++item){
+		const DDSSubresource& sub = file.GetSubresource(item, mip);
+		UINT index = D3D11CalcSubresource((UINT)(mip - t.baseMip), (UINT)item, (UINT)(t.info.mipCount - t.baseMip));
+		context->UpdateSubresource(t.resource, index, nullptr, sub.data, (UINT)sub.rowPitch, (UINT)sub.slicePitch);
+	}
+	t.filledMip = std::min<size_t>(t.filledMip, mip);
+
+	//	A new resource lost the old view, keep sampling what was published
+	if (!t.view)
+		CreateView(t);
+}
+
+void D3D11TextureBackend::Publish(TextureId id, size_t residentMip){
+	Texture& t = textures[id];
+	//	Never past what's filled, a failed reallocation leaves the coarser mips
+	t.publishedMip = std::max<size_t>(residentMip, t.filledMip);
+	CreateView(t);
+}
+
+void D3D11TextureBackend::Evict(TextureId id, size_t residentMip){
+	Texture& t = textures[id];
+	t.publishedMip = residentMip;
+	t.filledMip = std::max<size_t>(t.filledMip, residentMip);
+
+	//	Shrinks the resource when the format allows a smaller top
+	size_t base = AllocationBase(t, residentMip);
+	if (base > t.baseMip)
+		Allocate(t, base);
+	CreateView(t);
+}
+
+void D3D11TextureBackend::Destroy(TextureId id){
+	if (id >= textures.size())
+		return;
+
+	Texture& t = textures[id];
+	if (t.view)
+		t.view->Release();
+	if (t.resource)
+		t.resource->Release();
+	t = Texture();
+}
+
+ID3D11ShaderResourceView* D3D11TextureBackend::GetView(TextureId id) const{
+	if (id >= textures.size() || !textures[id].live)
+		return nullptr;
+	return textures[id].view ? textures[id].view : textures[id].fallback;
+}
@@ -0,0 +1,63 @@
+#ifndef _TEXTUREBACKENDD3D11_H_
+#define _TEXTUREBACKENDD3D11_H_
+
+#include "TextureStreamer.h"
+#include <d3d11.h>
+#include <vector>
+
+
+//	Streams into D3D11 textures that only hold the resident part of their
+//	chain. D3D11 can't add or drop mips of a resource, so a finer upload or an
+//	eviction recreates it at the new size and copies the kept mips across on
+//	the GPU; the texture memory follows the residency budget. Mips arrive
+//	through UpdateSubresource and each Publish swaps in a view whose
+//	MostDetailedMip is the finest resident one. Until then GetView hands out
+//	a 1x1 fallback texture.
+class D3D11TextureBackend : public TextureBackend {
+
+	struct Texture {
+		ID3D11Texture2D* resource;				//	mips [baseMip, mipCount), null while nothing is in
+		ID3D11ShaderResourceView* view;
+		ID3D11ShaderResourceView* fallback;		//	not owned
+		DDSInfo info;
+		size_t baseMip;
+		size_t filledMip;						//	uploaded down to here
+		size_t publishedMip;
+		bool live;
+	};
+
+	struct Fallback {
+		unsigned int color;
+		bool cube;
+		ID3D11ShaderResourceView* view;
+	};
+
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	std::vector<Texture> textures;
+	std::vector<Fallback> fallbacks;
+
+	ID3D11ShaderResourceView* GetFallback(unsigned int color, bool cube);
+	size_t AllocationBase(const Texture& t, size_t mip) const;
+	bool Allocate(Texture& t, size_t base);
+	void CreateView(Texture& t);
+
+public:
+
+	D3D11TextureBackend() : device(nullptr), context(nullptr){}
+	~D3D11TextureBackend();
+
+	bool Initialize(ID3D11Device* d, ID3D11DeviceContext* c);
+	void Shutdown();
+
+	bool Create(TextureId id, const DDSFile& file, size_t firstMip, unsigned int fallback) override;
+	void Upload(TextureId id, const DDSFile& file, size_t mip) override;
+	void Publish(TextureId id, size_t residentMip) override;
+	void Evict(TextureId id, size_t residentMip) override;
+	void Destroy(TextureId id) override;
+
+	//	What to bind for id right now, never null for a created texture
+	ID3D11ShaderResourceView* GetView(TextureId id) const;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+
+
+TextureResidency::TextureResidency(size_t b) : frame(1), budget(b), residentBytes(0), reservedBytes(0), peakBytes(0), evictions(0), evictedBytes(0), refusals(0){
+}
+
+void TextureResidency::Add(TextureId id, const size_t* mipBytes, size_t mipCount, size_t tailMip){
+	if (textures.size() <= id)
+		textures.resize(id + 1, Texture());
+
+	Texture& t = textures[id];
+	t.mipBytes.assign(mipBytes, mipBytes + mipCount);
+	t.tailMip = tailMip;
+	t.residentMip = tailMip;
+	t.reservedMip = mipCount;
+	t.lastUsed = 0;
+	t.live = true;
+
+	for (size_t mip = tailMip; mip < mipCount; ++mip)
+		residentBytes += mipBytes[mip];
+	peakBytes = std::max(peakBytes, residentBytes + reservedBytes);
+}
+
+void TextureResidency::Remove(TextureId id){
+	if (id >= textures.size() || !textures[id].live)
+		return;
+
+	Texture& t = textures[id];
+	for (size_t mip = t.residentMip; mip < t.mipBytes.size(); ++mip)
+		residentBytes -= t.mipBytes[mip];
+	if (t.reservedMip < t.mipBytes.size())
+		reservedBytes -= t.mipBytes[t.reservedMip];
+	t = Texture();
+}
+
+void TextureResidency::Touch(TextureId id){
+	if (id < textures.size())
+		textures[id].lastUsed = frame;
+}
+
+bool TextureResidency::IsEvictable(const Texture& t, unsigned long long before) const{
+	return t.live && t.residentMip < t.tailMip && t.reservedMip == t.mipBytes.size() && t.lastUsed < before;
+}
+
+bool TextureResidency::Reserve(TextureId id, size_t mip, std::vector<TextureEviction>& evicted){
+	if (id >= textures.size() || !textures[id].live)
+		return false;
+
+	Texture& t = textures[id];
+	if (mip + 1 != t.residentMip || t.reservedMip != t.mipBytes.size())
+		return false;
+
+	size_t need = t.mipBytes[mip];
+	size_t used = residentBytes + reservedBytes;
+
+	if (used + need > budget){
+		if (t.lastUsed + TEXTURE_EVICT_WINDOW < frame){
+			++refusals;
+			return false;
+		}
+
+		//	Oldest first, the finest mip of each goes first
+		std::vector<TextureId> victims;
+		size_t freeable = 0;
+		for (size_t i = 0; i < textures.size(); ++i){
+			const Texture& v = textures[i];
+			if (i == id || !IsEvictable(v, t.lastUsed))
+				continue;
+			victims.push_back((TextureId)i);
+			for (size_t m = v.residentMip; m < v.tailMip; ++m)
+				freeable += v.mipBytes[m];
+		}
+
+		//	All or nothing, a refused read shouldn't cost anyone their mips
+		if (used + need > budget + freeable){
+			++refusals;
+			return false;
+		}
+
+		std::stable_sort(victims.begin(), victims.end(), [&](TextureId a, TextureId b){ return textures[a].lastUsed < textures[b].lastUsed; });
+
+		for (size_t i = 0; i < victims.size() && used + need > budget; ++i){
+			Texture& v = textures[victims[i]];
+			while (v.residentMip < v.tailMip && used + need > budget){
+				used -= v.mipBytes[v.residentMip];
+				residentBytes -= v.mipBytes[v.residentMip];
+				evictedBytes += v.mipBytes[v.residentMip];
+				++evictions;
+				++v.residentMip;
+			}
+
+			TextureEviction e = { victims[i], v.residentMip };
+			evicted.push_back(e);
+		}
+	}
+
+	t.reservedMip = mip;
+	reservedBytes += need;
+	peakBytes = std::max(peakBytes, residentBytes + reservedBytes);
+	return true;
+}
+
+void TextureResidency::Commit(TextureId id){
+	Texture& t = textures[id];
+	if (t.reservedMip == t.mipBytes.size())
+		return;
+
+	reservedBytes -= t.mipBytes[t.reservedMip];
+	residentBytes += t.mipBytes[t.reservedMip];
+	t.residentMip = t.reservedMip;
+	t.reservedMip = t.mipBytes.size();
+}
+
+size_t TextureResidency::GetResidentMip(TextureId id) const{
+	return id < textures.size() ? textures[id].residentMip : 0;
+}
+
+bool TextureResidency::HasReservation(TextureId id) const{
+	return id < textures.size() && textures[id].reservedMip < textures[id].mipBytes.size();
+}
+
+TextureResidencyStats TextureResidency::GetStats() const{
+	TextureResidencyStats stats;
+	stats.budget = budget;
+	stats.residentBytes = residentBytes;
+	stats.reservedBytes = reservedBytes;
+	stats.peakBytes = peakBytes;
+	stats.textures = 0;
+	stats.fullyResident = 0;
+	for (size_t i = 0; i < textures.size(); ++i){
+		if (!textures[i].live)
+			continue;
+		++stats.textures;
+		if (textures[i].residentMip == 0)
+			++stats.fullyResident;
+	}
+	stats.evictions = evictions;
+	stats.evictedBytes = evictedBytes;
+	stats.refusals = refusals;
+	return stats;
+}
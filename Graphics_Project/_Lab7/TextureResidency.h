@@ -0,0 +1,92 @@
+#ifndef _TEXTURERESIDENCY_H_
+#define _TEXTURERESIDENCY_H_
+
+#include <cstddef>
+#include <vector>
+
+#define TEXTURE_BUDGET				(256 << 20)		//	default bytes of streamed texture memory
+#define TEXTURE_EVICT_WINDOW		2				//	frames since its last touch a texture may still evict for
+
+typedef unsigned int TextureId;
+#define TEXTURE_INVALID				((TextureId)-1)
+
+
+//	A texture losing its finest mips to make room, it keeps [residentMip, mipCount)
+struct TextureEviction {
+	TextureId id;
+	size_t residentMip;
+};
+
+struct TextureResidencyStats {
+	size_t budget;
+	size_t residentBytes;			//	committed mips, tails included
+	size_t reservedBytes;			//	granted to reads that haven't been committed
+	size_t peakBytes;				//	highest resident + reserved seen
+	size_t textures;
+	size_t fullyResident;			//	every mip in
+	size_t evictions;				//	mips dropped
+	size_t evictedBytes;
+	size_t refusals;				//	Reserve calls that couldn't make room
+};
+
+//	Budget and LRU policy for streamed textures, no device and no locking.
+//	Textures register their per-mip sizes and the mip tail, which is always
+//	resident and always counted. Reserve grants a finer mip when it fits;
+//	otherwise it evicts the finest mips of the least recently touched textures,
+//	one mip at a time, until it does. Only textures touched within
+//	TEXTURE_EVICT_WINDOW frames may evict, the rest prefetch into free memory.
+//	A texture is only ever evicted for one touched more recently than itself,
+//	never while it has a reservation, and never below its tail. When that can't make enough room nothing is evicted
+//	and the reservation is refused.
+class TextureResidency {
+
+	struct Texture {
+		std::vector<size_t> mipBytes;	//	every array item of the mip
+		size_t tailMip;
+		size_t residentMip;
+		size_t reservedMip;				//	mipCount when nothing is reserved
+		unsigned long long lastUsed;
+		bool live;
+	};
+
+	std::vector<Texture> textures;
+	unsigned long long frame;
+	size_t budget;
+	size_t residentBytes;
+	size_t reservedBytes;
+	size_t peakBytes;
+	size_t evictions;
+	size_t evictedBytes;
+	size_t refusals;
+
+	bool IsEvictable(const Texture& t, unsigned long long before) const;
+
+public:
+
+	TextureResidency(size_t budget = TEXTURE_BUDGET);
+
+	void SetBudget(size_t bytes) { budget = bytes; }
+	size_t GetBudget() const { return budget; }
+
+	//	mipBytes[mipCount], the tail [tailMip, mipCount) counts as resident right away
+	void Add(TextureId id, const size_t* mipBytes, size_t mipCount, size_t tailMip);
+	void Remove(TextureId id);
+
+	//	Starts a new frame of usage, touches after this are more recent than before
+	void BeginFrame() { ++frame; }
+	void Touch(TextureId id);
+
+	//	Room for mip, the next finer one after what's resident. Evictions made
+	//	to get it are appended to evicted, the caller applies them. False when
+	//	it doesn't fit, with nothing evicted.
+	bool Reserve(TextureId id, size_t mip, std::vector<TextureEviction>& evicted);
+	//	The reserved mip is resident now
+	void Commit(TextureId id);
+
+	size_t GetResidentMip(TextureId id) const;
+	bool HasReservation(TextureId id) const;
+	unsigned long long GetFrame() const { return frame; }
+	TextureResidencyStats GetStats() const;
+};
+
+#endif
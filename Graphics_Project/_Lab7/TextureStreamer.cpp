@@ -0,0 +1,376 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cstring>
+
+//	Stride for touching a mapping, no page is smaller
+#define TEXTURE_PAGE_SIZE	4096
+
+
+//	Reading a byte per page is what pulls a mapped file in, the data stays put
+static size_t TouchPages(const uint8_t* data, size_t size){
+	size_t sum = 0;
+	for (size_t i = 0; i < size; i += TEXTURE_PAGE_SIZE)
+		sum += data[i];
+	if (size)
+		sum += data[size - 1];
+	return sum;
+}
+
+float TexturePriority(float radius, float distance, float projScale, float viewportHeight){
+	//	From inside the sphere it covers the whole screen
+	if (distance <= radius)
+		return viewportHeight;
+	return radius * projScale * viewportHeight / distance;
+}
+
+#pragma region Headless Backend
+void HeadlessTextureBackend::Copy(Texture& tex, const DDSFile& file, size_t mip){
+	const DDSInfo& info = file.GetInfo();
+	for (size_t item = 0; item < info.arraySize; ++item){
+		const DDSSubresource& sub = file.GetSubresource(item, mip);
+		memcpy(&tex.bytes[tex.offsets[item * info.mipCount + mip]], sub.data, sub.size);
+		uploadedBytes += sub.size;
+	}
+}
+
+bool HeadlessTextureBackend::Create(TextureId id, const DDSFile& file, size_t firstMip, unsigned int){
+	const DDSInfo& info = file.GetInfo();
+	std::unique_ptr<Texture> tex(new Texture);
+	tex->residentMip = info.mipCount;
+	tex->filledMip = firstMip;
+	tex->mipCount = info.mipCount;
+	tex->mipBytes.assign(info.mipCount, 0);
+
+	size_t total = 0;
+	for (size_t i = 0; i < file.GetSubresourceCount(); ++i){
+		tex->offsets.push_back(total);
+		tex->mipBytes[i % info.mipCount] += file.GetSubresources()[i].size;
+		total += file.GetSubresources()[i].size;
+	}
+	tex->bytes.reset(new uint8_t[total]);
+
+	for (size_t mip = firstMip; mip < info.mipCount; ++mip){
+		Copy(*tex, file, mip);
+		residentBytes += tex->mipBytes[mip];
+	}
+
+	if (textures.size() <= id)
+		textures.resize(id + 1);
+	textures[id] = std::move(tex);
+	return true;
+}
+
+void HeadlessTextureBackend::Upload(TextureId id, const DDSFile& file, size_t mip){
+	Texture& tex = *textures[id];
+	Copy(tex, file, mip);
+	residentBytes += tex.mipBytes[mip];
+	tex.filledMip = mip;
+	++uploads;
+}
+
+void HeadlessTextureBackend::Publish(TextureId id, size_t residentMip){
+	textures[id]->residentMip = residentMip;
+	++publishes;
+}
+
+void HeadlessTextureBackend::Evict(TextureId id, size_t residentMip){
+	Texture& tex = *textures[id];
+	for (size_t mip = tex.filledMip; mip < residentMip; ++mip)
+		residentBytes -= tex.mipBytes[mip];
+	tex.filledMip = residentMip;
+	tex.residentMip = residentMip;
+	++evictions;
+}
+
+void HeadlessTextureBackend::Destroy(TextureId id){
+	if (id >= textures.size() || !textures[id])
+		return;
+
+	Texture& tex = *textures[id];
+	for (size_t mip = tex.filledMip; mip < tex.mipCount; ++mip)
+		residentBytes -= tex.mipBytes[mip];
+	textures[id].reset();
+}
+
+size_t HeadlessTextureBackend::GetResidentMip(TextureId id) const{
+	return textures[id]->residentMip;
+}
+
+const uint8_t* HeadlessTextureBackend::GetData(TextureId id, size_t subresource) const{
+	const Texture& tex = *textures[id];
+	return tex.bytes.get() + tex.offsets[subresource];
+}
+#pragma endregion
+
+#pragma region Streamer
+TextureStreamer::TextureStreamer() : backend(nullptr), pendingBytes(0), mipsRead(0), bytesRead(0), bytesUploaded(0), starved(false), quit(false){
+}
+
+TextureStreamer::~TextureStreamer(){
+	Shutdown();
+}
+
+bool TextureStreamer::Initialize(TextureBackend* b, unsigned int ioThreads){
+	Shutdown();
+	if (!b)
+		return false;
+
+	backend = b;
+	quit = false;
+	if (ioThreads == 0)
+		ioThreads = 1;
+	for (unsigned int i = 0; i < ioThreads; ++i)
+		threads.push_back(std::thread(&TextureStreamer::IOLoop, this));
+	return true;
+}
+
+void TextureStreamer::Shutdown(){
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (unsigned int i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	threads.clear();
+
+	if (backend){
+		for (size_t i = 0; i < entries.size(); ++i)
+			backend->Destroy((TextureId)i);
+	}
+	for (size_t i = 0; i < entries.size(); ++i)
+		residency.Remove((TextureId)i);
+	entries.clear();
+	completions.clear();
+	evictions.clear();
+	pendingBytes = 0;
+	starved = false;
+	backend = nullptr;
+}
+
+TextureId TextureStreamer::Request(const char* path, float priority, unsigned int fallback){
+	if (!backend)
+		return TEXTURE_INVALID;
+
+	std::unique_ptr<Entry> entry(new Entry);
+	if (!entry->file.Open(path))
+		return TEXTURE_INVALID;
+
+	//	The tail is every mip from the first one that fits TEXTURE_TAIL_SIZE down
+	const DDSInfo& info = entry->file.GetInfo();
+	size_t firstMip = info.mipCount;
+	while (firstMip > 0){
+		const DDSSubresource& sub = entry->file.GetSubresource(0, firstMip - 1);
+		if (sub.width > TEXTURE_TAIL_SIZE || sub.height > TEXTURE_TAIL_SIZE)
+			break;
+		--firstMip;
+	}
+
+	//	Only this thread adds entries, so the size is stable without the lock
+	TextureId id = (TextureId)entries.size();
+	if (!backend->Create(id, entry->file, firstMip, fallback))
+		return TEXTURE_INVALID;
+	if (firstMip < info.mipCount)
+		backend->Publish(id, firstMip);
+
+	entry->priority = priority;
+	entry->residentMip = firstMip;
+	entry->readMip = firstMip;
+	entry->reading = false;
+
+	std::vector<size_t> mipBytes(info.mipCount, 0);
+	for (size_t item = 0; item < info.arraySize; ++item){
+		for (size_t mip = 0; mip < info.mipCount; ++mip)
+			mipBytes[mip] += entry->file.GetSubresource(item, mip).size;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		residency.Add(id, &mipBytes[0], info.mipCount, firstMip);
+		entries.push_back(std::move(entry));
+	}
+	wake.notify_all();
+	return id;
+}
+
+void TextureStreamer::SetPriority(TextureId id, float priority){
+	std::lock_guard<std::mutex> guard(lock);
+	if (id < entries.size())
+		entries[id]->priority = priority;
+}
+
+void TextureStreamer::Touch(TextureId id){
+	std::lock_guard<std::mutex> guard(lock);
+	if (id < entries.size())
+		residency.Touch(id);
+}
+
+void TextureStreamer::SetBudget(size_t bytes){
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		residency.SetBudget(bytes);
+	}
+	wake.notify_all();
+}
+
+//	Caller holds lock
+bool TextureStreamer::PickNext(TextureId& id, size_t& mip){
+	//	One mip per texture in flight, its reservation is held until Update
+	candidates.clear();
+	for (size_t i = 0; i < entries.size(); ++i){
+		const Entry& e = *entries[i];
+		if (e.reading || e.readMip == 0 || residency.HasReservation((TextureId)i))
+			continue;
+
+		const DDSSubresource& sub = e.file.GetSubresource(0, e.readMip - 1);
+		float score = e.priority / (float)(sub.width > sub.height ? sub.width : sub.height);
+		candidates.push_back(std::make_pair(score, (TextureId)i));
+	}
+
+	starved = false;
+	if (candidates.empty())
+		return false;
+
+	//	Best first, a refused one mustn't hold up smaller mips that fit
+	std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, TextureId>& a, const std::pair<float, TextureId>& b){ return a.first > b.first; });
+
+	for (size_t i = 0; i < candidates.size(); ++i){
+		Entry& e = *entries[candidates[i].second];
+		size_t first = evictions.size();
+		if (!residency.Reserve(candidates[i].second, e.readMip - 1, evictions))
+			continue;
+
+		//	Evicted mips can be read again once wanted
+		for (size_t v = first; v < evictions.size(); ++v)
+			entries[evictions[v].id]->readMip = evictions[v].residentMip;
+
+		id = candidates[i].second;
+		mip = e.readMip - 1;
+		return true;
+	}
+
+	starved = true;
+	return false;
+}
+
+void TextureStreamer::IOLoop(){
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;){
+		TextureId id = 0;
+		size_t mip = 0;
+		wake.wait(guard, [&]{ return quit || (pendingBytes < TEXTURE_MAX_PENDING && PickNext(id, mip)); });
+		if (quit)
+			return;
+
+		//	Entries never move once added, the pointer outlives the unlock
+		Entry* e = entries[id].get();
+		e->reading = true;
+		guard.unlock();
+
+		const DDSInfo& info = e->file.GetInfo();
+		size_t bytes = 0;
+		volatile size_t touched = 0;
+		for (size_t item = 0; item < info.arraySize; ++item){
+			const DDSSubresource& sub = e->file.GetSubresource(item, mip);
+			touched = touched + TouchPages(sub.data, sub.size);
+			bytes += sub.size;
+		}
+
+		guard.lock();
+		e->readMip = mip;
+		e->reading = false;
+		Completion done = { id, mip, bytes };
+		completions.push_back(done);
+		pendingBytes += bytes;
+		bytesRead += bytes;
+		++mipsRead;
+
+		//	The texture is free for the next mip, maybe for another thread
+		wake.notify_all();
+	}
+}
+
+size_t TextureStreamer::Update(size_t uploadBudget){
+	std::vector<TextureEviction> evicted;
+	std::vector<Completion> batch;
+	size_t used = 0;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		evicted.swap(evictions);
+
+		size_t taken = 0;
+		for (; taken < completions.size(); ++taken){
+			if (taken > 0 && used + completions[taken].bytes > uploadBudget)
+				break;
+			used += completions[taken].bytes;
+		}
+		batch.assign(completions.begin(), completions.begin() + taken);
+		completions.erase(completions.begin(), completions.begin() + taken);
+	}
+
+	//	Evictions first, they made the room the uploads are about to take
+	for (size_t i = 0; i < evicted.size(); ++i){
+		backend->Evict(evicted[i].id, evicted[i].residentMip);
+		entries[evicted[i].id]->residentMip = evicted[i].residentMip;
+	}
+
+	//	A texture's mips were queued coarse to fine, so publishing in order
+	//	only ever widens what can be sampled
+	for (size_t i = 0; i < batch.size(); ++i){
+		Entry& e = *entries[batch[i].id];
+		backend->Upload(batch[i].id, e.file, batch[i].mip);
+		backend->Publish(batch[i].id, batch[i].mip);
+		e.residentMip = batch[i].mip;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (size_t i = 0; i < batch.size(); ++i)
+			residency.Commit(batch[i].id);
+		pendingBytes -= used;
+		bytesUploaded += used;
+		residency.BeginFrame();
+	}
+	wake.notify_all();
+	return used;
+}
+
+bool TextureStreamer::IsIdle(){
+	std::lock_guard<std::mutex> guard(lock);
+	if (!completions.empty() || !evictions.empty())
+		return false;
+	for (size_t i = 0; i < entries.size(); ++i){
+		if (entries[i]->reading || (entries[i]->readMip > 0 && !starved))
+			return false;
+	}
+	return true;
+}
+
+size_t TextureStreamer::GetResidentMip(TextureId id){
+	std::lock_guard<std::mutex> guard(lock);
+	return id < entries.size() ? entries[id]->residentMip : 0;
+}
+
+TextureStreamStats TextureStreamer::GetStats(){
+	std::lock_guard<std::mutex> guard(lock);
+	TextureStreamStats stats;
+	stats.textures = entries.size();
+	stats.resident = 0;
+	for (size_t i = 0; i < entries.size(); ++i){
+		if (entries[i]->residentMip == 0)
+			++stats.resident;
+	}
+	stats.mipsRead = mipsRead;
+	stats.bytesRead = bytesRead;
+	stats.bytesUploaded = bytesUploaded;
+	stats.pendingBytes = pendingBytes;
+	return stats;
+}
+
+TextureResidencyStats TextureStreamer::GetResidencyStats(){
+	std::lock_guard<std::mutex> guard(lock);
+	return residency.GetStats();
+}
+#pragma endregion
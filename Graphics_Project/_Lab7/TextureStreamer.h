@@ -0,0 +1,181 @@
+#ifndef _TEXTURESTREAMER_H_
+#define _TEXTURESTREAMER_H_
+
+#include "DDSFile.h"
+#include "TextureResidency.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define TEXTURE_TAIL_SIZE			64				//	mips no bigger than this on both sides come in with the request
+#define TEXTURE_IO_THREADS			2
+#define TEXTURE_UPLOAD_BUDGET		(4 << 20)		//	bytes handed to the backend per Update
+#define TEXTURE_MAX_PENDING			(16 << 20)		//	read but not uploaded yet, the I/O threads wait past this
+
+//	Stand-ins until a texture's first mip is resident, RGBA8 as 0xAABBGGRR
+#define TEXTURE_FALLBACK_GREY		0xff808080
+#define TEXTURE_FALLBACK_NORMAL		0xffff8080		//	flat tangent space normal
+
+
+//	Where streamed mips end up. Every call comes from the thread calling
+//	TextureStreamer::Request / Update, so a backend can use its immediate context.
+class TextureBackend {
+
+public:
+	virtual ~TextureBackend(){}
+
+	//	Mips [firstMip, mipCount) of every item filled from file. firstMip ==
+	//	mipCount means nothing yet, sampling sees fallback (RGBA8) until the
+	//	first Publish.
+	virtual bool Create(TextureId id, const DDSFile& file, size_t firstMip, unsigned int fallback) = 0;
+
+	//	Fills mip of every item from file, always the next finer one
+	virtual void Upload(TextureId id, const DDSFile& file, size_t mip) = 0;
+
+	//	Sampling may use mips [residentMip, mipCount) from now on
+	virtual void Publish(TextureId id, size_t residentMip) = 0;
+
+	//	Drops the mips finer than residentMip and their memory, sampling
+	//	stops at residentMip
+	virtual void Evict(TextureId id, size_t residentMip) = 0;
+
+	virtual void Destroy(TextureId id) = 0;
+};
+
+//	No GPU: uploads are copies into system memory, enough to time the
+//	scheduler and check what lands where
+class HeadlessTextureBackend : public TextureBackend {
+
+	struct Texture {
+		std::unique_ptr<uint8_t[]> bytes;	//	whole chain, items one after another, left uninitialized like VRAM
+		std::vector<size_t> offsets;		//	per subresource, DDSFile order
+		std::vector<size_t> mipBytes;		//	every item of the mip
+		size_t residentMip;
+		size_t filledMip;					//	uploaded down to here, what the memory holds
+		size_t mipCount;
+	};
+
+	std::vector<std::unique_ptr<Texture>> textures;
+	size_t uploads;
+	size_t uploadedBytes;
+	size_t publishes;
+	size_t evictions;
+	size_t residentBytes;
+
+	void Copy(Texture& tex, const DDSFile& file, size_t mip);
+
+public:
+
+	HeadlessTextureBackend() : uploads(0), uploadedBytes(0), publishes(0), evictions(0), residentBytes(0){}
+
+	bool Create(TextureId id, const DDSFile& file, size_t firstMip, unsigned int fallback) override;
+	void Upload(TextureId id, const DDSFile& file, size_t mip) override;
+	void Publish(TextureId id, size_t residentMip) override;
+	void Evict(TextureId id, size_t residentMip) override;
+	void Destroy(TextureId id) override;
+
+	//	mipCount while only the fallback is there
+	size_t GetResidentMip(TextureId id) const;
+	//	Copy of subresource index (DDSFile order), meaningful once resident
+	const uint8_t* GetData(TextureId id, size_t subresource) const;
+
+	size_t GetUploads() const { return uploads; }
+	size_t GetUploadedBytes() const { return uploadedBytes; }
+	size_t GetPublishes() const { return publishes; }
+	size_t GetEvictions() const { return evictions; }
+	//	Filled mips of every texture, what a device would hold
+	size_t GetResidentBytes() const { return residentBytes; }
+};
+
+struct TextureStreamStats {
+	size_t textures;
+	size_t resident;				//	all mips in
+	size_t mipsRead;
+	size_t bytesRead;
+	size_t bytesUploaded;
+	size_t pendingBytes;			//	read, waiting for Update
+};
+
+//	Projected diameter in pixels of a sphere, the priority unit
+float TexturePriority(float radius, float distance, float projScale, float viewportHeight);
+
+//	Loads DDS textures coarse to fine. Request maps the file and uploads the
+//	mip tail (or a fallback colour when the finest mip is already bigger than
+//	TEXTURE_TAIL_SIZE) before returning, so a texture can be bound right away.
+//	The I/O threads then read one mip of one texture at a time, most wanted
+//	first: the score is priority over the mip's size, so a texture covering
+//	512 pixels wants its 256 mip more than a 64 pixel one wants its 128 mip.
+//	Read mips wait in a completion queue until Update uploads and publishes
+//	them on the calling (render) thread, within a byte budget per call.
+//	Every read first gets its room from a TextureResidency: Touch marks what
+//	the frame drew with, and going over the memory budget evicts the finest
+//	mips of what was drawn with least recently. Evicted mips stream back in
+//	once their texture is touched again.
+class TextureStreamer {
+
+	struct Entry {
+		DDSFile file;
+		float priority;
+		size_t residentMip;			//	render thread side, published
+		size_t readMip;				//	I/O side, read down to here
+		bool reading;
+	};
+
+	struct Completion {
+		TextureId id;
+		size_t mip;
+		size_t bytes;
+	};
+
+	TextureBackend* backend;
+	std::vector<std::unique_ptr<Entry>> entries;
+	std::vector<Completion> completions;
+	std::vector<TextureEviction> evictions;		//	decided by the I/O threads, applied by Update
+	std::vector<std::pair<float, TextureId>> candidates;
+	std::vector<std::thread> threads;
+	TextureResidency residency;
+
+	std::mutex lock;
+	std::condition_variable wake;
+	size_t pendingBytes;
+	size_t mipsRead;
+	size_t bytesRead;
+	size_t bytesUploaded;
+	bool starved;				//	the last pick had candidates and none fit the budget
+	bool quit;
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	bool PickNext(TextureId& id, size_t& mip);
+	void IOLoop();
+
+public:
+
+	TextureStreamer();
+	~TextureStreamer();
+
+	bool Initialize(TextureBackend* backend, unsigned int ioThreads = TEXTURE_IO_THREADS);
+	void Shutdown();
+
+	//	TEXTURE_INVALID when the file can't be opened or the backend refuses it
+	TextureId Request(const char* path, float priority, unsigned int fallback = TEXTURE_FALLBACK_GREY);
+	void SetPriority(TextureId id, float priority);
+	//	id is drawn with this frame
+	void Touch(TextureId id);
+	void SetBudget(size_t bytes);
+
+	//	Applies evictions, then uploads finished reads, at least one when any
+	//	are waiting, and starts the next frame of usage. Returns the bytes uploaded.
+	size_t Update(size_t uploadBudget = TEXTURE_UPLOAD_BUDGET);
+
+	//	Nothing left to read or upload that fits the budget
+	bool IsIdle();
+	size_t GetResidentMip(TextureId id);
+	TextureStreamStats GetStats();
+	TextureResidencyStats GetResidencyStats();
+};
+
+#endif
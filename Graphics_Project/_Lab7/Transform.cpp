@@ -0,0 +1,114 @@
+#include "Transform.h"
+
+#include <cmath>
+
+
+FLOAT4 QuatIdentity(){
+	return FLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+FLOAT4 QuatRotationX(float radians){
+	float half = radians * 0.5f;
+	return FLOAT4(-sin(half), 0.0f, 0.0f, cos(half));
+}
+
+FLOAT4 QuatRotationY(float radians){
+	float half = radians * 0.5f;
+	return FLOAT4(0.0f, -sin(half), 0.0f, cos(half));
+}
+
+FLOAT4 QuatRotationAxis(FLOAT3 axis, float radians){
+	float length = sqrt((axis.x * axis.x) + (axis.y * axis.y) + (axis.z * axis.z));
+	if (length == 0.0f)
+		return QuatIdentity();
+
+	float half = radians * 0.5f;
+	float s = -sin(half) / length;
+	return FLOAT4(axis.x * s, axis.y * s, axis.z * s, cos(half));
+}
+
+FLOAT4 QuatMultiply(FLOAT4 a, FLOAT4 b){
+	//	Hamilton product b * a, so a is applied first
+	FLOAT4 q;
+	q.x = (b.w * a.x) + (b.x * a.w) + (b.y * a.z) - (b.z * a.y);
+	q.y = (b.w * a.y) - (b.x * a.z) + (b.y * a.w) + (b.z * a.x);
+	q.z = (b.w * a.z) + (b.x * a.y) - (b.y * a.x) + (b.z * a.w);
+	q.w = (b.w * a.w) - (b.x * a.x) - (b.y * a.y) - (b.z * a.z);
+	return q;
+}
+
+FLOAT4 QuatNormalize(FLOAT4 q){
+	float length = sqrt((q.x * q.x) + (q.y * q.y) + (q.z * q.z) + (q.w * q.w));
+	if (length == 0.0f)
+		return QuatIdentity();
+	return FLOAT4(q.x / length, q.y / length, q.z / length, q.w / length);
+}
+
+FLOAT3 QuatRotate(FLOAT4 q, FLOAT3 v){
+	//	v + w * t + cross(q.xyz, t), t = 2 * cross(q.xyz, v)
+	float tx = 2.0f * ((q.y * v.z) - (q.z * v.y));
+	float ty = 2.0f * ((q.z * v.x) - (q.x * v.z));
+	float tz = 2.0f * ((q.x * v.y) - (q.y * v.x));
+
+	FLOAT3 out;
+	out.x = v.x + (q.w * tx) + ((q.y * tz) - (q.z * ty));
+	out.y = v.y + (q.w * ty) + ((q.z * tx) - (q.x * tz));
+	out.z = v.z + (q.w * tz) + ((q.x * ty) - (q.y * tx));
+	return out;
+}
+
+
+Transform::Transform()
+	: position(0.0f, 0.0f, 0.0f), rotation(0.0f, 0.0f, 0.0f, 1.0f), scale(1.0f, 1.0f, 1.0f){}
+
+Transform::Transform(FLOAT3 _position, FLOAT4 _rotation, FLOAT3 _scale)
+	: position(_position), rotation(_rotation), scale(_scale){}
+
+MATRIX4X4 Transform::ToMatrix() const{
+	const FLOAT4& q = rotation;
+
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	MATRIX4X4 m = {
+		scale.x * (1.0f - 2.0f * (yy + zz)), scale.x * (2.0f * (xy + wz)), scale.x * (2.0f * (xz - wy)), 0.0f,
+		scale.y * (2.0f * (xy - wz)), scale.y * (1.0f - 2.0f * (xx + zz)), scale.y * (2.0f * (yz + wx)), 0.0f,
+		scale.z * (2.0f * (xz + wy)), scale.z * (2.0f * (yz - wx)), scale.z * (1.0f - 2.0f * (xx + yy)), 0.0f,
+		position.x, position.y, position.z, 1.0f
+	};
+	return m;
+}
+
+MATRIX4X4 Transform::ToInverseMatrix() const{
+	const FLOAT4& q = rotation;
+
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	//	Rotation rows
+	FLOAT3 r0(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy));
+	FLOAT3 r1(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx));
+	FLOAT3 r2(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy));
+
+	float ix = 1.0f / scale.x, iy = 1.0f / scale.y, iz = 1.0f / scale.z;
+
+	//	Translate^-1 * Rotate^T * Scale^-1
+	float tx = -((position.x * r0.x) + (position.y * r0.y) + (position.z * r0.z));
+	float ty = -((position.x * r1.x) + (position.y * r1.y) + (position.z * r1.z));
+	float tz = -((position.x * r2.x) + (position.y * r2.y) + (position.z * r2.z));
+
+	MATRIX4X4 m = {
+		r0.x * ix, r1.x * iy, r2.x * iz, 0.0f,
+		r0.y * ix, r1.y * iy, r2.y * iz, 0.0f,
+		r0.z * ix, r1.z * iy, r2.z * iz, 0.0f,
+		tx * ix, ty * iy, tz * iz, 1.0f
+	};
+	return m;
+}
+
+void ToMatrixBatch(const Transform* in, MATRIX4X4* out, size_t n){
+	for (size_t x = 0; x < n; ++x)
+		out[x] = in[x].ToMatrix();
+}
@@ -0,0 +1,46 @@
+#ifndef _TRANSFORM_H_
+#define _TRANSFORM_H_
+
+#include "Defines.h"
+#include <cstddef>
+
+
+//	Quaternions are stored in a FLOAT4 as (x, y, z, w). The rotation helpers
+//	turn the same way as RotateX / RotateY in MathFunc, so a Transform can
+//	stand in for an Identity -> Rotate -> Translate -> Scale chain.
+
+FLOAT4 QuatIdentity();
+
+FLOAT4 QuatRotationX(float radians);
+
+FLOAT4 QuatRotationY(float radians);
+
+FLOAT4 QuatRotationAxis(FLOAT3 axis, float radians);
+
+//	Rotation a followed by rotation b
+FLOAT4 QuatMultiply(FLOAT4 a, FLOAT4 b);
+
+FLOAT4 QuatNormalize(FLOAT4 q);
+
+//	v * rotationMatrix(q)
+FLOAT3 QuatRotate(FLOAT4 q, FLOAT3 v);
+
+
+struct Transform{
+	FLOAT3 position;
+	FLOAT4 rotation;
+	FLOAT3 scale;
+
+	Transform();
+	Transform(FLOAT3 _position, FLOAT4 _rotation, FLOAT3 _scale);
+
+	//	Scale * Rotate * Translate, written out directly
+	MATRIX4X4 ToMatrix() const;
+
+	//	Inverse of ToMatrix() without a general 4x4 inverse
+	MATRIX4X4 ToInverseMatrix() const;
+};
+
+void ToMatrixBatch(const Transform* in, MATRIX4X4* out, size_t n);
+
+#endif
@@ -15,7 +15,7 @@ struct VS_OUTPUT {
 };
 
 
-VS_OUTPUT main(float3 inPos : POSITION, float2 inTexCoord : TEXCOORD, float3 inNorm : COLOR, float3 inTan : TANGENT) {
+VS_OUTPUT main(float3 inPos : POSITION, float2 inTexCoord : TEXCOORD, float3 inNorm : COLOR, float4 inTan : TANGENT) {
 	VS_OUTPUT output = (VS_OUTPUT)0;
 
 	output.pos = mul(float4(inPos, 1.0f), WVP);
@@ -24,9 +24,10 @@ VS_OUTPUT main(float3 inPos : POSITION, float2 inTexCoord : TEXCOORD, float3 inN
 
 	output.norm = mul(inNorm, World);
 
-	output.tangent = mul(inTan, World);
+	output.tangent = mul(inTan.xyz, World);
 
-	float3 bi = cross(inNorm, inTan);
+	//	w flips the bitangent where the uvs are mirrored
+	float3 bi = cross(inNorm, inTan.xyz) * inTan.w;
 	output.biTan = mul(bi, World);
 	
 	output.tex = inTexCoord;
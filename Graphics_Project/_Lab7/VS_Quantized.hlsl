@@ -0,0 +1,47 @@
+#pragma pack_matrix(row_major)
+
+Texture2D ObjTexture;
+SamplerState ObjSamplerState;
+
+cbuffer cbPerObject : register(b0) {
+	float4x4 WVP;
+	float4x4 World;
+};
+
+//	Mesh bounds, PackedVert positions are 0..1 inside them
+cbuffer cbQuantize : register(b1) {
+	float4 posOffset;
+	float4 posScale;
+};
+
+struct VS_OUTPUT {
+	float4 Pos : SV_POSITION;
+	float4 worldPos : TEXCOORD1;
+	float2 TexCoord : TEXCOORD;
+	float3 Normal : COLOR;
+};
+
+//	Same steps as OctDecode in VertexFormat.cpp
+float3 OctDecode(float2 e) {
+	float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-n.z);
+	n.xy += (n.xy >= 0.0f) ? -t : t;
+	return normalize(n);
+}
+
+
+VS_OUTPUT main(float4 inPos : POSITION, float2 inTexCoord : TEXCOORD, float2 inNorm : COLOR) {
+	VS_OUTPUT output;
+
+	float4 pos = float4(posOffset.xyz + inPos.xyz * posScale.xyz, 1.0f);
+
+	output.Pos = mul(pos, WVP);
+
+	output.worldPos = mul(pos, World);
+
+	output.Normal = mul(OctDecode(inNorm), (float3x3)World);
+
+	output.TexCoord = inTexCoord;
+
+	return output;
+}
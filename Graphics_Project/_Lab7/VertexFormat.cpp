@@ -0,0 +1,305 @@
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#define UNORM16_MAX		65535.0f
+#define SNORM16_MAX		32767.0f
+
+
+#pragma region Layouts
+unsigned int DescribeVert(MeshVertexElement* elements){
+	elements[0].attribute = MESH_ATTR_POSITION;
+	elements[0].format = MESH_FMT_FLOAT3;
+	elements[0].offset = offsetof(Vert, Pos);
+
+	elements[1].attribute = MESH_ATTR_TEXCOORD;
+	elements[1].format = MESH_FMT_FLOAT2;
+	elements[1].offset = offsetof(Vert, Uvs);
+
+	elements[2].attribute = MESH_ATTR_NORMAL;
+	elements[2].format = MESH_FMT_FLOAT3;
+	elements[2].offset = offsetof(Vert, Norms);
+
+	elements[3].attribute = MESH_ATTR_TANGENT;
+	elements[3].format = MESH_FMT_FLOAT4;
+	elements[3].offset = offsetof(Vert, tangent);
+
+	return 4;
+}
+
+unsigned int DescribePackedVert(MeshVertexElement* elements){
+	elements[0].attribute = MESH_ATTR_POSITION;
+	elements[0].format = MESH_FMT_UNORM16X4;
+	elements[0].offset = offsetof(PackedVert, pos);
+
+	elements[1].attribute = MESH_ATTR_TEXCOORD;
+	elements[1].format = MESH_FMT_HALF2;
+	elements[1].offset = offsetof(PackedVert, uv);
+
+	elements[2].attribute = MESH_ATTR_NORMAL;
+	elements[2].format = MESH_FMT_OCT16;
+	elements[2].offset = offsetof(PackedVert, normal);
+
+	elements[3].attribute = MESH_ATTR_TANGENT;
+	elements[3].format = MESH_FMT_OCT16;
+	elements[3].offset = offsetof(PackedVert, tangent);
+
+	return 4;
+}
+
+const char* MeshAttributeSemantic(unsigned int attribute){
+	static const char* semantics[] = { "POSITION", "TEXCOORD", "COLOR", "TANGENT" };
+	return (attribute < 4) ? semantics[attribute] : "";
+}
+
+unsigned int MeshFormatComponents(unsigned int format){
+	static const unsigned int components[] = { 2, 3, 4, 2, 2, 4 };
+	return (format < 6) ? components[format] : 0;
+}
+
+#ifdef _WIN32
+void BuildInputLayout(const MeshVertexElement* elements, unsigned int count, D3D11_INPUT_ELEMENT_DESC* out){
+	static const DXGI_FORMAT formats[] = {
+		DXGI_FORMAT_R32G32_FLOAT,
+		DXGI_FORMAT_R32G32B32_FLOAT,
+		DXGI_FORMAT_R16G16B16A16_UNORM,
+		DXGI_FORMAT_R16G16_FLOAT,
+		DXGI_FORMAT_R16G16_SNORM,
+		DXGI_FORMAT_R32G32B32A32_FLOAT
+	};
+
+	for (unsigned int i = 0; i < count; ++i){
+		out[i].SemanticName = MeshAttributeSemantic(elements[i].attribute);
+		out[i].SemanticIndex = 0;
+		out[i].Format = formats[elements[i].format];
+		out[i].InputSlot = 0;
+		out[i].AlignedByteOffset = elements[i].offset;
+		out[i].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+		out[i].InstanceDataStepRate = 0;
+	}
+}
+#endif
+#pragma endregion
+
+#pragma region Scalar Packing
+//	Round to nearest even like the GPU does, overflow goes to infinity
+unsigned short FloatToHalf(float f){
+	unsigned int x;
+	memcpy(&x, &f, sizeof(x));
+
+	unsigned int sign = (x >> 16) & 0x8000;
+	unsigned int absx = x & 0x7FFFFFFF;
+
+	//	Inf / NaN, NaN keeps a mantissa bit
+	if (absx >= 0x7F800000)
+		return (unsigned short)(sign | 0x7C00 | (absx > 0x7F800000 ? 0x200 : 0));
+
+	//	65520 and up round past the largest half (65504)
+	if (absx >= 0x477FF000)
+		return (unsigned short)(sign | 0x7C00);
+
+	//	Under 2^-25 everything rounds to zero
+	if (absx < 0x33000000)
+		return (unsigned short)sign;
+
+	unsigned int half, rem, halfway;
+	if (absx < 0x38800000){
+		//	Half denormal, mantissa counts in steps of 2^-24
+		unsigned int shift = 113 - (absx >> 23) + 13;
+		unsigned int mant = (absx & 0x7FFFFF) | 0x800000;
+		half = mant >> shift;
+		rem = mant & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+	}
+	else {
+		//	Rebias the exponent from 127 to 15
+		half = (absx - 0x38000000) >> 13;
+		rem = absx & 0x1FFF;
+		halfway = 0x1000;
+	}
+
+	//	A carry out of the mantissa correctly bumps the exponent
+	if (rem > halfway || (rem == halfway && (half & 1)))
+		++half;
+	return (unsigned short)(sign | half);
+}
+
+float HalfToFloat(unsigned short h){
+	unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+	unsigned int exponent = (h >> 10) & 0x1F;
+	unsigned int mant = h & 0x3FF;
+	unsigned int x;
+
+	if (exponent == 0x1F)
+		x = sign | 0x7F800000 | (mant << 13);
+	else if (exponent != 0)
+		x = sign | ((exponent + 112) << 23) | (mant << 13);
+	else if (mant == 0)
+		x = sign;
+	else {
+		//	Denormal half is a normal float
+		exponent = 113;
+		while (!(mant & 0x400)){
+			mant <<= 1;
+			--exponent;
+		}
+		x = sign | (exponent << 23) | ((mant & 0x3FF) << 13);
+	}
+
+	float f;
+	memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+static inline unsigned short ToUnorm16(float v){
+	v = std::min(std::max(v, 0.0f), 1.0f);
+	return (unsigned short)(v * UNORM16_MAX + 0.5f);
+}
+
+static inline float FromSnorm16(short v){
+	//	-32768 and -32767 both mean -1
+	return std::max((float)v / SNORM16_MAX, -1.0f);
+}
+#pragma endregion
+
+#pragma region Octahedral
+//	Same steps as OctDecode in VS_Quantized.hlsl
+static FLOAT3 OctDecode(float x, float y){
+	FLOAT3 n(x, y, 1.0f - fabsf(x) - fabsf(y));
+	float t = std::max(-n.z, 0.0f);
+	n.x += (n.x >= 0.0f) ? -t : t;
+	n.y += (n.y >= 0.0f) ? -t : t;
+
+	float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+	return FLOAT3(n.x / len, n.y / len, n.z / len);
+}
+
+FLOAT3 OctDecode(const short in[2]){
+	return OctDecode(FromSnorm16(in[0]), FromSnorm16(in[1]));
+}
+
+//	Projects onto the octahedron, folds the lower half over the diagonals and
+//	then keeps whichever of the four neighbouring grid points decodes closest
+void OctEncode(const FLOAT3& n, short out[2]){
+	float len = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if (len == 0.0f){
+		out[0] = out[1] = 0;
+		return;
+	}
+
+	float x = n.x / len;
+	float y = n.y / len;
+	if (n.z < 0.0f){
+		float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = fx;
+		y = fy;
+	}
+
+	float unit = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+	float sx = floorf(x * SNORM16_MAX);
+	float sy = floorf(y * SNORM16_MAX);
+	float best = -2.0f;
+
+	for (int i = 0; i < 4; ++i){
+		float cx = std::min(std::max(sx + (i & 1), -SNORM16_MAX), SNORM16_MAX);
+		float cy = std::min(std::max(sy + (i >> 1), -SNORM16_MAX), SNORM16_MAX);
+
+		FLOAT3 d = OctDecode(cx / SNORM16_MAX, cy / SNORM16_MAX);
+		float dot = (d.x * n.x + d.y * n.y + d.z * n.z) / unit;
+		if (dot > best){
+			best = dot;
+			out[0] = (short)cx;
+			out[1] = (short)cy;
+		}
+	}
+}
+#pragma endregion
+
+#pragma region Mesh
+void GetDequantizeParams(const AABB& bounds, FLOAT4& offset, FLOAT4& scale){
+	offset = FLOAT4(bounds.min.x, bounds.min.y, bounds.min.z, 0.0f);
+	scale = FLOAT4(bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z, 1.0f);
+}
+
+void QuantizeVerts(const Vert* in, size_t count, const AABB& bounds, PackedVert* out){
+	FLOAT4 offset, scale;
+	GetDequantizeParams(bounds, offset, scale);
+
+	//	A flat axis stores 0 and decodes back to the bound
+	float invX = scale.x > 0.0f ? 1.0f / scale.x : 0.0f;
+	float invY = scale.y > 0.0f ? 1.0f / scale.y : 0.0f;
+	float invZ = scale.z > 0.0f ? 1.0f / scale.z : 0.0f;
+
+	for (size_t i = 0; i < count; ++i){
+		const Vert& v = in[i];
+		PackedVert& p = out[i];
+
+		p.pos[0] = ToUnorm16((v.Pos.x - offset.x) * invX);
+		p.pos[1] = ToUnorm16((v.Pos.y - offset.y) * invY);
+		p.pos[2] = ToUnorm16((v.Pos.z - offset.z) * invZ);
+		p.pos[3] = v.tangent.w < 0.0f ? 0 : (unsigned short)UNORM16_MAX;
+
+		p.uv[0] = FloatToHalf(v.Uvs.u);
+		p.uv[1] = FloatToHalf(v.Uvs.v);
+
+		OctEncode(v.Norms, p.normal);
+		OctEncode(FLOAT3(v.tangent.x, v.tangent.y, v.tangent.z), p.tangent);
+	}
+}
+
+void DequantizeVerts(const PackedVert* in, size_t count, const AABB& bounds, Vert* out){
+	FLOAT4 offset, scale;
+	GetDequantizeParams(bounds, offset, scale);
+
+	for (size_t i = 0; i < count; ++i){
+		const PackedVert& p = in[i];
+		Vert& v = out[i];
+
+		v.Pos.x = offset.x + (float)p.pos[0] / UNORM16_MAX * scale.x;
+		v.Pos.y = offset.y + (float)p.pos[1] / UNORM16_MAX * scale.y;
+		v.Pos.z = offset.z + (float)p.pos[2] / UNORM16_MAX * scale.z;
+
+		v.Uvs.u = HalfToFloat(p.uv[0]);
+		v.Uvs.v = HalfToFloat(p.uv[1]);
+
+		v.Norms = OctDecode(p.normal);
+		FLOAT3 t = OctDecode(p.tangent);
+		v.tangent = FLOAT4(t.x, t.y, t.z, p.pos[3] ? 1.0f : -1.0f);
+	}
+}
+
+static float AngleDegrees(const FLOAT3& a, const FLOAT3& b){
+	float la = sqrtf(a.x * a.x + a.y * a.y + a.z * a.z);
+	float lb = sqrtf(b.x * b.x + b.y * b.y + b.z * b.z);
+	if (la == 0.0f || lb == 0.0f)
+		return 0.0f;
+
+	double c = ((double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z) / ((double)la * lb);
+	return (float)(acos(std::min(std::max(c, -1.0), 1.0)) * (180.0 / 3.14159265358979323846));
+}
+
+QuantizeError MeasureQuantizeError(const Vert* original, const PackedVert* packed, size_t count, const AABB& bounds){
+	QuantizeError error = { 0.0f, 0.0f, 0.0f, 0.0f, 0 };
+
+	for (size_t i = 0; i < count; ++i){
+		const Vert& a = original[i];
+		Vert b;
+		DequantizeVerts(packed + i, 1, bounds, &b);
+
+		error.position = std::max(error.position, fabsf(a.Pos.x - b.Pos.x));
+		error.position = std::max(error.position, fabsf(a.Pos.y - b.Pos.y));
+		error.position = std::max(error.position, fabsf(a.Pos.z - b.Pos.z));
+		error.uv = std::max(error.uv, fabsf(a.Uvs.u - b.Uvs.u));
+		error.uv = std::max(error.uv, fabsf(a.Uvs.v - b.Uvs.v));
+		error.normalDegrees = std::max(error.normalDegrees, AngleDegrees(a.Norms, b.Norms));
+		error.tangentDegrees = std::max(error.tangentDegrees, AngleDegrees(FLOAT3(a.tangent.x, a.tangent.y, a.tangent.z), FLOAT3(b.tangent.x, b.tangent.y, b.tangent.z)));
+		if ((a.tangent.w < 0.0f) != (b.tangent.w < 0.0f))
+			++error.signFlips;
+	}
+	return error;
+}
+#pragma endregion
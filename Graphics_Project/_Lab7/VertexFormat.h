@@ -0,0 +1,85 @@
+#ifndef _VERTEXFORMAT_H_
+#define _VERTEXFORMAT_H_
+
+#include "Defines.h"
+#include "BVH.h"
+#include <cstddef>
+
+#define MESH_MAX_ELEMENTS		8
+
+
+enum MeshAttribute {
+	MESH_ATTR_POSITION = 0,
+	MESH_ATTR_TEXCOORD,
+	MESH_ATTR_NORMAL,
+	MESH_ATTR_TANGENT
+};
+
+enum MeshFormat {
+	MESH_FMT_FLOAT2 = 0,
+	MESH_FMT_FLOAT3,
+	MESH_FMT_UNORM16X4,		//	position inside the mesh bounds, w carries the tangent sign
+	MESH_FMT_HALF2,
+	MESH_FMT_OCT16,			//	unit vector, octahedral map in two snorm16
+	MESH_FMT_FLOAT4
+};
+
+//	One vertex attribute, mirrors a D3D11_INPUT_ELEMENT_DESC
+struct MeshVertexElement{
+	unsigned int attribute;		//	MeshAttribute
+	unsigned int format;		//	MeshFormat
+	unsigned int offset;		//	bytes from the start of the vertex
+};
+
+//	Compressed Vert, 20 bytes instead of 48. pos[3] is 1 for a tangent
+//	sign of +1 and 0 for -1, the shader builds w = 1 itself.
+struct PackedVert{
+	unsigned short pos[4];
+	unsigned short uv[2];
+	short normal[2];
+	short tangent[2];
+};
+
+//	Worst error of a packed mesh against the floats it came from
+struct QuantizeError{
+	float position;			//	world units
+	float uv;
+	float normalDegrees;
+	float tangentDegrees;
+	unsigned int signFlips;		//	tangent signs that did not survive, should be 0
+};
+
+//	Element tables for Vert / PackedVert, return the element count.
+//	Position, texcoord and normal come first so a prefix suits shaders
+//	without tangents.
+unsigned int DescribeVert(MeshVertexElement* elements);
+unsigned int DescribePackedVert(MeshVertexElement* elements);
+
+//	Shader semantic an attribute binds to, normals use COLOR like the
+//	existing shaders
+const char* MeshAttributeSemantic(unsigned int attribute);
+
+//	Values a format hands the shader, as float components
+unsigned int MeshFormatComponents(unsigned int format);
+
+#ifdef _WIN32
+//	Input layout for slot 0 from an element table, out needs count entries
+void BuildInputLayout(const MeshVertexElement* elements, unsigned int count, D3D11_INPUT_ELEMENT_DESC* out);
+#endif
+
+unsigned short FloatToHalf(float f);
+float HalfToFloat(unsigned short h);
+
+void OctEncode(const FLOAT3& n, short out[2]);
+FLOAT3 OctDecode(const short in[2]);
+
+//	bounds is normally the mesh's own (MeshView::bounds), positions outside are clamped
+void QuantizeVerts(const Vert* in, size_t count, const AABB& bounds, PackedVert* out);
+void DequantizeVerts(const PackedVert* in, size_t count, const AABB& bounds, Vert* out);
+
+QuantizeError MeasureQuantizeError(const Vert* original, const PackedVert* packed, size_t count, const AABB& bounds);
+
+//	posOffset / posScale for the cbQuantize constant buffer
+void GetDequantizeParams(const AABB& bounds, FLOAT4& offset, FLOAT4& scale);
+
+#endif
@@ -1,8 +1,23 @@
 #include "MathFunc.h"
+#include "MathSIMD.h"
+#include "Transform.h"
+#include "FrustumCull.h"
+#include "BVH.h"
+#include "LooseOctree.h"
+#include "OcclusionCull.h"
+#include "ObjLoader.h"
+#include "MeshOptimize.h"
+#include "MeshCache.h"
+#include "VertexFormat.h"
+#include "Meshlet.h"
+#include "TangentSpace.h"
+#include "MeshSimplify.h"
+#include "JobSystem.h"
 #include "TimerClass.h"
 #include "FPSClass.h"
 #include "CPUClass.h"
-#include "DDSTextureLoader.h"
+#include "TextureStreamer.h"
+#include "TextureBackendD3D11.h"
 
 #include <ctime>
 #include <string>
@@ -13,6 +28,7 @@
 #include "VS_Star.csh"
 #include "PS_Star.csh"
 #include "VS_Norm.csh"
+#include "VS_Quantized.csh"
 #include "PS_Norm.csh"
 #include "VS_Skybox.csh"
 #include "PS_Skybox.csh"
@@ -26,6 +42,24 @@
 #define BUFFER_WIDTH	1024
 #define BUFFER_HEIGHT	768
 
+//	Below this many instances the culling jobs cost more than they save.
+//	About twice the break even Benchmarks/CullBench estimates for 2 to 8 cores
+#define PARALLEL_CULL_MIN	32768
+
+//	Below this many instances the flat SIMD test beats walking the BVH,
+//	Benchmarks/BVHBench has them cross between 1k and 4k trees
+#define BVH_CULL_MIN		4096
+
+//	CPU depth buffer for occlusion culling, a quarter of the back buffer
+#define OCCLUSION_WIDTH		(BUFFER_WIDTH / 4)
+#define OCCLUSION_HEIGHT	(BUFFER_HEIGHT / 4)
+
+//	A tree switches to a coarser level once that level's error covers less than this many pixels
+#define TREE_LOD_PIXEL_ERROR	1.0f
+
+//	Off screen objects keep streaming, behind everything on screen
+#define TEXTURE_HIDDEN_SCALE	0.01f
+
 
 class GraphicsProject {
 
@@ -47,6 +81,7 @@ class GraphicsProject {
 	ID3D11InputLayout*		starLayout = nullptr;
 	ID3D11InputLayout*		normMapLayout = nullptr;
 	ID3D11InputLayout*		instLayout = nullptr;
+	ID3D11InputLayout*		quantLayout = nullptr;
 	
 	ID3D11Texture2D*		dsBuffer = nullptr;
 	ID3D11DepthStencilView* dsView = nullptr;
@@ -57,6 +92,7 @@ class GraphicsProject {
 	//	Buffers
 	ID3D11Buffer*			cbPerObjectBuffer = nullptr;
 	ID3D11Buffer*			cbPerFrameBuffer = nullptr;
+	ID3D11Buffer*			cbQuantizeLink = nullptr;
 
 	ID3D11Buffer*			vbSkybox = nullptr;
 	ID3D11Buffer*			vbCube = nullptr;
@@ -74,6 +110,12 @@ class GraphicsProject {
 	ID3D11Buffer*			ibStar = nullptr;
 	ID3D11Buffer*			ibTree = nullptr;
 
+	//	Loaded models get 16 bit indices when they have few enough vertices
+	DXGI_FORMAT				ibFormatSkybox = DXGI_FORMAT_R32_UINT;
+	DXGI_FORMAT				ibFormatLink = DXGI_FORMAT_R32_UINT;
+	DXGI_FORMAT				ibFormatBarrel = DXGI_FORMAT_R32_UINT;
+	DXGI_FORMAT				ibFormatTree = DXGI_FORMAT_R32_UINT;
+
 	ID3D11Buffer*			treeInstanceBuff = nullptr;
 
 	//	Shaders
@@ -82,6 +124,7 @@ class GraphicsProject {
 	ID3D11VertexShader*		vsSkybox = nullptr;
 	ID3D11VertexShader*		vsNorm = nullptr;
 	ID3D11VertexShader*		vsInst = nullptr;
+	ID3D11VertexShader*		vsQuant = nullptr;
 
 	ID3D11PixelShader*		ps = nullptr;
 	ID3D11PixelShader*		psStar = nullptr;
@@ -97,14 +140,16 @@ class GraphicsProject {
 	ID3D11RasterizerState*	rState_Wire = nullptr;
 	ID3D11RasterizerState*	rState_None = nullptr;
 
-	//	Textures
-	ID3D11ShaderResourceView* srvSkymap = nullptr;
-	ID3D11ShaderResourceView* srvGlass = nullptr;	
-	ID3D11ShaderResourceView* srvGrass = nullptr;
-	ID3D11ShaderResourceView* srvGround = nullptr;
-	ID3D11ShaderResourceView* srvBarrel = nullptr;
-	ID3D11ShaderResourceView* srvBarrelN = nullptr;	
-	ID3D11ShaderResourceView* srvBark = nullptr;
+	//	Textures, the mip tails load up front and the rest streams in
+	D3D11TextureBackend		textureBackend;
+	TextureStreamer			textureStreamer;
+	TextureId				texSkymap = TEXTURE_INVALID;
+	TextureId				texGlass = TEXTURE_INVALID;
+	TextureId				texGrass = TEXTURE_INVALID;
+	TextureId				texGround = TEXTURE_INVALID;
+	TextureId				texBarrel = TEXTURE_INVALID;
+	TextureId				texBarrelN = TEXTURE_INVALID;
+	TextureId				texBark = TEXTURE_INVALID;
 
 	//	Samp & Blend States
 	ID3D11SamplerState*		ssCube = nullptr;
@@ -119,7 +164,16 @@ class GraphicsProject {
 	//	Frustum Culling
 	vector<FLOAT3> treeAABB;
 	int numTreesToDraw = 0;
+	unsigned int numTrees = NUMTREES;		//	-trees N on the command line
+	bool flatCull = false;					//	-flatcull, no BVH whatever the count
 	vector<InstanceData> treeInstData;
+	InstanceSoA		treeInstSoA;
+	vector<unsigned int> visibleTrees;
+	vector<InstanceData> treeUpload;		//	visible instances packed for the upload
+	CullScratch		cullScratch;
+	BVH				treeBVH;
+	BVHCullCache	treeCullCache;
+	CullStats		cullStats;
 
 	//	cBuffer structs
 	cbPerFrame		constbuffPerFrame;	
@@ -133,6 +187,22 @@ class GraphicsProject {
 	Model*			skyboxModel = nullptr;
 	Model*			treeModel = nullptr;
 
+	//	What gets uploaded / rasterized, mapped from the .mesh caches when they are current
+	MeshCache		cacheLink, cacheBarrel, cacheSkybox, cacheTree;
+	MeshView		viewLink, viewBarrel, viewSkybox, viewTree;
+
+	//	Link is drawn per meshlet, frustum and back facing clusters are skipped
+	MeshletSet				linkMeshlets;
+	vector<unsigned int>	visibleMeshlets;
+	size_t					meshletTrisCulled = 0;
+
+	//	Tree levels of detail share ibTree, visible instances are bucketed per level
+	MeshLOD			treeLods[MESH_MAX_LODS];
+	unsigned int	treeLodCount = 1;
+	unsigned int	treeLodInstances[MESH_MAX_LODS];
+	unsigned int	treeLodStart[MESH_MAX_LODS];
+	vector<unsigned char> treeLodOf;		//	level picked for each visible tree this frame
+
 	//	Worlds
 	MATRIX4X4		WVP;
 	MATRIX4X4		cube1World;
@@ -140,15 +210,33 @@ class GraphicsProject {
 	MATRIX4X4		cube3World;
 	MATRIX4X4		cube4World;
 	MATRIX4X4		linkWorld;
+	MATRIX4X4		linkInverse;
 	MATRIX4X4		barrelWorld;
 	MATRIX4X4		skyboxWorld;
 	MATRIX4X4		groundWorld;
 	MATRIX4X4		starWorld;
 	MATRIX4X4		treeWorld;
 
+	//	World * ViewProj, built in one batch per frame
+	enum { OBJ_STAR, OBJ_GROUND, OBJ_LINK, OBJ_BARREL, OBJ_TREE,
+		OBJ_CUBE1, OBJ_CUBE2, OBJ_CUBE3, OBJ_CUBE4, OBJ_COUNT };
+	MATRIX4X4		batchWorld[OBJ_COUNT];
+	MATRIX4X4		batchWVP[OBJ_COUNT];
+
+	//	Movable objects by world bounds, only drawn while in the frustum
+	LooseOctree		sceneIndex;
+	AABB			localBounds[OBJ_COUNT];
+	bool			objVisible[OBJ_COUNT];
+	bool			objOccluder[OBJ_COUNT];		//	opaque, goes in the occlusion buffer
+	vector<unsigned int> visibleObjects;
+
+	//	The solid cube & Link hide the trees behind them
+	OcclusionBuffer	occlusion;
+
 	//	Camera
 	MATRIX4X4		camView;
 	MATRIX4X4		camProjection;
+	MATRIX4X4		camViewProj;
 
 	MATRIX4X4		mapView;
 	MATRIX4X4		mapProjection;
@@ -166,12 +254,15 @@ class GraphicsProject {
 	FPSClass				fpsTracker;
 	TimerClass				timeTracker;
 	CpuClass				cpuTracker;
+	JobSystem				jobSystem;
 
 public:
 
 	GraphicsProject();
 	GraphicsProject(HINSTANCE hinst, WNDPROC proc);
 
+	void SetTreeCount(unsigned int count) { numTrees = count; }
+	void SetFlatCull(bool flat) { flatCull = flat; }
 	bool InitScene();
 	bool Update();
 	bool Render();
@@ -183,17 +274,21 @@ public:
 	bool InitDirectInput(HINSTANCE hInstance);
 	void DetectInput(double time, float w, float h);
 	
-	void ComputeTangents(Model*);
-	UINT FindNumIndicies(ID3D11Buffer*);
-
-	void cullAABB(std::vector<FLOAT4> &frustumPlanes);
-	std::vector<FLOAT4> getFrustumPlanes(MATRIX4X4& viewProj);
+	UINT FindNumIndicies(ID3D11Buffer*, DXGI_FORMAT format = DXGI_FORMAT_R32_UINT);
+	HRESULT CreateIndexBuffer(const MeshView& mesh, ID3D11Buffer** ib, DXGI_FORMAT* format);
+	void DrawSubMeshes(const MeshView& mesh);
+
+	void drawOccluders();
+	void cullAABB(const Frustum& frustum);
+	void prioritizeTextures();
+	void bindTexture(UINT slot, TextureId id);
+	Frustum getFrustumPlanes(const MATRIX4X4& viewProj);
 };
 
 
 GraphicsProject* pApp = nullptr;
 
-bool loadOBJ(const char* path, ID3D11Device* d, Model* m);
+bool loadOBJ(const char* path, ID3D11Device* d, Model* m, MeshCache* cache, MeshView* view, bool tangents, JobSystem* jobs);
 
 
 GraphicsProject::GraphicsProject(HINSTANCE hinst, WNDPROC proc){
@@ -229,6 +324,7 @@ GraphicsProject::GraphicsProject(HINSTANCE hinst, WNDPROC proc){
 	fpsTracker.Initialize();
 	timeTracker.Initialize();
 	cpuTracker.Initialize();
+	jobSystem.Initialize();
 
 	if (!InitDirectInput(hinst)){
 		MessageBox(0, L"Direct Input Initialization - Failed",
@@ -392,20 +488,25 @@ bool GraphicsProject::InitScene(){
 	skyboxModel = new Model;
 	treeModel = new Model;	
 
-	threads.push_back(thread(loadOBJ, "Link.obj", pApp->device, linkModel));
-	threads.push_back(thread(loadOBJ, "Cube.obj", pApp->device, skyboxModel));
-	threads.push_back(thread(loadOBJ, "Barrel.obj", pApp->device, barrelModel));
-	threads.push_back(thread(loadOBJ, "Tree.obj", pApp->device, treeModel));
+	//	The loaders share the job system for parsing and tangents
+	threads.push_back(thread(loadOBJ, "Link.obj", pApp->device, linkModel, &cacheLink, &viewLink, false, &jobSystem));
+	threads.push_back(thread(loadOBJ, "Cube.obj", pApp->device, skyboxModel, &cacheSkybox, &viewSkybox, false, &jobSystem));
+	threads.push_back(thread(loadOBJ, "Barrel.obj", pApp->device, barrelModel, &cacheBarrel, &viewBarrel, true, &jobSystem));
+	threads.push_back(thread(loadOBJ, "Tree.obj", pApp->device, treeModel, &cacheTree, &viewTree, false, &jobSystem));
 #pragma endregion
 	
 #pragma region Load Textures
-	result = CreateDDSTextureFromFile(device, L"_skymap.dds", NULL, &srvSkymap, NULL);
-	result = CreateDDSTextureFromFile(device, L"_grass.dds", NULL, &srvGrass, NULL);
-	result = CreateDDSTextureFromFile(device, L"_glass.dds", NULL, &srvGlass, NULL);
-	result = CreateDDSTextureFromFile(device, L"_ground.dds", NULL, &srvGround, NULL);
-	result = CreateDDSTextureFromFile(device, L"_barrel.dds", NULL, &srvBarrel, NULL);
-	result = CreateDDSTextureFromFile(device, L"_barrelN.dds", NULL, &srvBarrelN, NULL);
-	result = CreateDDSTextureFromFile(device, L"_bark.dds", NULL, &srvBark, NULL);
+	//	Priorities start at 0, prioritizeTextures sets them every frame
+	textureBackend.Initialize(device, devContext);
+	textureStreamer.SetBudget(TEXTURE_BUDGET);
+	textureStreamer.Initialize(&textureBackend);
+	texSkymap = textureStreamer.Request("_skymap.dds", 0.0f);
+	texGrass = textureStreamer.Request("_grass.dds", 0.0f);
+	texGlass = textureStreamer.Request("_glass.dds", 0.0f);
+	texGround = textureStreamer.Request("_ground.dds", 0.0f);
+	texBarrel = textureStreamer.Request("_barrel.dds", 0.0f);
+	texBarrelN = textureStreamer.Request("_barrelN.dds", 0.0f, TEXTURE_FALLBACK_NORMAL);
+	texBark = textureStreamer.Request("_bark.dds", 0.0f);
 #pragma endregion
 
 #pragma region Create Shaders
@@ -423,17 +524,20 @@ bool GraphicsProject::InitScene(){
 
 	result = device->CreateVertexShader(VS_Instancing, sizeof(VS_Instancing), NULL, &vsInst);
 	result = device->CreatePixelShader(PS_Instancing, sizeof(PS_Instancing), NULL, &psInst);
+
+	result = device->CreateVertexShader(VS_Quantized, sizeof(VS_Quantized), NULL, &vsQuant);
 #pragma endregion
 
 #pragma region InputLayer
 	//	VS
-	D3D11_INPUT_ELEMENT_DESC layout[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-	};
+	//	Vert layouts come from the same table the mesh cache stores
+	MeshVertexElement vertElements[MESH_MAX_ELEMENTS];
+	UINT vertElementCount = DescribeVert(vertElements);
+
+	D3D11_INPUT_ELEMENT_DESC layout[MESH_MAX_ELEMENTS];
+	BuildInputLayout(vertElements, 3, layout);
 
-	UINT arrSize = ARRAYSIZE(layout);
+	UINT arrSize = 3;
 	result = device->CreateInputLayout(layout, arrSize, VS, sizeof(VS), &vertLayout);
 
 	//	Skybox
@@ -454,16 +558,22 @@ bool GraphicsProject::InitScene(){
 	result = device->CreateInputLayout(layout_Star, arrSize, VS_Star, sizeof(VS_Star), &starLayout);
 
 	//	Normal Mapping
-	D3D11_INPUT_ELEMENT_DESC layout_N[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-	};
+	D3D11_INPUT_ELEMENT_DESC layout_N[MESH_MAX_ELEMENTS];
+	BuildInputLayout(vertElements, vertElementCount, layout_N);
 
-	arrSize = ARRAYSIZE(layout_N);
+	arrSize = vertElementCount;
 	result = device->CreateInputLayout(layout_N, arrSize, VS_Norm, sizeof(VS_Norm), &normMapLayout);
 
+	//	Quantized (PackedVert), VS_Quantized takes no tangent
+	MeshVertexElement packedElements[MESH_MAX_ELEMENTS];
+	DescribePackedVert(packedElements);
+
+	D3D11_INPUT_ELEMENT_DESC layout_Q[MESH_MAX_ELEMENTS];
+	BuildInputLayout(packedElements, 3, layout_Q);
+
+	arrSize = 3;
+	result = device->CreateInputLayout(layout_Q, arrSize, VS_Quantized, sizeof(VS_Quantized), &quantLayout);
+
 	//	Instancing
 	D3D11_INPUT_ELEMENT_DESC layout_I[] = {
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
@@ -675,9 +785,12 @@ bool GraphicsProject::InitScene(){
 	std::vector<InstanceData> inst;	
 	srand(100);
 
-	for (int i = 0; i < NUMTREES; i++) {		//	Random tree Positions
-		float randX = ((float)(rand() % 2000) / 10) - 100;
-		float randZ = ((float)(rand() % 2000) / 10) - 100;
+	//	Bigger forests spread out to keep the density NUMTREES has
+	float spread = sqrtf((float)numTrees / NUMTREES);
+
+	for (unsigned int i = 0; i < numTrees; i++) {		//	Random tree Positions
+		float randX = ((float)(rand() % 2000) / 10) * spread - 100 * spread;
+		float randZ = ((float)(rand() % 2000) / 10) * spread - 100 * spread;
 
 		InstanceData iData;
 		iData.pos.x = randX;
@@ -689,12 +802,21 @@ bool GraphicsProject::InitScene(){
 
 	treeInstData = inst;
 
+	treeInstSoA.Reserve(inst.size());
+	for (unsigned int i = 0; i < inst.size(); ++i)
+		treeInstSoA.Add(inst[i].pos);
+
+	//	Culling scratch sized once, frames reuse it
+	visibleTrees.reserve(inst.size());
+	treeLodOf.resize(inst.size());
+	treeUpload.resize(inst.size());
+
 	D3D11_BUFFER_DESC instBuffDesc;
 	D3D11_SUBRESOURCE_DATA instData;
 
 	ZeroMemory(&instBuffDesc, sizeof(instBuffDesc));
 	instBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-	instBuffDesc.ByteWidth = sizeof(InstanceData) * NUMTREES;
+	instBuffDesc.ByteWidth = sizeof(InstanceData) * inst.size();
 	instBuffDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	instBuffDesc.CPUAccessFlags = 0;
 	instBuffDesc.MiscFlags = 0;
@@ -708,6 +830,17 @@ bool GraphicsProject::InitScene(){
 	//	Frustum Culling
 	treeAABB.push_back(FLOAT3(-0.5f, -0.5f, -0.5f));
 	treeAABB.push_back(FLOAT3(0.5f, 0.5f, 0.5f));
+
+	//	Static trees only. Instances that moved every frame would go flat: a
+	//	refit walks the whole tree and costs more than the flat cull does
+	if (!flatCull && inst.size() >= BVH_CULL_MIN) {
+		std::vector<AABB> treeBounds(inst.size());
+		for (unsigned int i = 0; i < inst.size(); ++i) {
+			treeBounds[i].min = FLOAT3(inst[i].pos.x + treeAABB[0].x, inst[i].pos.y + treeAABB[0].y, inst[i].pos.z + treeAABB[0].z);
+			treeBounds[i].max = FLOAT3(inst[i].pos.x + treeAABB[1].x, inst[i].pos.y + treeAABB[1].y, inst[i].pos.z + treeAABB[1].z);
+		}
+		treeBVH.Build(&treeBounds[0], treeBounds.size());
+	}
 #pragma endregion
 
 #pragma region Cam Setup
@@ -906,77 +1039,104 @@ bool GraphicsProject::InitScene(){
 
 	D3D11_BUFFER_DESC vbuffdesc;
 	D3D11_SUBRESOURCE_DATA vSubdata;
-	D3D11_BUFFER_DESC iBuffdesc;
-	D3D11_SUBRESOURCE_DATA iSubdata;
 
-	//	Link
+	//	Link, packed to 20 byte vertices and expanded again by VS_Quantized
+	vector<PackedVert> packedLink(viewLink.vertexCount);
+	QuantizeVerts(viewLink.verts, viewLink.vertexCount, viewLink.bounds, packedLink.data());
+
 	ZeroMemory(&vbuffdesc, sizeof(D3D11_BUFFER_DESC));
 	vbuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
 	vbuffdesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbuffdesc.ByteWidth = sizeof(Vert) * linkModel->interleaved.size();
+	vbuffdesc.ByteWidth = sizeof(PackedVert) * packedLink.size();
 	ZeroMemory(&vSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
-	vSubdata.pSysMem = &linkModel->interleaved[0];
+	vSubdata.pSysMem = packedLink.data();
 	result = device->CreateBuffer(&vbuffdesc, &vSubdata, &vbLink);
 
-	ZeroMemory(&iBuffdesc, sizeof(D3D11_BUFFER_DESC));
-	iBuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
-	iBuffdesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	iBuffdesc.ByteWidth = sizeof(unsigned int) * linkModel->out_Indicies.size();
-	ZeroMemory(&iSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
-	iSubdata.pSysMem = &(linkModel->out_Indicies[0]);
-	result = device->CreateBuffer(&iBuffdesc, &iSubdata, &ibLink);
+	cbQuantize quant;
+	GetDequantizeParams(viewLink.bounds, quant.posOffset, quant.posScale);
+
+	ZeroMemory(&vbuffdesc, sizeof(D3D11_BUFFER_DESC));
+	vbuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
+	vbuffdesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	vbuffdesc.ByteWidth = sizeof(cbQuantize);
+	ZeroMemory(&vSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
+	vSubdata.pSysMem = &quant;
+	result = device->CreateBuffer(&vbuffdesc, &vSubdata, &cbQuantizeLink);
+
+	//	Index buffer in meshlet order, each meshlet is one range of it
+	vector<unsigned int> linkClusterIndices;
+	linkMeshlets.Build(viewLink.verts, viewLink.vertexCount, viewLink.indices, viewLink.indexCount, linkClusterIndices);
+
+	MeshView clusteredLink = viewLink;
+	clusteredLink.indices = linkClusterIndices.data();
+	clusteredLink.indexCount = linkClusterIndices.size();
+	result = CreateIndexBuffer(clusteredLink, &ibLink, &ibFormatLink);
 
 	//	Skybox
 	ZeroMemory(&vbuffdesc, sizeof(D3D11_BUFFER_DESC));
 	vbuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
 	vbuffdesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbuffdesc.ByteWidth = sizeof(Vert) * skyboxModel->interleaved.size();
+	vbuffdesc.ByteWidth = sizeof(Vert) * viewSkybox.vertexCount;
 	ZeroMemory(&vSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
-	vSubdata.pSysMem = &skyboxModel->interleaved[0];
+	vSubdata.pSysMem = viewSkybox.verts;
 	result = device->CreateBuffer(&vbuffdesc, &vSubdata, &vbSkybox);
 
-	ZeroMemory(&iBuffdesc, sizeof(D3D11_BUFFER_DESC));
-	iBuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
-	iBuffdesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	iBuffdesc.ByteWidth = sizeof(unsigned int) * skyboxModel->out_Indicies.size();
-	ZeroMemory(&iSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
-	iSubdata.pSysMem = &(skyboxModel->out_Indicies[0]);
-	result = device->CreateBuffer(&iBuffdesc, &iSubdata, &ibSkybox);
+	result = CreateIndexBuffer(viewSkybox, &ibSkybox, &ibFormatSkybox);
 
 	//	Barrel
-	ComputeTangents(barrelModel);
 	ZeroMemory(&vbuffdesc, sizeof(D3D11_BUFFER_DESC));
 	vbuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
 	vbuffdesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbuffdesc.ByteWidth = sizeof(Vert) * barrelModel->interleaved.size();
+	vbuffdesc.ByteWidth = sizeof(Vert) * viewBarrel.vertexCount;
 	ZeroMemory(&vSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
-	vSubdata.pSysMem = &barrelModel->interleaved[0];
+	vSubdata.pSysMem = viewBarrel.verts;
 	result = device->CreateBuffer(&vbuffdesc, &vSubdata, &vbBarrel);
 
-	ZeroMemory(&iBuffdesc, sizeof(D3D11_BUFFER_DESC));
-	iBuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
-	iBuffdesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	iBuffdesc.ByteWidth = sizeof(unsigned int) * barrelModel->out_Indicies.size();
-	ZeroMemory(&iSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
-	iSubdata.pSysMem = &(barrelModel->out_Indicies[0]);
-	result = device->CreateBuffer(&iBuffdesc, &iSubdata, &ibBarrel);
+	result = CreateIndexBuffer(viewBarrel, &ibBarrel, &ibFormatBarrel);
 
 	//	Tree
 	ZeroMemory(&vbuffdesc, sizeof(D3D11_BUFFER_DESC));
 	vbuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
 	vbuffdesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbuffdesc.ByteWidth = sizeof(Vert) * treeModel->interleaved.size();
+	vbuffdesc.ByteWidth = sizeof(Vert) * viewTree.vertexCount;
 	ZeroMemory(&vSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
-	vSubdata.pSysMem = &treeModel->interleaved[0];
+	vSubdata.pSysMem = viewTree.verts;
 	result = device->CreateBuffer(&vbuffdesc, &vSubdata, &vbTree);
 
-	ZeroMemory(&iBuffdesc, sizeof(D3D11_BUFFER_DESC));
-	iBuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
-	iBuffdesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	iBuffdesc.ByteWidth = sizeof(unsigned int) * treeModel->out_Indicies.size();
-	ZeroMemory(&iSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
-	iSubdata.pSysMem = &(treeModel->out_Indicies[0]);
-	result = device->CreateBuffer(&iBuffdesc, &iSubdata, &ibTree);
+	//	Every level one after another in one index buffer, each a range of it
+	vector<unsigned int> treeLodIndices;
+	treeLodCount = BuildLODChain(viewTree.verts, viewTree.vertexCount, viewTree.indices, viewTree.indexCount, treeLodIndices, treeLods);
+
+	MeshView lodTree = viewTree;
+	lodTree.indices = treeLodIndices.data();
+	lodTree.indexCount = treeLodIndices.size();
+	result = CreateIndexBuffer(lodTree, &ibTree, &ibFormatTree);
+#pragma endregion
+
+#pragma region Scene Index
+	//	Star, ground, skybox & trees are always drawn (trees cull per instance)
+	for (int i = 0; i < OBJ_COUNT; ++i)
+		objVisible[i] = true;
+
+	//	Only what can't be seen through hides trees, the glass cubes 2-4 blend
+	for (int i = 0; i < OBJ_COUNT; ++i)
+		objOccluder[i] = false;
+	objOccluder[OBJ_CUBE1] = true;
+	objOccluder[OBJ_LINK] = true;
+
+	localBounds[OBJ_LINK] = viewLink.bounds;
+	localBounds[OBJ_BARREL] = viewBarrel.bounds;
+	for (int i = OBJ_CUBE1; i <= OBJ_CUBE4; ++i)
+		localBounds[i] = AABB(FLOAT3(-1.0f, -1.0f, -1.0f), FLOAT3(1.0f, 1.0f, 1.0f));
+
+	//	Real positions come in with the first Update
+	sceneIndex.Insert(OBJ_LINK, localBounds[OBJ_LINK]);
+	sceneIndex.Insert(OBJ_BARREL, localBounds[OBJ_BARREL]);
+	for (int i = OBJ_CUBE1; i <= OBJ_CUBE4; ++i)
+		sceneIndex.Insert(i, localBounds[i]);
+
+	visibleObjects.reserve(OBJ_COUNT);
+	occlusion.Initialize(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
 #pragma endregion
 
 	return true;
@@ -993,7 +1153,8 @@ bool GraphicsProject::Update() {
 	DetectInput(timeTracker.GetTime(), (float)BUFFER_WIDTH, (float)BUFFER_HEIGHT);
 
 	//	Frustum Culling
-	cullAABB(getFrustumPlanes(Mult_4x4(camView, camProjection)));
+	camViewProj = Mult_4x4(camView, camProjection);
+	Frustum frustum = getFrustumPlanes(camViewProj);
 
 	std::string lpwinname;
 	lpwinname = "FPS : ";
@@ -1005,6 +1166,17 @@ bool GraphicsProject::Update() {
 	lpwinname += " %";
 	lpwinname += ", Num Trees Drawn : ";
 	lpwinname += std::to_string(numTreesToDraw);
+	if (cullStats.objects > 0) {
+		lpwinname += ", Plane Tests Skipped : ";
+		lpwinname += std::to_string(cullStats.TestsSkipped());
+	}
+	lpwinname += ", Link Tris Culled : ";
+	lpwinname += std::to_string(meshletTrisCulled);
+	TextureResidencyStats texStats = textureStreamer.GetResidencyStats();
+	lpwinname += ", Texture MB : ";
+	lpwinname += std::to_string(texStats.residentBytes >> 20);
+	lpwinname += " / ";
+	lpwinname += std::to_string(texStats.budget >> 20);
 	pApp->ChangeTitleBar(lpwinname);
 
 	rot += timeTracker.GetTime();
@@ -1015,41 +1187,26 @@ bool GraphicsProject::Update() {
 #pragma region Reset Worlds
 	WVP = Identity();
 	cbPerObj.World = WVP;	
-	linkWorld = Identity();
-	cube1World = Identity();
-	cube2World = Identity();
-	cube3World = Identity();
-	cube4World = Identity();
-	groundWorld = Identity();
-	barrelWorld = Identity();
 #pragma endregion
 
 #pragma region Define Worlds
-	linkWorld = RotateZ(linkWorld, rot);
-	linkWorld = Translate(linkWorld, 0.0f, 0.8f, 15.0f);
-	linkWorld = Scale_4x4(linkWorld, 0.25f, 0.25f, 0.25f);
-
-	barrelWorld = RotateZ(barrelWorld, -rot);
-	barrelWorld = Translate(barrelWorld, 5.0f, 0.8f, 15.0f);
-	barrelWorld = Scale_4x4(barrelWorld, 0.0025f, 0.0025f, 0.0025f);
+	//	One closed form TRS per object instead of Identity -> Rotate -> Translate -> Scale.
+	//	RotateZ in MathFunc spins about y, so link & barrel use QuatRotationY to match.
+	FLOAT4 spinY = QuatRotationY(rot);
 
-	cube1World = Translate(cube1World, 5.0f, 0.8f, 3.0f);
-	cube1World = RotateZ(cube1World, rot);
+	Transform linkTransform(FLOAT3(0.0f, 0.8f, 15.0f), spinY, FLOAT3(0.25f, 0.25f, 0.25f));
+	linkWorld = linkTransform.ToMatrix();
+	linkInverse = linkTransform.ToInverseMatrix();
+	barrelWorld = Transform(FLOAT3(5.0f, 0.8f, 15.0f), QuatRotationY(-rot), FLOAT3(0.0025f, 0.0025f, 0.0025f)).ToMatrix();
 
-	cube2World = RotateX(cube2World, rot);
-	cube2World = Translate(cube2World, 0.0f, 1.0f, 0.0f);
-	cube2World = Scale_4x4(cube2World, 0.8f, 0.8f, 0.8f);
+	//	Translate then rotate, i.e. orbit the origin
+	cube1World = Transform(QuatRotate(spinY, FLOAT3(5.0f, 0.8f, 3.0f)), spinY, FLOAT3(1.0f, 1.0f, 1.0f)).ToMatrix();
 
-	cube3World = RotateX(cube3World, -rot);
-	cube3World = Translate(cube3World, 0.0f, 2.0f, 3.0f);
-	cube3World = Scale_4x4(cube3World, 1.4f, 1.4f, 1.4f);
+	cube2World = Transform(FLOAT3(0.0f, 1.0f, 0.0f), QuatRotationX(rot), FLOAT3(0.8f, 0.8f, 0.8f)).ToMatrix();
+	cube3World = Transform(FLOAT3(0.0f, 2.0f, 3.0f), QuatRotationX(-rot), FLOAT3(1.4f, 1.4f, 1.4f)).ToMatrix();
+	cube4World = Transform(FLOAT3(0.0f, 2.8f, 10.0f), QuatRotationX(rot), FLOAT3(2.0f, 2.0f, 2.0f)).ToMatrix();
 
-	cube4World = RotateX(cube4World, rot);
-	cube4World = Translate(cube4World, 0.0f, 2.8f, 10.0f);
-	cube4World = Scale_4x4(cube4World, 2.0f, 2.0f, 2.0f);
-
-	groundWorld = Translate(groundWorld, 0.0f, 1.0f, 0.0f);
-	groundWorld = Scale_4x4(groundWorld, 100.0f, 1.0f, 100.0f);
+	groundWorld = Transform(FLOAT3(0.0f, 1.0f, 0.0f), QuatIdentity(), FLOAT3(100.0f, 1.0f, 100.0f)).ToMatrix();
 
 	DirectX::XMMATRIX temp = XMConverter(starWorld);
 	light.position.x = temp.r[3].m128_f32[0];
@@ -1057,6 +1214,63 @@ bool GraphicsProject::Update() {
 	light.position.z = temp.r[3].m128_f32[2];
 #pragma endregion	
 
+#pragma region Batch WVP
+	batchWorld[OBJ_STAR] = starWorld;
+	batchWorld[OBJ_GROUND] = groundWorld;
+	batchWorld[OBJ_LINK] = linkWorld;
+	batchWorld[OBJ_BARREL] = barrelWorld;
+	batchWorld[OBJ_TREE] = treeWorld;
+	batchWorld[OBJ_CUBE1] = cube1World;
+	batchWorld[OBJ_CUBE2] = cube2World;
+	batchWorld[OBJ_CUBE3] = cube3World;
+	batchWorld[OBJ_CUBE4] = cube4World;
+
+	//	(World * View) * Proj, the order the per-object Mult_4x4 pairs used, so
+	//	the WVPs stay bit for bit what they were. World * ViewProj rounds differently.
+	MulBatch(batchWorld, camView, batchWVP, OBJ_COUNT);
+	MulBatch(batchWVP, camProjection, batchWVP, OBJ_COUNT);
+#pragma endregion
+
+#pragma region Scene Index
+	for (unsigned int i = 0; i < OBJ_COUNT; ++i) {
+		if (sceneIndex.Contains(i)) {
+			sceneIndex.Move(i, TransformAABB(localBounds[i], batchWorld[i]));
+			objVisible[i] = false;
+		}
+	}
+
+	visibleObjects.clear();
+	sceneIndex.QueryFrustum(frustum.planes, visibleObjects);
+	for (unsigned int i = 0; i < visibleObjects.size(); ++i)
+		objVisible[visibleObjects[i]] = true;
+#pragma endregion
+
+#pragma region Meshlet Culling
+	visibleMeshlets.clear();
+	meshletTrisCulled = 0;
+	if (objVisible[OBJ_LINK]) {
+		FLOAT4 localPlanes[6];
+		FrustumToLocal(frustum.planes, linkWorld, localPlanes);
+
+		//	camView only ever translates & rotates, so its inverse is cheap
+		MATRIX4X4 camWorld = FastInverse(camView);
+		FLOAT4 eye = Mult_Vertex4x4(FLOAT4(camWorld.m, camWorld.n, camWorld.o, 1.0f), linkInverse);
+
+		meshletTrisCulled = linkMeshlets.Cull(localPlanes, FLOAT3(eye.x, eye.y, eye.z), visibleMeshlets);
+	}
+#pragma endregion
+
+#pragma region Tree Culling
+	//	After the worlds so the occluders are where they get drawn this frame
+	drawOccluders();
+	cullAABB(frustum);
+#pragma endregion
+
+#pragma region Texture Streaming
+	prioritizeTextures();
+	textureStreamer.Update();
+#pragma endregion
+
 	return Render();
 }
 
@@ -1096,19 +1310,19 @@ bool GraphicsProject::Render(){
 	devContext->VSSetConstantBuffers(0, 1, &cbPerObjectBuffer);
 
 	devContext->IASetVertexBuffers(0, 1, &vbSkybox, &stride, &offset);
-	devContext->IASetIndexBuffer(ibSkybox, DXGI_FORMAT_R32_UINT, 0);
+	devContext->IASetIndexBuffer(ibSkybox, ibFormatSkybox, 0);
 
 	devContext->IASetInputLayout(skyboxLayout);
 	devContext->VSSetShader(vsSkybox, NULL, 0);
 	devContext->PSSetShader(psSkybox, NULL, 0);
 
 	devContext->OMSetBlendState(0, 0, 0xffffffff);
-	devContext->PSSetShaderResources(0, 1, &srvSkymap);
+	bindTexture(0, texSkymap);
 	devContext->PSSetSamplers(0, 1, &ssSkybox);
 	devContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	devContext->RSSetState(rState_F);
-	devContext->DrawIndexed(FindNumIndicies(ibSkybox), 0, 0);
+	DrawSubMeshes(viewSkybox);
 
 	devContext->ClearDepthStencilView(dsView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1, 0);
 #pragma endregion
@@ -1116,8 +1330,7 @@ bool GraphicsProject::Render(){
 #pragma region Draw Star
 	stride = sizeof(SIMPLE_VERTEX);
 
-	WVP = Mult_4x4(starWorld, camView);
-	WVP = Mult_4x4(WVP, camProjection);
+	WVP = batchWVP[OBJ_STAR];
 	cbPerObj.World = (starWorld);
 	cbPerObj.WVP = WVP;
 
@@ -1140,8 +1353,7 @@ bool GraphicsProject::Render(){
 #pragma region Draw Ground
 	stride = sizeof(VERTEX);
 
-	WVP = Mult_4x4(groundWorld, camView);
-	WVP = Mult_4x4(WVP, camProjection);
+	WVP = batchWVP[OBJ_GROUND];
 	cbPerObj.World = (groundWorld);
 	cbPerObj.WVP = WVP;
 
@@ -1155,7 +1367,7 @@ bool GraphicsProject::Render(){
 	devContext->VSSetShader(vs, NULL, 0);
 	devContext->PSSetShader(ps, NULL, 0);
 
-	devContext->PSSetShaderResources(0, 1, &srvGround);
+	bindTexture(0, texGround);
 	devContext->PSSetSamplers(0, 1, &ssSkybox);
 	devContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
@@ -1164,34 +1376,48 @@ bool GraphicsProject::Render(){
 #pragma endregion
 
 #pragma region Draw Link
-	stride = sizeof(Vert);
+	stride = sizeof(PackedVert);
 
-	WVP = Mult_4x4(linkWorld, camView);
-	WVP = Mult_4x4(WVP, camProjection);
+	WVP = batchWVP[OBJ_LINK];
 	cbPerObj.World = (linkWorld);
 	cbPerObj.WVP = WVP;
 
 	devContext->UpdateSubresource(cbPerObjectBuffer, 0, NULL, &cbPerObj, 0, 0);
 	devContext->VSSetConstantBuffers(0, 1, &cbPerObjectBuffer);
 
+	devContext->VSSetConstantBuffers(1, 1, &cbQuantizeLink);
+
 	devContext->IASetVertexBuffers(0, 1, &vbLink, &stride, &offset);
-	devContext->IASetIndexBuffer(ibLink, DXGI_FORMAT_R32_UINT, 0);
+	devContext->IASetIndexBuffer(ibLink, ibFormatLink, 0);
 
-	devContext->IASetInputLayout(vertLayout);
-	devContext->VSSetShader(vs, NULL, 0);
+	devContext->IASetInputLayout(quantLayout);
+	devContext->VSSetShader(vsQuant, NULL, 0);
 	devContext->PSSetShader(ps, NULL, 0);
 
 	devContext->RSSetState(rState_B);
 	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	
-	devContext->DrawIndexed(FindNumIndicies(ibLink), 0, 0);
+	//	Runs of neighbouring meshlets that survived go out as one draw
+	const Meshlet* meshlets = linkMeshlets.GetMeshlets();
+	for (size_t i = 0; i < visibleMeshlets.size();) {
+		const Meshlet& first = meshlets[visibleMeshlets[i]];
+		UINT count = first.triangleCount * 3;
+
+		size_t next = i + 1;
+		while (next < visibleMeshlets.size() && visibleMeshlets[next] == visibleMeshlets[next - 1] + 1) {
+			count += meshlets[visibleMeshlets[next]].triangleCount * 3;
+			++next;
+		}
+
+		devContext->DrawIndexed(count, first.firstIndex, 0);
+		i = next;
+	}
 #pragma endregion
 
 #pragma region Draw Barrel
 	stride = sizeof(Vert);
 
-	WVP = Mult_4x4(barrelWorld, camView);
-	WVP = Mult_4x4(WVP, camProjection);
+	WVP = batchWVP[OBJ_BARREL];
 	cbPerObj.World = (barrelWorld);
 	cbPerObj.WVP = WVP;
 
@@ -1199,18 +1425,19 @@ bool GraphicsProject::Render(){
 	devContext->VSSetConstantBuffers(0, 1, &cbPerObjectBuffer);
 
 	devContext->IASetVertexBuffers(0, 1, &vbBarrel, &stride, &offset);
-	devContext->IASetIndexBuffer(ibBarrel, DXGI_FORMAT_R32_UINT, 0);
+	devContext->IASetIndexBuffer(ibBarrel, ibFormatBarrel, 0);
 
 	devContext->IASetInputLayout(normMapLayout);
 	devContext->VSSetShader(vsNorm , NULL, 0);
 	devContext->PSSetShader(psNorm , NULL, 0);
 
-	devContext->PSSetShaderResources(0, 1, &srvBarrel);
-	devContext->PSSetShaderResources(1, 1, &srvBarrelN);
+	bindTexture(0, texBarrel);
+	bindTexture(1, texBarrelN);
 	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	devContext->RSSetState(rState_B_AA);
-	devContext->DrawIndexed(FindNumIndicies(ibBarrel), 0, 0);
+	if (objVisible[OBJ_BARREL])
+		DrawSubMeshes(viewBarrel);
 #pragma endregion
 
 #pragma region Draw Instance Trees
@@ -1225,11 +1452,10 @@ bool GraphicsProject::Render(){
 
 		ID3D11Buffer* vertInstBuffers[2] = { vbTree, treeInstanceBuff };
 
-		devContext->IASetIndexBuffer(ibTree, DXGI_FORMAT_R32_UINT, 0);
+		devContext->IASetIndexBuffer(ibTree, ibFormatTree, 0);
 		devContext->IASetVertexBuffers(0, 2, vertInstBuffers, strides, offsets);
 
-		WVP = Mult_4x4(treeWorld, camView);
-		WVP = Mult_4x4(WVP, camProjection);
+		WVP = batchWVP[OBJ_TREE];
 		cbPerObj.World = treeWorld;
 		cbPerObj.WVP = WVP;
 
@@ -1237,19 +1463,23 @@ bool GraphicsProject::Render(){
 		devContext->VSSetConstantBuffers(0, 1, &cbPerObjectBuffer);
 		devContext->PSSetConstantBuffers(1, 1, &cbPerObjectBuffer);
 
-		devContext->PSSetShaderResources(0, 1, &srvBark);
+		bindTexture(0, texBark);
 		devContext->PSSetSamplers(0, 1, &ssCube);
 
 		devContext->RSSetState(rState_None);
-		devContext->DrawIndexedInstanced(FindNumIndicies(ibTree), numTreesToDraw, 0, 0, 0);
+
+		//	One draw per level, cullAABB left each level's instances contiguous
+		for (unsigned int l = 0; l < treeLodCount; ++l) {
+			if (treeLodInstances[l])
+				devContext->DrawIndexedInstanced(treeLods[l].indexCount, treeLodInstances[l], treeLods[l].firstIndex, 0, treeLodStart[l]);
+		}
 	}
 #pragma endregion
 
 #pragma region Draw Cube
 	stride = sizeof(VERTEX);	
 
-	WVP = Mult_4x4(cube1World, camView);
-	WVP = Mult_4x4(WVP, camProjection);
+	WVP = batchWVP[OBJ_CUBE1];
 	cbPerObj.World = (cube1World);
 	cbPerObj.WVP = WVP;
 
@@ -1261,14 +1491,14 @@ bool GraphicsProject::Render(){
 	devContext->PSSetShader(ps, NULL, 0);
 	devContext->IASetInputLayout(vertLayout);
 	devContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	devContext->PSSetShaderResources(0, 1, &srvGrass);
+	bindTexture(0, texGrass);
 	devContext->PSSetSamplers(0, 1, &ssCube);
-	devContext->DrawIndexed(FindNumIndicies(ibCube), 0, 0);
+	if (objVisible[OBJ_CUBE1])
+		devContext->DrawIndexed(FindNumIndicies(ibCube), 0, 0);
 #pragma endregion
 
 #pragma region Draw Cube2
-	WVP = Mult_4x4(cube2World, camView);
-	WVP = Mult_4x4(WVP, camProjection);
+	WVP = batchWVP[OBJ_CUBE2];
 	cbPerObj.World = (cube2World);
 	cbPerObj.WVP = WVP;	
 
@@ -1283,17 +1513,17 @@ bool GraphicsProject::Render(){
 	devContext->PSSetShader(ps, NULL, 0);
 
 	devContext->OMSetBlendState(bsTransparency, blendFactor, 0xffffffff);
-	devContext->PSSetShaderResources(0, 1, &srvGlass);
+	bindTexture(0, texGlass);
 	devContext->PSSetSamplers(0, 1, &ssCube);
 	devContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	devContext->RSSetState(rState_F_AA);
-	devContext->DrawIndexed(FindNumIndicies(ibCube), 0, 0);
+	if (objVisible[OBJ_CUBE2])
+		devContext->DrawIndexed(FindNumIndicies(ibCube), 0, 0);
 #pragma endregion
 
 #pragma region Draw Cube3
-	WVP = Mult_4x4(cube3World, camView);
-	WVP = Mult_4x4(WVP, camProjection);
+	WVP = batchWVP[OBJ_CUBE3];
 	cbPerObj.World = (cube3World);
 	cbPerObj.WVP = WVP;
 
@@ -1308,17 +1538,17 @@ bool GraphicsProject::Render(){
 	devContext->PSSetShader(ps, NULL, 0);
 
 	devContext->OMSetBlendState(bsTransparency, blendFactor, 0xffffffff);
-	devContext->PSSetShaderResources(0, 1, &srvGlass);
+	bindTexture(0, texGlass);
 	devContext->PSSetSamplers(0, 1, &ssCube);
 	devContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	devContext->RSSetState(rState_F_AA);
-	devContext->DrawIndexed(FindNumIndicies(ibCube), 0, 0);
+	if (objVisible[OBJ_CUBE3])
+		devContext->DrawIndexed(FindNumIndicies(ibCube), 0, 0);
 #pragma endregion
 
 #pragma region Draw Cube4
-	WVP = Mult_4x4(cube4World, camView);
-	WVP = Mult_4x4(WVP, camProjection);
+	WVP = batchWVP[OBJ_CUBE4];
 	cbPerObj.World = (cube4World);
 	cbPerObj.WVP = WVP;
 
@@ -1333,12 +1563,13 @@ bool GraphicsProject::Render(){
 	devContext->PSSetShader(ps, NULL, 0);
 
 	devContext->OMSetBlendState(bsTransparency, blendFactor, 0xffffffff);
-	devContext->PSSetShaderResources(0, 1, &srvGlass);
+	bindTexture(0, texGlass);
 	devContext->PSSetSamplers(0, 1, &ssCube);
 	devContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	devContext->RSSetState(rState_F_AA);
-	devContext->DrawIndexed(FindNumIndicies(ibCube), 0, 0);
+	if (objVisible[OBJ_CUBE4])
+		devContext->DrawIndexed(FindNumIndicies(ibCube), 0, 0);
 #pragma endregion
 
 //#pragma region MiniMap
@@ -1578,56 +1809,149 @@ void GraphicsProject::DetectInput(double time, float w, float h){
 	return;
 }
 
-void GraphicsProject::cullAABB(std::vector<FLOAT4> &frustumPlanes) {
-	numTreesToDraw = 0;
+void GraphicsProject::drawOccluders() {
+	occlusion.Clear();
+
+	for (int i = OBJ_CUBE1; i <= OBJ_CUBE4; ++i) {
+		if (objVisible[i] && objOccluder[i])
+			occlusion.RasterizeBox(localBounds[i], batchWVP[i]);
+	}
+
+	if (objVisible[OBJ_LINK] && objOccluder[OBJ_LINK] && viewLink.indexCount)
+		occlusion.RasterizeOccluder(&viewLink.verts[0].Pos, sizeof(Vert), viewLink.indices, viewLink.indexCount, batchWVP[OBJ_LINK]);
+
+	occlusion.BuildHiZ();
+}
+
+void GraphicsProject::cullAABB(const Frustum& frustum) {
+	cullStats.Reset();
 
-	std::vector<InstanceData> tempTreeInstDat(NUMTREES);
-	bool cull = false;
+	//	Large static forests walk the BVH, whole subtrees in or out at once, each
+	//	node trying last frame's rejecting plane first.
+	//	Indices come back in tree order rather than instance order.
+	if (treeBVH.GetPrimCount() > 0) {
+		visibleTrees.clear();
+		treeBVH.CullFrustumCoherent(frustum.planes, visibleTrees, treeCullCache, &cullStats);
+		numTreesToDraw = (int)visibleTrees.size();
+	}
+	else {
+		CullPlanes planes;
+		BuildCullPlanes(frustum.planes, treeAABB[0], treeAABB[1], planes);
+
+		//	4 / 8 trees per test, visible indices come back in order.
+		//	Big forests are split into chunks across the job system.
+		visibleTrees.resize(treeInstSoA.Size());
+		if (treeInstSoA.Size() >= PARALLEL_CULL_MIN)
+			numTreesToDraw = (int)CullInstancesParallel(jobSystem, planes, treeInstSoA, cullScratch, &visibleTrees[0]);
+		else
+			numTreesToDraw = (int)CullInstances(planes, treeInstSoA, 0, treeInstSoA.Size(), &visibleTrees[0]);
+	}
 
-	for (int i = 0; i < NUMTREES; ++i) {
-		cull = false;
+	//	Drop the frustum survivors hidden behind the occluders
+	if (numTreesToDraw > 0)
+		numTreesToDraw = (int)occlusion.FilterInstances(&visibleTrees[0], numTreesToDraw, treeInstSoA, treeAABB[0], treeAABB[1], camViewProj, &visibleTrees[0]);
 
-		for (int planeID = 0; planeID < 6; ++planeID) {
-			DirectX::XMVECTOR planeNormal = DirectX::XMVectorSet(frustumPlanes[planeID].x, frustumPlanes[planeID].y, frustumPlanes[planeID].z, 0.0f);
-			DirectX::XMFLOAT3 axisVert;
+	for (unsigned int l = 0; l < MESH_MAX_LODS; ++l)
+		treeLodInstances[l] = 0;
 
-			float planeConstant = frustumPlanes[planeID].w;
+	if (numTreesToDraw == 0)
+		return;
 
-			//	Bounds checking - x-axis
-			if (frustumPlanes[planeID].x < 0.0f)	
-				axisVert.x = treeAABB[0].x + treeInstData[i].pos.x;
-			else
-				axisVert.x = treeAABB[1].x + treeInstData[i].pos.x;
+	//	Level by distance to the eye, projected error against TREE_LOD_PIXEL_ERROR
+	MATRIX4X4 camWorld = FastInverse(camView);
+	float pixelsPerUnit = 0.5f * viewport.Height * camProjection.f;
 
-			// y-axis
-			if (frustumPlanes[planeID].y < 0.0f)	
-				axisVert.y = treeAABB[0].y + treeInstData[i].pos.y;
-			else
-				axisVert.y = treeAABB[1].y + treeInstData[i].pos.y;
+	for (int i = 0; i < numTreesToDraw; ++i) {
+		const FLOAT3& pos = treeInstData[visibleTrees[i]].pos;
+		float dx = pos.x - camWorld.m, dy = pos.y - camWorld.n, dz = pos.z - camWorld.o;
 
-			// z-axis
-			if (frustumPlanes[planeID].z < 0.0f)	
-				axisVert.z = treeAABB[0].z + treeInstData[i].pos.z;
-			else
-				axisVert.z = treeAABB[1].z + treeInstData[i].pos.z;
+		unsigned int lod = SelectLOD(treeLods, treeLodCount, sqrtf(dx * dx + dy * dy + dz * dz), pixelsPerUnit, TREE_LOD_PIXEL_ERROR);
+		treeLodOf[i] = (unsigned char)lod;
+		++treeLodInstances[lod];
+	}
 
-			if (DirectX::XMVectorGetX(DirectX::XMVector3Dot(planeNormal, XMLoadFloat3(&axisVert))) + planeConstant < 0.0f) {
-				cull = true;
-				break;
-			}
-		}
+	//	Counting sort, each level's instances become one contiguous run
+	unsigned int next[MESH_MAX_LODS];
+	unsigned int start = 0;
+	for (unsigned int l = 0; l < treeLodCount; ++l) {
+		treeLodStart[l] = next[l] = start;
+		start += treeLodInstances[l];
+	}
 
-		if (!cull) {
-			tempTreeInstDat[numTreesToDraw].pos = treeInstData[i].pos;
-			numTreesToDraw++;
-		}
+	for (int i = 0; i < numTreesToDraw; ++i)
+		treeUpload[next[treeLodOf[i]]++] = treeInstData[visibleTrees[i]];
+
+	//	Only the visible prefix, the draw never reads past numTreesToDraw
+	D3D11_BOX dest;
+	dest.left = 0;
+	dest.right = sizeof(InstanceData) * numTreesToDraw;
+	dest.top = 0;
+	dest.bottom = 1;
+	dest.front = 0;
+	dest.back = 1;
+	devContext->UpdateSubresource(treeInstanceBuff, 0, &dest, &treeUpload[0], 0, 0);
+}
+
+void GraphicsProject::prioritizeTextures() {
+	MATRIX4X4 camWorld = FastInverse(camView);
+	float priority[OBJ_COUNT];
+
+	//	Projected size of each object's world bounds, hidden ones only get
+	//	what's left once the visible ones are in
+	for (unsigned int i = 0; i < OBJ_COUNT; ++i) {
+		AABB box = TransformAABB(localBounds[i], batchWorld[i]);
+		float ex = box.max.x - box.min.x, ey = box.max.y - box.min.y, ez = box.max.z - box.min.z;
+		float dx = 0.5f * (box.min.x + box.max.x) - camWorld.m;
+		float dy = 0.5f * (box.min.y + box.max.y) - camWorld.n;
+		float dz = 0.5f * (box.min.z + box.max.z) - camWorld.o;
+
+		float radius = 0.5f * sqrtf(ex * ex + ey * ey + ez * ez);
+		priority[i] = TexturePriority(radius, sqrtf(dx * dx + dy * dy + dz * dz), camProjection.f, viewport.Height);
+		if (!objVisible[i])
+			priority[i] *= TEXTURE_HIDDEN_SCALE;
 	}
-	devContext->UpdateSubresource(treeInstanceBuff, 0, NULL, &tempTreeInstDat[0], 0, 0);
+
+	//	The bark goes on every tree, the nearest visible one decides
+	float bark = 0.0f;
+	float treeRadius = 0.5f * sqrtf(3.0f) * (treeAABB[1].x - treeAABB[0].x);
+	for (int i = 0; i < numTreesToDraw; ++i) {
+		const FLOAT3& pos = treeUpload[i].pos;
+		float dx = pos.x - camWorld.m, dy = pos.y - camWorld.n, dz = pos.z - camWorld.o;
+		float p = TexturePriority(treeRadius, sqrtf(dx * dx + dy * dy + dz * dz), camProjection.f, viewport.Height);
+		if (p > bark)
+			bark = p;
+	}
+
+	//	The sky always fills the screen
+	textureStreamer.SetPriority(texSkymap, viewport.Height);
+	textureStreamer.SetPriority(texGround, priority[OBJ_GROUND]);
+	textureStreamer.SetPriority(texBarrel, priority[OBJ_BARREL]);
+	textureStreamer.SetPriority(texBarrelN, priority[OBJ_BARREL]);
+	textureStreamer.SetPriority(texBark, bark);
+	textureStreamer.SetPriority(texGrass, priority[OBJ_CUBE1]);
+
+	//	The three glass cubes share one texture
+	float glass = priority[OBJ_CUBE2];
+	for (unsigned int i = OBJ_CUBE3; i <= OBJ_CUBE4; ++i) {
+		if (priority[i] > glass)
+			glass = priority[i];
+	}
+	textureStreamer.SetPriority(texGlass, glass);
+}
+
+void GraphicsProject::bindTexture(UINT slot, TextureId id) {
+	//	Drawn with this frame, what the residency LRU goes by
+	textureStreamer.Touch(id);
+
+	//	Null for files that never loaded, same as before streaming
+	ID3D11ShaderResourceView* srv = textureBackend.GetView(id);
+	devContext->PSSetShaderResources(slot, 1, &srv);
 }
 
-std::vector<FLOAT4> GraphicsProject::getFrustumPlanes(MATRIX4X4& viewProj){
+Frustum GraphicsProject::getFrustumPlanes(const MATRIX4X4& viewProj){
 
-	std::vector<FLOAT4> fPlane(6);
+	Frustum frustum;
+	FLOAT4* fPlane = frustum.planes;
 
 	// Left Frustum Plane
 	fPlane[0].x = viewProj.d + viewProj.a;
@@ -1674,45 +1998,56 @@ std::vector<FLOAT4> GraphicsProject::getFrustumPlanes(MATRIX4X4& viewProj){
 		fPlane[i].w /= length;
 	}
 
-	return fPlane;
+	return frustum;
 }
 
-void GraphicsProject::ComputeTangents(Model* m){
-
-	for (unsigned int i = 0; i < m->interleaved.size(); i += 3){
-		Vert& v0 = m->interleaved[i];
-		Vert& v1 = m->interleaved[i + 1];
-		Vert& v2 = m->interleaved[i + 2];
-
-		FLOAT3 edge1 = Subtract(v1.Pos, v0.Pos);
-		FLOAT3 edge2 = Subtract(v2.Pos, v0.Pos);
+UINT GraphicsProject::FindNumIndicies(ID3D11Buffer* b, DXGI_FORMAT format){
+	D3D11_BUFFER_DESC ibufferDesc;
+	b->GetDesc(&ibufferDesc);
 
-		float du1 = v1.Uvs.u - v0.Uvs.u;
-		float du2 = v1.Uvs.v - v0.Uvs.v;
-		float dv1 = v2.Uvs.u - v0.Uvs.u;
-		float dv2 = v2.Uvs.v - v0.Uvs.v;
+	UINT numIndicies = ibufferDesc.ByteWidth / ((format == DXGI_FORMAT_R16_UINT) ? sizeof(unsigned short) : sizeof(UINT));
 
-		float f = 1.0f / ((du2 * dv2) - (du2 * dv1));
+	return numIndicies;
+}
 
-		FLOAT3 tan;
+HRESULT GraphicsProject::CreateIndexBuffer(const MeshView& mesh, ID3D11Buffer** ib, DXGI_FORMAT* format){
+	D3D11_BUFFER_DESC iBuffdesc;
+	D3D11_SUBRESOURCE_DATA iSubdata;
+	std::vector<unsigned short> indices16;
 
-		tan.x = f * (dv2 * edge1.x - dv1 * edge2.x);
-		tan.y = f * (dv2 * edge1.y - dv1 * edge2.y);
-		tan.z = f * (dv2 * edge1.z - dv1 * edge2.z);
+	ZeroMemory(&iBuffdesc, sizeof(D3D11_BUFFER_DESC));
+	iBuffdesc.Usage = D3D11_USAGE_IMMUTABLE;
+	iBuffdesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ZeroMemory(&iSubdata, sizeof(D3D11_SUBRESOURCE_DATA));
 
-		v0.tangent = tan;
-		v1.tangent = tan;
-		v2.tangent = tan;
+	//	Half the bytes whenever every index fits
+	if (mesh.vertexCount <= 0x10000) {
+		indices16.assign(mesh.indices, mesh.indices + mesh.indexCount);
+		iBuffdesc.ByteWidth = sizeof(unsigned short) * indices16.size();
+		iSubdata.pSysMem = &indices16[0];
+		*format = DXGI_FORMAT_R16_UINT;
+	}
+	else {
+		iBuffdesc.ByteWidth = sizeof(unsigned int) * mesh.indexCount;
+		iSubdata.pSysMem = mesh.indices;
+		*format = DXGI_FORMAT_R32_UINT;
 	}
-}
 
-UINT GraphicsProject::FindNumIndicies(ID3D11Buffer* b){
-	D3D11_BUFFER_DESC ibufferDesc;
-	b->GetDesc(&ibufferDesc);
+	return device->CreateBuffer(&iBuffdesc, &iSubdata, ib);
+}
 
-	UINT numIndicies = ibufferDesc.ByteWidth / sizeof(UINT);
+//	One vertex and index buffer per model, one draw per group / material range
+void GraphicsProject::DrawSubMeshes(const MeshView& mesh){
+	if (mesh.subMeshCount == 0) {
+		devContext->DrawIndexed((UINT)mesh.indexCount, 0, 0);
+		return;
+	}
 
-	return numIndicies;
+	for (size_t i = 0; i < mesh.subMeshCount; ++i) {
+		const SubMesh& sub = mesh.subMeshes[i];
+		if (sub.indexCount)
+			devContext->DrawIndexed(sub.indexCount, sub.firstIndex, 0);
+	}
 }
 
 bool GraphicsProject::ShutDown() {
@@ -1727,6 +2062,7 @@ bool GraphicsProject::ShutDown() {
 	starLayout->Release();
 	normMapLayout->Release();
 	instLayout->Release();
+	quantLayout->Release();
 	
 	
 	dsBuffer->Release();
@@ -1738,6 +2074,7 @@ bool GraphicsProject::ShutDown() {
 
 	cbPerObjectBuffer->Release();
 	cbPerFrameBuffer->Release();
+	cbQuantizeLink->Release();
 	
 	vbSkybox->Release();
 	vbCube->Release();
@@ -1763,6 +2100,7 @@ bool GraphicsProject::ShutDown() {
 	vsSkybox->Release();
 	vsNorm->Release();
 	vsInst->Release();
+	vsQuant->Release();
 	
 	ps->Release();
 	psStar->Release();
@@ -1779,13 +2117,8 @@ bool GraphicsProject::ShutDown() {
 	rState_None->Release();
 	
 	
-	srvSkymap->Release();
-	srvGlass->Release();
-	srvGrass->Release();
-	srvGround->Release();
-	srvBarrel->Release();
-	srvBarrelN->Release();
-	srvBark->Release();	
+	textureStreamer.Shutdown();
+	textureBackend.Shutdown();
 	
 	ssCube->Release();
 	ssSkybox->Release();
@@ -1799,6 +2132,8 @@ bool GraphicsProject::ShutDown() {
 	DIKeyboard->Release();
 	DIMouse->Release();
 
+	jobSystem.Shutdown();
+
 
 	delete linkModel;
 	delete barrelModel;
@@ -1816,9 +2151,17 @@ bool GraphicsProject::ShutDown() {
 
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpCmdLine, int nCmdShow);
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wparam, LPARAM lparam);
-int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, LPTSTR, int) {
+int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, LPTSTR lpCmdLine, int) {
 	srand(unsigned int(time(0)));
 	GraphicsProject myApp(hInstance, (WNDPROC)WndProc);
+
+	//	-trees N swaps the 400 tree forest for N, so the BVH cull gets used,
+	//	and with -flatcull as well the parallel flat one
+	const wchar_t* trees = wcsstr(lpCmdLine, L"-trees ");
+	if (trees && _wtoi(trees + 7) > 0)
+		myApp.SetTreeCount((unsigned int)_wtoi(trees + 7));
+	myApp.SetFlatCull(wcsstr(lpCmdLine, L"-flatcull") != nullptr);
+
 	myApp.InitScene();
 	MSG msg; ZeroMemory(&msg, sizeof(msg));
 	while (msg.message != WM_QUIT && myApp.Update()) {
@@ -1846,74 +2189,42 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	return DefWindowProc(hWnd, message, wParam, lParam);
 }
 
-bool loadOBJ(const char* path, ID3D11Device* d, Model* m){
-
-	std::vector<unsigned int> posIndicies, uvIndicies, normIndicies;
-	std::vector<FLOAT3> tmp_Pos;
-	std::vector<FLOAT2> tmp_Uvs;
-	std::vector<FLOAT3> tmp_Norms;
-
-	FILE* file = fopen(path, "r");
-	if (file == NULL){
-		printf("Impossible to open!\n");
+//	Maps path + ".mesh" when it was built from the same OBJ bytes by this
+//	loader version, otherwise parses the OBJ and writes the cache for next run
+bool loadOBJ(const char* path, ID3D11Device* d, Model* m, MeshCache* cache, MeshView* view, bool tangents, JobSystem* jobs){
+	MappedFile source;
+	if (!source.Open(path))
 		return false;
-	}
 
-	while (true){
-		char lineHeader[128];
+	unsigned long long hash = HashBytes(source.GetData(), source.GetSize());
+	unsigned long long size = source.GetSize();
+	unsigned int flags = tangents ? MESH_CACHE_TANGENTS : 0;
+	std::string cachePath = std::string(path) + ".mesh";
 
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break;
-
-		//	pos
-		if (strcmp(lineHeader, "v") == 0){
-			FLOAT3 f3;
-			fscanf(file, "%f %f %f\n", &f3.x, &f3.y, &f3.z);
-			tmp_Pos.push_back(f3);
-		}
-		//	uvs
-		else if (strcmp(lineHeader, "vt") == 0){
-			FLOAT2 uv;
-			fscanf(file, "%f %f\n", &uv.u, &uv.v);
-			tmp_Uvs.push_back(uv);
-		}
-		//	normals
-		else if (strcmp(lineHeader, "vn") == 0){
-			FLOAT3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-			tmp_Norms.push_back(normal);
-		}
-		else if (strcmp(lineHeader, "f") == 0){
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-			if (matches != 9){
-				printf("Cannot be read properly!");
-				return false;
-			}
-			posIndicies.push_back(vertexIndex[0]);
-			posIndicies.push_back(vertexIndex[1]);
-			posIndicies.push_back(vertexIndex[2]);
-			uvIndicies.push_back(uvIndex[0]);
-			uvIndicies.push_back(uvIndex[1]);
-			uvIndicies.push_back(uvIndex[2]);
-			normIndicies.push_back(normalIndex[0]);
-			normIndicies.push_back(normalIndex[1]);
-			normIndicies.push_back(normalIndex[2]);
-		}
+	if (cache->Open(cachePath.c_str(), hash, size, flags)){
+		*view = cache->GetView();
+		return true;
 	}
 
-	for (unsigned int i = 0; i < posIndicies.size(); ++i){
-		Vert temp;
-		temp.Pos = tmp_Pos[posIndicies[i] - 1];
-		temp.Uvs = tmp_Uvs[uvIndicies[i] - 1];
-		temp.Norms = tmp_Norms[normIndicies[i] - 1];
-		temp.tangent = FLOAT3(0.0f, 0.0f, 0.0f);
-
-		m->interleaved.push_back(temp);
-		m->out_Indicies.push_back(i);
+	if (!ParseOBJ(source.GetData(), source.GetSize(), m, jobs))
+		return false;
+	source.Close();
+
+	//	Tangents first, their handedness splits add vertices the reorder should see.
+	//	Still on the loader thread, so the reorder overlaps the other loads
+	if (tangents)
+		GenerateTangents(m, jobs);
+	//	No overdraw sort, on Tree.obj it gave back the cache win for no overdraw gain
+	OptimizeModel(m);
+
+	//	Use the mapping right away too so both runs upload the same way,
+	//	a read only folder just keeps the parsed copy
+	if (MeshCache::Write(cachePath.c_str(), *m, hash, size, flags) && cache->Open(cachePath.c_str(), hash, size, flags)){
+		std::vector<Vert>().swap(m->interleaved);
+		std::vector<unsigned int>().swap(m->out_Indicies);
+		*view = cache->GetView();
 	}
-
+	else
+		*view = MakeMeshView(*m);
 	return true;
-}
\ No newline at end of file
+}